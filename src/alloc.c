@@ -0,0 +1,222 @@
+#include "alloc.h"
+
+AllocStats allocStats[ALLOC_TAG_COUNT];
+const char* allocTagNames[ALLOC_TAG_COUNT] = { "loader", "mesh", "render", "swarm", "frame" };
+Arena frameArena;
+
+// Kept in front of every tracked allocation, padded so the memory after it stays aligned
+typedef union ALLOCHEADER {
+	struct {
+		size_t size;
+		AllocTag tag;
+	} info;
+	unsigned char padding[ALLOC_ALIGNMENT];
+} AllocHeader;
+
+// Rounds a size up to a multiple of the alignment
+#define ALLOC_ROUND(size) (((size) + ALLOC_ALIGNMENT - 1) & ~(size_t)(ALLOC_ALIGNMENT - 1))
+// Bytes at the start of an arena block before the memory it hands out
+#define ALLOC_BLOCK_HEADER ALLOC_ROUND(sizeof(ArenaBlock))
+
+// Counts memory being allocated or freed against a subsystem, raising its peak if it's a new high
+void allocCount(AllocTag tag, long long bytes, long long count) {
+	AllocStats* stats = &allocStats[tag];
+	const long long current = atomicAdd64(&stats->bytes, bytes) + bytes;
+	atomicAdd64(&stats->count, count);
+	if (count > 0) {
+		atomicAdd64(&stats->total, count);
+	}
+
+	long long peak = atomicLoad64(&stats->peak);
+	while (current > peak && !atomicCompareExchange64(&stats->peak, peak, current)) {
+		peak = atomicLoad64(&stats->peak);
+	}
+}
+
+void* allocMalloc(AllocTag tag, size_t size) {
+	AllocHeader* header = malloc(sizeof(AllocHeader) + size);
+	if (header == NULL) {
+		return NULL;
+	}
+	header->info.size = size;
+	header->info.tag = tag;
+	allocCount(tag, (long long)size, 1);
+	return header + 1;
+}
+
+void* allocCalloc(AllocTag tag, size_t count, size_t size) {
+	void* memory = allocMalloc(tag, count * size);
+	if (memory != NULL) {
+		memset(memory, 0, count * size);
+	}
+	return memory;
+}
+
+void* allocRealloc(AllocTag tag, void* memory, size_t size) {
+	if (memory == NULL) {
+		return allocMalloc(tag, size);
+	}
+
+	AllocHeader* header = (AllocHeader*)memory - 1;
+	const size_t oldSize = header->info.size;
+	const AllocTag oldTag = header->info.tag;
+	AllocHeader* resized = realloc(header, sizeof(AllocHeader) + size);
+	if (resized == NULL) {
+		return NULL;
+	}
+	resized->info.size = size;
+	allocCount(oldTag, (long long)size - (long long)oldSize, 0);
+	return resized + 1;
+}
+
+void allocFree(void* memory) {
+	if (memory == NULL) {
+		return;
+	}
+	AllocHeader* header = (AllocHeader*)memory - 1;
+	allocCount(header->info.tag, -(long long)header->info.size, -1);
+	free(header);
+}
+
+AllocStats allocGetStats(AllocTag tag) {
+	AllocStats stats;
+	stats.bytes = atomicLoad64(&allocStats[tag].bytes);
+	stats.count = atomicLoad64(&allocStats[tag].count);
+	stats.peak = atomicLoad64(&allocStats[tag].peak);
+	stats.total = atomicLoad64(&allocStats[tag].total);
+	return stats;
+}
+
+void allocReport(FILE* file) {
+	fprintf(file, "Memory        live KiB   live   peak KiB   allocations\n");
+	for (int tag = 0; tag < ALLOC_TAG_COUNT; ++tag) {
+		const AllocStats stats = allocGetStats((AllocTag)tag);
+		fprintf(file, "%-10s %11.1f %6lld %10.1f %13lld\n", allocTagNames[tag], stats.bytes / 1024.0, stats.count,
+			stats.peak / 1024.0, stats.total);
+	}
+}
+
+void arenaInit(Arena* arena, AllocTag tag, size_t blockSize) {
+	arena->tag = tag;
+	arena->blockSize = blockSize > 0 ? blockSize : ALLOC_ARENA_BLOCK_SIZE;
+	arena->blocks = NULL;
+	arena->used = 0;
+	arena->peak = 0;
+}
+
+// Adds an empty block with room for at least a number of bytes to the front of an arena
+ArenaBlock* arenaAddBlock(Arena* arena, size_t size) {
+	const size_t blockSize = size > arena->blockSize ? size : arena->blockSize;
+	ArenaBlock* block = allocMalloc(arena->tag, ALLOC_BLOCK_HEADER + blockSize);
+	if (block == NULL) {
+		return NULL;
+	}
+	block->next = arena->blocks;
+	block->size = blockSize;
+	block->used = 0;
+	arena->blocks = block;
+	return block;
+}
+
+void* arenaAlloc(Arena* arena, size_t size) {
+	ArenaBlock* block = arena->blocks;
+	size = ALLOC_ROUND(size > 0 ? size : 1);
+
+	if (block == NULL || block->size - block->used < size) {
+		ArenaBlock* current = block;
+		block = arenaAddBlock(arena, size);
+		if (block == NULL) {
+			return NULL;
+		}
+		// An allocation too big for a normal block gets one to itself, behind the block still being filled
+		if (current != NULL && size > arena->blockSize && current->size - current->used >= ALLOC_ALIGNMENT) {
+			arena->blocks = current;
+			block->next = current->next;
+			current->next = block;
+		}
+	}
+
+	void* memory = (unsigned char*)block + ALLOC_BLOCK_HEADER + block->used;
+	block->used += size;
+	arena->used += size;
+	arena->peak = arena->used > arena->peak ? arena->used : arena->peak;
+	return memory;
+}
+
+void* arenaCalloc(Arena* arena, size_t count, size_t size) {
+	void* memory = arenaAlloc(arena, count * size);
+	if (memory != NULL) {
+		memset(memory, 0, count * size);
+	}
+	return memory;
+}
+
+void arenaReset(Arena* arena) {
+	// An arena that outgrew its first block swaps them all for one big enough for its peak, so once it's
+	// settled it never goes back to the heap
+	if (arena->blocks != NULL && arena->blocks->next != NULL) {
+		arenaFree(arena);
+		arenaAddBlock(arena, arena->peak);
+	} else if (arena->blocks != NULL) {
+		arena->blocks->used = 0;
+	}
+	arena->used = 0;
+}
+
+void arenaFree(Arena* arena) {
+	ArenaBlock* block = arena->blocks;
+	while (block != NULL) {
+		ArenaBlock* next = block->next;
+		allocFree(block);
+		block = next;
+	}
+	arena->blocks = NULL;
+	arena->used = 0;
+}
+
+void* frameAlloc(size_t size) {
+	if (frameArena.blockSize == 0) {
+		arenaInit(&frameArena, ALLOC_FRAME, ALLOC_FRAME_BLOCK_SIZE);
+	}
+	return arenaAlloc(&frameArena, size);
+}
+
+void frameReset(void) {
+	arenaReset(&frameArena);
+}
+
+void poolInit(Pool* pool, AllocTag tag, size_t itemSize, unsigned int itemsPerBlock) {
+	pool->tag = tag;
+	pool->itemSize = ALLOC_ROUND(itemSize > sizeof(PoolItem) ? itemSize : sizeof(PoolItem));
+	pool->itemsPerBlock = itemsPerBlock > 0 ? itemsPerBlock : ALLOC_POOL_BLOCK_ITEMS;
+	pool->freeList = NULL;
+	pool->live = 0;
+	arenaInit(&pool->blocks, tag, pool->itemSize * pool->itemsPerBlock);
+}
+
+void* poolAlloc(Pool* pool) {
+	PoolItem* item = pool->freeList;
+	if (item != NULL) {
+		pool->freeList = item->next;
+	} else {
+		item = arenaAlloc(&pool->blocks, pool->itemSize);
+		if (item == NULL) {
+			return NULL;
+		}
+	}
+	++pool->live;
+	return item;
+}
+
+void poolRelease(Pool* pool, void* item) {
+	PoolItem* freed = item;
+	freed->next = pool->freeList;
+	pool->freeList = freed;
+	--pool->live;
+}
+
+void poolFree(Pool* pool) {
+	arenaFree(&pool->blocks);
+	pool->freeList = NULL;
+	pool->live = 0;
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "misc.h"
+#include "atomic.h"
+
+/*
+ * <alloc.c/alloc.h> Tracked heap allocations, and the arena, frame and pool allocators built on them.
+ * Every tracked allocation is tagged with the subsystem it belongs to and carries a small header with
+ * its size, so the bytes, count and peak of each subsystem can be read at any time and reported when
+ * the program closes. The counters are atomic, so any thread can allocate and free
+ *
+ * An arena hands out memory from large blocks and frees it all at once, for things that live and die
+ * together like the arrays of one loaded asset. The frame arena is reset at the start of every frame,
+ * for scratch memory the GL thread only needs until the frame is drawn. A pool hands out records of
+ * one size from a free list, so records that come and go often don't go back to the heap each time.
+ * Arenas and pools aren't locked, so each should only be used by one thread at a time
+ */
+
+// Alignment of everything the allocators return, enough for any type the program uses
+#define ALLOC_ALIGNMENT 16
+// Size of the blocks an arena is given when it's made with a block size of 0
+#define ALLOC_ARENA_BLOCK_SIZE (64 * 1024)
+// Size of the blocks the frame arena allocates from
+#define ALLOC_FRAME_BLOCK_SIZE (1024 * 1024)
+// Number of records in each block of a pool made with 0 records per block
+#define ALLOC_POOL_BLOCK_ITEMS 64
+
+// The subsystem an allocation is counted against
+typedef enum {
+	ALLOC_LOADER = 0,	// Parsed OBJ files and PPM pixels
+	ALLOC_MESH,			// Meshes and the buffers used to optimise them
+	ALLOC_RENDER,		// Vertex buffers' client side copies and the cull lists
+	ALLOC_SWARM,		// The swarm's drones, the poses drawn from them and the replay they fly
+	ALLOC_FRAME,		// The frame arena
+	ALLOC_TAG_COUNT
+} AllocTag;
+
+typedef struct ALLOCSTATS {
+	volatile long long bytes;	// Bytes allocated and not yet freed
+	volatile long long count;	// Allocations not yet freed
+	volatile long long peak;	// Most bytes ever allocated at once
+	volatile long long total;	// Allocations ever made
+} AllocStats;
+
+// A block of an arena, with the memory it hands out following the header
+typedef struct ARENABLOCK {
+	struct ARENABLOCK* next;
+	size_t size;				// Bytes after the header
+	size_t used;
+} ArenaBlock;
+
+typedef struct ARENA {
+	AllocTag tag;
+	size_t blockSize;			// Size of each new block, unless an allocation needs a bigger one
+	ArenaBlock* blocks;			// Every block, the one being allocated from first
+	size_t used;				// Bytes handed out since the arena was made or last reset
+	size_t peak;				// Most bytes handed out between resets
+} Arena;
+
+// A free record of a pool, which holds the link to the next in its own memory
+typedef struct POOLITEM {
+	struct POOLITEM* next;
+} PoolItem;
+
+typedef struct POOL {
+	AllocTag tag;
+	size_t itemSize;
+	unsigned int itemsPerBlock;
+	PoolItem* freeList;
+	Arena blocks;				// Where the records come from, a block of them at a time
+	unsigned int live;			// Records handed out and not yet released
+} Pool;
+
+extern AllocStats allocStats[ALLOC_TAG_COUNT];
+extern const char* allocTagNames[ALLOC_TAG_COUNT];
+extern Arena frameArena;
+
+// Allocates memory counted against a subsystem, or returns NULL if there isn't enough. Only allocFree can free it
+void* allocMalloc(AllocTag tag, size_t size);
+// Allocates zeroed memory counted against a subsystem
+void* allocCalloc(AllocTag tag, size_t count, size_t size);
+// Resizes tracked memory, keeping its subsystem, or allocates it if it's NULL
+void* allocRealloc(AllocTag tag, void* memory, size_t size);
+// Frees memory from allocMalloc, allocCalloc or allocRealloc. NULL is ignored
+void allocFree(void* memory);
+// Returns a copy of the counters of one subsystem
+AllocStats allocGetStats(AllocTag tag);
+// Writes a table of every subsystem's counters
+void allocReport(FILE* file);
+
+// Sets up an empty arena whose blocks are counted against a subsystem. A block size of 0 uses the default
+void arenaInit(Arena* arena, AllocTag tag, size_t blockSize);
+// Hands out memory from an arena, which stays valid until it's reset or freed
+void* arenaAlloc(Arena* arena, size_t size);
+// Hands out zeroed memory from an arena
+void* arenaCalloc(Arena* arena, size_t count, size_t size);
+// Takes back everything handed out by an arena, keeping its blocks for reuse
+void arenaReset(Arena* arena);
+// Frees every block of an arena
+void arenaFree(Arena* arena);
+
+// Hands out scratch memory that stays valid until the end of the frame. Only the GL thread may use it
+void* frameAlloc(size_t size);
+// Takes back all of the frame's scratch memory, at the start of the next frame
+void frameReset(void);
+
+// Sets up an empty pool of records of one size, counted against a subsystem. 0 items per block uses the default
+void poolInit(Pool* pool, AllocTag tag, size_t itemSize, unsigned int itemsPerBlock);
+// Hands out a record from a pool, reusing a released one if there is one
+void* poolAlloc(Pool* pool);
+// Gives a record back to its pool
+void poolRelease(Pool* pool, void* item);
+// Frees every block of a pool, whether or not its records were released
+void poolFree(Pool* pool);
@@ -0,0 +1,21 @@
+#include "angle.h"
+
+GLfloat angleSineTable[ANGLE_TABLE_SIZE + 1];
+GLfloat angleCosineTable[ANGLE_TABLE_SIZE + 1];
+AngleMode angleMode = ANGLE_PRECISE;
+
+void angleInitTables(void) {
+	for (unsigned int i = 0; i <= ANGLE_TABLE_SIZE; ++i) {
+		const double theta = (double)i / ANGLE_TABLE_SIZE * 2 * 3.14159265358979323846;
+		angleSineTable[i] = (GLfloat)sin(theta);
+		angleCosineTable[i] = (GLfloat)cos(theta);
+	}
+}
+
+void angleSetMode(AngleMode mode) {
+	if (mode == ANGLE_TABLE && angleCosineTable[0] == 0) {
+		angleInitTables();
+	}
+
+	angleMode = mode;
+}
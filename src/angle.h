@@ -0,0 +1,105 @@
+#pragma once
+#include <math.h>
+#include "vecinline.h"
+
+/*
+ * <angle.c/angle.h> Angle wrapping and sine/cosine in degrees. Besides the precise libm version
+ * there's a polynomial approximation and a lookup table, which --fast-math switches the
+ * simulation over to with angleSetMode
+ *
+ * Maximum absolute error over every float in [1, 360) degrees, measured by --bench trig:
+ *   ANGLE_POLYNOMIAL  3.4e-7 (a few units in the last place of the result)
+ *   ANGLE_TABLE       4.9e-7
+ * Both get less accurate as the angle gets far from [0, 360), so wrap large angles first
+ */
+
+// Number of steps the lookup table splits a full turn into
+#define ANGLE_TABLE_SIZE 4096
+// Largest absolute errors over [1, 360) degrees that --bench trig lets each approximation have
+#define ANGLE_POLYNOMIAL_MAX_ERROR 4e-7
+#define ANGLE_TABLE_MAX_ERROR 6e-7
+
+typedef enum {
+	ANGLE_PRECISE = 0,	// sinf and cosf
+	ANGLE_POLYNOMIAL,	// Minimax polynomials over an eighth of a turn
+	ANGLE_TABLE			// Linear interpolation in a lookup table
+} AngleMode;
+
+// Lookup table of sines and cosines at every step of a full turn, with the first step repeated at the end
+extern GLfloat angleSineTable[ANGLE_TABLE_SIZE + 1];
+extern GLfloat angleCosineTable[ANGLE_TABLE_SIZE + 1];
+// The way angleSinCos is currently calculating its results
+extern AngleMode angleMode;
+
+// Fills the lookup tables, which must be done before using ANGLE_TABLE
+void angleInitTables(void);
+// Sets the way angleSinCos calculates its results, filling the lookup tables if they're needed
+void angleSetMode(AngleMode mode);
+
+// Wraps an angle in degrees into [0, 360)
+VEC_INLINE GLfloat angleWrap(GLfloat angle) {
+	const GLfloat wrapped = angle - 360.0f * floorf(angle * (1 / 360.0f));
+	return wrapped >= 360.0f ? 0 : wrapped;
+}
+
+// Minimax polynomials for sine and cosine over [-pi/4, pi/4] (the single precision Cephes coefficients)
+VEC_INLINE GLfloat anglePolynomialSine(GLfloat x, GLfloat x2) {
+	return ((-1.9515295891e-4f * x2 + 8.3321608736e-3f) * x2 - 1.6666654611e-1f) * x2 * x + x;
+}
+
+VEC_INLINE GLfloat anglePolynomialCosine(GLfloat x2) {
+	return ((2.443315711809948e-5f * x2 - 1.388731625493765e-3f) * x2 + 4.166664568298827e-2f) * x2 * x2 - 0.5f * x2 + 1;
+}
+
+// Calculates the sine and cosine of an angle in degrees with the minimax polynomials. The angle is
+// reduced to the nearest quarter turn, then the polynomials are evaluated on what's left over
+VEC_INLINE void angleSinCosPolynomial(GLfloat degree, GLfloat* sine, GLfloat* cosine) {
+	const GLfloat quarters = degree * (1 / 90.0f);
+	const GLfloat quadrant = floorf(quarters + 0.5f);
+	const GLfloat x = (quarters - quadrant) * (VEC_PI / 2);
+	const GLfloat x2 = x * x;
+	const GLfloat s = anglePolynomialSine(x, x2), c = anglePolynomialCosine(x2);
+
+	// Quadrants 1 and 3 swap sine and cosine, sine is negated in 2 and 3, and cosine in 1 and 2.
+	// Worked out with bits rather than a switch, since the quadrant is close to random
+	const int wrapped = (int)quadrant & 3;
+	*sine = (wrapped & 1 ? c : s) * (GLfloat)(1 - (wrapped & 2));
+	*cosine = (wrapped & 1 ? s : c) * (GLfloat)(1 - ((wrapped + 1) & 2));
+}
+
+// Calculates the sine and cosine of an angle in degrees by interpolating the lookup tables
+VEC_INLINE void angleSinCosTable(GLfloat degree, GLfloat* sine, GLfloat* cosine) {
+	const GLfloat position = angleWrap(degree) * (ANGLE_TABLE_SIZE / 360.0f);
+	const int index = (int)position;
+	const GLfloat t = position - index;
+	*sine = angleSineTable[index] + (angleSineTable[index + 1] - angleSineTable[index]) * t;
+	*cosine = angleCosineTable[index] + (angleCosineTable[index + 1] - angleCosineTable[index]) * t;
+}
+
+// Calculates the sine and cosine of an angle in degrees, the way set by angleSetMode
+VEC_INLINE void angleSinCos(GLfloat degree, GLfloat* sine, GLfloat* cosine) {
+	switch (angleMode) {
+	case ANGLE_POLYNOMIAL: angleSinCosPolynomial(degree, sine, cosine); break;
+	case ANGLE_TABLE: angleSinCosTable(degree, sine, cosine); break;
+	default: sinCos(degree, sine, cosine); break;
+	}
+}
+
+// Calculates the sines and cosines of an array of angles in degrees, the way set by angleSetMode
+VEC_INLINE void angleSinCosBatch(const GLfloat* degrees, GLfloat* sines, GLfloat* cosines, unsigned int count) {
+	switch (angleMode) {
+	case ANGLE_POLYNOMIAL:
+		sinCosBatch(degrees, sines, cosines, count);
+		break;
+	case ANGLE_TABLE:
+		for (unsigned int i = 0; i < count; ++i) {
+			angleSinCosTable(degrees[i], &sines[i], &cosines[i]);
+		}
+		break;
+	default:
+		for (unsigned int i = 0; i < count; ++i) {
+			sinCos(degrees[i], &sines[i], &cosines[i]);
+		}
+		break;
+	}
+}
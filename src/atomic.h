@@ -0,0 +1,103 @@
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+/*
+ * <atomic.h> Header only atomic operations on ints and 64 bit integers, over the Interlocked functions
+ * on MSVC (which has no C11 atomics) and the __atomic builtins everywhere else. Every operation is
+ * sequentially consistent, so a store here also publishes every write made before it to whichever
+ * thread loads the value
+ */
+
+#ifdef _MSC_VER
+#define ATOMIC_INLINE static __inline
+#else
+#define ATOMIC_INLINE static inline
+#endif
+
+ATOMIC_INLINE int atomicLoad(volatile int* target) {
+#ifdef _WIN32
+	return InterlockedCompareExchange((volatile LONG*)target, 0, 0);
+#else
+	return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+#endif
+}
+
+ATOMIC_INLINE void atomicStore(volatile int* target, int value) {
+#ifdef _WIN32
+	InterlockedExchange((volatile LONG*)target, value);
+#else
+	__atomic_store_n(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Stores a value, returning the one it replaced
+ATOMIC_INLINE int atomicExchange(volatile int* target, int value) {
+#ifdef _WIN32
+	return InterlockedExchange((volatile LONG*)target, value);
+#else
+	return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Adds to a value, returning what it was before
+ATOMIC_INLINE int atomicAdd(volatile int* target, int value) {
+#ifdef _WIN32
+	return InterlockedExchangeAdd((volatile LONG*)target, value);
+#else
+	return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Stores desired if the value is still expected, returning whether it was
+ATOMIC_INLINE int atomicCompareExchange(volatile int* target, int expected, int desired) {
+#ifdef _WIN32
+	return InterlockedCompareExchange((volatile LONG*)target, desired, expected) == expected;
+#else
+	return __atomic_compare_exchange_n(target, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+ATOMIC_INLINE long long atomicLoad64(volatile long long* target) {
+#ifdef _WIN32
+	return InterlockedCompareExchange64(target, 0, 0);
+#else
+	return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+#endif
+}
+
+ATOMIC_INLINE void atomicStore64(volatile long long* target, long long value) {
+#ifdef _WIN32
+	InterlockedExchange64(target, value);
+#else
+	__atomic_store_n(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Adds to a value, returning what it was before
+ATOMIC_INLINE long long atomicAdd64(volatile long long* target, long long value) {
+#ifdef _WIN32
+	return InterlockedExchangeAdd64(target, value);
+#else
+	return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Stores a value, returning the one it replaced
+ATOMIC_INLINE long long atomicExchange64(volatile long long* target, long long value) {
+#ifdef _WIN32
+	return InterlockedExchange64(target, value);
+#else
+	return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Stores desired if the value is still expected, returning whether it was
+ATOMIC_INLINE int atomicCompareExchange64(volatile long long* target, long long expected, long long desired) {
+#ifdef _WIN32
+	return InterlockedCompareExchange64(target, desired, expected) == expected;
+#else
+	return __atomic_compare_exchange_n(target, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
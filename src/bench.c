@@ -0,0 +1,1476 @@
+#include "bench.h"
+#include "main.h"
+
+// The scene the passes benchmark draws, set up by init() as it would be for the window
+extern Helicopter helicopter;
+extern TreeObject trees[TREES_LENGTH];
+extern const RenderMaterial groundMaterial, waterMaterial;
+extern SnapshotBuffer snapshots;
+extern SceneSnapshot* scene;
+
+typedef struct BENCHMARK {
+	char* name;
+	void (*run)(void);
+} Benchmark;
+
+const Benchmark benchmarks[] = {
+	{ "collision", benchCollision },
+	{ "swarm", benchSwarm },
+	{ "bvh", benchBvh },
+	{ "vecmath", benchVecmath },
+	{ "trig", benchTrig },
+	{ "ground", benchGround },
+	{ "water", benchWater },
+	{ "terrain", benchTerrain },
+	{ "sky", benchSky },
+	{ "passes", benchPasses },
+	{ "meshes", benchMeshes },
+	{ "jobs", benchJobs },
+	{ "cull", benchCull },
+	{ "text", benchText },
+	{ "input", benchInput },
+	{ "alloc", benchAlloc },
+	{ "assets", benchAssets },
+};
+
+unsigned int benchFailures = 0;
+
+void benchFail(const char* format, ...) {
+	va_list arguments;
+	va_start(arguments, format);
+	printf("FAILED: ");
+	vprintf(format, arguments);
+	printf("\n");
+	va_end(arguments);
+	++benchFailures;
+}
+
+bool benchRun(char* name) {
+	bool found = FALSE;
+
+	for (unsigned int i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); ++i) {
+		if (!strcmp(name, "all") || !strcmp(name, benchmarks[i].name)) {
+			printf("-- %s --\n", benchmarks[i].name);
+			benchmarks[i].run();
+			found = TRUE;
+		}
+	}
+
+	if (!found) {
+		printf("Unknown benchmark '%s'\n", name);
+	}
+	return found && benchFailures == 0;
+}
+
+void benchCreateWindow(void) {
+	static bool created = FALSE;
+	int argc = 1;
+	char* argv[] = { "bench", NULL };
+
+	if (created) {
+		return;
+	}
+
+	glutInit(&argc, argv);
+	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH | GLUT_STENCIL);
+	glutInitWindowSize(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+	glutCreateWindow("Benchmark");
+	glprocLoad();
+	reshape(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+	textEnabled = textInit();
+	created = TRUE;
+}
+
+double benchSeconds(void) {
+	struct timespec time;
+	timespec_get(&time, TIME_UTC);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+void benchCollision(void) {
+	static TreeObject trees[TREES_LENGTH];
+	static Vec3 starts[BENCH_COLLISION_MOVES];
+	static Vec3 directions[BENCH_COLLISION_MOVES];
+	static bool sweeps[BENCH_COLLISION_MOVES], substepped[BENCH_COLLISION_MOVES];
+	const GLfloat speeds[] = { 0.25, 1, 4, 16 };
+
+	Helicopter helicopter = { 0 };
+	generateTrees(trees);
+	srand(1);
+
+	// Random starting points that are clear of the trees, heading in random directions
+	for (unsigned int i = 0; i < BENCH_COLLISION_MOVES; ++i) {
+		do {
+			starts[i] = (Vec3) { offsetRand(HELI_MAP_RADIUS * 2), 1 + ((GLfloat)rand() / RAND_MAX) * 27, offsetRand(HELI_MAP_RADIUS * 2) };
+		} while (helicopterCollision(&helicopter, starts[i], trees));
+
+		directions[i] = rotateVectorXZ((Vec3) { 1, offsetRand(0.2), 0 }, (GLfloat)rand() / RAND_MAX * 360);
+	}
+
+	for (unsigned int s = 0; s < sizeof(speeds) / sizeof(speeds[0]); ++s) {
+		const unsigned int substeps = (unsigned int)ceil(speeds[s] / BENCH_SUBSTEP_LENGTH);
+		unsigned int sweepHits = 0, substepHits = 0, endPointMisses = 0, sweepMisses = 0;
+
+		double time = benchSeconds();
+		for (unsigned int i = 0; i < BENCH_COLLISION_MOVES; ++i) {
+			sweeps[i] = helicopterSweep(starts[i], vec3Scale(directions[i], speeds[s]), trees, NULL).hit;
+			sweepHits += sweeps[i];
+		}
+		const double sweepTime = benchSeconds() - time;
+
+		time = benchSeconds();
+		for (unsigned int i = 0; i < BENCH_COLLISION_MOVES; ++i) {
+			substepped[i] = FALSE;
+			for (unsigned int j = 1; j <= substeps; ++j) {
+				const Vec3 position = vec3Add(starts[i], vec3Scale(directions[i], speeds[s] * j / substeps));
+				if (helicopterCollision(&helicopter, position, trees)) {
+					substepped[i] = TRUE;
+					++substepHits;
+					break;
+				}
+			}
+		}
+		const double substepTime = benchSeconds() - time;
+
+		// A move the substeps caught passing through a tree has to be caught by the sweep too, while the end
+		// point alone misses every move that tunnels straight through one
+		for (unsigned int i = 0; i < BENCH_COLLISION_MOVES; ++i) {
+			const bool endPoint = helicopterCollision(&helicopter, vec3Add(starts[i], vec3Scale(directions[i], speeds[s])), trees);
+			endPointMisses += sweeps[i] && !endPoint;
+			sweepMisses += substepped[i] && !sweeps[i];
+		}
+
+		printf("speed %5.2f | sweep %8.1f ns/move, %5u hits | %3u substeps %9.1f ns/move, %5u hits | end point only misses %u\n",
+			speeds[s],
+			sweepTime * 1e9 / BENCH_COLLISION_MOVES, sweepHits,
+			substeps, substepTime * 1e9 / BENCH_COLLISION_MOVES, substepHits,
+			endPointMisses);
+		if (sweepMisses > 0) {
+			benchFail("the sweep missed %u moves the substeps hit at speed %.2f", sweepMisses, speeds[s]);
+		}
+	}
+}
+
+void benchSwarm(void) {
+	static TreeObject trees[TREES_LENGTH];
+	const unsigned int cores = threadCoreCount(), workers = jobWorkerCount();
+	double singleThreadRate = 0;
+
+	generateTrees(trees);
+	printf("%u drones, %u ticks, %u cores\n", BENCH_SWARM_DRONES, BENCH_SWARM_TICKS, cores);
+
+	// The scheduler is restarted with each number of threads, the calling thread being one of them
+	for (unsigned int threads = 1; threads <= cores * 2 && threads <= JOB_MAX_THREADS / 2; threads *= 2) {
+		jobShutdown();
+		jobInit(threads - 1);
+		srand(1);
+		Swarm* swarm = swarmCreate(BENCH_SWARM_DRONES, trees);
+
+		const double start = benchSeconds();
+		swarmAdvance(swarm, BENCH_SWARM_TICKS, 1 / 60.0f);
+		const double rate = (double)BENCH_SWARM_DRONES * BENCH_SWARM_TICKS / (benchSeconds() - start);
+
+		if (threads == 1) { singleThreadRate = rate; }
+		printf("%3u threads | %12.0f drone-ticks/sec | %5.2fx\n", threads, rate, rate / singleThreadRate);
+		swarmFree(swarm);
+	}
+
+	jobShutdown();
+	jobInit(workers);
+}
+
+void benchBvh(void) {
+	static TreeObject trees[TREES_LENGTH];
+	const unsigned int queries = BENCH_BVH_QUERIES;
+	Vec3* origins = malloc(sizeof(Vec3) * queries);
+	Vec3* directions = malloc(sizeof(Vec3) * queries);
+	BvhHit* hits = malloc(sizeof(BvhHit) * queries);
+	unsigned int nearestIndices[BENCH_BVH_NEAREST];
+	GLfloat nearestDistances[BENCH_BVH_NEAREST];
+
+	generateTrees(trees);
+	srand(1);
+
+	double start = benchSeconds();
+	Bvh* bvh = bvhBuild(trees, TREES_LENGTH);
+	printf("build %.3f ms, %u nodes, %u levels deep\n", (benchSeconds() - start) * 1000, bvh->nodeCount, bvh->depth);
+
+	// Rays in packets of BVH_PACKET_SIZE share an origin and fan out slightly, like rays from a camera
+	for (unsigned int i = 0; i < queries; ++i) {
+		if (i % BVH_PACKET_SIZE == 0) {
+			origins[i] = (Vec3) { offsetRand(HELI_MAP_RADIUS * 2), 1 + ((GLfloat)rand() / RAND_MAX) * 27, offsetRand(HELI_MAP_RADIUS * 2) };
+			directions[i] = rotateVectorXZ((Vec3) { BENCH_BVH_RAY_LENGTH, offsetRand(20), 0 }, (GLfloat)rand() / RAND_MAX * 360);
+		} else {
+			origins[i] = origins[i - 1];
+			directions[i] = rotateVectorXZ(directions[i - 1], 0.5);
+		}
+	}
+
+	// Check the hierarchy agrees with testing every tree
+	unsigned int mismatches = 0, bruteHits = 0;
+	for (unsigned int i = 0; i < queries; i += 97) {
+		BvhHit hit, bruteHit = { 0, 1 };
+		bool bruteFound = FALSE;
+		for (unsigned int t = 0; t < TREES_LENGTH; ++t) {
+			bruteFound = bvhRaycastTree(&trees[t], origins[i], directions[i], bruteHit.time, &bruteHit) || bruteFound;
+		}
+		const bool found = bvhRaycast(bvh, origins[i], directions[i], 1, &hit);
+		bruteHits += bruteFound;
+		mismatches += found != bruteFound || (found && fabs(hit.time - bruteHit.time) > 1e-5);
+	}
+	printf("validation | %u of %u rays hit, %u mismatches\n", bruteHits, queries / 97 + 1, mismatches);
+	if (mismatches > 0) {
+		benchFail("the BVH's raycasts disagreed with testing every tree %u times", mismatches);
+	}
+
+	// The packets, segments and nearest trees are checked against testing every tree too
+	bvhRaycastPacket(bvh, origins, directions, 1, queries, hits);
+	unsigned int packetMismatches = 0, segmentMismatches = 0, nearestMismatches = 0;
+	for (unsigned int i = 0; i < queries; i += 97) {
+		BvhHit bruteHit = { 0, 1 };
+		bool bruteFound = FALSE;
+		for (unsigned int t = 0; t < TREES_LENGTH; ++t) {
+			bruteFound = bvhRaycastTree(&trees[t], origins[i], directions[i], bruteHit.time, &bruteHit) || bruteFound;
+		}
+		packetMismatches += (hits[i].time >= 0) != bruteFound || (bruteFound && fabs(hits[i].time - bruteHit.time) > 1e-5);
+		segmentMismatches += bvhSegmentIntersects(bvh, origins[i], vec3Add(origins[i], directions[i])) != bruteFound;
+
+		// The k nearest by testing every tree, kept sorted closest first
+		GLfloat bruteDistances[BENCH_BVH_NEAREST];
+		unsigned int bruteCount = 0;
+		for (unsigned int t = 0; t < TREES_LENGTH; ++t) {
+			const GLfloat distance = sqrt(pow(origins[i].x - trees[t].position.x, 2) + pow(origins[i].z - trees[t].position.y, 2));
+			if (bruteCount == BENCH_BVH_NEAREST && distance >= bruteDistances[BENCH_BVH_NEAREST - 1]) {
+				continue;
+			}
+			unsigned int slot = bruteCount < BENCH_BVH_NEAREST ? bruteCount++ : BENCH_BVH_NEAREST - 1;
+			while (slot > 0 && bruteDistances[slot - 1] > distance) {
+				bruteDistances[slot] = bruteDistances[slot - 1];
+				--slot;
+			}
+			bruteDistances[slot] = distance;
+		}
+		const unsigned int found = bvhNearest(bvh, origins[i], BENCH_BVH_NEAREST, nearestIndices, nearestDistances);
+		bool nearestMatches = found == bruteCount;
+		for (unsigned int k = 0; nearestMatches && k < found; ++k) {
+			nearestMatches = fabs(nearestDistances[k] - bruteDistances[k]) <= 1e-4;
+		}
+		nearestMismatches += !nearestMatches;
+	}
+	printf("validation | packet %u, segment %u, %u-nearest %u mismatches\n", packetMismatches, segmentMismatches,
+		BENCH_BVH_NEAREST, nearestMismatches);
+	if (packetMismatches + segmentMismatches + nearestMismatches > 0) {
+		benchFail("the BVH's packet, segment and nearest queries disagreed with testing every tree %u, %u and %u times",
+			packetMismatches, segmentMismatches, nearestMismatches);
+	}
+
+	unsigned int hitCount = 0;
+	start = benchSeconds();
+	for (unsigned int i = 0; i < queries; ++i) {
+		BvhHit hit;
+		hitCount += bvhRaycast(bvh, origins[i], directions[i], 1, &hit);
+	}
+	printf("raycast    | %10.0f queries/sec, %u hits\n", queries / (benchSeconds() - start), hitCount);
+
+	hitCount = 0;
+	start = benchSeconds();
+	bvhRaycastPacket(bvh, origins, directions, 1, queries, hits);
+	for (unsigned int i = 0; i < queries; ++i) {
+		hitCount += hits[i].time >= 0;
+	}
+	printf("packet     | %10.0f queries/sec, %u hits\n", queries / (benchSeconds() - start), hitCount);
+
+	hitCount = 0;
+	start = benchSeconds();
+	for (unsigned int i = 0; i < queries; ++i) {
+		hitCount += bvhSegmentIntersects(bvh, origins[i], vec3Add(origins[i], directions[i]));
+	}
+	printf("segment    | %10.0f queries/sec, %u hits\n", queries / (benchSeconds() - start), hitCount);
+
+	start = benchSeconds();
+	for (unsigned int i = 0; i < queries; ++i) {
+		bvhNearest(bvh, origins[i], BENCH_BVH_NEAREST, nearestIndices, nearestDistances);
+	}
+	printf("%u-nearest  | %10.0f queries/sec\n", BENCH_BVH_NEAREST, queries / (benchSeconds() - start));
+
+	bvhFree(bvh);
+	free(origins);
+	free(directions);
+	free(hits);
+}
+
+// The original implementations of rotateVectorXZ and vec3XZMagnitude, kept to compare against
+Vec3 benchOriginalRotateVectorXZ(Vec3 vector, GLfloat angle) {
+	const double theta = angle * (3.141592653 / 180.0);
+	return (Vec3) {
+		vector.x * cos(theta) - vector.z * sin(theta),
+		vector.y,
+		vector.x * sin(theta) + vector.z * cos(theta)
+	};
+}
+
+GLfloat benchOriginalXZMagnitude(Vec3 vector) {
+	return sqrt(pow(fabs(vector.x), 2) + pow(fabs(vector.z), 2));
+}
+
+// Prints the time per element of a benchmark pass, with a checksum so the work can't be optimised away
+void benchVecmathReport(char* name, double seconds, double checksum) {
+	printf("%-28s | %6.2f ns/vector (checksum %g)\n", name, seconds * 1e9 / ((double)BENCH_VECMATH_COUNT * BENCH_VECMATH_PASSES), checksum);
+}
+
+// Checks a batch function's results against the scalar function's, failing the benchmark on any that differ
+void benchVecmathCheck(char* name, const GLfloat* results, const GLfloat* expected, unsigned int count) {
+	unsigned int mismatches = 0;
+	for (unsigned int i = 0; i < count; ++i) {
+		mismatches += fabs(results[i] - expected[i]) > BENCH_VECMATH_TOLERANCE;
+	}
+	if (mismatches > 0) {
+		benchFail("%s differed from the scalar results %u times", name, mismatches);
+	}
+}
+
+void benchVecmath(void) {
+	const unsigned int count = BENCH_VECMATH_COUNT;
+	GLfloat* x = malloc(sizeof(GLfloat) * count), * z = malloc(sizeof(GLfloat) * count);
+	GLfloat* expectedX = malloc(sizeof(GLfloat) * count), * expectedZ = malloc(sizeof(GLfloat) * count);
+	GLfloat* angles = malloc(sizeof(GLfloat) * count), * results = malloc(sizeof(GLfloat) * count);
+	GLfloat* sines = malloc(sizeof(GLfloat) * count), * cosines = malloc(sizeof(GLfloat) * count);
+	Vec3* vectors = malloc(sizeof(Vec3) * count);
+	double checksum, start, seconds;
+
+	srand(1);
+	for (unsigned int i = 0; i < count; ++i) {
+		vectors[i] = (Vec3) { offsetRand(2), offsetRand(2), offsetRand(2) };
+		angles[i] = (GLfloat)rand() / RAND_MAX * 360;
+	}
+
+	// Every version does the same work a pass, and sums every result into the checksum, so the
+	// checksums of the versions of a function should agree
+	checksum = 0;
+	start = benchSeconds();
+	for (unsigned int pass = 0; pass < BENCH_VECMATH_PASSES; ++pass) {
+		for (unsigned int i = 0; i < count; ++i) {
+			const Vec3 rotated = benchOriginalRotateVectorXZ(vectors[i], angles[i]);
+			checksum += rotated.x + rotated.z;
+		}
+	}
+	benchVecmathReport("rotate, original", benchSeconds() - start, checksum);
+
+	checksum = 0;
+	start = benchSeconds();
+	for (unsigned int pass = 0; pass < BENCH_VECMATH_PASSES; ++pass) {
+		for (unsigned int i = 0; i < count; ++i) {
+			const Vec3 rotated = rotateVectorXZ(vectors[i], angles[i]);
+			checksum += rotated.x + rotated.z;
+		}
+	}
+	benchVecmathReport("rotate, scalar", benchSeconds() - start, checksum);
+
+	// The batch rotates in place, so the vectors are copied back in before each pass, outside the timing
+	checksum = 0;
+	seconds = 0;
+	for (unsigned int pass = 0; pass < BENCH_VECMATH_PASSES; ++pass) {
+		for (unsigned int i = 0; i < count; ++i) {
+			x[i] = vectors[i].x;
+			z[i] = vectors[i].z;
+		}
+		start = benchSeconds();
+		sinCosBatch(angles, sines, cosines, count);
+		rotateXZBatch(x, z, sines, cosines, count);
+		for (unsigned int i = 0; i < count; ++i) {
+			checksum += x[i] + z[i];
+		}
+		seconds += benchSeconds() - start;
+	}
+	benchVecmathReport("rotate, batch", seconds, checksum);
+
+	for (unsigned int i = 0; i < count; ++i) {
+		const Vec3 rotated = rotateVectorXZ(vectors[i], angles[i]);
+		expectedX[i] = rotated.x;
+		expectedZ[i] = rotated.z;
+	}
+	benchVecmathCheck("rotateXZBatch's x", x, expectedX, count);
+	benchVecmathCheck("rotateXZBatch's z", z, expectedZ, count);
+
+	checksum = 0;
+	start = benchSeconds();
+	for (unsigned int pass = 0; pass < BENCH_VECMATH_PASSES; ++pass) {
+		for (unsigned int i = 0; i < count; ++i) {
+			checksum += benchOriginalXZMagnitude(vectors[i]);
+		}
+	}
+	benchVecmathReport("XZ magnitude, original", benchSeconds() - start, checksum);
+
+	checksum = 0;
+	start = benchSeconds();
+	for (unsigned int pass = 0; pass < BENCH_VECMATH_PASSES; ++pass) {
+		for (unsigned int i = 0; i < count; ++i) {
+			checksum += vec3XZMagnitude(vectors[i]);
+		}
+	}
+	benchVecmathReport("XZ magnitude, scalar", benchSeconds() - start, checksum);
+
+	for (unsigned int i = 0; i < count; ++i) {
+		x[i] = vectors[i].x;
+		z[i] = vectors[i].z;
+	}
+	checksum = 0;
+	start = benchSeconds();
+	for (unsigned int pass = 0; pass < BENCH_VECMATH_PASSES; ++pass) {
+		distanceXZBatch(x, z, 0, 0, results, count);
+		for (unsigned int i = 0; i < count; ++i) {
+			checksum += results[i];
+		}
+	}
+	benchVecmathReport("XZ distance, batch", benchSeconds() - start, checksum);
+
+	for (unsigned int i = 0; i < count; ++i) {
+		expectedX[i] = vec3XZMagnitude(vectors[i]);
+	}
+	benchVecmathCheck("distanceXZBatch", results, expectedX, count);
+
+	// Each value is interpolated towards its z, into the results for the scalar version and in place,
+	// from a fresh copy each pass, for the batch
+	checksum = 0;
+	start = benchSeconds();
+	for (unsigned int pass = 0; pass < BENCH_VECMATH_PASSES; ++pass) {
+		for (unsigned int i = 0; i < count; ++i) {
+			results[i] = lerp(vectors[i].x, vectors[i].z, 0.15f);
+			checksum += results[i];
+		}
+	}
+	benchVecmathReport("lerp, scalar", benchSeconds() - start, checksum);
+
+	checksum = 0;
+	seconds = 0;
+	for (unsigned int pass = 0; pass < BENCH_VECMATH_PASSES; ++pass) {
+		for (unsigned int i = 0; i < count; ++i) {
+			x[i] = vectors[i].x;
+		}
+		start = benchSeconds();
+		lerpBatch(x, z, 0.15f, count);
+		for (unsigned int i = 0; i < count; ++i) {
+			checksum += x[i];
+		}
+		seconds += benchSeconds() - start;
+	}
+	benchVecmathReport("lerp, batch", seconds, checksum);
+	benchVecmathCheck("lerpBatch", x, results, count);
+
+	free(x);
+	free(z);
+	free(expectedX);
+	free(expectedZ);
+	free(angles);
+	free(results);
+	free(sines);
+	free(cosines);
+	free(vectors);
+}
+
+void benchTrig(void) {
+	static GLfloat degrees[BENCH_TRIG_BLOCK], sines[BENCH_TRIG_BLOCK], cosines[BENCH_TRIG_BLOCK];
+	const GLfloat wrapTests[] = { -720.5f, -360, -359.9f, -90, -0.001f, 0, 90, 359.999f, 360, 361, 1080.25f };
+	double polynomialError = 0, tableError = 0, polynomialErrorAt = 0, tableErrorAt = 0;
+	unsigned int batchMismatches = 0, wrapFailures = 0, count = 0;
+	GLfloat begin = 1, end = 360;
+	unsigned int beginBits, endBits;
+
+	angleInitTables();
+
+	for (unsigned int i = 0; i < sizeof(wrapTests) / sizeof(wrapTests[0]); ++i) {
+		const GLfloat wrapped = angleWrap(wrapTests[i]);
+		const double turns = (wrapTests[i] - wrapped) / 360.0;
+		if (wrapped < 0 || wrapped >= 360 || fabs(turns - floor(turns + 0.5)) > 1e-4) {
+			printf("angleWrap(%g) = %g\n", wrapTests[i], wrapped);
+			++wrapFailures;
+		}
+	}
+	printf("angleWrap  | %u failures\n", wrapFailures);
+	if (wrapFailures > 0) {
+		benchFail("angleWrap wrapped %u angles wrongly", wrapFailures);
+	}
+
+	// Every float from 1 up to 360 degrees, in order of their bit patterns. Below one degree
+	// both approximations are within a couple of ulps, so it would only cost time.
+	memcpy(&beginBits, &begin, sizeof(beginBits));
+	memcpy(&endBits, &end, sizeof(endBits));
+	for (unsigned int bits = beginBits; bits < endBits; ) {
+		unsigned int blockSize = 0;
+		for (; blockSize < BENCH_TRIG_BLOCK && bits < endBits; ++blockSize, ++bits) {
+			memcpy(&degrees[blockSize], &bits, sizeof(GLfloat));
+		}
+
+		sinCosBatch(degrees, sines, cosines, blockSize);
+
+		for (unsigned int i = 0; i < blockSize; ++i) {
+			const double theta = degrees[i] * (3.14159265358979323846 / 180.0);
+			const double sine = sin(theta), cosine = cos(theta);
+			GLfloat s, c;
+
+			angleSinCosPolynomial(degrees[i], &s, &c);
+			batchMismatches += s != sines[i] || c != cosines[i];
+			const double error = fmax(fabs(s - sine), fabs(c - cosine));
+			if (error > polynomialError) { polynomialError = error; polynomialErrorAt = degrees[i]; }
+
+			angleSinCosTable(degrees[i], &s, &c);
+			const double lookupError = fmax(fabs(s - sine), fabs(c - cosine));
+			if (lookupError > tableError) { tableError = lookupError; tableErrorAt = degrees[i]; }
+		}
+		count += blockSize;
+	}
+
+	printf("polynomial | max error %.3g at %.9g degrees over %u angles, %u batch mismatches\n", polynomialError, polynomialErrorAt, count, batchMismatches);
+	printf("table      | max error %.3g at %.9g degrees over %u angles\n", tableError, tableErrorAt, count);
+	if (polynomialError > ANGLE_POLYNOMIAL_MAX_ERROR) {
+		benchFail("the polynomial's error of %.3g is over its bound of %.3g", polynomialError, ANGLE_POLYNOMIAL_MAX_ERROR);
+	}
+	if (batchMismatches > 0) {
+		benchFail("the batched polynomial disagreed with the scalar one %u times", batchMismatches);
+	}
+	if (tableError > ANGLE_TABLE_MAX_ERROR) {
+		benchFail("the table's error of %.3g is over its bound of %.3g", tableError, ANGLE_TABLE_MAX_ERROR);
+	}
+
+	// Throughput, over a spread of angles the simulation would see
+	srand(1);
+	for (unsigned int i = 0; i < BENCH_TRIG_BLOCK; ++i) {
+		degrees[i] = (GLfloat)rand() / RAND_MAX * 720 - 360;
+	}
+
+	const AngleMode modes[] = { ANGLE_PRECISE, ANGLE_POLYNOMIAL, ANGLE_TABLE };
+	const char* modeNames[] = { "precise", "polynomial", "table" };
+	for (unsigned int m = 0; m < 3; ++m) {
+		double checksum = 0;
+		angleSetMode(modes[m]);
+
+		double start = benchSeconds();
+		for (unsigned int pass = 0; pass < 2000; ++pass) {
+			for (unsigned int i = 0; i < BENCH_TRIG_BLOCK; ++i) {
+				GLfloat s, c;
+				angleSinCos(degrees[i], &s, &c);
+				checksum += s + c;
+			}
+		}
+		const double scalarTime = benchSeconds() - start;
+
+		start = benchSeconds();
+		for (unsigned int pass = 0; pass < 2000; ++pass) {
+			angleSinCosBatch(degrees, sines, cosines, BENCH_TRIG_BLOCK);
+			checksum += sines[pass] + cosines[pass];
+		}
+		const double batchTime = benchSeconds() - start;
+
+		printf("%-10s | %6.2f ns/angle, %6.2f ns/angle batched (checksum %g)\n", modeNames[m],
+			scalarTime * 1e9 / (2000.0 * BENCH_TRIG_BLOCK), batchTime * 1e9 / (2000.0 * BENCH_TRIG_BLOCK), checksum);
+	}
+	angleSetMode(ANGLE_PRECISE);
+}
+
+void benchOriginalDrawGround(void) {
+	const GLfloat spacing = 5;
+
+	glBegin(GL_QUADS);
+	for (GLfloat x = -250; x <= 250; x += spacing) {
+		for (GLfloat z = -250; z <= 250; z += spacing) {
+			if (x < 40 && x > -40 && z < 40 && z > -40) {
+				continue;
+			}
+
+			glVertex3d(x, 0, z);
+			glNormal3d(0, 1, 0);
+			glTexCoord2f(0, 0);
+
+			glVertex3d(x + spacing, 0, z);
+			glNormal3d(0, 1, 0);
+			glTexCoord2f(1, 0);
+
+			glVertex3d(x + spacing, 0, z + spacing);
+			glNormal3d(0, 1, 0);
+			glTexCoord2f(1, 1);
+
+			glVertex3d(x, 0, z + spacing);
+			glNormal3d(0, 1, 0);
+			glTexCoord2f(0, 1);
+		}
+	}
+	glEnd();
+}
+
+void benchGroundFrame(VertexBuffer* buffer) {
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glLoadIdentity();
+	gluLookAt(-110, 6, 0, -100, 3, 0, 0, 1, 0);
+
+	if (buffer == NULL) {
+		benchOriginalDrawGround();
+	} else {
+		vertexBufferDraw(buffer);
+	}
+	glFinish();
+}
+
+void benchGround(void) {
+	benchCreateWindow();
+	printf("%s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+	const bool hasBuffers = glprocHasBuffers();
+	VertexBuffer* objectBuffer = groundGenerate();
+
+	// Build a second copy with the buffer object functions hidden, so it falls back to client arrays
+	const GlGenBuffersProc genBuffers = glprocGenBuffers;
+	glprocGenBuffers = NULL;
+	VertexBuffer* clientBuffer = groundGenerate();
+	glprocGenBuffers = genBuffers;
+
+	const char* names[] = { "immediate", "client arrays", hasBuffers ? "buffer objects" : "buffer objects (unsupported, client arrays)" };
+	VertexBuffer* buffers[] = { NULL, clientBuffer, objectBuffer };
+	unsigned int quads = 0;
+	for (unsigned int i = 0; i < GROUND_TILES * GROUND_TILES; ++i) {
+		quads += !groundTileCut(i % GROUND_TILES, i / GROUND_TILES);
+	}
+	printf("%u quads (%u immediate mode vertices) now %u shared vertices and %u strip indices\n",
+		quads, quads * 4, objectBuffer->vertexCount, objectBuffer->indexCount);
+
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_LIGHTING);
+	glEnable(GL_LIGHT0);
+	glEnable(GL_NORMALIZE);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, loadPPM("ground_color.PPM"));
+
+	// Full size the frame time is mostly filling pixels, so it's repeated with a tiny viewport to
+	// show what it costs to get the ground to the rasterizer
+	const int viewportSizes[][2] = { { DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT }, { 64, 64 } };
+	for (unsigned int size = 0; size < 2; ++size) {
+		glViewport(0, 0, viewportSizes[size][0], viewportSizes[size][1]);
+
+		for (unsigned int method = 0; method < 3; ++method) {
+			// One untimed frame first, so any uploads the driver defers don't count
+			benchGroundFrame(buffers[method]);
+
+			const double start = benchSeconds();
+			for (unsigned int frame = 0; frame < BENCH_GROUND_FRAMES; ++frame) {
+				benchGroundFrame(buffers[method]);
+			}
+			printf("%4dx%-4d | %-14s | %8.3f ms/frame\n", viewportSizes[size][0], viewportSizes[size][1],
+				names[method], (benchSeconds() - start) * 1e3 / BENCH_GROUND_FRAMES);
+		}
+	}
+	glViewport(0, 0, DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+
+	vertexBufferFree(clientBuffer);
+	vertexBufferFree(objectBuffer);
+}
+
+void benchOriginalDrawWater(GLfloat offset, GLfloat height) {
+	const GLfloat spacing = 5;
+
+	glPushMatrix();
+	glRotatef(30, 0, 1, 0);
+	glTranslatef(offset, 0, 0);
+	glBegin(GL_QUADS);
+	for (GLfloat x = -100; x <= 100; x += spacing) {
+		for (GLfloat z = -100; z <= 100; z += spacing) {
+			glVertex3d(x, height, z);
+			glNormal3d(0, 1, 0);
+			glTexCoord2f(0, 0);
+
+			glVertex3d(x + spacing, height, z);
+			glNormal3d(0, 1, 0);
+			glTexCoord2f(1, 0);
+
+			glVertex3d(x + spacing, height, z + spacing);
+			glNormal3d(0, 1, 0);
+			glTexCoord2f(1, 1);
+
+			glVertex3d(x, height, z + spacing);
+			glNormal3d(0, 1, 0);
+			glTexCoord2f(0, 1);
+		}
+	}
+	glEnd();
+	glPopMatrix();
+}
+
+void benchWater(void) {
+	const char* names[] = { "immediate", "static buffer", "waves" };
+	benchCreateWindow();
+	Water* still = waterCreate(FALSE);
+	Water* waves = waterCreate(TRUE);
+
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_LIGHTING);
+	glEnable(GL_LIGHT0);
+	glEnable(GL_NORMALIZE);
+	glViewport(0, 0, 64, 64);
+
+	// A small viewport, so what's measured is getting the water to the rasterizer rather than filling it in
+	for (unsigned int method = 0; method < 3; ++method) {
+		const double start = benchSeconds();
+		for (unsigned int frame = 0; frame < BENCH_WATER_FRAMES; ++frame) {
+			const GLfloat time = frame * 0.016f;
+
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glLoadIdentity();
+			gluLookAt(0, 30, 120, 0, 0, 0, 0, 1, 0);
+
+			if (method == 0) {
+				benchOriginalDrawWater(time, sinf(time) / 8 - 1);
+			} else {
+				const Mat4 rotation = mat4Rotation(30, (Vec3) { 0, 1, 0 });
+				waterAnimate(method == 1 ? still : waves, time);
+				waterDraw(method == 1 ? still : waves, &rotation, time, sinf(time) / 8 - 1, &waterMaterial);
+			}
+			glFinish();
+		}
+		printf("%-13s | %8.3f ms/frame\n", names[method], (benchSeconds() - start) * 1e3 / BENCH_WATER_FRAMES);
+	}
+	glViewport(0, 0, DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+
+	// The wave kernel on its own, without drawing
+	const double start = benchSeconds();
+	for (unsigned int i = 0; i < BENCH_WATER_WAVES; ++i) {
+		waterAnimate(waves, i * 0.016f);
+	}
+	const double waveTime = benchSeconds() - start;
+	printf("wave kernel   | %8.2f us/frame, %6.2f ns/vertex, including the upload\n",
+		waveTime * 1e6 / BENCH_WATER_WAVES, waveTime * 1e9 / ((double)BENCH_WATER_WAVES * WATER_SIDE * WATER_SIDE));
+
+	waterFree(still);
+	waterFree(waves);
+}
+
+void benchTerrain(void) {
+	static TreeObject trees[TREES_LENGTH];
+	const Vec3 cameras[] = { { -100, 5, 0 }, { 0, 40, 0 }, { 200, 20, 200 } };
+	GLfloat* heights = terrainGenerateHeights(BENCH_TERRAIN_SIZE, 1);
+	Terrain* terrain = terrainCreate(heights, BENCH_TERRAIN_SIZE, FALSE);
+	double checksum = 0;
+
+	printf("%ux%u heightmap, %ux%u chunks, highest point %.1f\n", terrain->size, terrain->size, terrain->chunksPerSide, terrain->chunksPerSide, terrain->maxHeight);
+
+	// Random points picked beforehand, so the time is only the queries
+	static GLfloat queries[4096][2];
+	srand(1);
+	for (unsigned int i = 0; i < 4096; ++i) {
+		queries[i][0] = offsetRand(TERRAIN_SIZE / 2.0f);
+		queries[i][1] = offsetRand(TERRAIN_SIZE / 2.0f);
+	}
+
+	double start = benchSeconds();
+	for (unsigned int i = 0; i < BENCH_TERRAIN_QUERIES; ++i) {
+		checksum += terrainHeight(terrain, queries[i & 4095][0], queries[i & 4095][1]);
+	}
+	printf("height query | %6.1f ns (checksum %g)\n", (benchSeconds() - start) * 1e9 / BENCH_TERRAIN_QUERIES, checksum);
+
+	// Sweeps over the hills, with and without the terrain, to see what the floor test adds
+	generateTrees(trees);
+	for (unsigned int i = 0; i < TREES_LENGTH; ++i) {
+		trees[i].height = terrainHeight(terrain, trees[i].position.x, trees[i].position.y);
+	}
+	TreeGrid* grid = malloc(sizeof(TreeGrid));
+	treeGridBuild(grid, trees);
+
+	for (unsigned int withTerrain = 0; withTerrain < 2; ++withTerrain) {
+		unsigned int hits = 0;
+		collisionTerrain = withTerrain ? terrain : NULL;
+
+		srand(2);
+		start = benchSeconds();
+		for (unsigned int i = 0; i < BENCH_TERRAIN_QUERIES / 10; ++i) {
+			const Vec3 position = { offsetRand(HELI_MAP_RADIUS), 0, offsetRand(HELI_MAP_RADIUS) };
+			const Vec3 movement = { offsetRand(1), offsetRand(1), offsetRand(1) };
+			hits += helicopterSweep((Vec3) { position.x, helicopterFloor(position.x, position.z) + 0.5f, position.z }, movement, trees, grid).hit;
+		}
+		printf("sweep %-7s| %6.1f ns, %u hits\n", withTerrain ? "terrain" : "flat", (benchSeconds() - start) * 1e9 / (BENCH_TERRAIN_QUERIES / 10), hits);
+	}
+	collisionTerrain = NULL;
+	free(grid);
+
+	// Triangles drawn from a few places, with only the distances picking levels and then with the budget
+	const unsigned int chunkCount = terrain->chunksPerSide * terrain->chunksPerSide;
+	printf("finest level everywhere would be %u triangles\n", chunkCount * terrain->chunks[0].triangles[0]);
+	for (unsigned int i = 0; i < sizeof(cameras) / sizeof(cameras[0]); ++i) {
+		terrainSelect(terrain, cameras[i], UINT_MAX);
+		const unsigned int unlimited = terrain->drawnTriangles;
+		terrainSelect(terrain, cameras[i], TERRAIN_TRIANGLE_BUDGET);
+		printf("camera (%4.0f, %2.0f, %4.0f) | %6u triangles by distance, %6u within the budget of %u\n",
+			cameras[i].x, cameras[i].y, cameras[i].z, unlimited, terrain->drawnTriangles, TERRAIN_TRIANGLE_BUDGET);
+	}
+	terrainFree(terrain);
+
+	// Frame times with the meshes, every chunk at the finest level against the selected levels
+	benchCreateWindow();
+	terrain = terrainCreate(heights, BENCH_TERRAIN_SIZE, TRUE);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_LIGHTING);
+	glEnable(GL_LIGHT0);
+	glEnable(GL_NORMALIZE);
+	glViewport(0, 0, 64, 64);
+
+	for (unsigned int selected = 0; selected < 2; ++selected) {
+		terrainSelect(terrain, cameras[0], TERRAIN_TRIANGLE_BUDGET);
+		if (!selected) {
+			for (unsigned int i = 0; i < chunkCount; ++i) {
+				terrain->chunks[i].level = 0;
+			}
+		}
+
+		start = benchSeconds();
+		for (unsigned int frame = 0; frame < BENCH_TERRAIN_FRAMES; ++frame) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glLoadIdentity();
+			gluLookAt(cameras[0].x, cameras[0].y, cameras[0].z, 0, 0, 0, 0, 1, 0);
+			terrainDraw(terrain, &groundMaterial);
+			glFinish();
+		}
+		printf("%-14s | %8.3f ms/frame (64x64 viewport)\n", selected ? "levels" : "finest level", (benchSeconds() - start) * 1e3 / BENCH_TERRAIN_FRAMES);
+	}
+	glViewport(0, 0, DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+
+	terrainFree(terrain);
+	free(heights);
+}
+
+void benchOriginalDrawSky(GLUquadricObj* quadric, GLuint texture) {
+	glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	glMaterialfv(GL_BACK, GL_EMISSION, (GLfloat[4]) { 1, 1, 1, 1 });
+	glMaterialfv(GL_BACK, GL_DIFFUSE, (GLfloat[4]) { 1, 1, 1, 1 });
+	glMaterialfv(GL_BACK, GL_SPECULAR, (GLfloat[4]) { 1, 1, 1, 1 });
+	gluQuadricTexture(quadric, TRUE);
+
+	glPushMatrix();
+	glRotatef(90, -1, 0, 0);
+	gluSphere(quadric, 250, 20, 20);
+	glPopMatrix();
+
+	gluQuadricTexture(quadric, FALSE);
+	glDisable(GL_TEXTURE_2D);
+	glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_FALSE);
+}
+
+void benchSky(void) {
+	const char* names[] = { "gluSphere last", "dome first", "skybox first", "dome last", "skybox last" };
+
+	benchCreateWindow();
+	GLUquadricObj* quadric = gluNewQuadric();
+	const GLuint texture = loadPPM("sky_color.ppm");
+	Sky* sky = skyCreate(texture, "sky_color.ppm", TRUE);
+	VertexBuffer* ground = groundGenerate();
+
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_LIGHTING);
+	glEnable(GL_LIGHT0);
+	glEnable(GL_NORMALIZE);
+	glEnable(GL_FOG);
+	glFogf(GL_FOG_MODE, GL_EXP);
+	glFogf(GL_FOG_DENSITY, 0.005f);
+
+	// Each frame is the ground and the sky, so what's measured includes the sky's share of the overdraw
+	const int viewportSizes[][2] = { { DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT }, { 64, 64 } };
+	for (unsigned int size = 0; size < 2; ++size) {
+		glViewport(0, 0, viewportSizes[size][0], viewportSizes[size][1]);
+
+		for (unsigned int method = 0; method < 5; ++method) {
+			sky->skybox = method == 2 || method == 4;
+
+			const double start = benchSeconds();
+			for (unsigned int frame = 0; frame < BENCH_SKY_FRAMES; ++frame) {
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				glLoadIdentity();
+				gluLookAt(-110, 6, 0, -100, 5, frame * 0.1f, 0, 1, 0);
+
+				if (method == 1 || method == 2) {
+					skyDraw(sky, (Vec3) { -110, 6, 0 });
+				}
+				vertexBufferDraw(ground);
+				if (method == 0) {
+					benchOriginalDrawSky(quadric, texture);
+				} else if (method > 2) {
+					skyDraw(sky, (Vec3) { -110, 6, 0 });
+				}
+				glFinish();
+			}
+			printf("%4dx%-4d | %-14s | %8.3f ms/frame\n", viewportSizes[size][0], viewportSizes[size][1],
+				names[method], (benchSeconds() - start) * 1e3 / BENCH_SKY_FRAMES);
+		}
+	}
+	glViewport(0, 0, DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+	glDisable(GL_FOG);
+
+	vertexBufferFree(ground);
+	skyFree(sky);
+	glDeleteTextures(1, &texture);
+	gluDeleteQuadric(quadric);
+}
+
+void benchOriginalDisplayOrder(void) {
+	drawHelicopterItem(NULL, 0);
+	drawGround();
+	for (unsigned int i = 0; i < TREES_LENGTH; ++i) {
+		drawTreeItem(trees, i);
+	}
+	drawSky();
+	drawWater();
+}
+
+void benchPasses(void) {
+	const char* names[] = { "original order", "front to back", "depth pre-pass" };
+	static PassScheduler scheduler;
+
+	benchCreateWindow();
+	init();
+	initLights(FALSE);
+	helicopter.position.y = 6;
+	helicopter.startup = FALSE;
+
+	const int viewportSizes[][2] = { { DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT }, { 64, 64 } };
+	for (unsigned int size = 0; size < 2; ++size) {
+		glViewport(0, 0, viewportSizes[size][0], viewportSizes[size][1]);
+
+		for (unsigned int method = 0; method < 3; ++method) {
+			scheduler.depthPrepass = method == 2;
+			double overdraw = 0;
+
+			// Every other frame counts fragments in the stencil buffer instead of being timed, and the
+			// camera turns a full circle over the timed frames
+			double seconds = 0;
+			for (unsigned int frame = 0; frame < BENCH_PASSES_FRAMES * 2; ++frame) {
+				const bool counting = frame & 1;
+				helicopter.angle = (frame / 2) * 360.0f / BENCH_PASSES_FRAMES;
+				publishSnapshot(0);
+				scene = snapshotBufferLatest(&snapshots);
+				scheduler.overdraw = counting;
+
+				const double start = benchSeconds();
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+				const Mat4 view = helicopterCamera(&scene->helicopter);
+				glLoadMatrixf(view.m);
+				glFogf(GL_FOG_DENSITY, helicopterFogDensity(&scene->helicopter));
+
+				if (method == 0) {
+					glPushAttrib(GL_ENABLE_BIT | GL_STENCIL_BUFFER_BIT);
+					if (counting) {
+						glEnable(GL_STENCIL_TEST);
+						glStencilFunc(GL_ALWAYS, 0, 0xFF);
+						glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+					}
+					benchOriginalDisplayOrder();
+					glPopAttrib();
+				} else {
+					submitScene(&scheduler);
+					passExecute(&scheduler);
+				}
+
+				if (counting) {
+					unsigned int histogram[PASS_OVERDRAW_LEVELS + 1];
+					overdraw += passReadOverdraw(histogram);
+					frameReset();
+				} else {
+					glFinish();
+					seconds += benchSeconds() - start;
+				}
+			}
+
+			printf("%4dx%-4d | %-14s | %8.3f ms/frame | %5.2f fragments/pixel\n", viewportSizes[size][0], viewportSizes[size][1],
+				names[method], seconds * 1e3 / BENCH_PASSES_FRAMES, overdraw / BENCH_PASSES_FRAMES);
+		}
+	}
+	glViewport(0, 0, DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+}
+
+// Prints one stage of a mesh's optimisation in the meshes benchmark
+void benchMeshesReport(char* stage, Mesh* mesh) {
+	const MeshCacheStats stats = meshCacheStats(mesh, MESH_CACHE_SIZE);
+	printf("  %-13s | ACMR %.3f | ATVR %.3f | overdraw %.3f\n", stage, stats.acmr, stats.atvr,
+		meshOverdraw(mesh, MESH_OVERDRAW_RESOLUTION));
+}
+
+void benchMeshes(void) {
+	char* fileNames[] = { "plane.obj", "tree01trunk.obj", "tree01leaves.obj", "tree02trunk.obj", "tree02leaves.obj",
+		"tree03trunk.obj", "tree03leaves.obj" };
+
+	printf("FIFO cache of %u vertices\n", MESH_CACHE_SIZE);
+	for (unsigned int i = 0; i < sizeof(fileNames) / sizeof(fileNames[0]); ++i) {
+		MeshObject* object = loadMeshObject(fileNames[i]);
+		if (object == NULL) {
+			printf("Couldn't load '%s'\n", fileNames[i]);
+			continue;
+		}
+
+		Mesh* mesh = meshCreate(object);
+		printf("%s: %u triangles, %u vertices\n", fileNames[i], mesh->indexCount / 3, mesh->vertexCount);
+		benchMeshesReport("exported", mesh);
+		meshOptimizeVertexCache(mesh, MESH_CACHE_SIZE);
+		benchMeshesReport("vertex cache", mesh);
+		meshOptimizeOverdraw(mesh, MESH_CACHE_SIZE, MESH_OVERDRAW_THRESHOLD);
+		printf("  %u clusters\n", mesh->clusterCount);
+		benchMeshesReport("overdraw", mesh);
+		meshOptimizeVertexFetch(mesh);
+
+		const size_t shortIndexSize = mesh->vertexCount <= 65536 ? sizeof(GLushort) : sizeof(GLuint);
+		printf("  float   %6u bytes\n", (unsigned int)(mesh->vertexCount * sizeof(Vertex) + mesh->indexCount * sizeof(GLuint)));
+		for (VertexFormat format = VERTEX_PACKED; format <= VERTEX_COMPACT; ++format) {
+			VertexDecode decode;
+			MeshQuantizeError error;
+			allocFree(meshQuantize(mesh, format, &decode, &error));
+			printf("  %-7s %6u bytes | position error %.5f (%.4f%% of the bounds) | normal error %.3f deg"
+				" | texture coordinate error %.6f\n", format == VERTEX_PACKED ? "packed" : "compact",
+				(unsigned int)(mesh->vertexCount * vertexFormatSize(format) + mesh->indexCount * shortIndexSize), error.position,
+				error.position * 100 / (decode.positionScale * 65534), error.normal, error.texCoord);
+		}
+		meshFree(mesh);
+
+		const double start = benchSeconds();
+		for (unsigned int repeat = 0; repeat < BENCH_MESHES_REPEATS; ++repeat) {
+			mesh = meshCreate(object);
+			meshOptimize(mesh);
+			meshFree(mesh);
+		}
+		printf("  built and optimised in %.3f ms\n", (benchSeconds() - start) * 1e3 / BENCH_MESHES_REPEATS);
+		freeMeshObject(object);
+	}
+}
+
+// Job function that does nothing, for timing the scheduler's own overhead
+void benchJobsEmpty(void* data, unsigned int begin, unsigned int end) {
+}
+
+// Job function that works out a square root for each element in its range, as a fixed amount of work to split
+void benchJobsWork(void* data, unsigned int begin, unsigned int end) {
+	float* values = data;
+	for (unsigned int i = begin; i < end; ++i) {
+		float value = (float)i;
+		for (unsigned int step = 0; step < 16; ++step) {
+			value = sqrtf(value + step);
+		}
+		values[i] = value;
+	}
+}
+
+void benchJobs(void) {
+	static Job* chain[BENCH_JOBS_BATCH];
+	const unsigned int cores = threadCoreCount(), workers = jobWorkerCount();
+	float* values = malloc(BENCH_JOBS_WORK * sizeof(float));
+	double singleThreadTime = 0;
+
+	printf("%u cores, %u workers\n", cores, workers);
+
+	// Children spawned and waited on a batch at a time, so the pools never run out
+	double start = benchSeconds();
+	for (unsigned int batch = 0; batch < BENCH_JOBS_SPAWNS / BENCH_JOBS_BATCH; ++batch) {
+		Job* root = jobCreate(NULL, NULL, NULL);
+		for (unsigned int i = 0; i < BENCH_JOBS_BATCH; ++i) {
+			jobSubmit(jobCreate(benchJobsEmpty, NULL, root));
+		}
+		jobSubmit(root);
+		jobWait(root);
+	}
+	printf("spawn        | %8.1f ns/job\n", (benchSeconds() - start) * 1e9 / BENCH_JOBS_SPAWNS);
+
+	start = benchSeconds();
+	jobParallelFor(benchJobsEmpty, NULL, BENCH_JOBS_SPAWNS, 1);
+	printf("parallel for | %8.1f ns/job, split down to single elements\n", (benchSeconds() - start) * 1e9 / BENCH_JOBS_SPAWNS);
+
+	// Chains where each job depends on the one before, so they have to run one at a time
+	start = benchSeconds();
+	for (unsigned int batch = 0; batch < BENCH_JOBS_SPAWNS / BENCH_JOBS_BATCH; ++batch) {
+		for (unsigned int i = 0; i < BENCH_JOBS_BATCH; ++i) {
+			chain[i] = jobCreate(benchJobsEmpty, NULL, NULL);
+			if (i > 0) {
+				jobDepend(chain[i], chain[i - 1]);
+			}
+		}
+		for (unsigned int i = BENCH_JOBS_BATCH; i > 0; --i) {
+			jobSubmit(chain[i - 1]);
+		}
+		jobWait(chain[BENCH_JOBS_BATCH - 1]);
+	}
+	printf("dependencies | %8.1f ns/job\n", (benchSeconds() - start) * 1e9 / BENCH_JOBS_SPAWNS);
+
+	for (unsigned int threads = 1; threads <= cores * 2 && threads <= JOB_MAX_THREADS / 2; threads *= 2) {
+		jobShutdown();
+		jobInit(threads - 1);
+
+		start = benchSeconds();
+		jobParallelFor(benchJobsWork, values, BENCH_JOBS_WORK, 0);
+		const double time = benchSeconds() - start;
+
+		if (threads == 1) { singleThreadTime = time; }
+		printf("%3u threads  | %8.3f ms | %5.2fx\n", threads, time * 1e3, singleThreadTime / time);
+	}
+
+	jobShutdown();
+	jobInit(workers);
+	free(values);
+}
+
+void benchCull(void) {
+	static TreeObject sceneTrees[TREES_LENGTH];
+	TreeObject* tiled = malloc(sizeof(TreeObject) * TREES_LENGTH * BENCH_CULL_TILES);
+	const unsigned int workers = jobWorkerCount();
+	const GLfloat nearPlane = 2, farPlane = 500, focal = 1 / tan(30 * M_PI / 180);
+	GLfloat projection[16] = { 0 }, modelview[16] = { 0 };
+
+	// The same projection as reshape() sets up for the default window
+	projection[0] = focal * DEFAULT_WINDOW_HEIGHT / DEFAULT_WINDOW_WIDTH;
+	projection[5] = focal;
+	projection[10] = (farPlane + nearPlane) / (nearPlane - farPlane);
+	projection[11] = -1;
+	projection[14] = 2 * farPlane * nearPlane / (nearPlane - farPlane);
+
+	generateTrees(sceneTrees);
+	printf("%u cores, %u frames, the camera turning a full circle in the middle of the trees\n", threadCoreCount(), BENCH_CULL_FRAMES);
+
+	for (unsigned int tiles = 1; tiles <= BENCH_CULL_TILES; tiles *= 4) {
+		// The scene's trees are tiled out in a square, each copy as wide as the grid they're placed in
+		const unsigned int side = (unsigned int)sqrt(tiles), count = TREES_LENGTH * tiles;
+		for (unsigned int tile = 0; tile < tiles; ++tile) {
+			const GLfloat offsetX = ((tile % side) - (side - 1) / 2.0f) * TREE_GRID_EXTENT * 2;
+			const GLfloat offsetZ = ((tile / side) - (side - 1) / 2.0f) * TREE_GRID_EXTENT * 2;
+			for (unsigned int i = 0; i < TREES_LENGTH; ++i) {
+				tiled[tile * TREES_LENGTH + i] = sceneTrees[i];
+				tiled[tile * TREES_LENGTH + i].position.x += offsetX;
+				tiled[tile * TREES_LENGTH + i].position.y += offsetZ;
+			}
+		}
+
+		TreeCull* cull = cullCreate(tiled, count);
+		for (unsigned int model = 0; model < TREE_MODEL_COUNT; ++model) {
+			const GLfloat radius = treeCollisionProfiles[model].canopyRadius;
+			cullSetModelBounds(cull, model, (Vec3) { -radius, 0, -radius }, (Vec3) { radius, TREE_COLLISION_HEIGHT, radius });
+		}
+
+		double singleThreadTime = 0;
+		for (unsigned int threads = 1; threads <= BENCH_CULL_THREADS; threads *= 2) {
+			jobShutdown();
+			jobInit(threads - 1);
+			unsigned long long visible = 0;
+
+			const double start = benchSeconds();
+			for (unsigned int frame = 0; frame < BENCH_CULL_FRAMES; ++frame) {
+				// Looking along the ground from above it, which is gluLookAt's matrix with the up vector along y
+				const GLfloat angle = frame * 2 * M_PI / BENCH_CULL_FRAMES;
+				const Vec3 camera = { 0, 20, 0 };
+				modelview[0] = cos(angle);
+				modelview[2] = -sin(angle);
+				modelview[5] = 1;
+				modelview[8] = sin(angle);
+				modelview[10] = cos(angle);
+				modelview[12] = -(modelview[0] * camera.x + modelview[8] * camera.z);
+				modelview[13] = -camera.y;
+				modelview[14] = -(modelview[2] * camera.x + modelview[10] * camera.z);
+				modelview[15] = 1;
+
+				Frustum frustum = cullFrustumFromMatrices(projection, modelview);
+				cullTrees(cull, &frustum, camera);
+				for (unsigned int model = 0; model < TREE_MODEL_COUNT; ++model) {
+					visible += cull->instanceCounts[model];
+				}
+			}
+			const double time = (benchSeconds() - start) / BENCH_CULL_FRAMES;
+
+			if (threads == 1) { singleThreadTime = time; }
+			printf("%6u trees | %u threads | %8.4f ms/frame | %6.0f visible | %5.2fx\n", count, threads, time * 1e3,
+				(double)visible / BENCH_CULL_FRAMES, singleThreadTime / time);
+		}
+		cullFree(cull);
+	}
+
+	free(tiled);
+	jobShutdown();
+	jobInit(workers);
+}
+
+void benchOriginalDrawText(char* text, Vec2 position) {
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	gluOrtho2D(0.0, DEFAULT_WINDOW_WIDTH, 0.0, DEFAULT_WINDOW_HEIGHT);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glRasterPos2i(position.x, position.y);
+	glutBitmapString(GLUT_BITMAP_HELVETICA_18, (unsigned char*)text);
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+}
+
+void benchText(void) {
+	const char* names[] = { "glutBitmapString", "atlas" };
+	char text[128];
+
+	benchCreateWindow();
+	if (!textEnabled) {
+		printf("The font atlas couldn't be built\n");
+		return;
+	}
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glColor3f(1, 1, 1);
+
+	for (unsigned int lines = 1; lines <= BENCH_TEXT_LINES; lines *= 4) {
+		for (unsigned int method = 0; method < 2; ++method) {
+			const double start = benchSeconds();
+			for (unsigned int frame = 0; frame < BENCH_TEXT_FRAMES; ++frame) {
+				glClear(GL_COLOR_BUFFER_BIT);
+
+				// Lines like the profiler overlay's, which change every frame
+				for (unsigned int line = 0; line < lines; ++line) {
+					const Vec2 position = { DEFAULT_WINDOW_WIDTH - 520, DEFAULT_WINDOW_HEIGHT - 56 - 22 * line };
+					snprintf(text, sizeof(text), "scope %u: cpu %.2f / %.2f, gpu %.2f / %.2f", line, frame * 0.01, frame * 0.02,
+						line * 0.03, line * 0.04);
+					if (method == 0) {
+						benchOriginalDrawText(text, position);
+					} else {
+						drawText(text, position);
+					}
+				}
+				textFlush();
+				glFinish();
+			}
+			printf("%3u lines | %-16s | %8.3f ms/frame\n", lines, names[method], (benchSeconds() - start) * 1e3 / BENCH_TEXT_FRAMES);
+		}
+	}
+	glEnable(GL_DEPTH_TEST);
+}
+
+// Presses and releases the forward key with random gaps between, then sets the int it's given
+void benchInputProducer(void* data) {
+	unsigned long long next = platformNanoseconds();
+
+	srand(1);
+	for (unsigned int i = 0; i < BENCH_INPUT_EVENTS; ++i) {
+		next += (unsigned long long)(rand() % (BENCH_INPUT_MAX_GAP * 1000)) * 1000;
+		platformSleepUntil(next);
+		inputPush(INPUT_MOVE_FORWARD, i % 2 == 0);
+	}
+	atomicStore((volatile int*)data, TRUE);
+}
+
+// Adds up how long the forward key was really held from the events' own times, as the queue applies them
+void benchInputRecord(void* data, InputEvent* event) {
+	unsigned long long* held = data;
+	static unsigned long long pressTime;
+
+	if (event->pressed) {
+		pressTime = event->time;
+	} else {
+		*held += event->time - pressTime;
+	}
+}
+
+void benchInput(void) {
+	const unsigned long long tickTime = 1000000000ULL / TARGET_FPS;
+	unsigned long long held = 0;
+	double sampled = 0, quantised = 0;
+	volatile int finished = FALSE;
+
+	memset(&inputQueue, 0, sizeof(inputQueue));
+	inputSetRecorder(benchInputRecord, &held);
+	Thread producer = threadStart(benchInputProducer, (void*)&finished);
+
+	// Ticks like the simulation thread, each taking the inputs from the tick's length before it's due
+	unsigned long long due = platformNanoseconds();
+	unsigned int ticks = 0;
+	while (!atomicLoad(&finished) || inputQueue.tail != atomicLoad(&inputQueue.head)) {
+		due += tickTime;
+		platformSleepUntil(due);
+		const InputSample sample = inputSample(due - tickTime, due);
+		sampled += sample.surge * (double)tickTime;
+		// Reading the key state once per tick, as before the queue, counts the whole tick as however it ended
+		quantised += inputQueue.motion.Surge * (double)tickTime;
+		++ticks;
+	}
+	threadJoin(producer);
+	inputSetRecorder(NULL, NULL);
+
+	printf("%u key events over %u ticks, forward held for %.2f ms\n", BENCH_INPUT_EVENTS, ticks, held / 1e6);
+	printf("sampled within ticks  | %8.2f ms moving | %8.3f ms error\n", sampled / 1e6, fabs(sampled - held) / 1e6);
+	printf("state at each tick    | %8.2f ms moving | %8.3f ms error\n", quantised / 1e6, fabs(quantised - held) / 1e6);
+	reportLatencies("motion", inputQueue.latencies, inputQueue.latencyCount, INPUT_LATENCY_SAMPLES);
+	if (inputQueue.dropped > 0) {
+		printf("%d events were dropped\n", inputQueue.dropped);
+	}
+	memset(&inputQueue, 0, sizeof(inputQueue));
+}
+
+void benchAlloc(void) {
+	char* fileNames[] = { "plane.obj", "tree01trunk.obj", "tree01leaves.obj", "tree02trunk.obj", "tree02leaves.obj",
+		"tree03trunk.obj", "tree03leaves.obj" };
+	const char* names[] = { "malloc and free", "arena", "pool" };
+	void** records = malloc(BENCH_ALLOC_RECORDS * sizeof(void*));
+	size_t* sizes = malloc(BENCH_ALLOC_RECORDS * sizeof(size_t));
+	Arena arena;
+	Pool pool;
+
+	// Each mesh's arrays and faces now come from the arena in a few blocks, where every face used to be a
+	// malloc of its own, and the object and its four arrays five more
+	for (unsigned int i = 0; i < sizeof(fileNames) / sizeof(fileNames[0]); ++i) {
+		const long long before = allocGetStats(ALLOC_LOADER).total;
+		unsigned int faces = 0;
+		const double start = benchSeconds();
+		for (unsigned int load = 0; load < BENCH_ALLOC_LOADS; ++load) {
+			MeshObject* object = loadMeshObject(fileNames[i]);
+			if (object == NULL) {
+				break;
+			}
+			faces = object->faceCount;
+			freeMeshObject(object);
+		}
+		const double seconds = (benchSeconds() - start) / BENCH_ALLOC_LOADS;
+		printf("%-17s | %5u faces | %3lld allocations per load, at least %4u before | %.3f ms per load\n", fileNames[i],
+			faces, (allocGetStats(ALLOC_LOADER).total - before) / BENCH_ALLOC_LOADS, faces + 5, seconds * 1e3);
+	}
+
+	// Records the size of an OBJ face of three to eight points, made and all freed again every round
+	srand(1);
+	for (unsigned int i = 0; i < BENCH_ALLOC_RECORDS; ++i) {
+		sizes[i] = (3 + rand() % 6) * sizeof(MeshObjectFacePoint);
+	}
+	arenaInit(&arena, ALLOC_LOADER, 0);
+	poolInit(&pool, ALLOC_LOADER, 8 * sizeof(MeshObjectFacePoint), 0);
+	for (unsigned int method = 0; method < 3; ++method) {
+		const double start = benchSeconds();
+		for (unsigned int round = 0; round < BENCH_ALLOC_ROUNDS; ++round) {
+			for (unsigned int i = 0; i < BENCH_ALLOC_RECORDS; ++i) {
+				records[i] = method == 0 ? malloc(sizes[i]) : method == 1 ? arenaAlloc(&arena, sizes[i]) : poolAlloc(&pool);
+				memset(records[i], 0, sizes[i]);
+			}
+			if (method == 1) {
+				arenaReset(&arena);
+				continue;
+			}
+			for (unsigned int i = 0; i < BENCH_ALLOC_RECORDS; ++i) {
+				if (method == 0) {
+					free(records[i]);
+				} else {
+					poolRelease(&pool, records[i]);
+				}
+			}
+		}
+		const double seconds = benchSeconds() - start;
+		printf("%-16s | %.1f ns per record\n", names[method], seconds * 1e9 / ((double)BENCH_ALLOC_ROUNDS * BENCH_ALLOC_RECORDS));
+	}
+	arenaFree(&arena);
+	poolFree(&pool);
+
+	allocReport(stdout);
+	free(records);
+	free(sizes);
+}
+
+GLubyte* benchOriginalLoadPPMPixels(char* filename, int* imageWidth, int* imageHeight) {
+	char header[100];
+	char tempChar;
+	int width, height, maxVal, red, green, blue;
+
+	char* filepath = generatePath(filename);
+	FILE* inFile = fopen(filepath, "r");
+	allocFree(filepath);
+	if (inFile == NULL) {
+		return NULL;
+	}
+
+	fscanf(inFile, "%[^\n] ", header);
+	fscanf(inFile, "%c", &tempChar);
+	while (tempChar == '#') {
+		fscanf(inFile, "%[^\n] ", header);
+		fscanf(inFile, "%c", &tempChar);
+	}
+	ungetc(tempChar, inFile);
+	fscanf(inFile, "%d %d %d", &width, &height, &maxVal);
+
+	const int totalPixels = width * height;
+	const float RGBScaling = 255.0f / maxVal;
+	GLubyte* texture = malloc(3 * totalPixels);
+	for (int i = 0; i < totalPixels; i++) {
+		fscanf(inFile, "%d %d %d", &red, &green, &blue);
+		texture[3 * totalPixels - 3 * i - 3] = maxVal == 255 ? red : (GLubyte)(red * RGBScaling);
+		texture[3 * totalPixels - 3 * i - 2] = maxVal == 255 ? green : (GLubyte)(green * RGBScaling);
+		texture[3 * totalPixels - 3 * i - 1] = maxVal == 255 ? blue : (GLubyte)(blue * RGBScaling);
+	}
+	fclose(inFile);
+
+	*imageWidth = width;
+	*imageHeight = height;
+	return texture;
+}
+
+void benchAssets(void) {
+	char* fileNames[] = { "ground_color.PPM", "sky_color.ppm", "water_color.ppm", "terrain.pgm", "tree.loc", "plane.obj",
+		"tree01trunk.obj", "tree01leaves.obj", "tree02trunk.obj", "tree02leaves.obj", "tree03trunk.obj", "tree03leaves.obj" };
+	char* archives[] = { NULL, BENCH_ASSETS_RAW_FILE, BENCH_ASSETS_LZ4_FILE };
+	const char* names[] = { "loose files", "raw archive", "LZ4 archive" };
+	const unsigned int fileCount = sizeof(fileNames) / sizeof(fileNames[0]);
+	char* path;
+	bool evicted = TRUE;
+
+	if (!packCreate(BENCH_ASSETS_RAW_FILE, FALSE) || !packCreate(BENCH_ASSETS_LZ4_FILE, TRUE)) {
+		return;
+	}
+
+	for (unsigned int method = 0; method < 3; ++method) {
+		double cold = 0, warm = 0;
+		long long stored = 0;
+
+		for (unsigned int run = 0; run <= BENCH_ASSETS_RUNS; ++run) {
+			// The first run is cold, after the files are dropped from the page cache
+			packClose();
+			if (run == 0 && archives[method] != NULL) {
+				evicted &= platformEvictFile(archives[method]);
+			}
+			for (unsigned int i = 0; run == 0 && archives[method] == NULL && i < fileCount; ++i) {
+				path = generatePath(fileNames[i]);
+				evicted &= platformEvictFile(path);
+				allocFree(path);
+			}
+
+			const long long before = atomicLoad64(&packArchive.storedBytes);
+			const double start = benchSeconds();
+			if (archives[method] != NULL && !packOpen(archives[method])) {
+				return;
+			}
+			for (unsigned int i = 0; i < fileCount; ++i) {
+				size_t size;
+				allocFree(packRead(fileNames[i], &size));
+			}
+			const double seconds = benchSeconds() - start;
+			stored = atomicLoad64(&packArchive.storedBytes) - before;
+
+			if (run == 0) {
+				cold = seconds;
+			} else {
+				warm += seconds / BENCH_ASSETS_RUNS;
+			}
+		}
+		printf("%-12s | %5.2f MB read | cold %7.2f ms | warm %7.2f ms\n", names[method], stored / 1e6, cold * 1e3, warm * 1e3);
+	}
+	packClose();
+	remove(BENCH_ASSETS_RAW_FILE);
+	remove(BENCH_ASSETS_LZ4_FILE);
+	if (!evicted) {
+		printf("The page cache couldn't be dropped here, so the cold reads may have come from it too\n");
+	}
+
+	// Most of the time loading the textures went on parsing them with fscanf
+	for (unsigned int i = 0; i < 3; ++i) {
+		int width, height;
+		double start = benchSeconds();
+		GLubyte* pixels = benchOriginalLoadPPMPixels(fileNames[i], &width, &height);
+		const double before = benchSeconds() - start;
+		free(pixels);
+
+		start = benchSeconds();
+		pixels = loadPPMPixels(fileNames[i], &width, &height);
+		const double after = benchSeconds() - start;
+		allocFree(pixels);
+		printf("%-17s | fscanf %7.2f ms | from memory %7.2f ms\n", fileNames[i], before * 1e3, after * 1e3);
+	}
+}
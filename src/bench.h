@@ -0,0 +1,155 @@
+#pragma once
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include "helicopter.h"
+#include "tree.h"
+#include "swarm.h"
+#include "bvh.h"
+#include "angle.h"
+#include "loader.h"
+#include "glproc.h"
+#include "buffer.h"
+#include "ground.h"
+#include "water.h"
+#include "terrain.h"
+#include "sky.h"
+#include "pass.h"
+#include "mesh.h"
+#include "job.h"
+
+/*
+ * <bench.c/bench.h> Benchmarks for the simulation and rendering code. These are run from
+ * the command line with --bench <name> (or --bench all) instead of opening the scene
+ */
+
+// Number of random movements each collision benchmark is run over
+#define BENCH_COLLISION_MOVES 20000
+// Largest step the substepping collision benchmark will move the helicopter by between tests
+#define BENCH_SUBSTEP_LENGTH 0.25
+// Size of the swarm and number of ticks it's simulated for in the swarm benchmark
+#define BENCH_SWARM_DRONES 2048
+#define BENCH_SWARM_TICKS 300
+// Number of queries made of each type in the BVH benchmark, and the k of its nearest queries
+#define BENCH_BVH_QUERIES 200000
+#define BENCH_BVH_NEAREST 8
+// Length of the rays cast in the BVH benchmark
+#define BENCH_BVH_RAY_LENGTH 60
+// Number of vectors and passes over them in the vector maths benchmark
+#define BENCH_VECMATH_COUNT 65536
+#define BENCH_VECMATH_PASSES 50
+// Largest difference allowed between a batch function's results and the scalar function's
+#define BENCH_VECMATH_TOLERANCE 1e-5
+// Number of angles the trigonometry error test evaluates at a time
+#define BENCH_TRIG_BLOCK 4096
+// Number of frames each way of drawing the ground is timed over
+#define BENCH_GROUND_FRAMES 200
+// Number of frames each way of drawing the water is timed over, and times the wave kernel is run
+#define BENCH_WATER_FRAMES 500
+#define BENCH_WATER_WAVES 20000
+// Size of the heightmap generated for the terrain benchmark, and the number of height queries and sweeps it makes
+#define BENCH_TERRAIN_SIZE 513
+#define BENCH_TERRAIN_QUERIES 2000000
+#define BENCH_TERRAIN_FRAMES 50
+// Number of frames each way of drawing the sky is timed over
+#define BENCH_SKY_FRAMES 100
+// Number of frames each way of ordering the scene's draws is timed over
+#define BENCH_PASSES_FRAMES 36
+// Number of times each mesh is optimised in the meshes benchmark, to time it
+#define BENCH_MESHES_REPEATS 100
+// Number of jobs the scheduler benchmark times spawning, and how many it has unfinished at once
+#define BENCH_JOBS_SPAWNS 262144
+#define BENCH_JOBS_BATCH 1024
+// Number of elements in the work the scheduler benchmark splits over more threads
+#define BENCH_JOBS_WORK (1 << 22)
+// Number of copies of the scene's trees the culling benchmark tiles out, at most, and the frames it culls each time
+#define BENCH_CULL_TILES 64
+#define BENCH_CULL_FRAMES 500
+// Most threads the culling benchmark runs the scheduler with
+#define BENCH_CULL_THREADS 8
+// Number of frames the text benchmark draws, and the most lines of text each one has
+#define BENCH_TEXT_FRAMES 200
+#define BENCH_TEXT_LINES 64
+// Number of key events the input benchmark pushes, and the longest gap between them in milliseconds
+#define BENCH_INPUT_EVENTS 200
+#define BENCH_INPUT_MAX_GAP 40
+// Number of times the allocator benchmark loads each of the scene's meshes
+#define BENCH_ALLOC_LOADS 50
+// Number of face sized records the allocator benchmark makes and frees each round, and the rounds it runs
+#define BENCH_ALLOC_RECORDS 4096
+#define BENCH_ALLOC_ROUNDS 500
+// Number of times the assets benchmark reads every asset warm, and the archives it writes to compare
+#define BENCH_ASSETS_RUNS 20
+#define BENCH_ASSETS_RAW_FILE "bench-raw.pak"
+#define BENCH_ASSETS_LZ4_FILE "bench-lz4.pak"
+
+// Opens a window for the benchmarks that need an OpenGL context, the first time it's called
+void benchCreateWindow(void);
+// Runs the benchmark with the given name, or every benchmark if the name is "all". Returns FALSE if there's
+// no such benchmark or any of the checks the benchmarks make failed
+bool benchRun(char* name);
+// Prints why a benchmark's check failed, and makes benchRun return FALSE
+void benchFail(const char* format, ...);
+// Returns the wall clock time in seconds
+double benchSeconds(void);
+// Compares a single swept collision query per frame against testing substeps of the movement
+void benchCollision(void);
+// Measures the swarm's simulation throughput as the job scheduler is given more threads
+void benchSwarm(void);
+// Measures the queries per second the tree BVH can answer, checked against testing every tree
+void benchBvh(void);
+// Compares the original vector functions against the current scalar and batch versions
+void benchVecmath(void);
+// Tests the approximate sine and cosine against libm at every float in [1, 360) degrees, checks the
+// angle wrapping, and measures the throughput of each way of calculating sine and cosine
+void benchTrig(void);
+
+// The ground as it was drawn before it was moved into a vertex buffer, one immediate mode quad at a time
+void benchOriginalDrawGround(void);
+// Draws and finishes one frame of the ground, from the given buffer or in immediate mode if it's NULL
+void benchGroundFrame(VertexBuffer* buffer);
+// Compares the frame time of drawing the ground in immediate mode, from client arrays, and from buffer objects
+void benchGround(void);
+// The water as it was drawn before it was moved into a vertex buffer, one immediate mode quad at a time
+void benchOriginalDrawWater(GLfloat offset, GLfloat height);
+// Compares the frame time of the immediate mode water against the static buffer, and times the wave kernel
+void benchWater(void);
+// Measures terrain height queries and sweeps, and the triangles and frame time of the chunk levels of detail
+void benchTerrain(void);
+// The sky as it was drawn before it was cached, tessellated with gluSphere and lit every frame
+void benchOriginalDrawSky(GLUquadricObj* quadric, GLuint texture);
+// Compares the frame time of the gluSphere sky drawn after the ground against the cached dome and the skybox,
+// drawn both before and after the ground
+void benchSky(void);
+// Draws the scene in the order display() drew it before the pass scheduler
+void benchOriginalDisplayOrder(void);
+// Compares the frame time and overdraw of the whole scene drawn in its original order, sorted front to
+// back, and sorted with a depth pre-pass
+void benchPasses(void);
+// Reports the ACMR, ATVR and overdraw of every mesh the scene loads, in the order it was exported in and after
+// each optimisation, the memory and error of packing its vertices, and times how long the optimisations take
+void benchMeshes(void);
+// Measures the job scheduler's overhead spawning jobs, splitting ranges and following dependencies, and how
+// a fixed amount of work scales as it's split over more threads
+void benchJobs(void);
+// Times culling the trees and building their draw lists each frame, for growing numbers of trees tiled out from the
+// scene's, as the work is split over 1, 2, 4 and 8 threads
+void benchCull(void);
+// Draws text the way drawText did before the font atlas, with one glBitmap call per character
+void benchOriginalDrawText(char* text, Vec2 position);
+// Times drawing lines of text each frame one character at a time through GLUT, against the font atlas
+void benchText(void);
+// Presses and releases a key at random times on another thread while ticking like the simulation, comparing
+// how long the key moved the helicopter for with input sampled within ticks and only at each tick, against
+// how long it was really held, and reports the input to motion latency
+void benchInput(void);
+// Compares the arena and pool allocators with the heap, and counts what loading the meshes allocates
+void benchAlloc(void);
+// Reads a PPM the way loadPPMPixels did before it parsed the file from memory, with fscanf. Returns NULL if it
+// can't be opened, and memory that must be free()'d otherwise
+GLubyte* benchOriginalLoadPPMPixels(char* filename, int* width, int* height);
+// Compares reading every asset from the loose files, a raw archive and an LZ4 archive, cold from the disk where
+// the page cache can be dropped and warm from the cache, and times parsing the textures before and after
+void benchAssets(void);
@@ -0,0 +1,231 @@
+#include "buffer.h"
+
+// Creates a vertex buffer from vertices of any format, each vertexSize bytes
+VertexBuffer* vertexBufferCreateData(GLenum mode, VertexFormat format, const void* vertices, unsigned int vertexCount,
+	size_t vertexSize, GLuint* indices, unsigned int indexCount, VertexDecode* decode) {
+	VertexBuffer* buffer = allocCalloc(ALLOC_RENDER, 1, sizeof(VertexBuffer));
+	buffer->mode = mode;
+	buffer->format = format;
+	buffer->vertexCount = vertexCount;
+	buffer->indexCount = indexCount;
+	buffer->indexType = GL_UNSIGNED_INT;
+	if (decode != NULL) {
+		buffer->decode = *decode;
+	}
+
+	for (unsigned int i = 0; i < vertexCount; ++i) {
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			// Packed and compact vertices both start with their shorts
+			const char* vertex = (const char*)vertices + i * vertexSize;
+			const GLfloat position = format != VERTEX_FLOAT
+				? ((const GLshort*)vertex)[axis] * decode->positionScale + decode->positionOffset[axis]
+				: ((const Vertex*)vertex)->position[axis];
+			buffer->minimum[axis] = i == 0 || position < buffer->minimum[axis] ? position : buffer->minimum[axis];
+			buffer->maximum[axis] = i == 0 || position > buffer->maximum[axis] ? position : buffer->maximum[axis];
+		}
+	}
+
+	// Packed and compact buffers are after the smallest size, so their indices are narrowed too if they can be
+	const void* indexData = indices;
+	GLushort* shortIndices = NULL;
+	if (format != VERTEX_FLOAT && vertexCount <= 65536) {
+		shortIndices = allocMalloc(ALLOC_RENDER, (indexCount + 1) * sizeof(GLushort));
+		for (unsigned int i = 0; i < indexCount; ++i) {
+			shortIndices[i] = (GLushort)indices[i];
+		}
+		buffer->indexType = GL_UNSIGNED_SHORT;
+		indexData = shortIndices;
+	}
+	const size_t indexBytes = indexCount * (buffer->indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+
+	if (glprocHasBuffers()) {
+		glprocGenBuffers(1, &buffer->vertexObject);
+		glprocBindBuffer(GL_ARRAY_BUFFER, buffer->vertexObject);
+		glprocBufferData(GL_ARRAY_BUFFER, vertexCount * vertexSize, vertices, GL_STATIC_DRAW);
+		glprocBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glprocGenBuffers(1, &buffer->indexObject);
+		glprocBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->indexObject);
+		glprocBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData, GL_STATIC_DRAW);
+		glprocBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	} else {
+		buffer->vertices = allocMalloc(ALLOC_RENDER, vertexCount * vertexSize);
+		memcpy(buffer->vertices, vertices, vertexCount * vertexSize);
+		buffer->indices = allocMalloc(ALLOC_RENDER, indexBytes);
+		memcpy(buffer->indices, indexData, indexBytes);
+	}
+
+	allocFree(shortIndices);
+	return buffer;
+}
+
+VertexBuffer* vertexBufferCreate(GLenum mode, Vertex* vertices, unsigned int vertexCount, GLuint* indices, unsigned int indexCount) {
+	return vertexBufferCreateData(mode, VERTEX_FLOAT, vertices, vertexCount, sizeof(Vertex), indices, indexCount, NULL);
+}
+
+VertexBuffer* vertexBufferCreatePacked(GLenum mode, VertexFormat format, const void* vertices, unsigned int vertexCount,
+	GLuint* indices, unsigned int indexCount, VertexDecode* decode) {
+	return vertexBufferCreateData(mode, format, vertices, vertexCount, vertexFormatSize(format), indices, indexCount, decode);
+}
+
+size_t vertexFormatSize(VertexFormat format) {
+	switch (format) {
+	case VERTEX_PACKED: return sizeof(PackedVertex);
+	case VERTEX_COMPACT: return sizeof(CompactVertex);
+	default: return sizeof(Vertex);
+	}
+}
+
+size_t vertexBufferSize(VertexBuffer* buffer) {
+	if (buffer == NULL) {
+		return 0;
+	}
+	return buffer->vertexCount * vertexFormatSize(buffer->format)
+		+ buffer->indexCount * (buffer->indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint));
+}
+
+void vertexBufferUpdate(VertexBuffer* buffer, Vertex* vertices) {
+	if (buffer->vertexObject != 0) {
+		glprocBindBuffer(GL_ARRAY_BUFFER, buffer->vertexObject);
+		glprocBufferSubData(GL_ARRAY_BUFFER, 0, buffer->vertexCount * sizeof(Vertex), vertices);
+		glprocBindBuffer(GL_ARRAY_BUFFER, 0);
+	} else {
+		memcpy(buffer->vertices, vertices, buffer->vertexCount * sizeof(Vertex));
+	}
+}
+
+void vertexBufferDraw(VertexBuffer* buffer) {
+	// With a buffer object bound, the array "pointers" are byte offsets into it
+	const char* base = (const char*)buffer->vertices;
+	const void* indices = buffer->indices;
+
+	if (buffer->vertexObject != 0) {
+		glprocBindBuffer(GL_ARRAY_BUFFER, buffer->vertexObject);
+		glprocBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->indexObject);
+		base = NULL;
+		indices = NULL;
+	}
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	if (buffer->format == VERTEX_PACKED) {
+		// Short positions and texture coordinates aren't normalised, so the matrices scale them back
+		const VertexDecode* decode = &buffer->decode;
+		glPushMatrix();
+		glTranslatef(decode->positionOffset[0], decode->positionOffset[1], decode->positionOffset[2]);
+		glScalef(decode->positionScale, decode->positionScale, decode->positionScale);
+		glMatrixMode(GL_TEXTURE);
+		glPushMatrix();
+		glTranslatef(decode->texCoordOffset[0], decode->texCoordOffset[1], 0);
+		glScalef(decode->texCoordScale[0], decode->texCoordScale[1], 1);
+		glMatrixMode(GL_MODELVIEW);
+
+		glVertexPointer(3, GL_SHORT, sizeof(PackedVertex), base + offsetof(PackedVertex, position));
+		glNormalPointer(GL_BYTE, sizeof(PackedVertex), base + offsetof(PackedVertex, normal));
+		glTexCoordPointer(2, GL_SHORT, sizeof(PackedVertex), base + offsetof(PackedVertex, texCoord));
+		glDrawElements(buffer->mode, buffer->indexCount, buffer->indexType, indices);
+
+		glMatrixMode(GL_TEXTURE);
+		glPopMatrix();
+		glMatrixMode(GL_MODELVIEW);
+		glPopMatrix();
+	} else {
+		glVertexPointer(3, GL_FLOAT, sizeof(Vertex), base + offsetof(Vertex, position));
+		glNormalPointer(GL_FLOAT, sizeof(Vertex), base + offsetof(Vertex, normal));
+		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), base + offsetof(Vertex, texCoord));
+		glDrawElements(buffer->mode, buffer->indexCount, buffer->indexType, indices);
+	}
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	if (buffer->vertexObject != 0) {
+		glprocBindBuffer(GL_ARRAY_BUFFER, 0);
+		glprocBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+}
+
+// Binds a vertex buffer's vertex array object, setting it up the first time. The vertex array object keeps
+// the index buffer and the attribute layout, so they're only set up once
+void vertexBufferBindAttributes(VertexBuffer* buffer) {
+	if (buffer->vertexArray != 0) {
+		glprocBindVertexArray(buffer->vertexArray);
+		return;
+	}
+
+	glprocGenVertexArrays(1, &buffer->vertexArray);
+	glprocBindVertexArray(buffer->vertexArray);
+	glprocBindBuffer(GL_ARRAY_BUFFER, buffer->vertexObject);
+	glprocBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->indexObject);
+	glprocEnableVertexAttribArray(VERTEX_POSITION_ATTRIBUTE);
+	glprocEnableVertexAttribArray(VERTEX_NORMAL_ATTRIBUTE);
+	glprocEnableVertexAttribArray(VERTEX_TEXCOORD_ATTRIBUTE);
+
+	if (buffer->format == VERTEX_PACKED) {
+		const GLsizei stride = sizeof(PackedVertex);
+		glprocVertexAttribPointer(VERTEX_POSITION_ATTRIBUTE, 3, GL_SHORT, GL_FALSE, stride, (void*)offsetof(PackedVertex, position));
+		glprocVertexAttribPointer(VERTEX_NORMAL_ATTRIBUTE, 3, GL_BYTE, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+		glprocVertexAttribPointer(VERTEX_TEXCOORD_ATTRIBUTE, 2, GL_SHORT, GL_FALSE, stride, (void*)offsetof(PackedVertex, texCoord));
+	} else if (buffer->format == VERTEX_COMPACT) {
+		const GLsizei stride = sizeof(CompactVertex);
+		glprocVertexAttribPointer(VERTEX_POSITION_ATTRIBUTE, 3, GL_SHORT, GL_FALSE, stride, (void*)offsetof(CompactVertex, position));
+		glprocVertexAttribPointer(VERTEX_NORMAL_ATTRIBUTE, 2, GL_BYTE, GL_TRUE, stride, (void*)offsetof(CompactVertex, normal));
+		glprocVertexAttribPointer(VERTEX_TEXCOORD_ATTRIBUTE, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(CompactVertex, texCoord));
+	} else {
+		const GLsizei stride = sizeof(Vertex);
+		glprocVertexAttribPointer(VERTEX_POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, position));
+		glprocVertexAttribPointer(VERTEX_NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, normal));
+		glprocVertexAttribPointer(VERTEX_TEXCOORD_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, texCoord));
+	}
+	glprocBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void vertexBufferDrawAttributes(VertexBuffer* buffer) {
+	vertexBufferBindAttributes(buffer);
+	glDrawElements(buffer->mode, buffer->indexCount, buffer->indexType, NULL);
+	glprocBindVertexArray(0);
+}
+
+void vertexBufferDrawInstanced(VertexBuffer* buffer, GLuint instanceObject, unsigned int instanceCount) {
+	vertexBufferBindAttributes(buffer);
+
+	// A mat4 attribute takes up four locations, one for each column, which step once per instance
+	glprocBindBuffer(GL_ARRAY_BUFFER, instanceObject);
+	for (unsigned int column = 0; column < 4; ++column) {
+		glprocEnableVertexAttribArray(VERTEX_INSTANCE_ATTRIBUTE + column);
+		glprocVertexAttribPointer(VERTEX_INSTANCE_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(GLfloat),
+			(void*)(column * 4 * sizeof(GLfloat)));
+		glprocVertexAttribDivisor(VERTEX_INSTANCE_ATTRIBUTE + column, 1);
+	}
+	glprocBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glprocDrawElementsInstanced(buffer->mode, buffer->indexCount, buffer->indexType, NULL, instanceCount);
+
+	// The instance buffer is only good for this draw, so the vertex array object is left without it
+	for (unsigned int column = 0; column < 4; ++column) {
+		glprocDisableVertexAttribArray(VERTEX_INSTANCE_ATTRIBUTE + column);
+	}
+	glprocBindVertexArray(0);
+}
+
+void vertexBufferFree(VertexBuffer* buffer) {
+	if (buffer == NULL) {
+		return;
+	}
+
+	if (buffer->vertexArray != 0) {
+		glprocDeleteVertexArrays(1, &buffer->vertexArray);
+	}
+
+	if (buffer->vertexObject != 0) {
+		glprocDeleteBuffers(1, &buffer->vertexObject);
+		glprocDeleteBuffers(1, &buffer->indexObject);
+	}
+
+	allocFree(buffer->vertices);
+	allocFree(buffer->indices);
+	allocFree(buffer);
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <stdlib.h>
+#include <string.h>
+#include <freeglut.h>
+#include "glproc.h"
+#include "alloc.h"
+
+/*
+ * <buffer.c/buffer.h> Static vertex buffers: geometry that's built once and drawn many times with a
+ * single call. The data lives in buffer objects when the driver has them, and in client side
+ * vertex arrays otherwise
+ *
+ * Vertices are either full floats, or packed into half the size as integers. Packed vertices are
+ * decoded by OpenGL itself when drawn with the fixed function pipeline: the positions and texture
+ * coordinates are scaled back by the modelview and texture matrices, and the normals are normalised
+ * signed bytes. Drawn through generic attributes instead, for a shader, the shader decodes them
+ *
+ * Compact vertices go further, to 12 bytes, with octahedral normals and half float texture coordinates.
+ * The fixed function pipeline can't unfold an octahedral normal, so they can only be drawn for a shader
+ */
+
+// Generic attribute locations that vertexBufferDrawAttributes feeds each part of a vertex to
+#define VERTEX_POSITION_ATTRIBUTE 0
+#define VERTEX_NORMAL_ATTRIBUTE 1
+#define VERTEX_TEXCOORD_ATTRIBUTE 2
+// First of the four generic attribute locations vertexBufferDrawInstanced feeds each instance's matrix to,
+// a column at a time
+#define VERTEX_INSTANCE_ATTRIBUTE 3
+
+typedef enum {
+	VERTEX_FLOAT = 0,	// Vertex, 32 bytes
+	VERTEX_PACKED,		// PackedVertex, 16 bytes
+	VERTEX_COMPACT		// CompactVertex, 12 bytes, only drawn through generic attributes
+} VertexFormat;
+
+typedef struct VERTEX {
+	GLfloat position[3];
+	GLfloat normal[3];
+	GLfloat texCoord[2];
+} Vertex;
+
+// A vertex quantised to 16 bytes. The position is 16 bits per axis and the texture coordinate 16 bits per
+// component, each across the range of the mesh it belongs to, and the normal is 8 bits per axis. The
+// padding keeps every attribute 4 byte aligned
+typedef struct PACKEDVERTEX {
+	GLshort position[3];
+	GLshort padding;
+	GLbyte normal[4];		// The fourth is padding
+	GLshort texCoord[2];
+} PackedVertex;
+
+// A vertex quantised to 12 bytes. The position is the same as a packed vertex's, the normal is folded onto
+// an octahedron and unfolded to a square, 8 bits a side, and the texture coordinate is two half floats
+typedef struct COMPACTVERTEX {
+	GLshort position[3];
+	GLbyte normal[2];
+	GLushort texCoord[2];	// IEEE 754 halves
+} CompactVertex;
+
+// Turns the integers of a packed or compact vertex back into a mesh's coordinates, as integer * scale +
+// offset. The position has one scale for every axis, so the modelview matrix stays uniformly scaled and
+// the normals aren't bent by it. Compact vertices' texture coordinates are already floats, so they're
+// decoded with a scale of 1 and no offset
+typedef struct VERTEXDECODE {
+	GLfloat positionScale;
+	GLfloat positionOffset[3];
+	GLfloat texCoordScale[2];
+	GLfloat texCoordOffset[2];
+} VertexDecode;
+
+typedef struct VERTEXBUFFER {
+	GLenum mode;			// Primitive type the indices describe (GL_TRIANGLE_STRIP, GL_TRIANGLES...)
+	VertexFormat format;
+	VertexDecode decode;	// How packed and compact vertices are decoded, unused for floats
+	GLenum indexType;		// GL_UNSIGNED_SHORT for packed and compact vertices when they all fit, GL_UNSIGNED_INT otherwise
+	GLfloat minimum[3];		// Bounds of the vertices' positions as they were created
+	GLfloat maximum[3];
+	unsigned int vertexCount;
+	unsigned int indexCount;
+	GLuint vertexObject;	// Buffer objects holding the vertices and indices, 0 when using client arrays
+	GLuint indexObject;
+	GLuint vertexArray;		// Vertex array object for drawing through generic attributes, made the first time it's needed
+	void* vertices;			// Copies of the data for the client array fallback, NULL when using buffer objects
+	void* indices;
+} VertexBuffer;
+
+// Creates a vertex buffer holding copies of the given vertices and indices
+VertexBuffer* vertexBufferCreate(GLenum mode, Vertex* vertices, unsigned int vertexCount, GLuint* indices, unsigned int indexCount);
+// Creates a vertex buffer holding copies of the given packed or compact vertices and indices, decoded as
+// given. The indices are stored in 16 bits if there are few enough vertices
+VertexBuffer* vertexBufferCreatePacked(GLenum mode, VertexFormat format, const void* vertices, unsigned int vertexCount,
+	GLuint* indices, unsigned int indexCount, VertexDecode* decode);
+// Returns the number of bytes one vertex in a format takes up
+size_t vertexFormatSize(VertexFormat format);
+// Returns the number of bytes a vertex buffer's vertices and indices take up, or 0 for NULL
+size_t vertexBufferSize(VertexBuffer* buffer);
+// Replaces every vertex in a vertex buffer of floats, keeping its indices
+void vertexBufferUpdate(VertexBuffer* buffer, Vertex* vertices);
+// Draws every primitive in a vertex buffer with its normals and texture coordinates, through the fixed
+// function arrays. Compact vertices can't be drawn this way
+void vertexBufferDraw(VertexBuffer* buffer);
+// Draws every primitive in a vertex buffer through the generic attributes at the VERTEX_ locations, with
+// packed and compact vertices left for the shader to decode. A compact vertex's normal is fed as its two
+// octahedral coordinates. Needs buffer objects and vertex array objects
+void vertexBufferDrawAttributes(VertexBuffer* buffer);
+// Draws every primitive in a vertex buffer once for each matrix in an instance buffer object, as
+// vertexBufferDrawAttributes does, with the matrices fed to the VERTEX_INSTANCE_ATTRIBUTE locations
+void vertexBufferDrawInstanced(VertexBuffer* buffer, GLuint instanceObject, unsigned int instanceCount);
+// Frees a vertex buffer and the OpenGL objects it owns
+void vertexBufferFree(VertexBuffer* buffer);
@@ -0,0 +1,395 @@
+#include <assert.h>
+#include "bvh.h"
+#include "vecinline.h"
+
+// The bins candidate splits are evaluated over while building
+typedef struct BVHBIN {
+	Vec3 min, max;
+	unsigned int count;
+} BvhBin;
+
+// Returns the bounds of a tree's collision cylinders
+void bvhTreeBounds(TreeObject* tree, Vec3* min, Vec3* max) {
+	const GLfloat radius = treeCollisionProfiles[tree->modelIndex].canopyRadius;
+	*min = (Vec3) { tree->position.x - radius, tree->height, tree->position.y - radius };
+	*max = (Vec3) { tree->position.x + radius, tree->height + TREE_COLLISION_HEIGHT, tree->position.y + radius };
+}
+
+// Grows a box to contain another box
+void bvhExpand(Vec3* min, Vec3* max, Vec3 otherMin, Vec3 otherMax) {
+	*min = (Vec3) { fmin(min->x, otherMin.x), fmin(min->y, otherMin.y), fmin(min->z, otherMin.z) };
+	*max = (Vec3) { fmax(max->x, otherMax.x), fmax(max->y, otherMax.y), fmax(max->z, otherMax.z) };
+}
+
+GLfloat bvhSurfaceArea(Vec3 min, Vec3 max) {
+	const Vec3 size = { max.x - min.x, max.y - min.y, max.z - min.z };
+	return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+GLfloat bvhAxis(Vec3 vector, unsigned int axis) {
+	return axis == 0 ? vector.x : axis == 1 ? vector.y : vector.z;
+}
+
+// Recursively builds the node at nodeIndex, depth levels below the root, from count trees starting at
+// start in the index array
+void bvhBuildNode(Bvh* bvh, unsigned int nodeIndex, unsigned int depth, unsigned int start, unsigned int count) {
+	BvhNode* node = &bvh->nodes[nodeIndex];
+	Vec3 centroidMin = { FLT_MAX, FLT_MAX, FLT_MAX }, centroidMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	node->min = centroidMin;
+	node->max = centroidMax;
+	for (unsigned int i = start; i < start + count; ++i) {
+		Vec3 min, max;
+		bvhTreeBounds(&bvh->trees[bvh->indices[i]], &min, &max);
+		bvhExpand(&node->min, &node->max, min, max);
+
+		const Vec3 centroid = { (min.x + max.x) / 2, (min.y + max.y) / 2, (min.z + max.z) / 2 };
+		bvhExpand(&centroidMin, &centroidMax, centroid, centroid);
+	}
+
+	node->start = start;
+	node->count = count;
+	if (depth > bvh->depth) { bvh->depth = depth; }
+	// Splitting this node deeper than the traversal stack can hold makes it a leaf however many trees it has
+	if (count <= BVH_MIN_LEAF_SIZE || depth + 2 > BVH_STACK_SIZE) { return; }
+
+	// Find the cheapest split by the surface area heuristic, evaluated at the boundaries of
+	// evenly sized bins along each axis
+	GLfloat bestCost = FLT_MAX;
+	unsigned int bestAxis = 0, bestSplit = 0;
+
+	for (unsigned int axis = 0; axis < 3; ++axis) {
+		const GLfloat axisMin = bvhAxis(centroidMin, axis);
+		const GLfloat extent = bvhAxis(centroidMax, axis) - axisMin;
+		if (extent <= 0) { continue; }
+
+		BvhBin bins[BVH_BINS];
+		for (unsigned int b = 0; b < BVH_BINS; ++b) {
+			bins[b] = (BvhBin) { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX }, 0 };
+		}
+
+		for (unsigned int i = start; i < start + count; ++i) {
+			Vec3 min, max;
+			bvhTreeBounds(&bvh->trees[bvh->indices[i]], &min, &max);
+			const GLfloat centroid = (bvhAxis(min, axis) + bvhAxis(max, axis)) / 2;
+			const unsigned int b = (unsigned int)fmin((centroid - axisMin) / extent * BVH_BINS, BVH_BINS - 1);
+			bvhExpand(&bins[b].min, &bins[b].max, min, max);
+			++bins[b].count;
+		}
+
+		// Sweep from the right to find the cost of everything right of each split, then
+		// from the left to combine it with everything left of it
+		GLfloat rightAreas[BVH_BINS];
+		unsigned int rightCounts[BVH_BINS];
+		Vec3 min = bins[BVH_BINS - 1].min, max = bins[BVH_BINS - 1].max;
+		unsigned int total = 0;
+		for (unsigned int b = BVH_BINS - 1; b > 0; --b) {
+			bvhExpand(&min, &max, bins[b].min, bins[b].max);
+			total += bins[b].count;
+			rightAreas[b] = total > 0 ? bvhSurfaceArea(min, max) : 0;
+			rightCounts[b] = total;
+		}
+
+		min = bins[0].min;
+		max = bins[0].max;
+		total = 0;
+		for (unsigned int b = 0; b < BVH_BINS - 1; ++b) {
+			bvhExpand(&min, &max, bins[b].min, bins[b].max);
+			total += bins[b].count;
+
+			if (total == 0 || rightCounts[b + 1] == 0) { continue; }
+
+			const GLfloat cost = bvhSurfaceArea(min, max) * total + rightAreas[b + 1] * rightCounts[b + 1];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b + 1;
+			}
+		}
+	}
+
+	const GLfloat leafCost = bvhSurfaceArea(node->min, node->max) * count;
+	if (bestCost == FLT_MAX || (bestCost >= leafCost && count <= BVH_MAX_LEAF_SIZE)) { return; }
+
+	// Partition the trees either side of the split
+	const GLfloat axisMin = bvhAxis(centroidMin, bestAxis);
+	const GLfloat extent = bvhAxis(centroidMax, bestAxis) - axisMin;
+	unsigned int middle = start;
+	for (unsigned int i = start; i < start + count; ++i) {
+		Vec3 min, max;
+		bvhTreeBounds(&bvh->trees[bvh->indices[i]], &min, &max);
+		const GLfloat centroid = (bvhAxis(min, bestAxis) + bvhAxis(max, bestAxis)) / 2;
+
+		if ((unsigned int)fmin((centroid - axisMin) / extent * BVH_BINS, BVH_BINS - 1) < bestSplit) {
+			const unsigned int swap = bvh->indices[i];
+			bvh->indices[i] = bvh->indices[middle];
+			bvh->indices[middle++] = swap;
+		}
+	}
+
+	const unsigned int leftIndex = bvh->nodeCount++;
+	bvhBuildNode(bvh, leftIndex, depth + 1, start, middle - start);
+	const unsigned int rightIndex = bvh->nodeCount++;
+	bvhBuildNode(bvh, rightIndex, depth + 1, middle, start + count - middle);
+
+	node = &bvh->nodes[nodeIndex];
+	node->start = rightIndex;
+	node->count = 0;
+}
+
+Bvh* bvhBuild(TreeObject* trees, unsigned int treeCount) {
+	Bvh* bvh = malloc(sizeof(Bvh));
+	bvh->trees = trees;
+	bvh->treeCount = treeCount;
+	bvh->indices = malloc(sizeof(unsigned int) * treeCount);
+	bvh->nodes = malloc(sizeof(BvhNode) * (treeCount * 2 + 1));
+	bvh->nodeCount = 1;
+	bvh->depth = 0;
+
+	for (unsigned int i = 0; i < treeCount; ++i) {
+		bvh->indices[i] = i;
+	}
+
+	bvhBuildNode(bvh, 0, 0, 0, treeCount);
+	// Traversals need a stack entry for every level down to the deepest leaf, plus one for its sibling
+	assert(bvh->depth + 1 <= BVH_STACK_SIZE);
+	return bvh;
+}
+
+// Returns the time a ray enters a box, or -1 if it misses it or enters after maxTime.
+// The inverse direction is passed in so it's only calculated once per ray
+GLfloat bvhRayBox(Vec3 origin, Vec3 inverseDirection, GLfloat maxTime, Vec3 min, Vec3 max) {
+	const GLfloat x0 = (min.x - origin.x) * inverseDirection.x, x1 = (max.x - origin.x) * inverseDirection.x;
+	const GLfloat y0 = (min.y - origin.y) * inverseDirection.y, y1 = (max.y - origin.y) * inverseDirection.y;
+	const GLfloat z0 = (min.z - origin.z) * inverseDirection.z, z1 = (max.z - origin.z) * inverseDirection.z;
+
+	const GLfloat enter = fmax(fmax(fmin(x0, x1), fmin(y0, y1)), fmax(fmin(z0, z1), 0));
+	const GLfloat exit = fmin(fmin(fmax(x0, x1), fmax(y0, y1)), fmin(fmax(z0, z1), maxTime));
+
+	return enter <= exit ? enter : -1;
+}
+
+// A direction's reciprocal, with zero components turned into huge values so the slab tests still work
+Vec3 bvhInverseDirection(Vec3 direction) {
+	return (Vec3) {
+		direction.x != 0 ? 1 / direction.x : FLT_MAX,
+		direction.y != 0 ? 1 / direction.y : FLT_MAX,
+		direction.z != 0 ? 1 / direction.z : FLT_MAX
+	};
+}
+
+// Intersects a ray with a capped vertical cylinder between two heights, updating the hit if it's closer
+bool bvhRayCylinder(Vec3 origin, Vec3 direction, Vec2 centre, GLfloat radius, GLfloat bottom, GLfloat top, BvhHit* hit) {
+	const Vec2 offset = { origin.x - centre.x, origin.z - centre.y };
+	const GLfloat a = direction.x * direction.x + direction.z * direction.z;
+	const GLfloat b = offset.x * direction.x + offset.y * direction.z;
+	const GLfloat c = offset.x * offset.x + offset.y * offset.y - radius * radius;
+	bool found = FALSE;
+
+	// Starting inside the cylinder counts as hitting it straight away
+	if (c <= 0 && origin.y >= bottom && origin.y <= top) {
+		hit->time = 0;
+		hit->normal = (Vec3) { 0, 0, 0 };
+		return TRUE;
+	}
+
+	// The side of the cylinder
+	if (a > 0 && b * b - a * c >= 0) {
+		const GLfloat time = (-b - sqrt(b * b - a * c)) / a;
+		const GLfloat y = origin.y + direction.y * time;
+		if (time >= 0 && time < hit->time && y >= bottom && y <= top) {
+			hit->time = time;
+			hit->normal = (Vec3) { (offset.x + direction.x * time) / radius, 0, (offset.y + direction.z * time) / radius };
+			found = TRUE;
+		}
+	}
+
+	// The caps
+	if (direction.y != 0) {
+		const GLfloat capY = direction.y > 0 ? bottom : top;
+		const GLfloat time = (capY - origin.y) / direction.y;
+		const GLfloat x = offset.x + direction.x * time, z = offset.y + direction.z * time;
+		if (time >= 0 && time < hit->time && x * x + z * z <= radius * radius) {
+			hit->time = time;
+			hit->normal = (Vec3) { 0, direction.y > 0 ? -1 : 1, 0 };
+			found = TRUE;
+		}
+	}
+
+	return found;
+}
+
+bool bvhRaycastTree(TreeObject* tree, Vec3 origin, Vec3 direction, GLfloat maxTime, BvhHit* hit) {
+	const TreeCollisionProfile* profile = &treeCollisionProfiles[tree->modelIndex];
+	BvhHit treeHit = { 0, maxTime };
+
+	bool found = bvhRayCylinder(origin, direction, tree->position, profile->trunkRadius, tree->height, tree->height + profile->canopyHeight, &treeHit);
+	found = bvhRayCylinder(origin, direction, tree->position, profile->canopyRadius, tree->height + profile->canopyHeight, tree->height + TREE_COLLISION_HEIGHT, &treeHit) || found;
+
+	if (found) {
+		treeHit.point = vec3Add(origin, vec3Scale(direction, treeHit.time));
+		hit->time = treeHit.time;
+		hit->point = treeHit.point;
+		hit->normal = treeHit.normal;
+	}
+	return found;
+}
+
+// Traverses the hierarchy with a single ray. Stops at the first hit found if anyHit is set,
+// rather than searching for the closest
+bool bvhTraverse(Bvh* bvh, Vec3 origin, Vec3 direction, GLfloat maxTime, bool anyHit, BvhHit* hit) {
+	const Vec3 inverseDirection = bvhInverseDirection(direction);
+	unsigned int stack[BVH_STACK_SIZE];
+	unsigned int stackSize = 0;
+	bool found = FALSE;
+
+	hit->time = maxTime;
+	if (bvhRayBox(origin, inverseDirection, maxTime, bvh->nodes[0].min, bvh->nodes[0].max) < 0) { return FALSE; }
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+		const BvhNode* node = &bvh->nodes[stack[--stackSize]];
+
+		if (node->count > 0) {
+			for (unsigned int i = node->start; i < node->start + node->count; ++i) {
+				if (bvhRaycastTree(&bvh->trees[bvh->indices[i]], origin, direction, hit->time, hit)) {
+					hit->treeIndex = bvh->indices[i];
+					found = TRUE;
+					if (anyHit) { return TRUE; }
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first, so hits found there can cull the further one
+		const unsigned int left = (unsigned int)(node - bvh->nodes) + 1, right = node->start;
+		const GLfloat leftTime = bvhRayBox(origin, inverseDirection, hit->time, bvh->nodes[left].min, bvh->nodes[left].max);
+		const GLfloat rightTime = bvhRayBox(origin, inverseDirection, hit->time, bvh->nodes[right].min, bvh->nodes[right].max);
+
+		if (leftTime >= 0 && rightTime >= 0) {
+			stack[stackSize++] = leftTime < rightTime ? right : left;
+			stack[stackSize++] = leftTime < rightTime ? left : right;
+		} else if (leftTime >= 0) {
+			stack[stackSize++] = left;
+		} else if (rightTime >= 0) {
+			stack[stackSize++] = right;
+		}
+	}
+
+	return found;
+}
+
+bool bvhRaycast(Bvh* bvh, Vec3 origin, Vec3 direction, GLfloat maxTime, BvhHit* hit) {
+	return bvhTraverse(bvh, origin, direction, maxTime, FALSE, hit);
+}
+
+bool bvhSegmentIntersects(Bvh* bvh, Vec3 start, Vec3 end) {
+	BvhHit hit;
+	return bvhTraverse(bvh, start, (Vec3) { end.x - start.x, end.y - start.y, end.z - start.z }, 1, TRUE, &hit);
+}
+
+// Returns the distance on the XZ plane from a point to a box
+GLfloat bvhBoxDistance(Vec3 point, Vec3 min, Vec3 max) {
+	const GLfloat x = fmax(fmax(min.x - point.x, point.x - max.x), 0);
+	const GLfloat z = fmax(fmax(min.z - point.z, point.z - max.z), 0);
+	return sqrt(x * x + z * z);
+}
+
+unsigned int bvhNearest(Bvh* bvh, Vec3 point, unsigned int k, unsigned int* treeIndices, GLfloat* distances) {
+	unsigned int stack[BVH_STACK_SIZE];
+	unsigned int stackSize = 0, found = 0;
+
+	if (k == 0) { return 0; }
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+		const BvhNode* node = &bvh->nodes[stack[--stackSize]];
+
+		// Nothing under this node can be closer than the furthest tree found so far
+		if (found == k && bvhBoxDistance(point, node->min, node->max) >= distances[k - 1]) { continue; }
+
+		if (node->count > 0) {
+			for (unsigned int i = node->start; i < node->start + node->count; ++i) {
+				const Vec2 position = bvh->trees[bvh->indices[i]].position;
+				const GLfloat distance = sqrt(pow(point.x - position.x, 2) + pow(point.z - position.y, 2));
+				if (found == k && distance >= distances[k - 1]) { continue; }
+
+				// Insert into the results, which are kept sorted closest first
+				unsigned int slot = found < k ? found++ : k - 1;
+				while (slot > 0 && distances[slot - 1] > distance) {
+					distances[slot] = distances[slot - 1];
+					treeIndices[slot] = treeIndices[slot - 1];
+					--slot;
+				}
+				distances[slot] = distance;
+				treeIndices[slot] = bvh->indices[i];
+			}
+			continue;
+		}
+
+		const unsigned int left = (unsigned int)(node - bvh->nodes) + 1, right = node->start;
+		const bool leftFirst = bvhBoxDistance(point, bvh->nodes[left].min, bvh->nodes[left].max) <
+			bvhBoxDistance(point, bvh->nodes[right].min, bvh->nodes[right].max);
+		stack[stackSize++] = leftFirst ? right : left;
+		stack[stackSize++] = leftFirst ? left : right;
+	}
+
+	return found;
+}
+
+void bvhRaycastPacket(Bvh* bvh, const Vec3* origins, const Vec3* directions, GLfloat maxTime, unsigned int count, BvhHit* hits) {
+	for (unsigned int first = 0; first < count; first += BVH_PACKET_SIZE) {
+		const unsigned int packetSize = count - first < BVH_PACKET_SIZE ? count - first : BVH_PACKET_SIZE;
+		Vec3 inverseDirections[BVH_PACKET_SIZE];
+		unsigned int stack[BVH_STACK_SIZE];
+		unsigned int stackSize = 0;
+
+		for (unsigned int r = 0; r < packetSize; ++r) {
+			inverseDirections[r] = bvhInverseDirection(directions[first + r]);
+			hits[first + r].time = maxTime;
+		}
+		stack[stackSize++] = 0;
+
+		// The whole packet walks the hierarchy together, visiting a node if any ray in it
+		// reaches the node's bounds, which shares the node fetches between coherent rays
+		while (stackSize > 0) {
+			const unsigned int nodeIndex = stack[--stackSize];
+			const BvhNode* node = &bvh->nodes[nodeIndex];
+			bool active = FALSE;
+
+			for (unsigned int r = 0; r < packetSize && !active; ++r) {
+				active = bvhRayBox(origins[first + r], inverseDirections[r], hits[first + r].time, node->min, node->max) >= 0;
+			}
+			if (!active) { continue; }
+
+			if (node->count > 0) {
+				for (unsigned int i = node->start; i < node->start + node->count; ++i) {
+					for (unsigned int r = 0; r < packetSize; ++r) {
+						BvhHit* hit = &hits[first + r];
+						if (bvhRaycastTree(&bvh->trees[bvh->indices[i]], origins[first + r], directions[first + r], hit->time, hit)) {
+							hit->treeIndex = bvh->indices[i];
+						}
+					}
+				}
+				continue;
+			}
+
+			stack[stackSize++] = node->start;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+
+		for (unsigned int r = 0; r < packetSize; ++r) {
+			if (hits[first + r].time >= maxTime) {
+				hits[first + r].time = -1;
+			}
+		}
+	}
+}
+
+void bvhFree(Bvh* bvh) {
+	if (bvh != NULL) {
+		free(bvh->nodes);
+		free(bvh->indices);
+		free(bvh);
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include "tree.h"
+#include "vecmath.h"
+
+/*
+ * <bvh.c/bvh.h> A bounding volume hierarchy over the trees' collision cylinders, built with
+ * binned SAH when the scene loads, for answering ray, segment and nearest tree queries
+ */
+
+// Number of bins candidate splits are evaluated over when building
+#define BVH_BINS 12
+// Nodes with this few trees are always made leaves
+#define BVH_MIN_LEAF_SIZE 2
+// Most trees a leaf can hold, even when the SAH would rather not split it
+#define BVH_MAX_LEAF_SIZE 8
+// Number of rays traversed together by the packet queries
+#define BVH_PACKET_SIZE 8
+// Entries in a traversal's stack of nodes to visit. It holds at most one node waiting at each level
+// above the current one plus the two children just pushed, so the build stops splitting nodes before
+// the leaves get deep enough to overflow it
+#define BVH_STACK_SIZE 64
+
+typedef struct BVHNODE {
+	Vec3 min, max; // Bounds of everything under this node
+	unsigned int start; // First index of the node's trees if it's a leaf, otherwise its right child
+	unsigned int count; // Number of trees in the node if it's a leaf, or 0 for an interior node
+} BvhNode;
+
+// Nodes are stored depth first, so the left child of an interior node is always the next node
+typedef struct BVH {
+	BvhNode* nodes;
+	unsigned int nodeCount;
+	unsigned int depth; // Levels between the root and the deepest leaf
+	unsigned int* indices; // Indexes into the tree array, in the order the leaves reference them
+	TreeObject* trees;
+	unsigned int treeCount;
+} Bvh;
+
+// Where a ray hit a tree
+typedef struct BVHHIT {
+	unsigned int treeIndex; // Index of the tree that was hit
+	GLfloat time; // Distance along the ray to the hit, in multiples of the ray direction's length
+	Vec3 point; // Position of the hit
+	Vec3 normal; // Surface normal of the tree at the hit
+} BvhHit;
+
+// Builds a BVH over an array of trees, using their collision profiles as their shapes
+Bvh* bvhBuild(TreeObject* trees, unsigned int treeCount);
+// Finds the closest tree a ray hits within maxTime along its direction. Returns FALSE if it hits nothing
+bool bvhRaycast(Bvh* bvh, Vec3 origin, Vec3 direction, GLfloat maxTime, BvhHit* hit);
+// Returns if the segment between two points passes through any tree
+bool bvhSegmentIntersects(Bvh* bvh, Vec3 start, Vec3 end);
+// Finds up to k trees nearest (on the XZ plane) to a point, closest first. Returns how many were found
+unsigned int bvhNearest(Bvh* bvh, Vec3 point, unsigned int k, unsigned int* treeIndices, GLfloat* distances);
+// Raycasts a batch of rays, traversing them through the hierarchy in packets. Each ray's hit has
+// a negative time if it missed
+void bvhRaycastPacket(Bvh* bvh, const Vec3* origins, const Vec3* directions, GLfloat maxTime, unsigned int count, BvhHit* hits);
+// Tests a ray against a single tree, returning if it hits within maxTime
+bool bvhRaycastTree(TreeObject* tree, Vec3 origin, Vec3 direction, GLfloat maxTime, BvhHit* hit);
+// Frees a BVH
+void bvhFree(Bvh* bvh);
@@ -0,0 +1,163 @@
+#include "cull.h"
+
+Frustum cullFrustumFromMatrices(const GLfloat projection[16], const GLfloat modelview[16]) {
+	GLfloat clip[16];
+	Frustum frustum;
+
+	// Both are column major, so element (row, column) is at [column * 4 + row]
+	for (unsigned int column = 0; column < 4; ++column) {
+		for (unsigned int row = 0; row < 4; ++row) {
+			clip[column * 4 + row] = 0;
+			for (unsigned int k = 0; k < 4; ++k) {
+				clip[column * 4 + row] += projection[k * 4 + row] * modelview[column * 4 + k];
+			}
+		}
+	}
+
+	// A point is inside when -w <= x, y, z <= w in clip space, so each plane is the last row plus or
+	// minus one of the others (Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes", 2001)
+	for (unsigned int plane = 0; plane < 6; ++plane) {
+		const GLfloat sign = plane & 1 ? -1.0f : 1.0f;
+		GLfloat length = 0;
+
+		for (unsigned int column = 0; column < 4; ++column) {
+			frustum.planes[plane][column] = clip[column * 4 + 3] + sign * clip[column * 4 + plane / 2];
+		}
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			length += frustum.planes[plane][axis] * frustum.planes[plane][axis];
+		}
+		length = sqrt(length);
+		for (unsigned int column = 0; column < 4; ++column) {
+			frustum.planes[plane][column] /= length;
+		}
+	}
+	return frustum;
+}
+
+Frustum cullFrustumCurrent(void) {
+	GLfloat projection[16], modelview[16];
+	glGetFloatv(GL_PROJECTION_MATRIX, projection);
+	glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+	return cullFrustumFromMatrices(projection, modelview);
+}
+
+bool cullSphereVisible(Frustum* frustum, Vec3 centre, GLfloat radius) {
+	for (unsigned int plane = 0; plane < 6; ++plane) {
+		const GLfloat* p = frustum->planes[plane];
+		if (p[0] * centre.x + p[1] * centre.y + p[2] * centre.z + p[3] < -radius) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+TreeCull* cullCreate(TreeObject* trees, unsigned int treeCount) {
+	TreeCull* cull = allocCalloc(ALLOC_RENDER, 1, sizeof(TreeCull));
+	cull->trees = trees;
+	cull->treeCount = treeCount;
+	cull->models = allocMalloc(ALLOC_RENDER, treeCount);
+	cull->distances = allocMalloc(ALLOC_RENDER, treeCount * sizeof(GLfloat));
+	cull->chunkCount = (treeCount + CULL_CHUNK_SIZE - 1) / CULL_CHUNK_SIZE;
+	cull->chunks = allocMalloc(ALLOC_RENDER, cull->chunkCount * sizeof(CullChunk));
+
+	// Every tree could be of the same model, so each list has room for all of them
+	for (unsigned int model = 0; model < TREE_MODEL_COUNT; ++model) {
+		cull->instances[model] = allocMalloc(ALLOC_RENDER, treeCount * sizeof(unsigned int));
+		cull->instanceDistances[model] = allocMalloc(ALLOC_RENDER, treeCount * sizeof(GLfloat));
+	}
+	return cull;
+}
+
+void cullSetModelBounds(TreeCull* cull, GLuint modelIndex, Vec3 minimum, Vec3 maximum) {
+	const Vec3 half = { (maximum.x - minimum.x) / 2, (maximum.y - minimum.y) / 2, (maximum.z - minimum.z) / 2 };
+	cull->centres[modelIndex] = (Vec3) { minimum.x + half.x, minimum.y + half.y, minimum.z + half.z };
+	cull->radii[modelIndex] = sqrt(half.x * half.x + half.y * half.y + half.z * half.z);
+}
+
+// Tests each tree in a range of chunks against the frustum, and counts the visible ones of each model
+void cullClassifyJob(void* data, unsigned int begin, unsigned int end) {
+	TreeCull* cull = data;
+
+	for (unsigned int chunk = begin; chunk < end; ++chunk) {
+		CullChunk* counts = &cull->chunks[chunk];
+		const unsigned int last = (chunk + 1) * CULL_CHUNK_SIZE < cull->treeCount ? (chunk + 1) * CULL_CHUNK_SIZE : cull->treeCount;
+
+		for (unsigned int model = 0; model < TREE_MODEL_COUNT; ++model) {
+			counts->counts[model] = 0;
+		}
+
+		for (unsigned int i = chunk * CULL_CHUNK_SIZE; i < last; ++i) {
+			const TreeObject* tree = &cull->trees[i];
+			const GLuint model = tree->modelIndex;
+			const Vec3 position = { tree->position.x, tree->height, tree->position.y };
+			const Vec3 centre = { position.x + cull->centres[model].x, position.y + cull->centres[model].y,
+				position.z + cull->centres[model].z };
+
+			if (!cullSphereVisible(&cull->frustum, centre, cull->radii[model])) {
+				cull->models[i] = CULL_HIDDEN;
+				continue;
+			}
+
+			const GLfloat dx = position.x - cull->camera.x, dy = position.y - cull->camera.y, dz = position.z - cull->camera.z;
+			cull->models[i] = (unsigned char)model;
+			cull->distances[i] = sqrt(dx * dx + dy * dy + dz * dz);
+			++counts->counts[model];
+		}
+	}
+}
+
+// Copies the visible trees in a range of chunks into the ranges of the lists the prefix sum gave them
+void cullScatterJob(void* data, unsigned int begin, unsigned int end) {
+	TreeCull* cull = data;
+
+	for (unsigned int chunk = begin; chunk < end; ++chunk) {
+		unsigned int next[TREE_MODEL_COUNT];
+		const unsigned int last = (chunk + 1) * CULL_CHUNK_SIZE < cull->treeCount ? (chunk + 1) * CULL_CHUNK_SIZE : cull->treeCount;
+
+		for (unsigned int model = 0; model < TREE_MODEL_COUNT; ++model) {
+			next[model] = cull->chunks[chunk].offsets[model];
+		}
+
+		for (unsigned int i = chunk * CULL_CHUNK_SIZE; i < last; ++i) {
+			const unsigned char model = cull->models[i];
+			if (model != CULL_HIDDEN) {
+				cull->instances[model][next[model]] = i;
+				cull->instanceDistances[model][next[model]] = cull->distances[i];
+				++next[model];
+			}
+		}
+	}
+}
+
+void cullTrees(TreeCull* cull, Frustum* frustum, Vec3 camera) {
+	cull->frustum = *frustum;
+	cull->camera = camera;
+
+	jobParallelFor(cullClassifyJob, cull, cull->chunkCount, 0);
+
+	// There's only one sum per chunk and model, far too few to be worth spreading over the threads
+	for (unsigned int model = 0; model < TREE_MODEL_COUNT; ++model) {
+		unsigned int offset = 0;
+		for (unsigned int chunk = 0; chunk < cull->chunkCount; ++chunk) {
+			cull->chunks[chunk].offsets[model] = offset;
+			offset += cull->chunks[chunk].counts[model];
+		}
+		cull->instanceCounts[model] = offset;
+	}
+
+	jobParallelFor(cullScatterJob, cull, cull->chunkCount, 0);
+}
+
+void cullFree(TreeCull* cull) {
+	if (cull == NULL) {
+		return;
+	}
+	for (unsigned int model = 0; model < TREE_MODEL_COUNT; ++model) {
+		allocFree(cull->instances[model]);
+		allocFree(cull->instanceDistances[model]);
+	}
+	allocFree(cull->models);
+	allocFree(cull->distances);
+	allocFree(cull->chunks);
+	allocFree(cull);
+}
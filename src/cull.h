@@ -0,0 +1,72 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <freeglut.h>
+#include "misc.h"
+#include "vecmath.h"
+#include "tree.h"
+#include "job.h"
+#include "alloc.h"
+
+/*
+ * <cull.c/cull.h> Culls the trees against the view frustum on the job scheduler each frame, and builds
+ * the list of visible trees of each model for the pass scheduler to draw. The trees are split into
+ * chunks, and every chunk is tested on whichever thread picks it up, counting its visible trees of each
+ * model. An exclusive prefix sum over those counts then gives each chunk its own range of every
+ * model's list, so a second parallel pass can copy the trees into place without any locks, leaving
+ * each list in the same order as the tree array whatever the number of threads
+ *
+ * The GL thread only reads the matrices before the jobs run and submits the lists after
+ */
+
+// Number of trees each chunk holds, and so the least work a thread is handed at once
+#define CULL_CHUNK_SIZE 128
+// Marks a tree that isn't in the view frustum
+#define CULL_HIDDEN 0xFF
+
+// The six planes bounding what the camera can see, each (a, b, c, d) with ax + by + cz + d >= 0 on
+// the inside and (a, b, c) of unit length, so the value is a distance
+typedef struct FRUSTUM {
+	GLfloat planes[6][4];
+} Frustum;
+
+typedef struct CULLCHUNK {
+	unsigned int counts[TREE_MODEL_COUNT];	// Visible trees of each model in the chunk
+	unsigned int offsets[TREE_MODEL_COUNT];	// Where the chunk's trees of each model start in its list
+} CullChunk;
+
+typedef struct TREECULL {
+	TreeObject* trees;
+	unsigned int treeCount;
+	Vec3 centres[TREE_MODEL_COUNT];		// Bounding sphere of each model, relative to the tree's position
+	GLfloat radii[TREE_MODEL_COUNT];
+
+	Frustum frustum;					// What the current cull is against
+	Vec3 camera;
+	unsigned char* models;				// Model of each tree if it's visible, otherwise CULL_HIDDEN
+	GLfloat* distances;					// Distance of each tree from the camera, for the visible ones
+	CullChunk* chunks;
+	unsigned int chunkCount;
+
+	unsigned int* instances[TREE_MODEL_COUNT];	// Indexes of the visible trees of each model, in tree order
+	GLfloat* instanceDistances[TREE_MODEL_COUNT];	// Their distances from the camera
+	unsigned int instanceCounts[TREE_MODEL_COUNT];
+} TreeCull;
+
+// Extracts the frustum from column major projection and modelview matrices, in the space the modelview
+// matrix transforms from
+Frustum cullFrustumFromMatrices(const GLfloat projection[16], const GLfloat modelview[16]);
+// Extracts the frustum from OpenGL's current projection and modelview matrices
+Frustum cullFrustumCurrent(void);
+// Returns whether a sphere is at least partly inside a frustum. Spheres near a corner can be let through
+// when they're outside, but one that's inside is never turned away
+bool cullSphereVisible(Frustum* frustum, Vec3 centre, GLfloat radius);
+// Creates the buffers for culling an array of trees. Every model's bounds start out empty
+TreeCull* cullCreate(TreeObject* trees, unsigned int treeCount);
+// Sets the bounding sphere of a tree model to one around a box, relative to the tree's position
+void cullSetModelBounds(TreeCull* cull, GLuint modelIndex, Vec3 minimum, Vec3 maximum);
+// Culls the trees against a frustum and fills in the instance lists, using every thread in the scheduler
+void cullTrees(TreeCull* cull, Frustum* frustum, Vec3 camera);
+// Frees the buffers for culling trees
+void cullFree(TreeCull* cull);
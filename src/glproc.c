@@ -0,0 +1,128 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "glproc.h"
+
+GlGenBuffersProc glprocGenBuffers = NULL;
+GlDeleteBuffersProc glprocDeleteBuffers = NULL;
+GlBindBufferProc glprocBindBuffer = NULL;
+GlBufferDataProc glprocBufferData = NULL;
+GlBufferSubDataProc glprocBufferSubData = NULL;
+GlGenQueriesProc glprocGenQueries = NULL;
+GlDeleteQueriesProc glprocDeleteQueries = NULL;
+GlBeginQueryProc glprocBeginQuery = NULL;
+GlEndQueryProc glprocEndQuery = NULL;
+GlGetQueryObjectuivProc glprocGetQueryObjectuiv = NULL;
+GlGetQueryObjectui64vProc glprocGetQueryObjectui64v = NULL;
+GlCreateShaderProc glprocCreateShader = NULL;
+GlShaderSourceProc glprocShaderSource = NULL;
+GlCompileShaderProc glprocCompileShader = NULL;
+GlGetShaderivProc glprocGetShaderiv = NULL;
+GlGetShaderInfoLogProc glprocGetShaderInfoLog = NULL;
+GlDeleteShaderProc glprocDeleteShader = NULL;
+GlCreateProgramProc glprocCreateProgram = NULL;
+GlAttachShaderProc glprocAttachShader = NULL;
+GlLinkProgramProc glprocLinkProgram = NULL;
+GlGetProgramivProc glprocGetProgramiv = NULL;
+GlGetProgramInfoLogProc glprocGetProgramInfoLog = NULL;
+GlDeleteProgramProc glprocDeleteProgram = NULL;
+GlUseProgramProc glprocUseProgram = NULL;
+GlGetUniformLocationProc glprocGetUniformLocation = NULL;
+GlUniform1iProc glprocUniform1i = NULL;
+GlGetUniformBlockIndexProc glprocGetUniformBlockIndex = NULL;
+GlUniformBlockBindingProc glprocUniformBlockBinding = NULL;
+GlBindBufferBaseProc glprocBindBufferBase = NULL;
+GlBindBufferRangeProc glprocBindBufferRange = NULL;
+GlVertexAttribPointerProc glprocVertexAttribPointer = NULL;
+GlEnableVertexAttribArrayProc glprocEnableVertexAttribArray = NULL;
+GlDisableVertexAttribArrayProc glprocDisableVertexAttribArray = NULL;
+GlGenVertexArraysProc glprocGenVertexArrays = NULL;
+GlDeleteVertexArraysProc glprocDeleteVertexArrays = NULL;
+GlBindVertexArrayProc glprocBindVertexArray = NULL;
+GlVertexAttribDivisorProc glprocVertexAttribDivisor = NULL;
+GlDrawElementsInstancedProc glprocDrawElementsInstanced = NULL;
+GlprocLoader glprocLoader = NULL;
+
+void glprocSetLoader(GlprocLoader loader) {
+	glprocLoader = loader;
+}
+
+void* glprocFind(const char* name) {
+	return glprocLoader != NULL ? glprocLoader(name) : (void*)glutGetProcAddress(name);
+}
+
+void glprocLoad(void) {
+	glprocGenBuffers = (GlGenBuffersProc)glprocFind("glGenBuffers");
+	glprocDeleteBuffers = (GlDeleteBuffersProc)glprocFind("glDeleteBuffers");
+	glprocBindBuffer = (GlBindBufferProc)glprocFind("glBindBuffer");
+	glprocBufferData = (GlBufferDataProc)glprocFind("glBufferData");
+	glprocBufferSubData = (GlBufferSubDataProc)glprocFind("glBufferSubData");
+	glprocGenQueries = (GlGenQueriesProc)glprocFind("glGenQueries");
+	glprocDeleteQueries = (GlDeleteQueriesProc)glprocFind("glDeleteQueries");
+	glprocBeginQuery = (GlBeginQueryProc)glprocFind("glBeginQuery");
+	glprocEndQuery = (GlEndQueryProc)glprocFind("glEndQuery");
+	glprocGetQueryObjectuiv = (GlGetQueryObjectuivProc)glprocFind("glGetQueryObjectuiv");
+	glprocGetQueryObjectui64v = (GlGetQueryObjectui64vProc)glprocFind("glGetQueryObjectui64v");
+	if (glprocGetQueryObjectui64v == NULL) {
+		glprocGetQueryObjectui64v = (GlGetQueryObjectui64vProc)glprocFind("glGetQueryObjectui64vEXT");
+	}
+	glprocCreateShader = (GlCreateShaderProc)glprocFind("glCreateShader");
+	glprocShaderSource = (GlShaderSourceProc)glprocFind("glShaderSource");
+	glprocCompileShader = (GlCompileShaderProc)glprocFind("glCompileShader");
+	glprocGetShaderiv = (GlGetShaderivProc)glprocFind("glGetShaderiv");
+	glprocGetShaderInfoLog = (GlGetShaderInfoLogProc)glprocFind("glGetShaderInfoLog");
+	glprocDeleteShader = (GlDeleteShaderProc)glprocFind("glDeleteShader");
+	glprocCreateProgram = (GlCreateProgramProc)glprocFind("glCreateProgram");
+	glprocAttachShader = (GlAttachShaderProc)glprocFind("glAttachShader");
+	glprocLinkProgram = (GlLinkProgramProc)glprocFind("glLinkProgram");
+	glprocGetProgramiv = (GlGetProgramivProc)glprocFind("glGetProgramiv");
+	glprocGetProgramInfoLog = (GlGetProgramInfoLogProc)glprocFind("glGetProgramInfoLog");
+	glprocDeleteProgram = (GlDeleteProgramProc)glprocFind("glDeleteProgram");
+	glprocUseProgram = (GlUseProgramProc)glprocFind("glUseProgram");
+	glprocGetUniformLocation = (GlGetUniformLocationProc)glprocFind("glGetUniformLocation");
+	glprocUniform1i = (GlUniform1iProc)glprocFind("glUniform1i");
+	glprocGetUniformBlockIndex = (GlGetUniformBlockIndexProc)glprocFind("glGetUniformBlockIndex");
+	glprocUniformBlockBinding = (GlUniformBlockBindingProc)glprocFind("glUniformBlockBinding");
+	glprocBindBufferBase = (GlBindBufferBaseProc)glprocFind("glBindBufferBase");
+	glprocBindBufferRange = (GlBindBufferRangeProc)glprocFind("glBindBufferRange");
+	glprocVertexAttribPointer = (GlVertexAttribPointerProc)glprocFind("glVertexAttribPointer");
+	glprocEnableVertexAttribArray = (GlEnableVertexAttribArrayProc)glprocFind("glEnableVertexAttribArray");
+	glprocDisableVertexAttribArray = (GlDisableVertexAttribArrayProc)glprocFind("glDisableVertexAttribArray");
+	glprocGenVertexArrays = (GlGenVertexArraysProc)glprocFind("glGenVertexArrays");
+	glprocDeleteVertexArrays = (GlDeleteVertexArraysProc)glprocFind("glDeleteVertexArrays");
+	glprocBindVertexArray = (GlBindVertexArrayProc)glprocFind("glBindVertexArray");
+	glprocVertexAttribDivisor = (GlVertexAttribDivisorProc)glprocFind("glVertexAttribDivisor");
+	glprocDrawElementsInstanced = (GlDrawElementsInstancedProc)glprocFind("glDrawElementsInstanced");
+}
+
+bool glprocHasBuffers(void) {
+	return glprocGenBuffers != NULL && glprocDeleteBuffers != NULL && glprocBindBuffer != NULL
+		&& glprocBufferData != NULL && glprocBufferSubData != NULL;
+}
+
+bool glprocHasShaders(void) {
+	return glprocCreateShader != NULL && glprocShaderSource != NULL && glprocCompileShader != NULL
+		&& glprocGetShaderiv != NULL && glprocGetShaderInfoLog != NULL && glprocDeleteShader != NULL
+		&& glprocCreateProgram != NULL && glprocAttachShader != NULL && glprocLinkProgram != NULL
+		&& glprocGetProgramiv != NULL && glprocGetProgramInfoLog != NULL && glprocDeleteProgram != NULL
+		&& glprocUseProgram != NULL && glprocGetUniformLocation != NULL && glprocUniform1i != NULL
+		&& glprocGetUniformBlockIndex != NULL && glprocUniformBlockBinding != NULL && glprocBindBufferBase != NULL
+		&& glprocBindBufferRange != NULL && glprocVertexAttribPointer != NULL && glprocEnableVertexAttribArray != NULL
+		&& glprocDisableVertexAttribArray != NULL && glprocGenVertexArrays != NULL && glprocDeleteVertexArrays != NULL
+		&& glprocBindVertexArray != NULL && glprocVertexAttribDivisor != NULL && glprocDrawElementsInstanced != NULL
+		&& glprocHasBuffers();
+}
+
+bool glprocHasTimerQueries(void) {
+	const char* version = (const char*)glGetString(GL_VERSION);
+	const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+	int major = 0, minor = 0;
+
+	// Some drivers hand out the functions without supporting GL_TIME_ELAPSED, so it's checked for too
+	if (version != NULL) {
+		sscanf(version, "%d.%d", &major, &minor);
+	}
+	const bool supported = major > 3 || (major == 3 && minor >= 3)
+		|| (extensions != NULL && (strstr(extensions, "GL_ARB_timer_query") != NULL || strstr(extensions, "GL_EXT_timer_query") != NULL));
+
+	return supported && glprocGenQueries != NULL && glprocDeleteQueries != NULL && glprocBeginQuery != NULL
+		&& glprocEndQuery != NULL && glprocGetQueryObjectuiv != NULL && glprocGetQueryObjectui64v != NULL;
+}
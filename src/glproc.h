@@ -0,0 +1,163 @@
+#pragma once
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <freeglut.h>
+#include "misc.h"
+
+/*
+ * <glproc.c/glproc.h> Loads the OpenGL functions newer than 1.1 at runtime, since Windows' opengl32
+ * only exports the 1.1 ones. Anything that uses them should check it was loaded first
+ */
+
+// Buffer object constants, which aren't in the 1.1 headers
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_STATIC_DRAW 0x88E4
+#define GL_DYNAMIC_DRAW 0x88E8
+#define GL_STREAM_DRAW 0x88E0
+#endif
+
+// Texture wrapping that stops at the edge texels (OpenGL 1.2), which isn't in the 1.1 headers either
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+// Query object constants for timing work on the GPU (OpenGL 1.5 and 3.3)
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+
+// Shader and uniform buffer constants (OpenGL 2.0 and 3.1)
+#ifndef GL_VERTEX_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#define GL_CURRENT_PROGRAM 0x8B8D
+#endif
+#ifndef GL_UNIFORM_BUFFER
+#define GL_UNIFORM_BUFFER 0x8A11
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 0x8A34
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+#endif
+
+// Half float vertex attributes (OpenGL 3.0)
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+typedef ptrdiff_t GLsizeiptrProc;
+typedef ptrdiff_t GLintptrProc;
+
+typedef void (APIENTRY* GlGenBuffersProc)(GLsizei count, GLuint* buffers);
+typedef void (APIENTRY* GlDeleteBuffersProc)(GLsizei count, const GLuint* buffers);
+typedef void (APIENTRY* GlBindBufferProc)(GLenum target, GLuint buffer);
+typedef void (APIENTRY* GlBufferDataProc)(GLenum target, GLsizeiptrProc size, const void* data, GLenum usage);
+typedef void (APIENTRY* GlBufferSubDataProc)(GLenum target, GLintptrProc offset, GLsizeiptrProc size, const void* data);
+typedef void (APIENTRY* GlGenQueriesProc)(GLsizei count, GLuint* queries);
+typedef void (APIENTRY* GlDeleteQueriesProc)(GLsizei count, const GLuint* queries);
+typedef void (APIENTRY* GlBeginQueryProc)(GLenum target, GLuint query);
+typedef void (APIENTRY* GlEndQueryProc)(GLenum target);
+typedef void (APIENTRY* GlGetQueryObjectuivProc)(GLuint query, GLenum name, GLuint* value);
+typedef void (APIENTRY* GlGetQueryObjectui64vProc)(GLuint query, GLenum name, unsigned long long* value);
+typedef GLuint (APIENTRY* GlCreateShaderProc)(GLenum type);
+typedef void (APIENTRY* GlShaderSourceProc)(GLuint shader, GLsizei count, const char* const* sources, const GLint* lengths);
+typedef void (APIENTRY* GlCompileShaderProc)(GLuint shader);
+typedef void (APIENTRY* GlGetShaderivProc)(GLuint shader, GLenum name, GLint* value);
+typedef void (APIENTRY* GlGetShaderInfoLogProc)(GLuint shader, GLsizei size, GLsizei* length, char* log);
+typedef void (APIENTRY* GlDeleteShaderProc)(GLuint shader);
+typedef GLuint (APIENTRY* GlCreateProgramProc)(void);
+typedef void (APIENTRY* GlAttachShaderProc)(GLuint program, GLuint shader);
+typedef void (APIENTRY* GlLinkProgramProc)(GLuint program);
+typedef void (APIENTRY* GlGetProgramivProc)(GLuint program, GLenum name, GLint* value);
+typedef void (APIENTRY* GlGetProgramInfoLogProc)(GLuint program, GLsizei size, GLsizei* length, char* log);
+typedef void (APIENTRY* GlDeleteProgramProc)(GLuint program);
+typedef void (APIENTRY* GlUseProgramProc)(GLuint program);
+typedef GLint (APIENTRY* GlGetUniformLocationProc)(GLuint program, const char* name);
+typedef void (APIENTRY* GlUniform1iProc)(GLint location, GLint value);
+typedef GLuint (APIENTRY* GlGetUniformBlockIndexProc)(GLuint program, const char* name);
+typedef void (APIENTRY* GlUniformBlockBindingProc)(GLuint program, GLuint block, GLuint binding);
+typedef void (APIENTRY* GlBindBufferBaseProc)(GLenum target, GLuint index, GLuint buffer);
+typedef void (APIENTRY* GlBindBufferRangeProc)(GLenum target, GLuint index, GLuint buffer, GLintptrProc offset, GLsizeiptrProc size);
+typedef void (APIENTRY* GlVertexAttribPointerProc)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+	const void* pointer);
+typedef void (APIENTRY* GlEnableVertexAttribArrayProc)(GLuint index);
+typedef void (APIENTRY* GlDisableVertexAttribArrayProc)(GLuint index);
+typedef void (APIENTRY* GlGenVertexArraysProc)(GLsizei count, GLuint* arrays);
+typedef void (APIENTRY* GlDeleteVertexArraysProc)(GLsizei count, const GLuint* arrays);
+typedef void (APIENTRY* GlBindVertexArrayProc)(GLuint array);
+typedef void (APIENTRY* GlVertexAttribDivisorProc)(GLuint index, GLuint divisor);
+typedef void (APIENTRY* GlDrawElementsInstancedProc)(GLenum mode, GLsizei count, GLenum type, const void* indices,
+	GLsizei instanceCount);
+
+// Looks up an OpenGL function by name, returning NULL if the context doesn't have it
+typedef void* (*GlprocLoader)(const char* name);
+
+// Buffer objects (OpenGL 1.5), NULL until glprocLoad finds them
+extern GlGenBuffersProc glprocGenBuffers;
+extern GlDeleteBuffersProc glprocDeleteBuffers;
+extern GlBindBufferProc glprocBindBuffer;
+extern GlBufferDataProc glprocBufferData;
+extern GlBufferSubDataProc glprocBufferSubData;
+// Query objects (OpenGL 1.5) and their 64 bit results (OpenGL 3.3 or ARB/EXT_timer_query)
+extern GlGenQueriesProc glprocGenQueries;
+extern GlDeleteQueriesProc glprocDeleteQueries;
+extern GlBeginQueryProc glprocBeginQuery;
+extern GlEndQueryProc glprocEndQuery;
+extern GlGetQueryObjectuivProc glprocGetQueryObjectuiv;
+extern GlGetQueryObjectui64vProc glprocGetQueryObjectui64v;
+// Shaders and programs (OpenGL 2.0) and uniform blocks (OpenGL 3.1)
+extern GlCreateShaderProc glprocCreateShader;
+extern GlShaderSourceProc glprocShaderSource;
+extern GlCompileShaderProc glprocCompileShader;
+extern GlGetShaderivProc glprocGetShaderiv;
+extern GlGetShaderInfoLogProc glprocGetShaderInfoLog;
+extern GlDeleteShaderProc glprocDeleteShader;
+extern GlCreateProgramProc glprocCreateProgram;
+extern GlAttachShaderProc glprocAttachShader;
+extern GlLinkProgramProc glprocLinkProgram;
+extern GlGetProgramivProc glprocGetProgramiv;
+extern GlGetProgramInfoLogProc glprocGetProgramInfoLog;
+extern GlDeleteProgramProc glprocDeleteProgram;
+extern GlUseProgramProc glprocUseProgram;
+extern GlGetUniformLocationProc glprocGetUniformLocation;
+extern GlUniform1iProc glprocUniform1i;
+extern GlGetUniformBlockIndexProc glprocGetUniformBlockIndex;
+extern GlUniformBlockBindingProc glprocUniformBlockBinding;
+extern GlBindBufferBaseProc glprocBindBufferBase;
+extern GlBindBufferRangeProc glprocBindBufferRange;
+// Generic vertex attributes (OpenGL 2.0) and vertex array objects (OpenGL 3.0)
+extern GlVertexAttribPointerProc glprocVertexAttribPointer;
+extern GlEnableVertexAttribArrayProc glprocEnableVertexAttribArray;
+extern GlDisableVertexAttribArrayProc glprocDisableVertexAttribArray;
+extern GlGenVertexArraysProc glprocGenVertexArrays;
+extern GlDeleteVertexArraysProc glprocDeleteVertexArrays;
+extern GlBindVertexArrayProc glprocBindVertexArray;
+// Instanced drawing (OpenGL 3.3)
+extern GlVertexAttribDivisorProc glprocVertexAttribDivisor;
+extern GlDrawElementsInstancedProc glprocDrawElementsInstanced;
+
+// Replaces GLUT as the way functions are looked up, for contexts that weren't created by GLUT
+void glprocSetLoader(GlprocLoader loader);
+// Looks up a function with the current loader
+void* glprocFind(const char* name);
+// Looks up every function this file knows about, which must be done after the window (and so the
+// OpenGL context) has been created
+void glprocLoad(void);
+// Returns whether the buffer object functions were found
+bool glprocHasBuffers(void);
+// Returns whether the shader, program, uniform block, vertex attribute, vertex array and instancing functions were found
+bool glprocHasShaders(void);
+// Returns whether GL_TIME_ELAPSED queries are supported and their functions were found
+bool glprocHasTimerQueries(void);
@@ -0,0 +1,198 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "golden.h"
+#include "main.h"
+
+// The scene the poses are set up in, by init() as it would be for the window
+extern Helicopter helicopter;
+extern GLfloat waterHeight, waterOffset, waterTime;
+extern Headless headlessState;
+
+// Between them the poses look over the ground, the pond, the trees close up and far off, and the sky
+const GoldenPose goldenPoses[] = {
+	{ "start", { -100, 1, 0 }, { 0, 0, 0 }, 0 },
+	{ "pond", { -25, 6, 5 }, { 0, 0, 0 }, 10 },
+	{ "high", { -60, 45, 30 }, { 0, 0, 0 }, 45 },
+	{ "forest", { 60, 4, -60 }, { 0, 0, 0 }, 135 },
+	{ "banking", { 20, 10, 80 }, { 3, 0, 1 }, 300 },
+	{ "edge", { 200, 8, 0 }, { 0, 0, 0 }, 180 },
+};
+
+int goldenCompareTimes(const void* a, const void* b) {
+	const double timeA = *(const double*)a, timeB = *(const double*)b;
+	return timeA < timeB ? -1 : timeA > timeB ? 1 : 0;
+}
+
+// Puts the helicopter in a pose, with everything else that moves held still, and publishes it to be drawn
+void goldenSetPose(const GoldenPose* pose) {
+	// With terrain the heights are taken above the ground, as the helicopter's start is, rather than
+	// leaving the forest pose looking at the hills from underneath
+	helicopter.position = pose->position;
+	if (collisionTerrain != NULL) {
+		helicopter.position.y += helicopterFloor(pose->position.x, pose->position.z) - HELI_MIN_HEIGHT;
+	}
+	helicopter.velocity = pose->velocity;
+	helicopter.angle = pose->angle;
+	helicopter.angularVelocity = 0;
+	helicopter.rotorAngle = 30;
+	helicopter.rotorAngularVelocity = 0;
+	helicopter.startup = FALSE;
+	helicopter.atEdge = FALSE;
+
+	waterHeight = -1;
+	waterOffset = 0;
+	waterTime = 2;
+	publishSnapshot(0);
+}
+
+GoldenDiff goldenCompare(unsigned char* frame, unsigned char* golden, unsigned int count, unsigned int tolerance,
+	unsigned char* diffImage) {
+	GoldenDiff diff = { 0, 0, 0 };
+	double squaredError = 0;
+
+	for (unsigned int i = 0; i < count; ++i) {
+		unsigned int pixelDifference = 0;
+
+		for (unsigned int channel = 0; channel < 3; ++channel) {
+			const int difference = abs(frame[i * 3 + channel] - golden[i * 3 + channel]);
+			pixelDifference = difference > pixelDifference ? difference : pixelDifference;
+			squaredError += difference * difference;
+		}
+
+		diff.maxDifference = pixelDifference > diff.maxDifference ? pixelDifference : diff.maxDifference;
+		if (pixelDifference > tolerance) {
+			++diff.badPixels;
+		}
+
+		if (diffImage != NULL) {
+			for (unsigned int channel = 0; channel < 3; ++channel) {
+				diffImage[i * 3 + channel] = pixelDifference > tolerance ? (channel == 0 ? 255 : 0) : golden[i * 3 + channel] / 2;
+			}
+		}
+	}
+
+	const double meanSquaredError = squaredError / ((double)count * 3);
+	diff.psnr = meanSquaredError > 0 ? 10 * log10(255.0 * 255.0 / meanSquaredError) : INFINITY;
+	return diff;
+}
+
+double goldenSavedTime(char* fileName, char* poseName) {
+	FILE* file = fopen(fileName, "r");
+	char line[256];
+	double time = -1;
+
+	if (file == NULL) {
+		return time;
+	}
+
+	const size_t nameLength = strlen(poseName);
+	while (fgets(line, sizeof(line), file) != NULL) {
+		if (!strncmp(line, poseName, nameLength) && line[nameLength] == ',') {
+			time = atof(line + nameLength + 1);
+			break;
+		}
+	}
+
+	fclose(file);
+	return time;
+}
+
+bool goldenRun(char* directory, bool update, char* outputDirectory, unsigned int tolerance) {
+	const unsigned int width = headlessState.width, height = headlessState.height, count = width * height;
+	char* timingsDirectory = update ? directory : outputDirectory;
+	FILE* timingsFile = NULL;
+	char fileName[1024];
+	bool passed = TRUE;
+
+	reshape(width, height);
+	printf("%s %u poses at %ux%u with %s\n", update ? "Saving" : "Checking", (unsigned int)_countof(goldenPoses),
+		width, height, (const char*)glGetString(GL_RENDERER));
+
+	if (timingsDirectory != NULL) {
+		sprintf_s(fileName, sizeof(fileName), "%s/%s", timingsDirectory, GOLDEN_TIMINGS_FILE);
+		timingsFile = fopen(fileName, "w");
+		if (timingsFile == NULL) {
+			printf("Couldn't write '%s'\n", fileName);
+			return FALSE;
+		}
+		fprintf(timingsFile, "pose,median_ms\n");
+	}
+
+	for (unsigned int i = 0; i < _countof(goldenPoses); ++i) {
+		const GoldenPose* pose = &goldenPoses[i];
+		double times[GOLDEN_TIMING_DRAWS];
+
+		goldenSetPose(pose);
+		for (unsigned int draw = 0; draw < GOLDEN_TIMING_DRAWS; ++draw) {
+			frameReset();
+			const unsigned long long start = platformNanoseconds();
+			display();
+			times[draw] = (platformNanoseconds() - start) / 1e6;
+		}
+		qsort(times, GOLDEN_TIMING_DRAWS, sizeof(double), goldenCompareTimes);
+		const double time = times[GOLDEN_TIMING_DRAWS / 2];
+
+		unsigned char* frame = headlessReadFrame();
+		if (timingsFile != NULL) {
+			fprintf(timingsFile, "%s,%.3f\n", pose->name, time);
+		}
+
+		if (update) {
+			sprintf_s(fileName, sizeof(fileName), "%s/%s.ppm", directory, pose->name);
+			if (!headlessWritePPM(fileName, frame, width, height)) {
+				printf("Couldn't write '%s'\n", fileName);
+				passed = FALSE;
+			} else {
+				printf("%-10s saved, %.3f ms\n", pose->name, time);
+			}
+			free(frame);
+			continue;
+		}
+
+		if (outputDirectory != NULL) {
+			sprintf_s(fileName, sizeof(fileName), "%s/%s.ppm", outputDirectory, pose->name);
+			headlessWritePPM(fileName, frame, width, height);
+		}
+
+		unsigned int goldenWidth, goldenHeight;
+		sprintf_s(fileName, sizeof(fileName), "%s/%s.ppm", directory, pose->name);
+		unsigned char* golden = headlessReadPPM(fileName, &goldenWidth, &goldenHeight);
+
+		if (golden == NULL || goldenWidth != width || goldenHeight != height) {
+			printf("%-10s FAILED, '%s' is missing or isn't %ux%u\n", pose->name, fileName, width, height);
+			passed = FALSE;
+		} else {
+			unsigned char* diffImage = outputDirectory != NULL ? malloc((size_t)count * 3) : NULL;
+			const GoldenDiff diff = goldenCompare(frame, golden, count, tolerance, diffImage);
+			const bool matched = diff.badPixels <= count * GOLDEN_MAX_BAD_FRACTION;
+
+			sprintf_s(fileName, sizeof(fileName), "%s/%s", directory, GOLDEN_TIMINGS_FILE);
+			const double savedTime = goldenSavedTime(fileName, pose->name);
+
+			printf("%-10s %s, %u pixels over tolerance (%.3f%%), max difference %u, PSNR %.1f dB, %.3f ms",
+				pose->name, matched ? "passed" : "FAILED", diff.badPixels, diff.badPixels * 100.0 / count,
+				diff.maxDifference, diff.psnr, time);
+			if (savedTime > 0) {
+				printf(" (%.3f ms saved, %+.1f%%)", savedTime, (time / savedTime - 1) * 100);
+			}
+			printf("\n");
+
+			if (!matched && diffImage != NULL) {
+				sprintf_s(fileName, sizeof(fileName), "%s/%s-diff.ppm", outputDirectory, pose->name);
+				headlessWritePPM(fileName, diffImage, width, height);
+			}
+			passed = passed && matched;
+			free(diffImage);
+		}
+
+		free(golden);
+		free(frame);
+	}
+
+	if (timingsFile != NULL) {
+		fclose(timingsFile);
+	}
+	if (!update) {
+		printf("%s\n", passed ? "All poses match" : "Some poses don't match");
+	}
+	return passed;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <freeglut.h>
+#include "misc.h"
+#include "vecmath.h"
+#include "headless.h"
+
+/*
+ * <golden.c/golden.h> Golden image checks for the renderer. A fixed set of camera poses is drawn
+ * headless and compared against frames saved earlier, so a change meant only to make drawing faster
+ * can be shown to draw the same picture. Small differences from rounding are tolerated, up to a
+ * threshold on each colour channel and a share of the pixels. The time each pose takes to draw is
+ * saved with the frames, and compared the same way
+ *
+ * Run --golden-update DIR before a change to save the frames, then --golden DIR after it to check them
+ */
+
+// Largest difference in any colour channel of a pixel that still counts as matching, unless
+// --golden-tolerance gives another
+#define GOLDEN_TOLERANCE 8
+// Largest share of the pixels in a frame that can differ by more than the tolerance before it fails
+#define GOLDEN_MAX_BAD_FRACTION 0.001
+// Number of times each pose is drawn, with the median time kept
+#define GOLDEN_TIMING_DRAWS 5
+// Name of the file the timings are saved to, in the same folder as the frames
+#define GOLDEN_TIMINGS_FILE "timings.csv"
+
+typedef struct GOLDENPOSE {
+	char* name;			// Name the frame is saved under
+	Vec3 position;		// Where the helicopter is, with the camera following behind it
+	Vec3 velocity;		// Velocity of the helicopter, which it tilts into
+	GLfloat angle;		// Heading of the helicopter in degrees
+} GoldenPose;
+
+typedef struct GOLDENDIFF {
+	unsigned int maxDifference;		// Largest difference in any channel of any pixel
+	unsigned int badPixels;			// Number of pixels differing by more than the tolerance
+	double psnr;					// Peak signal to noise ratio in dB, or INFINITY if the frames are the same
+} GoldenDiff;
+
+// Compares two frames of RGB bytes, with count pixels each. If diffImage isn't NULL, it's filled with
+// the golden frame darkened, and the pixels beyond the tolerance in red
+GoldenDiff goldenCompare(unsigned char* frame, unsigned char* golden, unsigned int count, unsigned int tolerance,
+	unsigned char* diffImage);
+// Draws every pose, then either saves the frames and timings into a folder, or compares them against the
+// ones already saved there. When comparing, the frames, timings and diffs of failing frames are written to the
+// output folder if one is given. Returns FALSE if any frame failed or couldn't be read or written
+bool goldenRun(char* directory, bool update, char* outputDirectory, unsigned int tolerance);
+// Returns the time saved for a pose in a timings file, or a negative number if it isn't there
+double goldenSavedTime(char* fileName, char* poseName);
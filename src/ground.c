@@ -0,0 +1,58 @@
+#include "ground.h"
+
+bool groundTileCut(unsigned int column, unsigned int row) {
+	const int x = -GROUND_EXTENT + (int)column * GROUND_SPACING;
+	const int z = -GROUND_EXTENT + (int)row * GROUND_SPACING;
+	return x < GROUND_CUTOUT && x > -GROUND_CUTOUT && z < GROUND_CUTOUT && z > -GROUND_CUTOUT;
+}
+
+VertexBuffer* groundGenerate(void) {
+	const unsigned int side = GROUND_TILES + 1;
+	Vertex* vertices = malloc(side * side * sizeof(Vertex));
+	// Two indices per tile edge in each run, plus at most four to start and join each run
+	GLuint* indices = malloc(GROUND_TILES * (2 * (GROUND_TILES + 1) + 8) * sizeof(GLuint));
+	unsigned int indexCount = 0;
+
+	// Every tile corner is shared by the tiles around it, and the texture coordinates carry on across
+	// tiles so the repeating texture lines up the same way it did with a separate quad per tile
+	for (unsigned int row = 0; row < side; ++row) {
+		for (unsigned int column = 0; column < side; ++column) {
+			const GLfloat x = (GLfloat)(-GROUND_EXTENT + (int)column * GROUND_SPACING);
+			const GLfloat z = (GLfloat)(-GROUND_EXTENT + (int)row * GROUND_SPACING);
+			vertices[row * side + column] = (Vertex) {
+				{ x, 0, z }, { 0, 1, 0 }, { x / GROUND_SPACING, z / GROUND_SPACING }
+			};
+		}
+	}
+
+	for (unsigned int row = 0; row < GROUND_TILES; ++row) {
+		unsigned int column = 0;
+
+		while (column < GROUND_TILES) {
+			if (groundTileCut(column, row)) {
+				++column;
+				continue;
+			}
+
+			// Join on from the previous run with a pair of degenerate triangles. Every run has an even
+			// number of indices, so the winding of the strip carries on unchanged
+			if (indexCount > 0) {
+				indices[indexCount] = indices[indexCount - 1];
+				indices[indexCount + 1] = (row + 1) * side + column;
+				indexCount += 2;
+			}
+
+			for (; column < GROUND_TILES && !groundTileCut(column, row); ++column) {
+				indices[indexCount++] = (row + 1) * side + column;
+				indices[indexCount++] = row * side + column;
+			}
+			indices[indexCount++] = (row + 1) * side + column;
+			indices[indexCount++] = row * side + column;
+		}
+	}
+
+	VertexBuffer* buffer = vertexBufferCreate(GL_TRIANGLE_STRIP, vertices, side * side, indices, indexCount);
+	free(vertices);
+	free(indices);
+	return buffer;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <freeglut.h>
+#include "buffer.h"
+
+/*
+ * <ground.c/ground.h> Builds the flat ground around the pond as a single static vertex buffer
+ */
+
+// Size of each ground tile, which the ground texture is repeated across once
+#define GROUND_SPACING 5
+// Corner of the first and last tile along each axis (the ground reaches GROUND_EXTENT + GROUND_SPACING)
+#define GROUND_EXTENT 250
+// Tiles whose corner is closer than this to the origin on both axes are left out for the pond
+#define GROUND_CUTOUT 40
+// Number of tiles along each axis
+#define GROUND_TILES (2 * GROUND_EXTENT / GROUND_SPACING + 1)
+
+// Returns whether the tile in a given column and row is part of the pond cut-out
+bool groundTileCut(unsigned int column, unsigned int row);
+// Builds the ground into a vertex buffer of triangle strips, one per row of tiles, joined by
+// degenerate triangles where a row is split by the pond or moves on to the next row
+VertexBuffer* groundGenerate(void);
@@ -0,0 +1,296 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "headless.h"
+#include "main.h"
+
+// The scene headlessRun steps, set up by init() as it would be for the window
+extern unsigned int frameStartTime;
+extern unsigned long long tickCount;
+
+// The path flown without recorded inputs: take off, head out over the trees, then loop back round
+// past the pond, climbing and dropping on the way
+const HeadlessSegment headlessPath[] = {
+	{ 90, { MOTION_NONE, MOTION_UP, MOTION_NONE, MOTION_NONE } },
+	{ 180, { MOTION_FORWARD, MOTION_NONE, MOTION_NONE, MOTION_NONE } },
+	{ 150, { MOTION_FORWARD, MOTION_NONE, MOTION_NONE, MOTION_ANTICLOCKWISE } },
+	{ 120, { MOTION_FORWARD, MOTION_DOWN, MOTION_RIGHT, MOTION_NONE } },
+	{ 150, { MOTION_FORWARD, MOTION_UP, MOTION_NONE, MOTION_CLOCKWISE } },
+	{ 60, { MOTION_NONE, MOTION_NONE, MOTION_LEFT, MOTION_ANTICLOCKWISE } },
+};
+
+Headless headlessState = { 0 };
+
+#ifndef _WIN32
+void* headlessGetProcAddress(const char* name) {
+	return (void*)eglGetProcAddress(name);
+}
+#endif
+
+bool headlessCreateContext(unsigned int width, unsigned int height) {
+	headlessState.width = width;
+	headlessState.height = height;
+
+#ifdef _WIN32
+	int argc = 1;
+	char* argv[] = { "headless", NULL };
+
+	glutInit(&argc, argv);
+	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH | GLUT_STENCIL);
+	glutInitWindowSize(width, height);
+	glutCreateWindow("Headless");
+	glutHideWindow();
+#else
+	// The surfaceless platform needs no display server at all, but older EGLs without it can usually
+	// still make a pbuffer on the default display
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	headlessState.display = EGL_NO_DISPLAY;
+	if (getPlatformDisplay != NULL) {
+		headlessState.display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+	if (headlessState.display == EGL_NO_DISPLAY) {
+		headlessState.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major, minor;
+	if (headlessState.display == EGL_NO_DISPLAY || !eglInitialize(headlessState.display, &major, &minor)) {
+		printf("Couldn't initialise EGL for headless rendering\n");
+		return FALSE;
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+		EGL_DEPTH_SIZE, 24, EGL_STENCIL_SIZE, 8,
+		EGL_NONE
+	};
+	const EGLint surfaceAttributes[] = { EGL_WIDTH, (EGLint)width, EGL_HEIGHT, (EGLint)height, EGL_NONE };
+	EGLConfig config;
+	EGLint configCount = 0;
+
+	if (!eglChooseConfig(headlessState.display, configAttributes, &config, 1, &configCount) || configCount == 0
+		|| !eglBindAPI(EGL_OPENGL_API)) {
+		printf("EGL has no desktop OpenGL pbuffer config for headless rendering\n");
+		eglTerminate(headlessState.display);
+		return FALSE;
+	}
+
+	headlessState.context = eglCreateContext(headlessState.display, config, EGL_NO_CONTEXT, NULL);
+	headlessState.surface = eglCreatePbufferSurface(headlessState.display, config, surfaceAttributes);
+	if (headlessState.context == EGL_NO_CONTEXT || headlessState.surface == EGL_NO_SURFACE
+		|| !eglMakeCurrent(headlessState.display, headlessState.surface, headlessState.surface, headlessState.context)) {
+		printf("Couldn't create a %ux%u headless context (EGL error 0x%x)\n", width, height, eglGetError());
+		headlessDestroyContext();
+		return FALSE;
+	}
+
+	// GLUT was never initialised, so it can neither look up functions nor draw its bitmap fonts
+	glprocSetLoader(headlessGetProcAddress);
+	textEnabled = FALSE;
+#endif
+
+	return TRUE;
+}
+
+void headlessSwapBuffers(void) {
+	// Nothing is shown, but the frame still has to be finished for its time to count
+	glFinish();
+}
+
+void headlessDestroyContext(void) {
+#ifdef _WIN32
+	glutDestroyWindow(glutGetWindow());
+#else
+	if (headlessState.display != EGL_NO_DISPLAY) {
+		eglMakeCurrent(headlessState.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (headlessState.surface != EGL_NO_SURFACE) {
+			eglDestroySurface(headlessState.display, headlessState.surface);
+		}
+		if (headlessState.context != EGL_NO_CONTEXT) {
+			eglDestroyContext(headlessState.display, headlessState.context);
+		}
+		eglTerminate(headlessState.display);
+	}
+#endif
+	free(headlessState.input);
+	headlessState.input = NULL;
+}
+
+bool headlessLoadInput(char* fileName) {
+	FILE* file = fopen(fileName, "r");
+
+	if (file == NULL) {
+		return FALSE;
+	}
+
+	unsigned int capacity = 1024;
+	Quat4 control;
+	Quat4* input = malloc(sizeof(Quat4) * capacity);
+	unsigned int length = 0;
+
+	while (fscanf(file, "%f %f %f %f", &control.x, &control.y, &control.z, &control.w) == 4) {
+		if (length == capacity) {
+			capacity *= 2;
+			input = realloc(input, sizeof(Quat4) * capacity);
+		}
+		input[length++] = control;
+	}
+	fclose(file);
+
+	if (length == 0) {
+		free(input);
+		return FALSE;
+	}
+
+	free(headlessState.input);
+	headlessState.input = input;
+	headlessState.inputLength = length;
+	return TRUE;
+}
+
+Quat4 headlessControl(unsigned int tick) {
+	if (headlessState.input != NULL) {
+		return headlessState.input[tick % headlessState.inputLength];
+	}
+
+	unsigned int pathLength = 0;
+	for (unsigned int i = 0; i < _countof(headlessPath); ++i) {
+		pathLength += headlessPath[i].ticks;
+	}
+
+	tick %= pathLength;
+	for (unsigned int i = 0; i < _countof(headlessPath); ++i) {
+		if (tick < headlessPath[i].ticks) {
+			return headlessPath[i].control;
+		}
+		tick -= headlessPath[i].ticks;
+	}
+	return (Quat4) { 0, 0, 0, 0 };
+}
+
+unsigned char* headlessReadFrame(void) {
+	const unsigned int rowSize = headlessState.width * 3;
+	unsigned char* pixels = malloc(rowSize * headlessState.height);
+	unsigned char* row = malloc(rowSize);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, headlessState.width, headlessState.height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+
+	// OpenGL reads from the bottom row up, and images are stored from the top down
+	for (unsigned int top = 0, bottom = headlessState.height - 1; top < bottom; ++top, --bottom) {
+		memcpy(row, pixels + top * rowSize, rowSize);
+		memcpy(pixels + top * rowSize, pixels + bottom * rowSize, rowSize);
+		memcpy(pixels + bottom * rowSize, row, rowSize);
+	}
+
+	free(row);
+	return pixels;
+}
+
+bool headlessSaveFrame(char* fileName) {
+	unsigned char* pixels = headlessReadFrame();
+	const bool saved = headlessWritePPM(fileName, pixels, headlessState.width, headlessState.height);
+
+	free(pixels);
+	return saved;
+}
+
+bool headlessWritePPM(char* fileName, unsigned char* pixels, unsigned int width, unsigned int height) {
+	FILE* file = fopen(fileName, "wb");
+
+	if (file == NULL) {
+		return FALSE;
+	}
+
+	fprintf(file, "P6\n%u %u\n255\n", width, height);
+	fwrite(pixels, 3, (size_t)width * height, file);
+	return fclose(file) == 0;
+}
+
+unsigned char* headlessReadPPM(char* fileName, unsigned int* width, unsigned int* height) {
+	FILE* file = fopen(fileName, "rb");
+	unsigned int maxValue = 0;
+
+	if (file == NULL) {
+		return NULL;
+	}
+
+	// Only what headlessWritePPM writes is read: binary, 8 bits a channel, with no comments
+	if (fscanf(file, "P6 %u %u %u", width, height, &maxValue) != 3 || maxValue != 255 || fgetc(file) == EOF) {
+		fclose(file);
+		return NULL;
+	}
+
+	const size_t size = (size_t)*width * *height * 3;
+	unsigned char* pixels = malloc(size);
+	if (fread(pixels, 1, size, file) != size) {
+		free(pixels);
+		pixels = NULL;
+	}
+
+	fclose(file);
+	return pixels;
+}
+
+void headlessRun(unsigned int frames, char* captureDirectory, unsigned int captureInterval) {
+	double* frameTimes = malloc(sizeof(double) * (frames > 0 ? frames : 1));
+	unsigned long long thinkTime = 0;
+	char fileName[1024];
+
+	reshape(headlessState.width, headlessState.height);
+	printf("Drawing %u frames at %ux%u with %s\n", frames, headlessState.width, headlessState.height,
+		(const char*)glGetString(GL_RENDERER));
+
+	const unsigned long long runStart = platformNanoseconds();
+	for (unsigned int frame = 0; frame < frames; ++frame) {
+		frameReset();
+		reloadApply();
+		const unsigned long long thinkStart = platformNanoseconds();
+		frameStartTime = (unsigned int)(tickCount * 1000 / TARGET_FPS);
+		think();
+		publishSnapshot(0);
+
+		const unsigned long long displayStart = platformNanoseconds();
+		display();
+		frameTimes[frame] = (platformNanoseconds() - displayStart) / 1e6;
+		thinkTime += displayStart - thinkStart;
+
+		if (captureDirectory != NULL && frame % captureInterval == 0) {
+			sprintf_s(fileName, sizeof(fileName), "%s/frame%05u.ppm", captureDirectory, frame);
+			if (!headlessSaveFrame(fileName)) {
+				printf("Couldn't write '%s', no more frames will be captured\n", fileName);
+				captureDirectory = NULL;
+			}
+		}
+	}
+	const double runTime = (platformNanoseconds() - runStart) / 1e9;
+
+	if (frames > 0) {
+		printf("%u frames in %.2f s, %.3f ms per tick simulating\n", frames, runTime, thinkTime / 1e6 / frames);
+		headlessReport(frameTimes, frames, stdout);
+	}
+	free(frameTimes);
+}
+
+int headlessCompareTimes(const void* a, const void* b) {
+	const double timeA = *(const double*)a, timeB = *(const double*)b;
+	return timeA < timeB ? -1 : timeA > timeB ? 1 : 0;
+}
+
+void headlessReport(double* frameTimes, unsigned int count, FILE* file) {
+	double mean = 0, squares = 0;
+
+	// Welford's method, as the pacer uses for its intervals
+	for (unsigned int i = 0; i < count; ++i) {
+		const double delta = frameTimes[i] - mean;
+		mean += delta / (i + 1);
+		squares += delta * (frameTimes[i] - mean);
+	}
+	qsort(frameTimes, count, sizeof(double), headlessCompareTimes);
+
+	fprintf(file, "Frame time %.3f ms mean (%.1f fps), %.3f ms deviation\n", mean, 1000 / mean,
+		count > 1 ? sqrt(squares / (count - 1)) : 0);
+	fprintf(file, "min %.3f ms, median %.3f ms, 95th %.3f ms, 99th %.3f ms, max %.3f ms\n", frameTimes[0],
+		frameTimes[count / 2], frameTimes[(count * 95 + 99) / 100 - 1], frameTimes[(count * 99 + 99) / 100 - 1],
+		frameTimes[count - 1]);
+}
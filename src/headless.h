@@ -0,0 +1,72 @@
+#pragma once
+#ifndef _WIN32
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <freeglut.h>
+#include "misc.h"
+#include "vecmath.h"
+#include "glproc.h"
+#include "platform.h"
+#include "alloc.h"
+
+/*
+ * <headless.c/headless.h> Draws the scene without a window, for benchmarking the renderer and capturing
+ * frames on machines with no display or GPU. The context is an EGL pbuffer on Mesa's surfaceless
+ * platform, which falls back to llvmpipe without a GPU. Windows has no EGL, so there the context
+ * belongs to a hidden GLUT window instead
+ *
+ * The simulation ticks once per frame on the drawing thread rather than on its own, flying a fixed path
+ * or a recording of inputs from --record, with the trees placed from a fixed seed, so every run draws
+ * exactly the same frames whatever the machine
+ */
+
+// Number of frames drawn if --frames isn't given
+#define HEADLESS_DEFAULT_FRAMES 600
+// Seed the scene is generated from, unless --seed gives another
+#define HEADLESS_SEED 1
+
+typedef struct HEADLESSSEGMENT {
+	unsigned int ticks;		// Number of ticks the control input is held for
+	Quat4 control;			// Surge, heave, sway and yaw, as think() passes to helicopterThink
+} HeadlessSegment;
+
+typedef struct HEADLESS {
+	unsigned int width, height;
+	Quat4* input;				// Recorded control inputs to fly, or NULL to fly the fixed path
+	unsigned int inputLength;
+#ifndef _WIN32
+	EGLDisplay display;
+	EGLSurface surface;
+	EGLContext context;
+#endif
+} Headless;
+
+// Creates an offscreen context of the given size and makes it current. Returns FALSE if it couldn't be created
+bool headlessCreateContext(unsigned int width, unsigned int height);
+// Finishes drawing the frame, standing in for glutSwapBuffers
+void headlessSwapBuffers(void);
+// Destroys the offscreen context
+void headlessDestroyContext(void);
+// Loads control inputs written by --record to fly instead of the fixed path. Returns FALSE if there were none
+bool headlessLoadInput(char* fileName);
+// Returns the control input for a tick, from the loaded inputs or the fixed path, repeating once it runs out
+Quat4 headlessControl(unsigned int tick);
+// Reads back the frame that was just drawn, as RGB bytes from the top row down. Returns memory that must be free()'d
+unsigned char* headlessReadFrame(void);
+// Writes the frame that was just drawn as a binary PPM file. Returns FALSE if the file couldn't be written
+bool headlessSaveFrame(char* fileName);
+// Writes RGB bytes from the top row down as a binary PPM file. Returns FALSE if the file couldn't be written
+bool headlessWritePPM(char* fileName, unsigned char* pixels, unsigned int width, unsigned int height);
+// Reads a binary PPM file written by headlessWritePPM, returning its RGB bytes from the top row down, or NULL
+// if it couldn't be read. Returns memory that must be free()'d
+unsigned char* headlessReadPPM(char* fileName, unsigned int* width, unsigned int* height);
+// Draws a number of frames, each after a tick of the simulation, and prints statistics on how long they took.
+// Every captureInterval'th frame is saved into the capture directory if one is given
+void headlessRun(unsigned int frames, char* captureDirectory, unsigned int captureInterval);
+// Prints the mean, deviation and percentiles of a set of frame times in milliseconds, sorting them as it goes
+void headlessReport(double* frameTimes, unsigned int count, FILE* file);
@@ -1,44 +1,69 @@
 #include "helicopter.h"
+#include "angle.h"
+
+Terrain* collisionTerrain = NULL;
 
 void helicopterMove(Helicopter* helicopter, TreeObject* trees, Vec3 velocity) {
-	Vec3 rotatedVelocity = rotateVectorXZ(velocity, -helicopter->angle);
+	GLfloat sine, cosine;
+	angleSinCos(-helicopter->angle, &sine, &cosine);
+
+	Vec3 rotatedVelocity = rotateVectorXZSinCos(velocity, sine, cosine);
 	helicopter->velocity = vec3Lerp(helicopter->velocity, rotatedVelocity, 0.15);
 
-	Vec3 newPosition = (Vec3) {
-		helicopter->position.x + helicopter->velocity.x,
-		helicopter->position.y + helicopter->velocity.y,
-		helicopter->position.z + helicopter->velocity.z
-	};
+	profileBegin(PROFILE_COLLISION);
+	helicopter->atEdge = helicopterSlide(&helicopter->position, &helicopter->velocity, trees, NULL);
+	profileEnd(PROFILE_COLLISION);
+}
+
+bool helicopterSlide(Vec3* position, Vec3* velocity, TreeObject* trees, TreeGrid* grid) {
+	const Collision collision = helicopterSweep(*position, *velocity, trees, grid);
+
+	if (!collision.hit) {
+		*position = vec3Add(*position, *velocity);
+		if (collisionTerrain != NULL) {
+			position->y = fmax(position->y, helicopterFloor(position->x, position->z));
+		}
+		return FALSE;
+	}
 
-	if (!helicopterCollision(helicopter, newPosition, trees)) { helicopter->position = newPosition; }
-	else { helicopter->velocity = (Vec3) {0,0,0}; }
-	
+	// Move up to the point of impact, then slide along the surface that was hit with what's
+	// left of the movement, stopping short of anything else the slide runs into
+	*position = vec3Add(*position, vec3Scale(*velocity, collision.time));
+
+	const Collision slideCollision = helicopterSweep(*position, collision.slide, trees, grid);
+	*position = vec3Add(*position, vec3Scale(collision.slide, slideCollision.hit ? slideCollision.time : 1));
+
+	// Only keep the part of the velocity that runs along the surface that was hit
+	const GLfloat approach = vec3Dot(*velocity, collision.normal);
+	if (approach < 0) {
+		*velocity = vec3Add(*velocity, vec3Scale(collision.normal, -approach));
+	}
+
+	// The sweep treats the ground as flat between the start and end of a movement, so on a
+	// bulging hillside the end can still be a little under it
+	if (collisionTerrain != NULL) {
+		position->y = fmax(position->y, helicopterFloor(position->x, position->z));
+	}
+
+	return collision.atEdge || slideCollision.atEdge;
+}
+
+GLfloat helicopterFloor(GLfloat x, GLfloat z) {
+	return HELI_MIN_HEIGHT + (collisionTerrain != NULL ? terrainHeight(collisionTerrain, x, z) : 0);
 }
 
 bool helicopterCollision(Helicopter* helicopter, Vec3 newPosition, TreeObject* trees) {
 	// This is if exiting the bounds of the map
-	if (sqrt(pow(newPosition.x, 2) + pow(newPosition.z, 2)) > 190) {
+	if (sqrt(pow(newPosition.x, 2) + pow(newPosition.z, 2)) > HELI_MAP_RADIUS) {
 		helicopter->atEdge = TRUE;
 		return TRUE;
 	}
 
-	if (newPosition.y < 0.55 || newPosition.y > 50) { return TRUE; }
-	if (newPosition.y > 29) { return FALSE; }
+	if (newPosition.y < helicopterFloor(newPosition.x, newPosition.z) || newPosition.y > HELI_MAX_HEIGHT) { return TRUE; }
 
 	for (unsigned int i = 0; i < TREES_LENGTH; ++i) {
-		GLfloat treeRadCol = 0;
-
-		if (trees[i].modelIndex == 0) {
-			treeRadCol = newPosition.y > 5 ? 11 : 6.5;
-		}
-
-		if (trees[i].modelIndex == 1) {
-			treeRadCol = newPosition.y > 13 ? 11 : 6;
-		}
-
-		if (trees[i].modelIndex == 2) {
-			treeRadCol = newPosition.y > 10 ? 9.5 : 4.5 ;
-		}
+		if (newPosition.y - trees[i].height > TREE_COLLISION_HEIGHT) { continue; }
+		const GLfloat treeRadCol = treeCollisionRadius(trees[i].modelIndex, newPosition.y - trees[i].height);
 
 		if (sqrt(
 			pow(newPosition.x - trees[i].position.x, 2) + \
@@ -51,118 +76,437 @@ bool helicopterCollision(Helicopter* helicopter, Vec3 newPosition, TreeObject* t
 	return FALSE;
 }
 
-// Draws a cylinder with two spheres at the end for caps with given parameters
-void drawCylinder(
-	Helicopter* helicopter, 
-	Vec3 offset, 
-	GLfloat angle, 
-	GLfloat radius, 
-	GLfloat height, 
-	GLUquadricObj* cylinderQuadric, 
-	GLUquadricObj* sphereQuadric, 
-	bool endCaps
-) {
-	glTranslatef(offset.x, offset.y, offset.z);
-	glRotated(90 + angle, 0, 1, 0);
-	glTranslated(0, 0, -height / 2.0f);
-	gluCylinder(cylinderQuadric, radius, radius, height, 20, 20);
+// Keeps an impact if it happens before the closest impact found so far
+void collisionRecord(Collision* collision, GLfloat time, Vec3 normal, bool atEdge) {
+	if (collision->hit && time >= collision->time) { return; }
 
-	if (endCaps) {
-		gluSphere(sphereQuadric, radius, 20, 20);
-		glRotated(-90, 0, 1, 0);
-		glTranslated(height, 0, 0);
-		gluSphere(sphereQuadric, radius, 20, 20);
-		glRotated(-angle, 0, 1, 0);
+	collision->hit = TRUE;
+	collision->atEdge = atEdge;
+	collision->time = time;
+	collision->normal = normal;
+}
+
+// Sweeps a point on the XZ plane, relative to the centre of a circle, over the times [start, end] of
+// its movement. Returns the time the point enters the circle (and the normal at that point), or -1
+// if it never does
+GLfloat collisionSweepCircle(Vec2 offset, Vec2 direction, GLfloat radius, GLfloat start, GLfloat end, Vec3* normal) {
+	const GLfloat a = direction.x * direction.x + direction.y * direction.y;
+	const GLfloat b = offset.x * direction.x + offset.y * direction.y;
+	const GLfloat c = offset.x * offset.x + offset.y * offset.y - radius * radius;
+
+	// Already inside the circle when the sweep starts, which happens when the profile radius
+	// grows at this height, or if the point started off inside the tree
+	const Vec2 startOffset = { offset.x + direction.x * start, offset.y + direction.y * start };
+	if (startOffset.x * startOffset.x + startOffset.y * startOffset.y < radius * radius) {
+		if (start > 0) {
+			*normal = (Vec3) { 0, 0, 0 };
+			return start;
+		}
+
+		// Only stop the point if it's heading further in, so it can always back out
+		if (b >= 0) { return -1; }
+		const GLfloat length = sqrt(c + radius * radius);
+		*normal = length > 0 ? (Vec3) { offset.x / length, 0, offset.y / length } : (Vec3) { 0, 0, 0 };
+		return 0;
+	}
+
+	const GLfloat discriminant = b * b - a * c;
+	if (a <= 0 || discriminant < 0) { return -1; }
+
+	const GLfloat time = (-b - sqrt(discriminant)) / a;
+	if (time < start || time > end) { return -1; }
+
+	*normal = (Vec3) { (offset.x + direction.x * time) / radius, 0, (offset.y + direction.y * time) / radius };
+	return time;
+}
+
+// Sweeps a movement against one tree's collision profile, keeping the impact if it's the closest so far.
+// The bounds are the box the movement covers on the XZ plane, used to skip trees it can't reach
+void collisionSweepTree(Collision* collision, Vec3 start, Vec3 movement, TreeObject* tree, Vec2 boundsMin, Vec2 boundsMax) {
+	const TreeCollisionProfile* profile = &treeCollisionProfiles[tree->modelIndex];
+	const Vec2 position = tree->position;
+
+	// Heights are worked out from the ground the tree stands on
+	start.y -= tree->height;
+
+	if (position.x + profile->canopyRadius < boundsMin.x || position.x - profile->canopyRadius > boundsMax.x ||
+		position.y + profile->canopyRadius < boundsMin.y || position.y - profile->canopyRadius > boundsMax.y) {
+		return;
+	}
+
+	// Split the movement where it crosses the heights the profile changes at, so that
+	// each piece only has to be swept against a single cylinder
+	GLfloat times[4] = { 0, 1, 1, 1 };
+	unsigned int timeCount = 1;
+	if (movement.y != 0) {
+		const GLfloat canopyTime = (profile->canopyHeight - start.y) / movement.y;
+		const GLfloat topTime = (TREE_COLLISION_HEIGHT - start.y) / movement.y;
+		if (canopyTime > 0 && canopyTime < 1) { times[timeCount++] = canopyTime; }
+		if (topTime > 0 && topTime < 1) { times[timeCount++] = topTime; }
+		if (timeCount == 3 && times[1] > times[2]) { times[2] = times[1]; times[1] = topTime; }
+	}
+
+	const Vec2 offset = { start.x - position.x, start.z - position.y };
+	const Vec2 direction = { movement.x, movement.z };
+	for (unsigned int j = 0; j < timeCount; ++j) {
+		const GLfloat height = start.y + movement.y * (times[j] + times[j + 1]) / 2;
+		if (height > TREE_COLLISION_HEIGHT) { continue; }
+
+		Vec3 normal;
+		const GLfloat time = collisionSweepCircle(offset, direction, treeCollisionRadius(tree->modelIndex, height), times[j], times[j + 1], &normal);
+		if (time < 0) { continue; }
+
+		// Entering the circle through its top or bottom rather than its side
+		if (normal.x == 0 && normal.z == 0) {
+			normal.y = movement.y < 0 ? 1 : -1;
+		}
+
+		collisionRecord(collision, time, normal, FALSE);
+		return;
+	}
+}
+
+Collision helicopterSweep(Vec3 start, Vec3 movement, TreeObject* trees, TreeGrid* grid) {
+	Collision collision = { FALSE, FALSE, 1, { 0, 0, 0 }, movement };
+	const GLfloat distance = sqrt(vec3Dot(movement, movement));
+
+	if (distance <= 0) { return collision; }
+
+	// Leaving the bounds of the map, which is the far intersection with the edge circle
+	const GLfloat a = movement.x * movement.x + movement.z * movement.z;
+	const GLfloat b = start.x * movement.x + start.z * movement.z;
+	const GLfloat c = start.x * start.x + start.z * start.z - HELI_MAP_RADIUS * HELI_MAP_RADIUS;
+	if (a > 0 && (c <= 0 || b < 0)) {
+		const GLfloat edgeTime = (-b + sqrt(fmax(b * b - a * c, 0))) / a;
+		if (edgeTime <= 1) {
+			const Vec3 edgePoint = vec3Add(start, vec3Scale(movement, edgeTime));
+			collisionRecord(&collision, fmax(edgeTime, 0), (Vec3) { -edgePoint.x / HELI_MAP_RADIUS, 0, -edgePoint.z / HELI_MAP_RADIUS }, TRUE);
+		}
+	} else if (a > 0) {
+		collisionRecord(&collision, 0, (Vec3) { -start.x / HELI_MAP_RADIUS, 0, -start.z / HELI_MAP_RADIUS }, TRUE);
+	}
+
+	// The floor and ceiling. Terrain is treated as flat between the start and end of the movement,
+	// so the impact is where the height above the ground, which changes linearly, reaches zero
+	if (collisionTerrain != NULL) {
+		const Vec3 end = vec3Add(start, movement);
+		const GLfloat startClearance = start.y - helicopterFloor(start.x, start.z);
+		const GLfloat endClearance = end.y - helicopterFloor(end.x, end.z);
+
+		if (endClearance < 0 && endClearance < startClearance) {
+			const GLfloat time = startClearance > 0 ? startClearance / (startClearance - endClearance) : 0;
+			const Vec3 point = vec3Add(start, vec3Scale(movement, time));
+			collisionRecord(&collision, time, terrainNormal(collisionTerrain, point.x, point.z), FALSE);
+		}
+	} else if (start.y + movement.y < HELI_MIN_HEIGHT && movement.y < 0) {
+		collisionRecord(&collision, fmax((HELI_MIN_HEIGHT - start.y) / movement.y, 0), (Vec3) { 0, 1, 0 }, FALSE);
+	}
+	if (start.y + movement.y > HELI_MAX_HEIGHT && movement.y > 0) {
+		collisionRecord(&collision, fmax((HELI_MAX_HEIGHT - start.y) / movement.y, 0), (Vec3) { 0, -1, 0 }, FALSE);
+	}
+
+	// Bounding box of the movement on the XZ plane, for skipping trees it can't reach
+	const Vec2 boundsMin = { fmin(start.x, start.x + movement.x), fmin(start.z, start.z + movement.z) };
+	const Vec2 boundsMax = { fmax(start.x, start.x + movement.x), fmax(start.z, start.z + movement.z) };
+
+	if (fmin(start.y, start.y + movement.y) <= TREE_COLLISION_HEIGHT + (collisionTerrain != NULL ? collisionTerrain->maxHeight : 0)) {
+		if (grid == NULL) {
+			for (unsigned int i = 0; i < TREES_LENGTH; ++i) {
+				collisionSweepTree(&collision, start, movement, &trees[i], boundsMin, boundsMax);
+			}
+		} else {
+			// Trees are bucketed by their centre, so widen the search by the largest tree radius
+			const int cellMinX = treeGridCell(boundsMin.x - TREE_MAX_COLLISION_RADIUS), cellMaxX = treeGridCell(boundsMax.x + TREE_MAX_COLLISION_RADIUS);
+			const int cellMinZ = treeGridCell(boundsMin.y - TREE_MAX_COLLISION_RADIUS), cellMaxZ = treeGridCell(boundsMax.y + TREE_MAX_COLLISION_RADIUS);
+
+			for (int z = cellMinZ; z <= cellMaxZ; ++z) {
+				for (int x = cellMinX; x <= cellMaxX; ++x) {
+					const unsigned int cell = z * TREE_GRID_CELLS + x;
+					for (unsigned int i = grid->cellStarts[cell]; i < grid->cellStarts[cell + 1]; ++i) {
+						collisionSweepTree(&collision, start, movement, &trees[grid->treeIndices[i]], boundsMin, boundsMax);
+					}
+				}
+			}
+		}
+	}
+
+	if (collision.hit) {
+		// Stop just short of the impact, then project what's left of the movement onto the surface
+		collision.time = fmax(collision.time - HELI_CONTACT_OFFSET / distance, 0);
+
+		const Vec3 remaining = vec3Scale(movement, 1 - collision.time);
+		const GLfloat approach = vec3Dot(remaining, collision.normal);
+		collision.slide = approach < 0 ? vec3Add(remaining, vec3Scale(collision.normal, -approach)) : remaining;
 	}
+
+	return collision;
 }
 
-// Draws a flat cylinder for a rotor guard with given parameters
-void drawRotorGuard(GLUquadricObj* cylinderQuadric) {
-	setMaterial((RGB) { 51, 51, 51 }, (RGB) { 0, 0, 0 }, 80);
-	glTranslatef(0, 0.12, 0);
-	glRotatef(90, 1, 0, 0);
-	gluCylinder(cylinderQuadric, (HELI_ROTOR_LENGTH / 2) + 0.1, (HELI_ROTOR_LENGTH / 2) + 0.1, HELI_ROTOR_RADIUS * 2, 20, 20);
-	glRotatef(-90, 1, 0, 0);
-	glTranslatef(0, -0.12, 0);
+const RenderMaterial helicopterBodyMaterial = { { 0, 0, 0, 0 }, { 51.f / 255.f, 51.f / 255.f, 51.f / 255.f, 1 }, { 1, 1, 1, 1 }, { 0, 0, 0, 1 }, 80 };
+const RenderMaterial helicopterRedLightMaterial = { { 0, 0, 0, 0 }, { 51.f / 255.f, 51.f / 255.f, 51.f / 255.f, 1 }, { 1, 1, 1, 1 }, { 3, 0, 0, 1 }, 80 };
+const RenderMaterial helicopterWhiteLightMaterial = { { 0, 0, 0, 0 }, { 51.f / 255.f, 51.f / 255.f, 51.f / 255.f, 1 }, { 1, 1, 1, 1 }, { 2, 2, 2, 1 }, 80 };
+const RenderMaterial helicopterRotorMaterial = { { 0, 0, 0, 0 }, { 18.f / 255.f, 94.f / 255.f, 161.f / 255.f, 1 }, { 1, 1, 1, 1 }, { 0, 0, 0, 1 }, 80 };
+
+// Adds a vertex to a mesh being built, moved into place by a transformation, and returns its index
+GLuint helicopterMeshVertex(HelicopterMesh* mesh, const Mat4* transform, Vec3 position, Vec3 normal) {
+	if (mesh->vertexCount == mesh->vertexCapacity) {
+		mesh->vertexCapacity = mesh->vertexCapacity == 0 ? 1024 : mesh->vertexCapacity * 2;
+		mesh->vertices = allocRealloc(ALLOC_MESH, mesh->vertices, mesh->vertexCapacity * sizeof(Vertex));
+	}
+
+	const Vec3 placed = mat4TransformPoint(*transform, position);
+	const Vec3 turned = mat4TransformDirection(*transform, normal);
+	mesh->vertices[mesh->vertexCount] = (Vertex) { { placed.x, placed.y, placed.z }, { turned.x, turned.y, turned.z }, { 0, 0 } };
+	return mesh->vertexCount++;
 }
 
-// Draws a low poly cylinder for a rotor with given parameters
-void drawRotor(Helicopter* helicopter, Vec3 offset, GLfloat rotation, GLUquadricObj* cylinderQuadric) {
-	setMaterial((RGB) { 18, 94, 161 }, (RGB) { 0, 0, 0 }, 80);
-	glTranslatef(offset.x, offset.y, offset.z);
-	glRotated(90, 0, 1, 0);
-	
-	glRotatef(rotation, 0, 1, 0);
-	glTranslated(0, 0, -HELI_ROTOR_LENGTH / 2.0f);
-	gluCylinder(cylinderQuadric, HELI_ROTOR_RADIUS, HELI_ROTOR_RADIUS, HELI_ROTOR_LENGTH, 4, 4);
-	glTranslated(0, 0, HELI_ROTOR_LENGTH / 2.0f);
-	glRotatef(-rotation - 90, 0, 1, 0);
+// Adds a triangle to a mesh being built
+void helicopterMeshTriangle(HelicopterMesh* mesh, GLuint a, GLuint b, GLuint c) {
+	if (mesh->indexCount + 3 > mesh->indexCapacity) {
+		mesh->indexCapacity = mesh->indexCapacity == 0 ? 3072 : mesh->indexCapacity * 2;
+		mesh->indices = allocRealloc(ALLOC_MESH, mesh->indices, mesh->indexCapacity * sizeof(GLuint));
+	}
 
-	drawRotorGuard(cylinderQuadric);
+	mesh->indices[mesh->indexCount++] = a;
+	mesh->indices[mesh->indexCount++] = b;
+	mesh->indices[mesh->indexCount++] = c;
 }
 
-void helicopterDisplay(Helicopter* helicopter, GLUquadricObj* cylinderQuadric, GLUquadricObj* sphereQuadric) {
-	const double theta = -toRad(helicopter->angle);
+// Adds the triangles of a quad strip that alternates between two rows of vertices, starting with the first.
+// Each quad is split along the same diagonal OpenGL splits a GL_QUAD_STRIP along
+void helicopterMeshStrip(HelicopterMesh* mesh, GLuint first, GLuint second, unsigned int length) {
+	for (unsigned int i = 0; i + 1 < length; ++i) {
+		helicopterMeshTriangle(mesh, first + i + 1, first + i, second + i + 1);
+		helicopterMeshTriangle(mesh, first + i, second + i, second + i + 1);
+	}
+}
 
-	Vec3 cameraPosition = (Vec3) {
-		helicopter->position.x - CAMERA_FOLLOW_DISTANCE * cos(theta),
-		helicopter->position.y + CAMERA_HEIGHT_OFFSET,
-		helicopter->position.z - CAMERA_FOLLOW_DISTANCE * sin(theta)
-	};
+// Adds a cylinder with the vertices and normals gluCylinder gives one, worked out in the same precision
+void helicopterMeshCylinder(HelicopterMesh* mesh, const Mat4* transform, GLdouble radius, GLdouble height, int slices, int stacks) {
+	GLfloat sines[HELI_QUADRIC_DETAIL + 1], cosines[HELI_QUADRIC_DETAIL + 1];
 
-	gluLookAt(cameraPosition.x, cameraPosition.y, cameraPosition.z, helicopter->position.x, helicopter->position.y + 2, helicopter->position.z, 0, 1, 0);
+	for (int i = 0; i < slices; ++i) {
+		const GLfloat angle = 2 * 3.14159265358979323846 * i / slices;
+		sines[i] = sin(angle);
+		cosines[i] = cos(angle);
+	}
+	sines[slices] = sines[0];
+	cosines[slices] = cosines[0];
+
+	const GLuint first = mesh->vertexCount;
+	for (int j = 0; j <= stacks; ++j) {
+		const GLfloat z = j * height / stacks, ringRadius = radius;
+		for (int i = 0; i <= slices; ++i) {
+			helicopterMeshVertex(mesh, transform, (Vec3) { ringRadius * sines[i], ringRadius * cosines[i], z },
+				(Vec3) { sines[i], cosines[i], 0 });
+		}
+	}
+	for (int j = 0; j < stacks; ++j) {
+		helicopterMeshStrip(mesh, first + j * (slices + 1), first + (j + 1) * (slices + 1), slices + 1);
+	}
+}
 
-	glPushMatrix();
-	glTranslatef(helicopter->position.x, helicopter->position.y, helicopter->position.z);
-	glRotatef(helicopter->angle, 0, 1, 0);
+// Adds a sphere with the vertices and normals gluSphere gives one, worked out in the same precision. Its
+// poles are fans of triangles and the rings between them quad strips, as gluSphere draws them
+void helicopterMeshSphere(HelicopterMesh* mesh, const Mat4* transform, GLdouble radius, int slices, int stacks) {
+	GLfloat sines[HELI_QUADRIC_DETAIL + 1], cosines[HELI_QUADRIC_DETAIL + 1];
+	GLfloat stackSines[HELI_QUADRIC_DETAIL + 1], stackCosines[HELI_QUADRIC_DETAIL + 1];
+	GLfloat ringRadii[HELI_QUADRIC_DETAIL + 1], ringHeights[HELI_QUADRIC_DETAIL + 1];
+
+	for (int i = 0; i < slices; ++i) {
+		const GLfloat angle = 2 * 3.14159265358979323846 * i / slices;
+		sines[i] = sin(angle);
+		cosines[i] = cos(angle);
+	}
+	sines[slices] = sines[0];
+	cosines[slices] = cosines[0];
+	for (int j = 0; j <= stacks; ++j) {
+		const GLfloat angle = 3.14159265358979323846 * j / stacks;
+		stackSines[j] = sin(angle);
+		stackCosines[j] = cos(angle);
+		ringRadii[j] = radius * sin(angle);
+		ringHeights[j] = radius * cos(angle);
+	}
+	ringRadii[0] = ringRadii[stacks] = 0;
+
+	// The rings between the poles, from the top down
+	const GLuint top = helicopterMeshVertex(mesh, transform, (Vec3) { 0, 0, radius }, (Vec3) { 0, 0, stackCosines[0] });
+	for (int j = 1; j < stacks; ++j) {
+		for (int i = 0; i <= slices; ++i) {
+			helicopterMeshVertex(mesh, transform, (Vec3) { ringRadii[j] * sines[i], ringRadii[j] * cosines[i], ringHeights[j] },
+				(Vec3) { sines[i] * stackSines[j], cosines[i] * stackSines[j], stackCosines[j] });
+		}
+	}
+	const GLuint bottom = helicopterMeshVertex(mesh, transform, (Vec3) { 0, 0, -radius },
+		(Vec3) { sines[stacks] * stackSines[stacks], cosines[stacks] * stackSines[stacks], stackCosines[stacks] });
 
-	const Vec3 pitch = rotateVectorXZ(helicopter->velocity, helicopter->angle - 90);
-	glRotatef(vec3XZMagnitude(helicopter->velocity) * 30, pitch.x, 0, pitch.z);
+	const GLuint firstRing = top + 1, lastRing = top + 1 + (stacks - 2) * (slices + 1);
+	for (int i = slices; i > 0; --i) {
+		helicopterMeshTriangle(mesh, top, firstRing + i, firstRing + i - 1);
+	}
+	for (int i = 0; i < slices; ++i) {
+		helicopterMeshTriangle(mesh, bottom, lastRing + i, lastRing + i + 1);
+	}
+	for (int j = 1; j < stacks - 1; ++j) {
+		helicopterMeshStrip(mesh, firstRing + j * (slices + 1), firstRing + (j - 1) * (slices + 1), slices + 1);
+	}
+}
 
-	setMaterial((RGB) { 51, 51, 51 }, (RGB) { 0, 0, 0 }, 80);
-	drawCylinder(helicopter, (Vec3) { 0, 0, 0 }, 0, HELI_BODY_RADIUS, HELI_BODY_LENGTH, cylinderQuadric, sphereQuadric, TRUE);
-	drawCylinder(helicopter, (Vec3) { 0.3, 0, 1  }, 120, HELI_ARM_RADIUS, HELI_ARM_LENGTH, cylinderQuadric, sphereQuadric, TRUE);
-	drawCylinder(helicopter, (Vec3) { 0.5, 0, -1.1  }, 60, HELI_ARM_RADIUS, HELI_ARM_LENGTH, cylinderQuadric, sphereQuadric, TRUE);
-	drawCylinder(helicopter,(Vec3) { -4, 0, 0.8 }, 120, HELI_ARM_RADIUS, HELI_ARM_LENGTH, cylinderQuadric, sphereQuadric, TRUE);
-	drawCylinder(helicopter, (Vec3) { 0.55, 0, 2.9 }, 60, HELI_ARM_RADIUS, HELI_ARM_LENGTH, cylinderQuadric, sphereQuadric, TRUE);
+// Moves the transformation the parts are being built with, as glTranslate would
+void helicopterTranslate(Mat4* transform, GLfloat x, GLfloat y, GLfloat z) {
+	*transform = mat4Multiply(*transform, mat4Translation((Vec3) { x, y, z }));
+}
 
-	drawRotor(helicopter, (Vec3) { -1, 0.2, -1.95 }, helicopter->rotorAngle, cylinderQuadric);
-	drawRotor(helicopter, (Vec3) { 0, 0, 3.65 }, helicopter->rotorAngle, cylinderQuadric);
-	drawRotor(helicopter, (Vec3) { 4.4, 0, -0.05 }, helicopter->rotorAngle, cylinderQuadric);
-	drawRotor(helicopter, (Vec3) { 0, 0, -3.5 }, helicopter->rotorAngle, cylinderQuadric);
-	
+// Turns the transformation the parts are being built with, as glRotate would
+void helicopterRotate(Mat4* transform, GLfloat angle, GLfloat x, GLfloat y, GLfloat z) {
+	*transform = mat4Multiply(*transform, mat4Rotation(angle, (Vec3) { x, y, z }));
+}
 
-	// Drawing Lights
-	setMaterial((RGB) { 51, 51, 51 }, (RGB) { 3, 0, 0 }, 80);
-	drawCylinder(helicopter, (Vec3) { -3.7, 0.2, 1.72 }, 90, 0.08, 0.6, cylinderQuadric, sphereQuadric, FALSE);
-	setMaterial((RGB) { 51, 51, 51 }, (RGB) { 0, 0, 0 }, 80);
-	drawCylinder(helicopter, (Vec3) { -0.08, 0.05, 0.3 }, 90, 0.1, 0.6, cylinderQuadric, sphereQuadric, FALSE);
-	drawCylinder(helicopter, (Vec3) { 2.6, 0, 0.3 }, 90, 0.08, 0.6, cylinderQuadric, sphereQuadric, FALSE);
-	setMaterial((RGB) { 51, 51, 51 }, (RGB) { 2, 2, 2 }, 80);
-	drawCylinder(helicopter, (Vec3) { -0.05, 0.02, 0.3 }, 90, 0.08, 0.6, cylinderQuadric, sphereQuadric, FALSE);
+// Adds a cylinder, with two spheres at the end for caps if asked for. The transformation is left where
+// the cylinder ends up, which is where the next part starts from
+void helicopterBuildCylinder(HelicopterMesh* mesh, Mat4* transform, Vec3 offset, GLfloat angle, GLfloat radius, GLfloat height,
+	bool endCaps) {
+	helicopterTranslate(transform, offset.x, offset.y, offset.z);
+	helicopterRotate(transform, 90 + angle, 0, 1, 0);
+	helicopterTranslate(transform, 0, 0, -height / 2.0f);
+	helicopterMeshCylinder(mesh, transform, radius, height, HELI_QUADRIC_DETAIL, HELI_QUADRIC_DETAIL);
 
-	// Reset the emission material
-	setMaterial((RGB) { 0, 0, 0 }, (RGB) { 0, 0, 0 }, 80);
+	if (endCaps) {
+		helicopterMeshSphere(mesh, transform, radius, HELI_QUADRIC_DETAIL, HELI_QUADRIC_DETAIL);
+		helicopterRotate(transform, -90, 0, 1, 0);
+		helicopterTranslate(transform, height, 0, 0);
+		helicopterMeshSphere(mesh, transform, radius, HELI_QUADRIC_DETAIL, HELI_QUADRIC_DETAIL);
+		helicopterRotate(transform, -angle, 0, 1, 0);
+	}
+}
+
+// Adds a rotor's guard to the body, and returns where its blade spins
+Mat4 helicopterBuildRotor(HelicopterMesh* body, Mat4* transform, Vec3 offset) {
+	helicopterTranslate(transform, offset.x, offset.y, offset.z);
+	helicopterRotate(transform, 90, 0, 1, 0);
+	const Mat4 placement = *transform;
+	helicopterRotate(transform, -90, 0, 1, 0);
+
+	helicopterTranslate(transform, 0, 0.12, 0);
+	helicopterRotate(transform, 90, 1, 0, 0);
+	helicopterMeshCylinder(body, transform, (HELI_ROTOR_LENGTH / 2) + 0.1, HELI_ROTOR_RADIUS * 2, HELI_QUADRIC_DETAIL, HELI_QUADRIC_DETAIL);
+	helicopterRotate(transform, -90, 1, 0, 0);
+	helicopterTranslate(transform, 0, -0.12, 0);
+	return placement;
+}
+
+// Puts a mesh that's been built into a vertex buffer, and frees what it was built in
+VertexBuffer* helicopterMeshBuffer(HelicopterMesh* mesh) {
+	VertexBuffer* buffer = vertexBufferCreate(GL_TRIANGLES, mesh->vertices, mesh->vertexCount, mesh->indices, mesh->indexCount);
+	allocFree(mesh->vertices);
+	allocFree(mesh->indices);
+	return buffer;
+}
+
+HelicopterModel helicopterGenerateModel(void) {
+	HelicopterModel model;
+	HelicopterMesh body = { 0 }, redLight = { 0 }, whiteLight = { 0 }, blade = { 0 };
+	Mat4 transform = mat4Identity();
+
+	// The parts are placed one after another from where the last left off, which is how the helicopter
+	// was first drawn into a display list
+	helicopterBuildCylinder(&body, &transform, (Vec3) { 0, 0, 0 }, 0, HELI_BODY_RADIUS, HELI_BODY_LENGTH, TRUE);
+	helicopterBuildCylinder(&body, &transform, (Vec3) { 0.3, 0, 1 }, 120, HELI_ARM_RADIUS, HELI_ARM_LENGTH, TRUE);
+	helicopterBuildCylinder(&body, &transform, (Vec3) { 0.5, 0, -1.1 }, 60, HELI_ARM_RADIUS, HELI_ARM_LENGTH, TRUE);
+	helicopterBuildCylinder(&body, &transform, (Vec3) { -4, 0, 0.8 }, 120, HELI_ARM_RADIUS, HELI_ARM_LENGTH, TRUE);
+	helicopterBuildCylinder(&body, &transform, (Vec3) { 0.55, 0, 2.9 }, 60, HELI_ARM_RADIUS, HELI_ARM_LENGTH, TRUE);
+
+	model.rotors[0] = helicopterBuildRotor(&body, &transform, (Vec3) { -1, 0.2, -1.95 });
+	model.rotors[1] = helicopterBuildRotor(&body, &transform, (Vec3) { 0, 0, 3.65 });
+	model.rotors[2] = helicopterBuildRotor(&body, &transform, (Vec3) { 4.4, 0, -0.05 });
+	model.rotors[3] = helicopterBuildRotor(&body, &transform, (Vec3) { 0, 0, -3.5 });
+
+	// The lights, of which only the red and white ones glow
+	helicopterBuildCylinder(&redLight, &transform, (Vec3) { -3.7, 0.2, 1.72 }, 90, 0.08, 0.6, FALSE);
+	helicopterBuildCylinder(&body, &transform, (Vec3) { -0.08, 0.05, 0.3 }, 90, 0.1, 0.6, FALSE);
+	helicopterBuildCylinder(&body, &transform, (Vec3) { 2.6, 0, 0.3 }, 90, 0.08, 0.6, FALSE);
+	helicopterBuildCylinder(&whiteLight, &transform, (Vec3) { -0.05, 0.02, 0.3 }, 90, 0.08, 0.6, FALSE);
+
+	// Every blade is the same low poly cylinder, centred on where it spins
+	transform = mat4Translation((Vec3) { 0, 0, -HELI_ROTOR_LENGTH / 2.0f });
+	helicopterMeshCylinder(&blade, &transform, HELI_ROTOR_RADIUS, HELI_ROTOR_LENGTH, 4, 4);
+
+	model.body = helicopterMeshBuffer(&body);
+	model.redLight = helicopterMeshBuffer(&redLight);
+	model.whiteLight = helicopterMeshBuffer(&whiteLight);
+	model.blade = helicopterMeshBuffer(&blade);
+	return model;
+}
+
+void helicopterModelFree(HelicopterModel* model) {
+	vertexBufferFree(model->body);
+	vertexBufferFree(model->redLight);
+	vertexBufferFree(model->whiteLight);
+	vertexBufferFree(model->blade);
+	*model = (HelicopterModel) { 0 };
+}
+
+Mat4 helicopterInstance(Vec3 position, Vec3 velocity, GLfloat angle) {
+	GLfloat sine, cosine;
+	angleSinCos(angle - 90, &sine, &cosine);
+
+	const Vec3 pitch = rotateVectorXZSinCos(velocity, sine, cosine);
+	const Mat4 turn = mat4Multiply(mat4Translation(position), mat4Rotation(angle, (Vec3) { 0, 1, 0 }));
+	return mat4Multiply(turn, mat4Rotation(vec3XZMagnitude(velocity) * 30, (Vec3) { pitch.x, 0, pitch.z }));
+}
 
-	glPopMatrix();
+void helicopterDrawInstances(HelicopterModel* model, const Mat4* instances, unsigned int count, GLfloat rotorAngle) {
+	renderSetInstances(instances, count);
+	renderDrawInstanced(model->body, NULL, &helicopterBodyMaterial);
+	renderDrawInstanced(model->redLight, NULL, &helicopterRedLightMaterial);
+	renderDrawInstanced(model->whiteLight, NULL, &helicopterWhiteLightMaterial);
+
+	const Mat4 spin = mat4Rotation(rotorAngle, (Vec3) { 0, 1, 0 });
+	for (unsigned int i = 0; i < HELI_ROTOR_COUNT; ++i) {
+		const Mat4 rotor = mat4Multiply(model->rotors[i], spin);
+		renderDrawInstanced(model->blade, &rotor, &helicopterRotorMaterial);
+	}
+	renderSetInstances(NULL, 0);
+}
+
+Vec3 helicopterCameraPosition(Helicopter* helicopter) {
+	GLfloat sine, cosine;
+	angleSinCos(-helicopter->angle, &sine, &cosine);
+
+	return (Vec3) {
+		helicopter->position.x - CAMERA_FOLLOW_DISTANCE * cosine,
+		helicopter->position.y + CAMERA_HEIGHT_OFFSET,
+		helicopter->position.z - CAMERA_FOLLOW_DISTANCE * sine
+	};
+}
+
+Mat4 helicopterCamera(Helicopter* helicopter) {
+	const Vec3 target = { helicopter->position.x, helicopter->position.y + 2, helicopter->position.z };
+	return mat4LookAt(helicopterCameraPosition(helicopter), target, (Vec3) { 0, 1, 0 });
+}
+
+void helicopterDisplay(Helicopter* helicopter, HelicopterModel* model) {
+	const Mat4 instance = helicopterInstance(helicopter->position, helicopter->velocity, helicopter->angle);
+	helicopterDrawInstances(model, &instance, 1, helicopter->rotorAngle);
 
 	if (helicopter->atEdge) {
 		drawText("You cannot go any further!", (Vec2) { 20, 20 });
 	}
 }
 
-void helicopterThink(Helicopter* helicopter, Quat4 controlQuaternion, TreeObject* trees, GLfloat DeltaTime) {
+GLfloat helicopterFogDensity(Helicopter* helicopter) {
 	const GLfloat distance = sqrt(pow(helicopter->position.x, 2) + pow(helicopter->position.z, 2));
 	const GLfloat newFogDensityRange = ((distance * (0.036)) / 190) + 0.005;
 	// This ludicrous power 6 polynomal function makes the fog only very slowly climb
 	// as you reach the edges, and then ramp up sharply near the end, so most of the
 	// time the fog is manageable, until we want it to completely block visibility.
-	const GLfloat newFogDensity = 8800000 * pow(newFogDensityRange, 6) + 0.005;
+	return 8800000 * pow(newFogDensityRange, 6) + 0.005;
+}
 
-	glFogf(GL_FOG_DENSITY, newFogDensity);
+void helicopterThink(Helicopter* helicopter, Quat4 controlQuaternion, TreeObject* trees, GLfloat DeltaTime) {
 	if (helicopter->startup) {
 		helicopter->rotorAngularVelocity += 8 ;
-		helicopter->rotorAngle = angleClamp(helicopter->rotorAngle + helicopter->rotorAngularVelocity * DeltaTime);
+		helicopter->rotorAngle = angleWrap(helicopter->rotorAngle + helicopter->rotorAngularVelocity * DeltaTime);
 
 		if (helicopter->rotorAngularVelocity >= ROTOR_SPEED) {
 			helicopterMove(helicopter, trees, (Vec3) { 0, 0.3, 0 });
@@ -175,8 +519,8 @@ void helicopterThink(Helicopter* helicopter, Quat4 controlQuaternion, TreeObject
 	} 
 
 	helicopter->angularVelocity = lerp(helicopter->angularVelocity, controlQuaternion.w * YAW_SPEED * DeltaTime, 0.15);
-	helicopter->angle = angleClamp(helicopter->angle + helicopter->angularVelocity);
-	helicopter->rotorAngle = angleClamp(helicopter->rotorAngle + ROTOR_SPEED * DeltaTime);
+	helicopter->angle = angleWrap(helicopter->angle + helicopter->angularVelocity);
+	helicopter->rotorAngle = angleWrap(helicopter->rotorAngle + ROTOR_SPEED * DeltaTime);
 
 	helicopterMove(
 		helicopter,
@@ -5,6 +5,9 @@
 #include "vecmath.h"
 #include "misc.h"
 #include "tree.h"
+#include "terrain.h"
+#include "profile.h"
+#include "render.h"
 
 /*
  * <helicopter.c/helicopter.h> Defines the functions and datatypes required to render
@@ -31,6 +34,20 @@
 #define HELI_ARM_LENGTH 2
 #define HELI_ROTOR_RADIUS 0.1
 #define HELI_ROTOR_LENGTH 2.8
+#define HELI_ROTOR_COUNT 4
+// Slices and stacks the cylinders and spheres are made of, besides the blades
+#define HELI_QUADRIC_DETAIL 20
+
+// Helicopter Movement Bounds
+
+#define HELI_MAP_RADIUS 190
+#define HELI_MIN_HEIGHT 0.55
+#define HELI_MAX_HEIGHT 50
+// Distance the helicopter is kept back from a surface it collides with
+#define HELI_CONTACT_OFFSET 0.01
+
+// Terrain the helicopters collide with, or NULL for flat ground at a height of 0
+extern Terrain* collisionTerrain;
 
 // Object for data storage of a helicopter's parameters
 typedef struct HELICOPTER {
@@ -43,12 +60,64 @@ typedef struct HELICOPTER {
 	bool startup, atEdge;// Booleans for if the heli is staring up, or if it is at the edge of the scene;
 } Helicopter;
 
+// Vertex buffers for drawing helicopters around the origin, split by material. The blades spin, so
+// there's one blade that's drawn in each rotor's place, turned to the rotor angle
+typedef struct HELICOPTERMODEL {
+	VertexBuffer* body; // Everything grey: the body, arms, rotor guards and unlit lights
+	VertexBuffer* redLight;
+	VertexBuffer* whiteLight;
+	VertexBuffer* blade; // A blade spinning around the origin
+	Mat4 rotors[HELI_ROTOR_COUNT]; // Where each rotor's blade spins
+} HelicopterModel;
+
+// A helicopter part being built, as the triangles that GLU's quadrics draw
+typedef struct HELICOPTERMESH {
+	Vertex* vertices;
+	GLuint* indices;
+	unsigned int vertexCount, vertexCapacity;
+	unsigned int indexCount, indexCapacity;
+} HelicopterMesh;
+
+// Result of sweeping the helicopter along a movement vector
+typedef struct COLLISION {
+	bool hit; // If anything was hit during the movement
+	bool atEdge; // If the thing that was hit is the edge of the scene
+	GLfloat time; // Fraction of the movement [0, 1] that can be made before the impact
+	Vec3 normal; // Normal of the surface that was hit
+	Vec3 slide; // The remaining movement after the impact, projected onto the surface that was hit
+} Collision;
+
 // Moves the helicopter based on a given position offset. This offset will be rotated along the XZ plane 
 // according to the rotation of the helicopter, so can be given relative to the rotation of the helicopter
 void helicopterMove(Helicopter* helicopter, TreeObject* trees, Vec3 velocity);
+// Returns the lowest height the helicopter can be at a point on the XZ plane, above the ground or terrain
+GLfloat helicopterFloor(GLfloat x, GLfloat z);
 // Calculates the collision of a given position, and updates the helicopter's state accordingly
 bool helicopterCollision(Helicopter* helicopter, Vec3 newPosition, TreeObject* trees);
-// Function to draw a helictoper
-void helicopterDisplay(Helicopter* helicopter, GLUquadricObj* cylinderQuadric, GLUquadricObj* sphereQuadric);
+// Sweeps the helicopter from a start position along a movement vector against the scene bounds and
+// the tree collision profiles, returning the earliest impact. This can't tunnel through a tree no matter
+// how large the movement is, so a single sweep per frame replaces testing many small substeps
+// The trees can be searched through a tree grid, or all tested if the grid is NULL
+Collision helicopterSweep(Vec3 start, Vec3 movement, TreeObject* trees, TreeGrid* grid);
+// Moves a position by a velocity, sliding along anything it collides with and removing the part of the
+// velocity heading into it. Returns if the movement ran into the edge of the scene
+bool helicopterSlide(Vec3* position, Vec3* velocity, TreeObject* trees, TreeGrid* grid);
+// Builds the vertex buffers for drawing helicopters, with the same triangles GLU's cylinders and spheres had
+HelicopterModel helicopterGenerateModel(void);
+// Frees a helicopter model's vertex buffers
+void helicopterModelFree(HelicopterModel* model);
+// Returns the model matrix of a helicopter at a given position and angle, pitched by its velocity
+Mat4 helicopterInstance(Vec3 position, Vec3 velocity, GLfloat angle);
+// Draws a helicopter from a model at each of the given model matrices, all with their rotor blades at
+// one angle. The GLSL backend draws each part for all of them at once, as an instanced draw
+void helicopterDrawInstances(HelicopterModel* model, const Mat4* instances, unsigned int count, GLfloat rotorAngle);
+// Returns where the camera sits behind the helicopter
+Vec3 helicopterCameraPosition(Helicopter* helicopter);
+// Returns the view matrix of the camera behind the helicopter, looking at it
+Mat4 helicopterCamera(Helicopter* helicopter);
+// Function to draw a helictoper, which the camera should already be behind
+void helicopterDisplay(Helicopter* helicopter, HelicopterModel* model);
+// Returns the fog density around a helicopter, which thickens sharply towards the edge of the scene
+GLfloat helicopterFogDensity(Helicopter* helicopter);
 // Function to calculate a helicopter's updated parameters on a given frame
 void helicopterThink(Helicopter* helicopter, Quat4 controlQuaternion, TreeObject* trees, GLfloat DeltaTime);
@@ -0,0 +1,110 @@
+#include "input.h"
+
+InputQueue inputQueue;
+
+void inputPush(InputKey key, bool pressed) {
+	InputQueue* queue = &inputQueue;
+	const int head = queue->head;
+
+	if (head - atomicLoad(&queue->tail) == INPUT_QUEUE_SIZE) {
+		atomicAdd(&queue->dropped, 1);
+		return;
+	}
+
+	queue->events[head & (INPUT_QUEUE_SIZE - 1)] = (InputEvent) { platformNanoseconds(), key, pressed };
+	// Publishing the new head also publishes the event written before it
+	atomicStore(&queue->head, head + 1);
+}
+
+// Updates which keys are held and which way each axis moves for one event. The most recent key always wins
+// (holding left then pressing right moves right), and releasing a key moves the other way if its opposite
+// is still held, or stops the axis otherwise
+void inputApply(InputQueue* queue, InputEvent* event) {
+	motionkeys_t* keys = &queue->keys;
+	motionstate4_t* motion = &queue->motion;
+	const keystate_t state = event->pressed ? KEYSTATE_DOWN : KEYSTATE_UP;
+
+	switch (event->key) {
+	case INPUT_MOVE_FORWARD:
+		keys->MoveForward = state;
+		motion->Surge = event->pressed ? MOTION_FORWARD : keys->MoveBackward == KEYSTATE_DOWN ? MOTION_BACKWARD : MOTION_NONE;
+		break;
+	case INPUT_MOVE_BACKWARD:
+		keys->MoveBackward = state;
+		motion->Surge = event->pressed ? MOTION_BACKWARD : keys->MoveForward == KEYSTATE_DOWN ? MOTION_FORWARD : MOTION_NONE;
+		break;
+	case INPUT_MOVE_LEFT:
+		keys->MoveLeft = state;
+		motion->Sway = event->pressed ? MOTION_LEFT : keys->MoveRight == KEYSTATE_DOWN ? MOTION_RIGHT : MOTION_NONE;
+		break;
+	case INPUT_MOVE_RIGHT:
+		keys->MoveRight = state;
+		motion->Sway = event->pressed ? MOTION_RIGHT : keys->MoveLeft == KEYSTATE_DOWN ? MOTION_LEFT : MOTION_NONE;
+		break;
+	case INPUT_MOVE_UP:
+		keys->MoveUp = state;
+		motion->Heave = event->pressed ? MOTION_UP : keys->MoveDown == KEYSTATE_DOWN ? MOTION_DOWN : MOTION_NONE;
+		break;
+	case INPUT_MOVE_DOWN:
+		keys->MoveDown = state;
+		motion->Heave = event->pressed ? MOTION_DOWN : keys->MoveUp == KEYSTATE_DOWN ? MOTION_UP : MOTION_NONE;
+		break;
+	case INPUT_TURN_LEFT:
+		keys->TurnLeft = state;
+		motion->Yaw = event->pressed ? MOTION_ANTICLOCKWISE : keys->TurnRight == KEYSTATE_DOWN ? MOTION_CLOCKWISE : MOTION_NONE;
+		break;
+	case INPUT_TURN_RIGHT:
+		keys->TurnRight = state;
+		motion->Yaw = event->pressed ? MOTION_CLOCKWISE : keys->TurnLeft == KEYSTATE_DOWN ? MOTION_ANTICLOCKWISE : MOTION_NONE;
+		break;
+	default:
+		break;
+	}
+}
+
+// Adds the motion of each axis over a length of time to a sample
+void inputAccumulate(InputSample* sample, motionstate4_t* motion, double duration) {
+	sample->yaw += (GLfloat)(motion->Yaw * duration);
+	sample->surge += (GLfloat)(motion->Surge * duration);
+	sample->sway += (GLfloat)(motion->Sway * duration);
+	sample->heave += (GLfloat)(motion->Heave * duration);
+}
+
+InputSample inputSample(unsigned long long start, unsigned long long end) {
+	InputQueue* queue = &inputQueue;
+	InputSample sample = { 0, 0, 0, 0 };
+	const unsigned long long now = platformNanoseconds();
+	const int head = atomicLoad(&queue->head);
+	const double length = end > start ? (double)(end - start) : 1;
+	unsigned long long cursor = start;
+	int tail = queue->tail;
+
+	for (; tail != head; ++tail) {
+		InputEvent* event = &queue->events[tail & (INPUT_QUEUE_SIZE - 1)];
+		if (event->time >= end) {
+			break;
+		}
+
+		// An event from before the tick started, pushed just too late for the last one, counts from the start
+		const unsigned long long time = event->time > cursor ? event->time : cursor;
+		inputAccumulate(&sample, &queue->motion, (time - cursor) / length);
+		cursor = time;
+
+		inputApply(queue, event);
+		queue->appliedTime = event->time;
+		queue->latencies[queue->latencyCount++ % INPUT_LATENCY_SAMPLES] = now > event->time ? (now - event->time) / 1e6 : 0;
+		if (queue->recorder != NULL) {
+			queue->recorder(queue->recorderData, event);
+		}
+	}
+	// The slots are only handed back once the events in them have been read
+	atomicStore(&queue->tail, tail);
+
+	inputAccumulate(&sample, &queue->motion, (end > cursor ? end - cursor : 0) / length);
+	return sample;
+}
+
+void inputSetRecorder(InputRecorder recorder, void* data) {
+	inputQueue.recorder = recorder;
+	inputQueue.recorderData = data;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include "misc.h"
+#include "atomic.h"
+#include "platform.h"
+
+/*
+ * <input.c/input.h> Carries key presses and releases from the GLUT thread to the simulation thread.
+ * The key callbacks push each one with the time it happened onto a single producer, single consumer
+ * ring, and never touch the motion state themselves. Each simulation tick then takes the events that
+ * happened during the time it stands for, applies them in order, and works out how much of the tick
+ * each axis spent moving which way. A key pressed halfway through a tick moves the helicopter half as
+ * far in it, so input lands at the right point between ticks instead of being rounded to the tick
+ * boundary, and ticks run back to back to catch up still each see their own events
+ */
+
+// Number of events the ring holds. Events pushed while it's full are dropped, so it's far more than
+// can be typed in a tick. Has to be a power of two
+#define INPUT_QUEUE_SIZE 256
+// Number of the most recent events the input to motion latency is reported over
+#define INPUT_LATENCY_SAMPLES 1024
+
+// The keys that move the helicopter
+typedef enum {
+	INPUT_MOVE_FORWARD,
+	INPUT_MOVE_BACKWARD,
+	INPUT_MOVE_LEFT,
+	INPUT_MOVE_RIGHT,
+	INPUT_MOVE_UP,
+	INPUT_MOVE_DOWN,
+	INPUT_TURN_LEFT,
+	INPUT_TURN_RIGHT,
+	INPUT_KEY_COUNT
+} InputKey;
+
+typedef struct INPUTEVENT {
+	unsigned long long time;	// Platform clock time the key went down or up
+	InputKey key;
+	bool pressed;
+} InputEvent;
+
+// Called on the simulation thread with each event as it's applied
+typedef void (*InputRecorder)(void* data, InputEvent* event);
+
+// How each axis moved over a tick, as the average of its MOTION_ value over the time, so it can be a fraction
+typedef struct INPUTSAMPLE {
+	GLfloat yaw, surge, sway, heave;
+} InputSample;
+
+typedef struct INPUTQUEUE {
+	InputEvent events[INPUT_QUEUE_SIZE];
+	volatile int head;			// Next slot the producer writes, only ever increasing
+	volatile int tail;			// Next slot the consumer reads, only ever increasing
+	volatile int dropped;		// Events pushed while the ring was full
+
+	// Everything below is only touched by the consumer
+	motionkeys_t keys;			// Which keys are held down, after the events applied so far
+	motionstate4_t motion;		// Which way each axis is moving, the most recent key winning
+	unsigned long long appliedTime;	// Time of the newest event applied, or 0 if there hasn't been one
+	InputRecorder recorder;
+	void* recorderData;
+	double latencies[INPUT_LATENCY_SAMPLES];	// Milliseconds from each event to the tick that applied it
+	unsigned int latencyCount;
+} InputQueue;
+
+extern InputQueue inputQueue;
+
+// Pushes a key press or release at the current time. Only one thread may push
+void inputPush(InputKey key, bool pressed);
+// Applies the events that happened before the end of a tick, in order, and returns how each axis moved
+// over the tick from start to end on the platform clock. Events after the end are left for the next tick.
+// Only one thread may sample
+InputSample inputSample(unsigned long long start, unsigned long long end);
+// Sets a function to be called with each event as a tick applies it, or NULL for none
+void inputSetRecorder(InputRecorder recorder, void* data);
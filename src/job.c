@@ -0,0 +1,395 @@
+#include "job.h"
+
+#ifdef _MSC_VER
+#define JOB_THREAD_LOCAL __declspec(thread)
+#else
+#define JOB_THREAD_LOCAL __thread
+#endif
+
+JobScheduler jobScheduler;
+
+// The calling thread's slot in the scheduler, and the jobInit it was claimed under
+JOB_THREAD_LOCAL int jobSlot;
+JOB_THREAD_LOCAL int jobSlotGeneration;
+// Whether the calling thread is one of the scheduler's workers
+JOB_THREAD_LOCAL bool jobIsWorker;
+
+// Returns the calling thread's slot, claiming one the first time a thread uses the scheduler
+int jobThreadSlot(void) {
+	if (jobSlotGeneration == jobScheduler.generation) {
+		return jobSlot;
+	}
+
+	// The deques are cleared by jobInit, so a slot only needs its pool before it's used
+	const int slot = atomicAdd(&jobScheduler.threadCount, 1);
+	if (slot >= JOB_MAX_THREADS) {
+		printf("More than %d threads are using the job scheduler\n", JOB_MAX_THREADS);
+		exit(EXIT_FAILURE);
+	}
+	jobScheduler.threads[slot].pool = calloc(JOB_POOL_SIZE, sizeof(Job));
+	jobScheduler.threads[slot].poolNext = 0;
+
+	jobSlot = slot;
+	jobSlotGeneration = jobScheduler.generation;
+	return slot;
+}
+
+// Pushes a job onto the bottom of a thread's own deque. Returns FALSE if it's full
+bool jobDequePush(JobThread* thread, Job* job) {
+	const int bottom = atomicLoad(&thread->bottom);
+	if (bottom - atomicLoad(&thread->top) >= JOB_DEQUE_SIZE) {
+		return FALSE;
+	}
+	atomicStore64(&thread->entries[bottom & (JOB_DEQUE_SIZE - 1)], (long long)(size_t)job);
+	atomicStore(&thread->bottom, bottom + 1);
+	return TRUE;
+}
+
+// Pops the job its owner pushed most recently off the bottom of a deque, or returns NULL if it's empty
+Job* jobDequePop(JobThread* thread) {
+	const int bottom = atomicLoad(&thread->bottom) - 1;
+	atomicStore(&thread->bottom, bottom);
+	const int top = atomicLoad(&thread->top);
+
+	if (top > bottom) {
+		atomicStore(&thread->bottom, bottom + 1);
+		return NULL;
+	}
+
+	Job* job = (Job*)(size_t)atomicLoad64(&thread->entries[bottom & (JOB_DEQUE_SIZE - 1)]);
+	if (top == bottom) {
+		// The last job, which a thief could be taking at the same time, so whoever moves top gets it
+		if (!atomicCompareExchange(&thread->top, top, top + 1)) {
+			job = NULL;
+		}
+		atomicStore(&thread->bottom, bottom + 1);
+	}
+	return job;
+}
+
+// Steals the oldest job off the top of another thread's deque, or returns NULL if it's empty or another
+// thief got there first
+Job* jobDequeSteal(JobThread* thread) {
+	const int top = atomicLoad(&thread->top);
+	if (top >= atomicLoad(&thread->bottom)) {
+		return NULL;
+	}
+
+	Job* job = (Job*)(size_t)atomicLoad64(&thread->entries[top & (JOB_DEQUE_SIZE - 1)]);
+	return atomicCompareExchange(&thread->top, top, top + 1) ? job : NULL;
+}
+
+// Takes a main thread job off the queue, or returns NULL if there are none
+Job* jobTakeMainThread(void) {
+	Job* job = NULL;
+
+	if (atomicLoad(&jobScheduler.mainCount) == 0) {
+		return NULL;
+	}
+
+	threadMutexLock(&jobScheduler.mutex);
+	if (jobScheduler.mainCount > 0) {
+		job = jobScheduler.mainJobs[jobScheduler.mainHead];
+		jobScheduler.mainHead = (jobScheduler.mainHead + 1) % JOB_MAIN_QUEUE_SIZE;
+		atomicAdd(&jobScheduler.mainCount, -1);
+	}
+	threadMutexUnlock(&jobScheduler.mutex);
+	return job;
+}
+
+// Takes a worker job off the queue, or returns NULL if there are none
+Job* jobTakeWorker(void) {
+	Job* job = NULL;
+
+	if (atomicLoad(&jobScheduler.workerJobCount) == 0) {
+		return NULL;
+	}
+
+	threadMutexLock(&jobScheduler.mutex);
+	if (jobScheduler.workerJobCount > 0) {
+		job = jobScheduler.workerJobs[jobScheduler.workerHead];
+		jobScheduler.workerHead = (jobScheduler.workerHead + 1) % JOB_WORKER_QUEUE_SIZE;
+		atomicAdd(&jobScheduler.workerJobCount, -1);
+	}
+	threadMutexUnlock(&jobScheduler.mutex);
+	return job;
+}
+
+void jobExecute(Job* job);
+
+// Wakes a sleeping worker, if there is one, after a job's been counted in queued
+void jobWakeWorker(void) {
+	// A worker counts itself as sleeping before it checks queued, so either it sees the job or it's woken
+	if (atomicLoad(&jobScheduler.sleeping) > 0) {
+		threadMutexLock(&jobScheduler.mutex);
+		threadConditionWakeOne(&jobScheduler.wake);
+		threadMutexUnlock(&jobScheduler.mutex);
+	}
+}
+
+// Makes a job ready to run, waking a worker to take it
+void jobPush(Job* job) {
+	if (job->mainThread) {
+		// Other threads wait for space, since only the main thread can run it
+		for (;;) {
+			threadMutexLock(&jobScheduler.mutex);
+			if (jobScheduler.mainCount < JOB_MAIN_QUEUE_SIZE) {
+				jobScheduler.mainJobs[(jobScheduler.mainHead + jobScheduler.mainCount) % JOB_MAIN_QUEUE_SIZE] = job;
+				atomicAdd(&jobScheduler.mainCount, 1);
+				threadMutexUnlock(&jobScheduler.mutex);
+				return;
+			}
+			threadMutexUnlock(&jobScheduler.mutex);
+
+			if (jobThreadSlot() == jobScheduler.mainSlot) {
+				jobExecute(job);
+				return;
+			}
+			threadYield();
+		}
+	}
+
+	if (job->workerOnly) {
+		// Workers and the thread that's submitting it are the only ones that can run it, so when there
+		// are no workers or no room it's run now
+		bool pushed = FALSE;
+		if (jobScheduler.workerCount > 0) {
+			threadMutexLock(&jobScheduler.mutex);
+			if (jobScheduler.workerJobCount < JOB_WORKER_QUEUE_SIZE) {
+				jobScheduler.workerJobs[(jobScheduler.workerHead + jobScheduler.workerJobCount) % JOB_WORKER_QUEUE_SIZE] = job;
+				atomicAdd(&jobScheduler.workerJobCount, 1);
+				pushed = TRUE;
+			}
+			threadMutexUnlock(&jobScheduler.mutex);
+		}
+		if (!pushed) {
+			jobExecute(job);
+			return;
+		}
+	} else if (!jobDequePush(&jobScheduler.threads[jobThreadSlot()], job)) {
+		jobExecute(job);
+		return;
+	}
+
+	atomicAdd(&jobScheduler.queued, 1);
+	jobWakeWorker();
+}
+
+// Counts one of a job's parts as finished, and once they all are, releases the jobs that depend on it and
+// counts it as finished in its parent
+void jobFinish(Job* job) {
+	// Read before finishing, since a finished job can be handed out again
+	Job* parent = job->parent;
+	Job* continuations[JOB_MAX_CONTINUATIONS];
+	const unsigned int continuationCount = job->continuationCount;
+	memcpy(continuations, job->continuations, continuationCount * sizeof(Job*));
+
+	if (atomicAdd(&job->unfinished, -1) != 1) {
+		return;
+	}
+
+	for (unsigned int i = 0; i < continuationCount; ++i) {
+		if (atomicAdd(&continuations[i]->pending, -1) == 1) {
+			jobPush(continuations[i]);
+		}
+	}
+	if (parent != NULL) {
+		jobFinish(parent);
+	}
+}
+
+// Runs a job, first splitting off the upper half of its range into new jobs until what's left fits the grain
+void jobExecute(Job* job) {
+	while (job->grainSize > 0 && job->end - job->begin > job->grainSize) {
+		const unsigned int middle = job->begin + (job->end - job->begin) / 2;
+		Job* half = jobCreateRange(job->function, job->data, middle, job->end, job->grainSize, job);
+		half->workerOnly = job->workerOnly;
+		job->end = middle;
+		jobSubmit(half);
+	}
+
+	if (job->function != NULL) {
+		job->function(job->data, job->begin, job->end);
+	}
+	jobFinish(job);
+}
+
+// Finds a job for a thread to run: its own newest, then a main thread job if it's the main thread, then
+// the oldest job of another thread, then a worker job if it's a worker
+Job* jobFind(int slot) {
+	Job* job = jobDequePop(&jobScheduler.threads[slot]);
+
+	if (job == NULL && slot == jobScheduler.mainSlot) {
+		job = jobTakeMainThread();
+		if (job != NULL) {
+			return job;
+		}
+	}
+
+	const int threadCount = atomicLoad(&jobScheduler.threadCount);
+	for (int i = 1; job == NULL && i < threadCount; ++i) {
+		job = jobDequeSteal(&jobScheduler.threads[(slot + i) % threadCount]);
+	}
+	if (job == NULL && jobIsWorker) {
+		job = jobTakeWorker();
+	}
+
+	if (job != NULL) {
+		atomicAdd(&jobScheduler.queued, -1);
+	}
+	return job;
+}
+
+// Worker thread entry point, running jobs until the scheduler stops and sleeping when there are none
+void jobWorkerMain(void* data) {
+	const int slot = jobThreadSlot();
+	jobIsWorker = TRUE;
+
+	while (!atomicLoad(&jobScheduler.stopping)) {
+		Job* job = jobFind(slot);
+		if (job != NULL) {
+			jobExecute(job);
+			continue;
+		}
+
+		threadMutexLock(&jobScheduler.mutex);
+		atomicAdd(&jobScheduler.sleeping, 1);
+		while (atomicLoad(&jobScheduler.queued) <= 0 && !atomicLoad(&jobScheduler.stopping)) {
+			threadConditionWait(&jobScheduler.wake, &jobScheduler.mutex);
+		}
+		atomicAdd(&jobScheduler.sleeping, -1);
+		threadMutexUnlock(&jobScheduler.mutex);
+	}
+}
+
+void jobInit(unsigned int workerCount) {
+	const int generation = jobScheduler.generation + 1;
+
+	memset(&jobScheduler, 0, sizeof(JobScheduler));
+	jobScheduler.generation = generation;
+	jobScheduler.workerCount = workerCount < JOB_MAX_THREADS / 2 ? workerCount : JOB_MAX_THREADS / 2;
+	threadMutexInit(&jobScheduler.mutex);
+	threadConditionInit(&jobScheduler.wake);
+	jobScheduler.mainSlot = jobThreadSlot();
+
+	for (unsigned int i = 0; i < jobScheduler.workerCount; ++i) {
+		jobScheduler.workers[i] = threadStart(jobWorkerMain, NULL);
+	}
+}
+
+void jobShutdown(void) {
+	atomicStore(&jobScheduler.stopping, TRUE);
+	threadMutexLock(&jobScheduler.mutex);
+	threadConditionWakeAll(&jobScheduler.wake);
+	threadMutexUnlock(&jobScheduler.mutex);
+
+	for (unsigned int i = 0; i < jobScheduler.workerCount; ++i) {
+		threadJoin(jobScheduler.workers[i]);
+	}
+	for (int i = 0; i < jobScheduler.threadCount && i < JOB_MAX_THREADS; ++i) {
+		free(jobScheduler.threads[i].pool);
+		jobScheduler.threads[i].pool = NULL;
+	}
+
+	threadConditionFree(&jobScheduler.wake);
+	threadMutexFree(&jobScheduler.mutex);
+	jobScheduler.workerCount = 0;
+}
+
+unsigned int jobWorkerCount(void) {
+	return jobScheduler.workerCount;
+}
+
+Job* jobCreateRange(JobFunction function, void* data, unsigned int begin, unsigned int end, unsigned int grainSize, Job* parent) {
+	JobThread* thread = &jobScheduler.threads[jobThreadSlot()];
+	Job* job = &thread->pool[thread->poolNext++ % JOB_POOL_SIZE];
+
+	// Jobs that are still unfinished when the pool wraps around onto them are skipped. They can't be waited
+	// for, since they could be waiting on the job that's running now, like the parents of a split range
+	for (unsigned int skipped = 0; atomicLoad(&job->unfinished) > 0; ++skipped) {
+		if (skipped == JOB_POOL_SIZE) {
+			printf("More than %d jobs are unfinished on one thread\n", JOB_POOL_SIZE);
+			exit(EXIT_FAILURE);
+		}
+		job = &thread->pool[thread->poolNext++ % JOB_POOL_SIZE];
+	}
+
+	job->function = function;
+	job->data = data;
+	job->begin = begin;
+	job->end = end;
+	job->grainSize = grainSize;
+	job->mainThread = FALSE;
+	job->workerOnly = FALSE;
+	job->parent = parent;
+	job->continuationCount = 0;
+	atomicStore(&job->pending, 1);
+	atomicStore(&job->unfinished, 1);
+
+	if (parent != NULL) {
+		atomicAdd(&parent->unfinished, 1);
+	}
+	return job;
+}
+
+Job* jobCreate(JobFunction function, void* data, Job* parent) {
+	return jobCreateRange(function, data, 0, 0, 0, parent);
+}
+
+void jobRequireMainThread(Job* job) {
+	job->mainThread = TRUE;
+}
+
+void jobRequireWorker(Job* job) {
+	job->workerOnly = TRUE;
+}
+
+void jobDepend(Job* job, Job* dependency) {
+	if (dependency->continuationCount >= JOB_MAX_CONTINUATIONS) {
+		printf("More than %d jobs depend on one job\n", JOB_MAX_CONTINUATIONS);
+		exit(EXIT_FAILURE);
+	}
+	dependency->continuations[dependency->continuationCount++] = job;
+	atomicAdd(&job->pending, 1);
+}
+
+void jobSubmit(Job* job) {
+	if (atomicAdd(&job->pending, -1) == 1) {
+		jobPush(job);
+	}
+}
+
+void jobWait(Job* job) {
+	const int slot = jobThreadSlot();
+
+	while (atomicLoad(&job->unfinished) > 0) {
+		Job* next = jobFind(slot);
+		if (next != NULL) {
+			jobExecute(next);
+		} else {
+			threadYield();
+		}
+	}
+}
+
+bool jobFinished(Job* job) {
+	return atomicLoad(&job->unfinished) == 0;
+}
+
+void jobParallelFor(JobFunction function, void* data, unsigned int count, unsigned int grainSize) {
+	if (grainSize == 0) {
+		grainSize = count / ((jobScheduler.workerCount + 1) * 8);
+		grainSize = grainSize > 0 ? grainSize : 1;
+	}
+
+	Job* job = jobCreateRange(function, data, 0, count, grainSize, NULL);
+	jobSubmit(job);
+	jobWait(job);
+}
+
+void jobRunMainThread(void) {
+	Job* job;
+	while ((job = jobTakeMainThread()) != NULL) {
+		jobExecute(job);
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "misc.h"
+#include "atomic.h"
+#include "thread.h"
+
+/*
+ * <job.c/job.h> A small work stealing job scheduler shared by everything that runs in parallel. Each
+ * thread that uses it has its own deque of jobs (Chase and Lev, "Dynamic Circular Work-Stealing
+ * Deque", 2005): it pushes and pops at the bottom, and idle threads steal from the top, so most
+ * jobs never leave the thread that made them. Worker threads sleep when there's nothing to steal
+ *
+ * A job can have children, which it doesn't count as finished until they all are, and can depend
+ * on other jobs, which it won't start until they've finished. Jobs that need the OpenGL context are
+ * marked as main thread jobs, and only run on the thread that called jobInit, either while it waits
+ * on a job or when it calls jobRunMainThread. Background work that no frame or tick is waiting for,
+ * like reparsing an asset, is marked as worker jobs, which only the worker threads take, and only once
+ * there's nothing else to steal, so the GL and simulation threads never pick them up while they wait.
+ * Ranges are split in half as they're run until they're down to the grain size, so a thief always
+ * takes the biggest piece left
+ *
+ * Jobs come from a ring of JOB_POOL_SIZE per thread and are never freed, so no thread should have
+ * more than that many unfinished at once
+ */
+
+// Most threads that can use the scheduler, counting the workers, the main thread and the simulation thread
+#define JOB_MAX_THREADS 64
+// Number of jobs each thread can have waiting in its deque before it runs any more it submits itself
+#define JOB_DEQUE_SIZE 1024
+// Number of jobs in each thread's pool, which are reused in turn
+#define JOB_POOL_SIZE 4096
+// Most jobs that can depend on any one job
+#define JOB_MAX_CONTINUATIONS 8
+// Number of main thread jobs that can be waiting to run
+#define JOB_MAIN_QUEUE_SIZE 256
+// Number of worker jobs that can be waiting to run
+#define JOB_WORKER_QUEUE_SIZE 256
+
+// The work of a job, given the job's data and the range it was asked to run
+typedef void (*JobFunction)(void* data, unsigned int begin, unsigned int end);
+
+typedef struct JOB {
+	JobFunction function;		// NULL for a job that only groups its children
+	void* data;
+	unsigned int begin, end;	// Range passed to the function
+	unsigned int grainSize;		// Largest part of the range run without splitting it, or 0 not to split it
+	bool mainThread;			// Whether it has to run on the thread that called jobInit
+	bool workerOnly;			// Whether only a worker thread can run it
+	struct JOB* parent;			// Job that won't finish until this one has, if any
+	volatile int unfinished;	// This job and its children that haven't finished
+	volatile int pending;		// Dependencies that haven't finished, plus one until it's submitted
+	struct JOB* continuations[JOB_MAX_CONTINUATIONS];	// Jobs depending on this one
+	unsigned int continuationCount;
+} Job;
+
+typedef struct JOBTHREAD {
+	volatile int top;			// Where thieves take jobs from, only ever increasing
+	volatile int bottom;		// Where the owner pushes and pops jobs
+	volatile long long entries[JOB_DEQUE_SIZE];	// Job pointers, indexed by top and bottom modulo the size
+	Job* pool;
+	unsigned int poolNext;		// Next job in the pool to hand out
+	char padding[64];			// Keeps the next thread's top and bottom off this one's cache line
+} JobThread;
+
+typedef struct JOBSCHEDULER {
+	JobThread threads[JOB_MAX_THREADS];
+	volatile int threadCount;	// Number of thread slots claimed
+	int generation;				// Counts calls to jobInit, so threads know to claim a new slot after one
+	int mainSlot;				// Slot of the thread that called jobInit
+	Thread workers[JOB_MAX_THREADS];
+	unsigned int workerCount;
+
+	Mutex mutex;				// Guards the main thread queue and sleeping workers
+	Condition wake;
+	volatile int queued;		// Jobs pushed onto deques and not yet taken, to know when to sleep
+	volatile int sleeping;		// Workers waiting on the condition
+	volatile int stopping;
+
+	Job* mainJobs[JOB_MAIN_QUEUE_SIZE];	// Main thread jobs waiting to run, as a ring
+	unsigned int mainHead;
+	volatile int mainCount;
+
+	Job* workerJobs[JOB_WORKER_QUEUE_SIZE];	// Worker jobs waiting to run, as a ring
+	unsigned int workerHead;
+	volatile int workerJobCount;
+} JobScheduler;
+
+// Starts the scheduler with a number of worker threads, on top of the calling thread, which becomes the main
+// thread. With no workers, jobs run on whichever thread waits for them
+void jobInit(unsigned int workerCount);
+// Stops and joins the worker threads. No jobs may be left unfinished
+void jobShutdown(void);
+// Returns the number of worker threads
+unsigned int jobWorkerCount(void);
+// Creates a job that runs a function once, as a child of parent if it isn't NULL. It doesn't start until submitted
+Job* jobCreate(JobFunction function, void* data, Job* parent);
+// Creates a job that runs a function over the range [begin, end), split into parts no bigger than the grain size
+// that can run in parallel, as a child of parent if it isn't NULL. It doesn't start until submitted
+Job* jobCreateRange(JobFunction function, void* data, unsigned int begin, unsigned int end, unsigned int grainSize, Job* parent);
+// Makes a job only run on the main thread, for OpenGL calls. Has to be called before it's submitted
+void jobRequireMainThread(Job* job);
+// Makes a job only run on a worker thread, after any other work there is to steal, so nothing waiting on a
+// frame runs it. With no workers it runs on the thread that submits it. Has to be called before it's submitted
+void jobRequireWorker(Job* job);
+// Makes a job wait for another to finish before starting. Both have to be called before either is submitted
+void jobDepend(Job* job, Job* dependency);
+// Lets a job run, as soon as its dependencies have finished
+void jobSubmit(Job* job);
+// Runs other jobs until a job and its children have finished
+void jobWait(Job* job);
+// Returns whether a job and its children have finished
+bool jobFinished(Job* job);
+// Runs a function over [0, count) in parallel, in parts no bigger than the grain size, returning once it's
+// all done. A grain size of 0 picks one that gives each thread several parts
+void jobParallelFor(JobFunction function, void* data, unsigned int count, unsigned int grainSize);
+// Runs any main thread jobs that are waiting. Only the main thread can call this
+void jobRunMainThread(void);
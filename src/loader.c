@@ -8,22 +8,77 @@
 
 char* generatePath(char* name) {
 	const unsigned int pathLength = strlen(DIR) + strlen(name) + 1;
-	char* path = malloc(pathLength);
+	char* path = allocMalloc(ALLOC_LOADER, pathLength);
 	sprintf_s(path, pathLength, "%s%s", DIR, name);
 	return path;
 }
 
-void loadTrees(GLfloat values[TREES_LENGTH][3]) {
-	FILE* file = fopen("assets/tree.loc", "r");
+char* readLine(char* line, int length, const char** cursor) {
+	const char* text = *cursor;
+	int i = 0;
 
-	if (file == NULL) {
+	if (*text == '\0') {
 		return NULL;
 	}
+	while (i < length - 1 && text[i] != '\0') {
+		line[i] = text[i];
+		if (text[i++] == '\n') {
+			break;
+		}
+	}
+	line[i] = '\0';
+	*cursor = text + i;
+	return line;
+}
+
+bool readKeyword(const char* line, char* keyword, size_t size) {
+	size_t i = 0;
+
+	while (*line == ' ' || *line == '\t' || *line == '\r' || *line == '\n') {
+		++line;
+	}
+	while (i < size - 1 && line[i] != '\0' && line[i] != ' ' && line[i] != '\t' && line[i] != '\r' && line[i] != '\n') {
+		keyword[i] = line[i];
+		++i;
+	}
+	keyword[i] = '\0';
+	return i > 0;
+}
+
+int readPNMNumber(const unsigned char* data, size_t length, size_t* offset) {
+	int value = -1;
 
+	while (*offset < length) {
+		if (data[*offset] == '#') {
+			while (*offset < length && data[*offset] != '\n') { ++*offset; }
+		} else if (data[*offset] == ' ' || data[*offset] == '\t' || data[*offset] == '\r' || data[*offset] == '\n') {
+			++*offset;
+		} else {
+			break;
+		}
+	}
+
+	while (*offset < length && data[*offset] >= '0' && data[*offset] <= '9') {
+		value = (value < 0 ? 0 : value * 10) + (data[*offset] - '0');
+		++*offset;
+	}
+
+	return value;
+}
+
+void loadTrees(GLfloat values[TREES_LENGTH][3]) {
+	size_t size;
+	char* data = (char*)packRead("tree.loc", &size);
+
+	if (data == NULL) {
+		return;
+	}
+
+	const char* cursor = data;
 	char line[32];
 	char* var;
 	unsigned int i = 0;
-	while (fgets(line, (unsigned)_countof(line), file)) {
+	while (readLine(line, _countof(line), &cursor)) {
 		unsigned int type = 0;
 		var = strtok(line, " ");
 		while (var != NULL) {
@@ -34,7 +89,7 @@ void loadTrees(GLfloat values[TREES_LENGTH][3]) {
 		}
 		++i;
 	}
-	fclose(file);
+	allocFree(data);
 }
 
  /*
@@ -44,7 +99,8 @@ void loadTrees(GLfloat values[TREES_LENGTH][3]) {
 	 returned by this function CANNOT be released with free().
  */
 MeshObject* loadMeshObject(char* fileName) {
-	FILE* inFile;
+	size_t size;
+	const char* cursor;				// Start of the next line to be parsed
 	MeshObject* object;
 	char line[512];					// Line currently being parsed 
 	char keyword[10];				// Keyword currently being parsed
@@ -53,16 +109,14 @@ MeshObject* loadMeshObject(char* fileName) {
 	int currentNormalIndex = 0;		// 0-based index of the normal currently being parsed
 	int currentFaceIndex = 0;		// 0-based index of the face currently being parsed
 
-	const char* filePath = generatePath(fileName);
-	inFile = fopen(filePath, "r");
-	free(filePath);
+	char* data = (char*)packRead(fileName, &size);
 
-	if (inFile == NULL) {
+	if (data == NULL) {
 		return NULL;
 	}
 
 	// Allocate and initialize a new Mesh Object.
-	object = malloc(sizeof(MeshObject));
+	object = allocMalloc(ALLOC_LOADER, sizeof(MeshObject));
 	object->vertexCount = 0;
 	object->vertices = NULL;
 	object->texCoordCount = 0;
@@ -71,10 +125,12 @@ MeshObject* loadMeshObject(char* fileName) {
 	object->normals = NULL;
 	object->faceCount = 0;
 	object->faces = NULL;
+	arenaInit(&object->arena, ALLOC_LOADER, 0);
 
 	// Pre-parse the file to determine how many vertices, texture coordinates, normals, and faces we have.
-	while (fgets(line, (unsigned)_countof(line), inFile)) {
-		if (sscanf_s(line, "%9s", keyword, (unsigned)_countof(keyword)) == 1) {
+	cursor = data;
+	while (readLine(line, _countof(line), &cursor)) {
+		if (readKeyword(line, keyword, _countof(keyword))) {
 			if (strcmp(keyword, "v") == 0) {
 				object->vertexCount++;
 			} else if (strcmp(keyword, "vt") == 0) {
@@ -87,16 +143,15 @@ MeshObject* loadMeshObject(char* fileName) {
 		}
 	}
 
-	if (object->vertexCount > 0)object->vertices = malloc(sizeof(Vec3) * object->vertexCount);
-	if (object->texCoordCount > 0) object->texCoords = malloc(sizeof(Vec2) * object->texCoordCount);
-	if (object->normalCount > 0) object->normals = malloc(sizeof(Vec3) * object->normalCount);
-	if (object->faceCount > 0) object->faces = malloc(sizeof(MeshObjectFace) * object->faceCount);
+	if (object->vertexCount > 0) object->vertices = arenaAlloc(&object->arena, sizeof(Vec3) * object->vertexCount);
+	if (object->texCoordCount > 0) object->texCoords = arenaAlloc(&object->arena, sizeof(Vec2) * object->texCoordCount);
+	if (object->normalCount > 0) object->normals = arenaAlloc(&object->arena, sizeof(Vec3) * object->normalCount);
+	if (object->faceCount > 0) object->faces = arenaAlloc(&object->arena, sizeof(MeshObjectFace) * object->faceCount);
 
 	// Parse the file again, reading the actual vertices, texture coordinates, normals, and faces.
-	rewind(inFile);
-
-	while (fgets(line, (unsigned)_countof(line), inFile)) {
-		if (sscanf_s(line, "%9s", keyword, (unsigned)_countof(keyword)) == 1) {
+	cursor = data;
+	while (readLine(line, _countof(line), &cursor)) {
+		if (readKeyword(line, keyword, _countof(keyword))) {
 			if (strcmp(keyword, "v") == 0) {
 				Vec3 vertex = { 0, 0, 0 };
 				sscanf_s(line, "%*s %f %f %f", &vertex.x, &vertex.y, &vertex.z);
@@ -113,13 +168,13 @@ MeshObject* loadMeshObject(char* fileName) {
 				memcpy_s(&object->normals[currentNormalIndex], sizeof(Vec3), &normal, sizeof(Vec3));
 				currentNormalIndex++;
 			} else if (strcmp(keyword, "f") == 0) {
-				initMeshObjectFace(&(object->faces[currentFaceIndex]), line, _countof(line));
+				initMeshObjectFace(&object->arena, &(object->faces[currentFaceIndex]), line, _countof(line));
 				currentFaceIndex++;
 			}
 		}
 	}
 
-	fclose(inFile);
+	allocFree(data);
 
 	return object;
 }
@@ -156,9 +211,10 @@ void renderMeshObject(MeshObject* object) {
 }
 
 /*
-	Initialise the specified Mesh Object Face from a string of face data in the Wavefront OBJ file format.
+	Initialise the specified Mesh Object Face from a string of face data in the Wavefront OBJ file format,
+	allocating its points from the object's arena.
 */
-void initMeshObjectFace(MeshObjectFace* face, char* faceData, int maxFaceDataLength) {
+void initMeshObjectFace(Arena* arena, MeshObjectFace* face, char* faceData, int maxFaceDataLength) {
 	int maxPoints = 0;
 	int inWhitespace = 0;
 	const char* delimiter = " ";
@@ -185,7 +241,7 @@ void initMeshObjectFace(MeshObjectFace* face, char* faceData, int maxFaceDataLen
 	// Parse the input string to extract actual face points (if we're expecting any).
 	face->pointCount = 0;
 	if (maxPoints > 0) {
-		face->points = malloc(sizeof(MeshObjectFacePoint) * maxPoints);
+		face->points = arenaAlloc(arena, sizeof(MeshObjectFacePoint) * maxPoints);
 
 		token = strtok_s(faceData, delimiter, &context);
 		while ((token != NULL) && (face->pointCount < maxPoints)) {
@@ -215,12 +271,9 @@ void initMeshObjectFace(MeshObjectFace* face, char* faceData, int maxFaceDataLen
 			token = strtok_s(NULL, delimiter, &context);
 		}
 
-		// If we have fewer points than expected, free the unused memory.
+		// If we have no points, the unused memory goes back with the rest of the arena.
 		if (face->pointCount == 0) {
-			free(face->points);
 			face->points = NULL;
-		} else if (face->pointCount < maxPoints) {
-			realloc(face->points, sizeof(MeshObjectFacePoint) * face->pointCount);
 		}
 	} else {
 		face->points = NULL;
@@ -232,19 +285,8 @@ void initMeshObjectFace(MeshObjectFace* face, char* faceData, int maxFaceDataLen
 */
 void freeMeshObject(MeshObject* object) {
 	if (object != NULL) {
-		free(object->vertices);
-		free(object->texCoords);
-		free(object->normals);
-
-		if (object->faces != NULL) {
-			for (int i = 0; i < object->faceCount; i++) {
-				free(object->faces[i].points);
-			}
-
-			free(object->faces);
-		}
-
-		free(object);
+		arenaFree(&object->arena);
+		allocFree(object);
 	}
 }
 
@@ -252,18 +294,16 @@ void freeMeshObject(MeshObject* object) {
  * PPM Object Loader Implementation
  ******************************************************************************/
 
-int loadPPM(char* filename) {
-	FILE* inFile; //File pointer
+GLubyte* loadPPMPixels(char* filename, int* imageWidth, int* imageHeight) {
+	unsigned char* data; //the whole file, from the archive or the assets folder
+	size_t size; //length of the file
+	size_t offset = 2; //position of the next character to parse, after the 'P3'
 	int width, height, maxVal; //image metadata from PPM file format
 	int totalPixels; // total number of pixels in the image
 
-					 // temporary character
-	char tempChar;
 	// counter variable for the current pixel in the image
 	int i;
 
-	char header[100]; //input buffer for reading in the file header information
-
 	// if the original values are larger than 255
 	float RGBScaling;
 
@@ -272,51 +312,34 @@ int loadPPM(char* filename) {
 
 	GLubyte* texture; //the texture buffer pointer
 
-	//create one texture with the next available index
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-
-	const char* filepath = generatePath(filename);
-	inFile = fopen(filepath, "r");
-	free(filepath);
-
-	// read in the first header line
-	//    - "%[^\n]"  matches a string of all characters not equal to the new line character ('\n')
-	//    - so we are just reading everything up to the first line break
-	fscanf(inFile, "%[^\n] ", header);
+	data = packRead(filename, &size);
+	if (data == NULL) {
+		printf("Couldn't load '%s'\n", filename);
+		return NULL;
+	}
 
 	// make sure that the image begins with 'P3', which signifies a PPM file
-	if ((header[0] != 'P') || (header[1] != '3')) {
-		printf("This is not a PPM file!\n");
-		exit(0);
+	if (size < 2 || (data[0] != 'P') || (data[1] != '3')) {
+		printf("'%s' is not a PPM file!\n", filename);
+		allocFree(data);
+		return NULL;
 	}
 
-
-	// read in the first character of the next line
-	fscanf(inFile, "%c", &tempChar);
-
-	// while we still have comment lines (which begin with #)
-	while (tempChar == '#') {
-		// read in the comment
-		fscanf(inFile, "%[^\n] ", header);
-
-
-		// read in the first character of the next line
-		fscanf(inFile, "%c", &tempChar);
+	// read in the image width, height and the maximum value, skipping any comment lines (which begin with #)
+	width = readPNMNumber(data, size, &offset);
+	height = readPNMNumber(data, size, &offset);
+	maxVal = readPNMNumber(data, size, &offset);
+	if (width <= 0 || height <= 0 || maxVal <= 0) {
+		printf("'%s' has a broken header\n", filename);
+		allocFree(data);
+		return NULL;
 	}
 
-	// the last one was not a comment character '#', so we need to put it back into the file stream (undo)
-	ungetc(tempChar, inFile);
-
-	// read in the image hieght, width and the maximum value
-	fscanf(inFile, "%d %d %d", &width, &height, &maxVal);
-	// print out the information about the image file
-
 	// compute the total number of pixels in the image
 	totalPixels = width * height;
 
 	// allocate enough memory for the image  (3*) because of the RGB data
-	texture = malloc(3 * sizeof(GLuint) * totalPixels);
+	texture = allocMalloc(ALLOC_LOADER, 3 * sizeof(GLubyte) * totalPixels);
 
 	// determine the scaling for RGB values
 	RGBScaling = 255.0f / maxVal;
@@ -326,7 +349,9 @@ int loadPPM(char* filename) {
 	if (maxVal == 255) {
 		for (i = 0; i < totalPixels; i++) {
 			// read in the current pixel from the file
-			fscanf(inFile, "%d %d %d", &red, &green, &blue);
+			red = readPNMNumber(data, size, &offset);
+			green = readPNMNumber(data, size, &offset);
+			blue = readPNMNumber(data, size, &offset);
 
 			// store the red, green and blue data of the current pixel in the data array
 			texture[3 * totalPixels - 3 * i - 3] = red;
@@ -337,7 +362,9 @@ int loadPPM(char* filename) {
 	{
 		for (i = 0; i < totalPixels; i++) {
 			// read in the current pixel from the file
-			fscanf(inFile, "%d %d %d", &red, &green, &blue);
+			red = readPNMNumber(data, size, &offset);
+			green = readPNMNumber(data, size, &offset);
+			blue = readPNMNumber(data, size, &offset);
 
 			// store the red, green and blue data of the current pixel in the data array
 			texture[3 * totalPixels - 3 * i - 3] = (GLubyte)(red * RGBScaling);
@@ -347,7 +374,33 @@ int loadPPM(char* filename) {
 	}
 
 
-	fclose(inFile);
+	allocFree(data);
+
+	*imageWidth = width;
+	*imageHeight = height;
+	return texture;
+}
+
+int loadPPM(char* filename) {
+	int width, height;
+	GLubyte* texture = loadPPMPixels(filename, &width, &height);
+	if (texture == NULL) {
+		exit(0);
+	}
+
+	GLuint textureID = createTexture(texture, width, height);
+
+	//openGL guarantees to have the texture data stored so we no longer need it
+	allocFree(texture);
+
+	//return the current texture id
+	return(textureID);
+}
+
+int createTexture(GLubyte* pixels, int width, int height) {
+	//create one texture with the next available index
+	GLuint textureID;
+	glGenTextures(1, &textureID);
 
 	glBindTexture(GL_TEXTURE_2D, textureID);
 
@@ -359,12 +412,12 @@ int loadPPM(char* filename) {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
 
 
-	//Create mipmaps
-	gluBuild2DMipmaps(GL_TEXTURE_2D, 4, (GLuint)width, (GLuint)height, GL_RGB, GL_UNSIGNED_BYTE, texture);
-
-	//openGL guarantees to have the texture data stored so we no longer need it
-	free(texture);
+	//Create mipmaps. The rows are packed tightly, which OpenGL only expects if told, since a row of an odd
+	//width isn't a multiple of four bytes
+	glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	gluBuild2DMipmaps(GL_TEXTURE_2D, 4, (GLuint)width, (GLuint)height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+	glPopClientAttrib();
 
-	//return the current texture id
 	return(textureID);
 }
\ No newline at end of file
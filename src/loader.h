@@ -1,7 +1,12 @@
 #pragma once
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <freeglut.h>
+#include "platform.h"
 #include "vecmath.h"
+#include "alloc.h"
+#include "pack.h"
 
 /*
  * <loader.c/loader.h> Handles all logic for loading and using Wavefront Objects, PPM images,
@@ -32,17 +37,32 @@ typedef struct {
 	Vec3* normals;
 	int faceCount;
 	MeshObjectFace* faces;
+	Arena arena;		// Holds every array above, so the whole object is freed at once
 } MeshObject;
 
+// Copies the next line of some text into a buffer of a length, including the newline, and moves the cursor
+// past it, like fgets. Returns NULL once the text runs out
+char* readLine(char* line, int length, const char** cursor);
+// Copies the first word of a line into a buffer of a size, cutting it short if it doesn't fit. Returns
+// whether the line had a word
+bool readKeyword(const char* line, char* keyword, size_t size);
+// Reads the next number from a PNM header or ASCII image, skipping whitespace and comments. Returns -1 if there isn't one
+int readPNMNumber(const unsigned char* data, size_t length, size_t* offset);
 // Loads the tree data from the trees file
 void loadTrees(GLfloat values[TREES_LENGTH][3]);
-// Generates an asset path from a given filename. Return value must be free()'d after use
+// Generates an asset path from a given filename. Return value must be allocFree()'d after use
 char* generatePath(char* name);
 // Loads a Wavefront OBJ mesh file from a given file. Returns a pointer to the loaded mesh object
 MeshObject* loadMeshObject(char* fileName);
 // Renders a given mesh object
 void renderMeshObject(MeshObject* object);
-void initMeshObjectFace(MeshObjectFace* face, char* faceData, int faceDataLength);
+void initMeshObjectFace(Arena* arena, MeshObjectFace* face, char* faceData, int faceDataLength);
 void freeMeshObject(MeshObject* object);
-// Load a binary ppm file into an OpenGL texture and return the OpenGL texture reference ID
-int loadPPM(char* filename);
\ No newline at end of file
+// Load a binary ppm file into an OpenGL texture and return the OpenGL texture reference ID. Exits if it can't be read
+int loadPPM(char* filename);
+// Load the pixels of a ppm file, as RGB bytes in the order OpenGL expects them for a texture, or NULL if it
+// can't be read. Return value is counted against ALLOC_LOADER and must be allocFree()'d after use
+GLubyte* loadPPMPixels(char* filename, int* width, int* height);
+// Create a mipmapped OpenGL texture from RGB pixels and return the OpenGL texture reference ID. The pixels
+// can be freed straight after
+int createTexture(GLubyte* pixels, int width, int height);
\ No newline at end of file
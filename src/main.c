@@ -15,31 +15,85 @@
 
 #include "main.h"
 
-// Ideal time each frame should be displayed for (in milliseconds).
-const unsigned int FRAME_TIME = 1000 / TARGET_FPS;
-// Frame time in fractional seconds.
-// Note: This is calculated to accurately reflect the truncated integer value of
-// FRAME_TIME, which is used for timing, rather than the more accurate fractional
-// value we'd get if we simply calculated "FRAME_TIME_SEC = 1.0f / TARGET_FPS".
-const float FRAME_TIME_SEC = (1000 / TARGET_FPS) / 1000.0f;
-// Time we started preparing the current frame (in milliseconds since GLUT was initialized).
+// Time between simulation ticks (in nanoseconds). The simulation always ticks at TARGET_FPS,
+// however fast frames are actually drawn.
+const unsigned long long TICK_TIME = 1000000000ULL / TARGET_FPS;
+// Tick time in fractional seconds.
+const float FRAME_TIME_SEC = 1.0f / TARGET_FPS;
+// Time the current tick started (in milliseconds since the main loop started).
 unsigned int frameStartTime = 0;
+// When the current tick is due (in nanoseconds on the platform clock). The tick applies the inputs from the
+// TICK_TIME before it.
+unsigned long long tickDueTime = 0;
+// When the main loop started (in nanoseconds on the platform clock).
+unsigned long long loopStartTime = 0;
+// Paces the frames to the target frame rate.
+FramePacer pacer;
+// Number of simulation ticks run so far, only touched by the simulation thread.
+unsigned long long tickCount = 0;
 
 
-// pointer to quadric objects
-GLUquadricObj* sphereQuadric;
-GLUquadricObj* cylinderQuadric;
-
 // Animated object parameters
 Helicopter helicopter;
-GLfloat waterHeight, waterOffset;
+HelicopterModel helicopterModel;
+Swarm* swarm = NULL;
+GLfloat waterHeight, waterOffset, waterTime;
+Water* water = NULL;
 
 // Meshes and Textures
-MeshObject* pondModel;
+VertexBuffer* pondBuffer = NULL;
+VertexBuffer* groundBuffer = NULL;
+Terrain* terrain = NULL;
+Sky* sky = NULL;
 TreeModel treeModel01, treeModel02, treeModel03;
 GLuint treeDisplayList01, treeDisplayList02, treeDisplayList03;
 TreeObject trees[TREES_LENGTH];
+TreeCull* treeCull = NULL;
+PassScheduler passes;
+
+// The simulation runs on its own thread, and hands the scene to display() through snapshots
+Thread simulationThread;
+volatile int simulationRunning = FALSE;
+SnapshotBuffer snapshots;
+SceneSnapshot* scene = NULL; // The snapshot display() is drawing, only touched by the render thread
+// Time each thread has spent working since the main loop started, in nanoseconds
+volatile long long simulationBusyTime = 0;
+unsigned long long renderBusyTime = 0;
+// Time from an input to the end of the buffer swap of the first frame drawn after it was simulated
+double latencySamples[LATENCY_SAMPLES];
+unsigned int latencyCount = 0;
+unsigned long long lastPresentedInput = 0;
 GLuint groundTexture, skyTexture, waterTexture;
+const RenderMaterial groundMaterial = { { 0, 0, 0, 0 }, { 1, 1, 1, 1 }, { 1, 1, 1, 1 }, { 0, 0, 0, 1 }, 5 };
+const RenderMaterial waterMaterial = { { 0, 0, 0, 0 }, { 0.2, 0.4, 1, 0.8 }, { 1, 1, 1, 1 }, { 0, 0, 0, 1 }, 80 };
+
+// Command line options
+unsigned int swarmSize = 0; // Number of drones to fly alongside the player, from --swarm
+char* replayFileName = NULL; // Control inputs for the swarm to play back, from --replay
+FILE* recordFile = NULL; // Where the player's control inputs are recorded to, from --record
+FILE* eventFile = NULL; // Where the key presses and releases are recorded to as they're applied, from --record-events
+bool waterWaves = FALSE; // Whether the water surface has moving waves, from --waves
+char* terrainFileName = NULL; // Heightmap to replace the flat ground with, from --terrain
+RenderBackend sceneRenderer = RENDER_FIXED; // How the scene is shaded, from --renderer
+VertexFormat meshFormat = VERTEX_FLOAT; // How the loaded meshes' vertices are stored, from --vertex-format
+bool skybox = FALSE; // Whether the sky is a box around the camera rather than the dome, from --skybox
+double frameRate = TARGET_FPS; // Frames drawn per second, or 0 for as fast as possible, from --fps
+bool profileOverlay = FALSE; // Whether frame timings are drawn over the scene, from --profile
+FILE* profileCsvFile = NULL; // Where frame timings are written as CSV, from --profile-csv
+FILE* profileJsonFile = NULL; // Where frame timings are written as JSON lines, from --profile-json
+bool headless = FALSE; // Whether frames are drawn offscreen and timed rather than shown, from --headless
+unsigned int headlessFrames = HEADLESS_DEFAULT_FRAMES; // Number of frames drawn headless, from --frames
+unsigned int headlessWidth = DEFAULT_WINDOW_WIDTH, headlessHeight = DEFAULT_WINDOW_HEIGHT; // From --size
+char* captureDirectory = NULL; // Where headless frames are saved as PPM files, from --capture
+unsigned int captureInterval = 1; // Saves every this many headless frames, from --capture-every
+char* inputFileName = NULL; // Recorded control inputs for the player to fly headless, from --input
+char* goldenDirectory = NULL; // Where golden frames are checked against, from --golden, or saved to, from --golden-update
+bool goldenUpdate = FALSE;
+unsigned int goldenTolerance = GOLDEN_TOLERANCE; // Largest channel difference that still matches, from --golden-tolerance
+unsigned int sceneSeed = 0; // Seed the trees are placed from, or 0 to seed from the time, from --seed
+int jobWorkers = -1; // Worker threads the job scheduler runs, from --workers, or -1 for one per core after the first
+char* archiveFileName = PACK_DEFAULT_FILE; // Archive the assets are read from, from --archive, or NULL for the loose files (--loose)
+bool hotReload = FALSE; // Whether meshes and textures are reloaded when their files change, from --hot-reload
 
 /******************************************************************************
  * Entry Point (don't put anything except the main function here)
@@ -47,25 +101,171 @@ GLuint groundTexture, skyTexture, waterTexture;
 
 void main(int argc, char **argv) {
 	bool fullBright = FALSE;
-	if (argc > 1) {
-		fullBright = !strcmp(argv[1], "--fullbright");
+	char* benchName = NULL;
+	char* packFileName = NULL;
+	bool packCompressed = TRUE;
+	bool archiveRequired = FALSE;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--fullbright")) {
+			fullBright = TRUE;
+		} else if (!strcmp(argv[i], "--bench") && i + 1 < argc) {
+			benchName = argv[++i];
+		} else if (!strcmp(argv[i], "--swarm") && i + 1 < argc) {
+			swarmSize = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--replay") && i + 1 < argc) {
+			replayFileName = argv[++i];
+		} else if (!strcmp(argv[i], "--terrain") && i + 1 < argc) {
+			terrainFileName = argv[++i];
+		} else if (!strcmp(argv[i], "--renderer") && i + 1 < argc) {
+			sceneRenderer = !strcmp(argv[++i], "glsl") ? RENDER_GLSL : RENDER_FIXED;
+		} else if (!strcmp(argv[i], "--vertex-format") && i + 1 < argc) {
+			meshFormat = !strcmp(argv[++i], "packed") ? VERTEX_PACKED : VERTEX_FLOAT;
+		} else if (!strcmp(argv[i], "--skybox")) {
+			skybox = TRUE;
+		} else if (!strcmp(argv[i], "--depth-prepass")) {
+			passes.depthPrepass = TRUE;
+		} else if (!strcmp(argv[i], "--overdraw")) {
+			passes.overdraw = TRUE;
+		} else if (!strcmp(argv[i], "--fps") && i + 1 < argc) {
+			frameRate = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "--profile")) {
+			profileOverlay = TRUE;
+		} else if (!strcmp(argv[i], "--profile-csv") && i + 1 < argc) {
+			profileCsvFile = fopen(argv[++i], "w");
+			if (profileCsvFile == NULL) {
+				printf("Couldn't open '%s' to write the frame timings CSV to\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+		} else if (!strcmp(argv[i], "--profile-json") && i + 1 < argc) {
+			profileJsonFile = fopen(argv[++i], "w");
+			if (profileJsonFile == NULL) {
+				printf("Couldn't open '%s' to write the frame timings JSON to\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+		} else if (!strcmp(argv[i], "--waves")) {
+			waterWaves = TRUE;
+		} else if (!strcmp(argv[i], "--fast-math")) {
+			angleSetMode(ANGLE_POLYNOMIAL);
+		} else if (!strcmp(argv[i], "--record") && i + 1 < argc) {
+			recordFile = fopen(argv[++i], "w");
+		} else if (!strcmp(argv[i], "--record-events") && i + 1 < argc) {
+			eventFile = fopen(argv[++i], "w");
+			if (eventFile == NULL) {
+				printf("Couldn't open '%s' to record the key events to\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			inputSetRecorder(recordInputEvent, eventFile);
+		} else if (!strcmp(argv[i], "--headless")) {
+			headless = TRUE;
+		} else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+			headlessFrames = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+			sscanf_s(argv[++i], "%ux%u", &headlessWidth, &headlessHeight);
+		} else if (!strcmp(argv[i], "--capture") && i + 1 < argc) {
+			captureDirectory = argv[++i];
+		} else if (!strcmp(argv[i], "--capture-every") && i + 1 < argc) {
+			captureInterval = atoi(argv[++i]);
+			captureInterval = captureInterval > 0 ? captureInterval : 1;
+		} else if (!strcmp(argv[i], "--input") && i + 1 < argc) {
+			inputFileName = argv[++i];
+		} else if ((!strcmp(argv[i], "--golden") || !strcmp(argv[i], "--golden-update")) && i + 1 < argc) {
+			goldenUpdate = !strcmp(argv[i], "--golden-update");
+			goldenDirectory = argv[++i];
+			headless = TRUE;
+		} else if (!strcmp(argv[i], "--golden-tolerance") && i + 1 < argc) {
+			goldenTolerance = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+			sceneSeed = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--workers") && i + 1 < argc) {
+			jobWorkers = atoi(argv[++i]);
+		} else if ((!strcmp(argv[i], "--pack") || !strcmp(argv[i], "--pack-raw")) && i + 1 < argc) {
+			packCompressed = !strcmp(argv[i], "--pack");
+			packFileName = argv[++i];
+		} else if (!strcmp(argv[i], "--archive") && i + 1 < argc) {
+			archiveFileName = argv[++i];
+			archiveRequired = TRUE;
+		} else if (!strcmp(argv[i], "--loose")) {
+			archiveFileName = NULL;
+		} else if (!strcmp(argv[i], "--hot-reload")) {
+			hotReload = TRUE;
+		}
+	}
+
+	// Packing the assets is all that's done when it's asked for
+	if (packFileName != NULL) {
+		packCreate(packFileName, packCompressed);
+		return;
+	}
+	// The files being edited are the loose ones, so nothing is read from the archive while they're watched
+	if (hotReload) {
+		archiveFileName = NULL;
+	}
+	// Without an archive, or with one that's broken, every asset is read from the assets folder
+	if (archiveFileName != NULL && !packOpen(archiveFileName) && archiveRequired) {
+		printf("Couldn't open the archive '%s', the assets will be read from '%s' instead\n", archiveFileName, DIR);
 	}
 
-	// Initialize the OpenGL window.
-	glutInit(&argc, argv);
-	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
-	glutInitWindowSize(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
-	glutCreateWindow("OpenGL Drone | 19076935");
+	jobInit(jobWorkers >= 0 ? jobWorkers : threadCoreCount() - 1);
 
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	// Because it's taking a little over a second or two to load,
-	// I want to display something while it loads
-	drawText("Loading...", (Vec2) {DEFAULT_WINDOW_WIDTH / 2 - 45, DEFAULT_WINDOW_HEIGHT /2 });
-	glutSwapBuffers();
+	// Benchmarks run without the window, and exit once they're done, with a failure if any of their checks failed
+	if (benchName != NULL) {
+		exit(benchRun(benchName) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
 
-	// Set up the scene.
-	init();
+	if (headless) {
+		// Headless runs draw into an offscreen context instead, and always place the trees the same way
+		if (!headlessCreateContext(headlessWidth, headlessHeight)) {
+			return;
+		}
+		if (sceneSeed == 0) {
+			sceneSeed = HEADLESS_SEED;
+		}
+		if (inputFileName != NULL && !headlessLoadInput(inputFileName)) {
+			printf("Couldn't load the inputs '%s', the fixed path will be flown instead\n", inputFileName);
+		}
+	} else {
+		// Initialize the OpenGL window.
+		glutInit(&argc, argv);
+		glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH | GLUT_STENCIL);
+		glutInitWindowSize(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+		glutCreateWindow("OpenGL Drone | 19076935");
+
+		textEnabled = textInit();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// Because it's taking a little over a second or two to load,
+		// I want to display something while it loads
+		drawText("Loading...", (Vec2) {windowWidth / 2 - 45, windowHeight /2 });
+		textFlush();
+		glutSwapBuffers();
+	}
+
+	// Set up the scene. The renderer comes first, since the meshes are stored in whichever format the
+	// backend that ends up drawing them does best with
+	glprocLoad();
 	initLights(fullBright);
+	renderInit(sceneRenderer);
+	if (meshFormat == VERTEX_PACKED && renderBackend() == RENDER_GLSL) {
+		meshFormat = VERTEX_COMPACT;
+	}
+	init();
+	if (profileOverlay || profileCsvFile != NULL || profileJsonFile != NULL) {
+		profileStart(profileOverlay, profileCsvFile, profileJsonFile);
+	}
+
+	// Headless runs draw their frames straight away, without the GLUT loop, and exit once they're done.
+	// Golden image checks exit with a failure if any frame didn't match
+	if (headless) {
+		bool passed = TRUE;
+		if (goldenDirectory != NULL) {
+			passed = goldenRun(goldenDirectory, goldenUpdate, captureDirectory, goldenTolerance);
+		} else {
+			headlessRun(headlessFrames, captureDirectory, captureInterval);
+		}
+		cleanup();
+		headlessDestroyContext();
+		exit(passed ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
 
 	// Disable key repeat (keyPressed or specialKeyPressed will only be called once when a key is first pressed).
 	glutSetKeyRepeat(GLUT_KEY_REPEAT_OFF);
@@ -78,10 +278,13 @@ void main(int argc, char **argv) {
 	glutKeyboardUpFunc(keyReleased);
 	glutSpecialUpFunc(specialKeyReleased);
 	glutIdleFunc(idle);
-	glutCloseFunc(close);
+	glutCloseFunc(cleanup);
 
-	// Record when we started rendering the very first frame (which should happen after we call glutMainLoop).
-	frameStartTime = (unsigned int)glutGet(GLUT_ELAPSED_TIME);
+	// Start the frame and tick schedules from the very first frame (which should happen after we call glutMainLoop).
+	loopStartTime = platformNanoseconds();
+	pacerInit(&pacer, frameRate);
+	simulationRunning = TRUE;
+	simulationThread = threadStart(simulate, NULL);
 
 	// Enter the main drawing loop (this will never return).
 	glutMainLoop();
@@ -99,27 +302,83 @@ void main(int argc, char **argv) {
 	 etc.) should only be performed within the think() function provided below.
  */
 void display(void) {
-	// clear the screen and depth buffer
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	// load the identity matrix into the model view matrix
-	glLoadIdentity();
-
-	helicopterDisplay(&helicopter, cylinderQuadric, sphereQuadric);
-	
-	drawGround();
-	drawWater();
-	drawSky();
+	// clear the screen, depth buffer, and the stencil buffer overdraw is counted in
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+	const unsigned long long displayStartTime = platformNanoseconds();
+	profileBegin(PROFILE_DISPLAY);
+	scene = snapshotBufferLatest(&snapshots);
+	// load the camera into the model view matrix, for whatever the fixed function pipeline draws
+	const Mat4 view = helicopterCamera(&scene->helicopter);
+	glLoadMatrixf(view.m);
+	renderBeginScene(&sceneProjection, &view, helicopterFogDensity(&scene->helicopter));
+	submitScene(&passes);
+	passExecute(&passes);
+	renderEndScene();
+
+	if (passes.overdraw) {
+		drawOverdraw();
+	}
+	profileDrawOverlay();
+	textFlush();
+	profileEnd(PROFILE_DISPLAY);
+
+	profileBegin(PROFILE_SWAP);
+	if (headless) {
+		headlessSwapBuffers();
+	} else {
+		glutSwapBuffers();
+	}
+	profileEnd(PROFILE_SWAP);
+	profileFrameEnd();
 
-	treesDisplay(trees, (GLuint[3]) { treeDisplayList01, treeDisplayList02, treeDisplayList03 });
-	glutSwapBuffers();
+	const unsigned long long displayEndTime = platformNanoseconds();
+	if (scene->inputTime > lastPresentedInput) {
+		latencySamples[latencyCount++ % LATENCY_SAMPLES] = (displayEndTime - scene->inputTime) / 1e6;
+		lastPresentedInput = scene->inputTime;
+	}
+	renderBusyTime += displayEndTime - displayStartTime;
 }
 
 
-void close(void) {
+void cleanup(void) {
+	if (simulationRunning) {
+		atomicStore(&simulationRunning, FALSE);
+		threadJoin(simulationThread);
+		reportThreads();
+	}
+	profileStop();
+	reloadStop();
+	if (pacer.frames > 0) {
+		pacerReport(&pacer, stdout);
+	}
 	treeClose(&treeModel01);
 	treeClose(&treeModel02);
 	treeClose(&treeModel03);
-	freeMeshObject(pondModel);
+	vertexBufferFree(pondBuffer);
+	vertexBufferFree(groundBuffer);
+	helicopterModelFree(&helicopterModel);
+	terrainFree(terrain);
+	skyFree(sky);
+	waterFree(water);
+	renderFree();
+	textFree();
+	swarmFree(swarm);
+	snapshotBufferFree(&snapshots);
+	cullFree(treeCull);
+	poolFree(&meshLoadPool);
+	arenaFree(&frameArena);
+	jobShutdown();
+	packReport(stdout);
+	packClose();
+	allocReport(stdout);
+
+	if (recordFile != NULL) {
+		fclose(recordFile);
+	}
+	if (eventFile != NULL) {
+		fclose(eventFile);
+	}
 }
 
 /*
@@ -131,22 +390,13 @@ void close(void) {
 */
 void idle(void)
 {
-	// Wait until it's time to render the next frame.
-
-	unsigned int frameTimeElapsed = (unsigned int)glutGet(GLUT_ELAPSED_TIME) - frameStartTime;
-	if (frameTimeElapsed < FRAME_TIME)
-	{
-		// This frame took less time to render than the ideal FRAME_TIME: we'll suspend this thread for the remaining time,
-		// so we're not taking up the CPU until we need to render another frame.
-		unsigned int timeLeft = FRAME_TIME - frameTimeElapsed;
-		Sleep(timeLeft);
-	}
-
-	// Begin processing the next frame.
-
-	frameStartTime = glutGet(GLUT_ELAPSED_TIME); // Record when we started work on the new frame.
-
-	think(); // Update our simulated world before the next call to display().
+	// Wait until it's time to render the next frame. The simulation ticks on its own thread,
+	// so there's nothing else to do here.
+	pacerWait(&pacer);
+	// Scratch memory from the last frame is done with once it's been drawn
+	frameReset();
+	// Assets are only swapped between frames, so nothing drawn ever sees one half replaced
+	reloadApply();
 
 	glutPostRedisplay(); // Tell OpenGL there's a new frame ready to be drawn.
 }
@@ -160,7 +410,7 @@ void idle(void)
  */
 void init(void) {
 
-	srand(time(NULL));
+	srand(sceneSeed != 0 ? sceneSeed : (unsigned int)time(NULL));
 	
 	// enable depth testing
 	glEnable(GL_DEPTH_TEST);
@@ -168,9 +418,6 @@ void init(void) {
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_BLEND);
 
-	sphereQuadric = gluNewQuadric();
-	cylinderQuadric = gluNewQuadric();
-
 	helicopter.position = (Vec3) { -100.0f, 1.0f, 0.0f };
 	helicopter.velocity = (Vec3) { 0, 0, 0 };
 	helicopter.angle = 0.0f;
@@ -180,32 +427,100 @@ void init(void) {
 
 	waterHeight = -1;
 	waterOffset = -50;
+	waterTime = 0;
 	
-	pondModel = loadMeshObject("plane.obj");
-	treeLoad(&treeModel01, "tree01trunk.obj", "tree01leaves.obj");
-	treeLoad(&treeModel02, "tree02trunk.obj", "tree02leaves.obj");
-	treeLoad(&treeModel03, "tree03trunk.obj", "tree03leaves.obj");
+	// The meshes are read on the job scheduler while the textures load, and go into vertex buffers here
+	// as each one is ready
+	Job* meshLoading = jobCreate(NULL, NULL, NULL);
+	meshLoadAsync("plane.obj", meshFormat, &pondBuffer, meshLoading);
+	treeLoad(&treeModel01, "tree01trunk.obj", "tree01leaves.obj", meshFormat, meshLoading);
+	treeLoad(&treeModel02, "tree02trunk.obj", "tree02leaves.obj", meshFormat, meshLoading);
+	treeLoad(&treeModel03, "tree03trunk.obj", "tree03leaves.obj", meshFormat, meshLoading);
+	jobSubmit(meshLoading);
 
 	groundTexture = loadPPM("ground_color.PPM");
 	skyTexture = loadPPM("sky_color.ppm");
+	sky = skyCreate(skyTexture, "sky_color.ppm", skybox);
 	waterTexture = loadPPM("water_color.ppm");
 
+	groundBuffer = groundGenerate();
+	water = waterCreate(waterWaves);
 	generateTrees(trees);
-	treeDisplayList01 = treeGenerateDisplayList(&treeModel01);
-	treeDisplayList02 = treeGenerateDisplayList(&treeModel02);
-	treeDisplayList03 = treeGenerateDisplayList(&treeModel03);
 
+	if (terrainFileName != NULL) {
+		terrain = terrainLoad(terrainFileName);
+
+		if (terrain == NULL) {
+			printf("Couldn't load the terrain '%s', the ground will be flat instead\n", terrainFileName);
+		} else {
+			collisionTerrain = terrain;
+			for (unsigned int i = 0; i < TREES_LENGTH; ++i) {
+				trees[i].height = terrainHeight(terrain, trees[i].position.x, trees[i].position.y);
+			}
+			helicopter.position.y += helicopterFloor(helicopter.position.x, helicopter.position.z) - HELI_MIN_HEIGHT;
+		}
+	}
+
+	helicopterModel = helicopterGenerateModel();
+	jobWait(meshLoading);
+	// Display lists keep their own copy of the vertices, so the trees are only recorded into them when
+	// they're floats drawn by the fixed function backend. Anything packed is drawn from its vertex buffers,
+	// so it stays at the size it was packed to
+	if (renderBackend() == RENDER_FIXED && meshFormat == VERTEX_FLOAT) {
+		treeDisplayList01 = treeGenerateDisplayList(&treeModel01);
+		treeDisplayList02 = treeGenerateDisplayList(&treeModel02);
+		treeDisplayList03 = treeGenerateDisplayList(&treeModel03);
+	}
+	const char* formatNames[] = { "float", "packed", "compact" };
+	const size_t meshBytes = vertexBufferSize(pondBuffer) + treeModelSize(&treeModel01) + treeModelSize(&treeModel02)
+		+ treeModelSize(&treeModel03);
+	printf("The pond and tree meshes take %.1f KB as %s vertices%s\n", meshBytes / 1024.0, formatNames[meshFormat],
+		treeDisplayList01 != 0 ? ", and the trees' display lists hold another copy" : "");
+
+	treeCull = cullCreate(trees, TREES_LENGTH);
+	TreeModel* models[TREE_MODEL_COUNT] = { &treeModel01, &treeModel02, &treeModel03 };
+	for (unsigned int i = 0; i < TREE_MODEL_COUNT; ++i) {
+		Vec3 minimum, maximum;
+		treeBounds(models[i], &minimum, &maximum);
+		cullSetModelBounds(treeCull, i, minimum, maximum);
+	}
+
+	if (hotReload) {
+		reloadAddMesh("plane.obj", &pondBuffer, meshFormat, NULL, NULL);
+		for (unsigned int i = 0; i < TREE_MODEL_COUNT; ++i) {
+			reloadAddMesh(models[i]->trunkFilePath, &models[i]->trunkBuffer, meshFormat, treeModelReloaded, models[i]);
+			reloadAddMesh(models[i]->leavesFilePath, &models[i]->leavesBuffer, meshFormat, treeModelReloaded, models[i]);
+		}
+		reloadAddTexture("ground_color.PPM", &groundTexture, NULL, NULL);
+		reloadAddTexture("sky_color.ppm", &skyTexture, skyReloaded, NULL);
+		reloadAddTexture("water_color.ppm", &waterTexture, NULL, NULL);
+		reloadStart(DIR);
+	}
+
+	if (swarmSize > 0) {
+		swarm = swarmCreate(swarmSize, trees);
+
+		if (replayFileName != NULL && !swarmLoadReplay(swarm, replayFileName)) {
+			printf("Couldn't load the replay '%s', the swarm will be scripted instead\n", replayFileName);
+		}
+	}
+
+	// Publish the starting scene, so there's something to draw before the first tick
+	snapshotBufferInit(&snapshots, swarmSize);
+	publishSnapshot(0);
+	scene = snapshotBufferLatest(&snapshots);
 }
 
 /*
-	Advance our animation by FRAME_TIME milliseconds.
+	Advance our animation by one tick of FRAME_TIME_SEC seconds.
 
-	Note: Our template's GLUT idle() callback calls this once before each new
-	frame is drawn, EXCEPT the very first frame drawn after our application
-	starts. Any setup required before the first frame is drawn should be placed
+	Note: Our template's GLUT idle() callback calls this once for every tick that's
+	come due before each new frame is drawn (usually once), EXCEPT the very first
+	frame drawn after our application starts. Any setup required before the first frame is drawn should be placed
 	in init().
 */
 void think(void) {
+	profileBegin(PROFILE_THINK);
 
 	/*
 		Keyboard motion handler: complete this section to make your "player-controlled"
@@ -214,24 +529,107 @@ void think(void) {
 
 	Quat4 controlQuaternion = { 0, 0, 0, 0 };
 
-	if (getKeyboardState().Yaw != MOTION_NONE) {
-		controlQuaternion.w = getKeyboardState().Yaw;
-	}
-	if (getKeyboardState().Surge != MOTION_NONE) {
-		controlQuaternion.x = getKeyboardState().Surge;
+	// Each axis moves by how much of the tick its key was held down for, so a key pressed partway
+	// through a tick already counts for that part of it
+	if (headless) {
+		controlQuaternion = headlessControl((unsigned int)tickCount);
+	} else {
+		const InputSample input = inputSample(tickDueTime - TICK_TIME, tickDueTime);
+		controlQuaternion = (Quat4) { input.surge, input.heave, input.sway, input.yaw };
 	}
-	if (getKeyboardState().Sway != MOTION_NONE) {
-		controlQuaternion.z = getKeyboardState().Sway;
-	}
-	if (getKeyboardState().Heave != MOTION_NONE) {
-		controlQuaternion.y = getKeyboardState().Heave;
+
+	if (recordFile != NULL) {
+		fprintf(recordFile, "%g %g %g %g\n", controlQuaternion.x, controlQuaternion.y, controlQuaternion.z, controlQuaternion.w);
 	}
 
+	profileBegin(PROFILE_HELICOPTER_THINK);
 	helicopterThink(&helicopter, controlQuaternion, trees, FRAME_TIME_SEC );
+	profileEnd(PROFILE_HELICOPTER_THINK);
+	if (swarm != NULL) {
+		swarmAdvance(swarm, 1, FRAME_TIME_SEC);
+	}
+
 	const GLfloat x = FRAME_TIME_SEC * (GLfloat)frameStartTime / 10;
 	waterHeight = (sin(x) / 8) - 1;
 	waterOffset = waterOffset >= 50 ? -50 : waterOffset + 1 * FRAME_TIME_SEC;
+	waterTime += FRAME_TIME_SEC;
+
+	profileEnd(PROFILE_THINK);
+}
+
+void simulate(void* data) {
+	unsigned long long nextTickTime = loopStartTime;
+
+	while (atomicLoad(&simulationRunning)) {
+		platformSleepUntil(nextTickTime);
 
+		// Ticks that come due while the simulation is behind run back to back until it catches up, but
+		// after a long stall the missed ticks are dropped, rather than run in one burst
+		const unsigned long long start = platformNanoseconds();
+		if (start > nextTickTime + TICK_TIME * MAX_TICKS_BEHIND) {
+			nextTickTime = start;
+		}
+
+		frameStartTime = (unsigned int)((nextTickTime - loopStartTime) / 1000000); // Record when this tick started.
+		tickDueTime = nextTickTime;
+		think();
+		publishSnapshot(inputQueue.appliedTime);
+		nextTickTime += TICK_TIME;
+
+		atomicAdd64(&simulationBusyTime, platformNanoseconds() - start);
+	}
+}
+
+void publishSnapshot(unsigned long long inputTime) {
+	SceneSnapshot* snapshot = snapshotBufferWriting(&snapshots);
+
+	snapshot->tick = tickCount++;
+	snapshot->inputTime = inputTime;
+	snapshot->helicopter = helicopter;
+	if (swarm != NULL) {
+		swarmPoseCopy(swarm, snapshot->swarm);
+	}
+	snapshot->waterHeight = waterHeight;
+	snapshot->waterOffset = waterOffset;
+	snapshot->waterTime = waterTime;
+
+	snapshotBufferPublish(&snapshots);
+}
+
+void recordInputEvent(void* data, InputEvent* event) {
+	fprintf((FILE*)data, "%.3f %d %d\n", (double)(event->time - loopStartTime) / 1e6, event->key, event->pressed);
+}
+
+int compareLatencies(const void* a, const void* b) {
+	const double latencyA = *(const double*)a, latencyB = *(const double*)b;
+	return latencyA < latencyB ? -1 : latencyA > latencyB ? 1 : 0;
+}
+
+void reportThreads(void) {
+	const double elapsed = (double)(platformNanoseconds() - loopStartTime);
+	printf("Simulation thread %.1f%% busy over %llu ticks, render thread %.1f%% busy\n",
+		atomicLoad64(&simulationBusyTime) * 100 / elapsed, tickCount, renderBusyTime * 100 / elapsed);
+
+	reportLatencies("motion", inputQueue.latencies, inputQueue.latencyCount, INPUT_LATENCY_SAMPLES);
+	reportLatencies("swap", latencySamples, latencyCount, LATENCY_SAMPLES);
+	if (inputQueue.dropped > 0) {
+		printf("%d inputs were dropped with the input queue full\n", inputQueue.dropped);
+	}
+}
+
+void reportLatencies(char* name, double* samples, unsigned int sampleCount, unsigned int capacity) {
+	if (sampleCount == 0) {
+		return;
+	}
+
+	const unsigned int count = sampleCount < capacity ? sampleCount : capacity;
+	double total = 0;
+	for (unsigned int i = 0; i < count; ++i) {
+		total += samples[i];
+	}
+	qsort(samples, count, sizeof(double), compareLatencies);
+	printf("Input to %s latency over the last %u inputs: %.2f ms average, %.2f ms 99th percentile\n",
+		name, count, total / count, samples[(count * 99 + 99) / 100 - 1]);
 }
 
 /*
@@ -289,116 +687,175 @@ void initLights(bool fullBright) {
 }
 
 void drawWater(void) {
-	glMaterialfv(GL_FRONT, GL_AMBIENT, (GLfloat[4]) { 0, 0, 0, 0 });
-	glMaterialfv(GL_FRONT, GL_DIFFUSE, (GLfloat[4]) { 0.2, 0.4, 1, 0.8 });
-	glMaterialfv(GL_FRONT, GL_SPECULAR, (GLfloat[4]) { 1, 1, 1, 1 });
-	glMaterialf(GL_FRONT, GL_SHININESS, 80);
+	renderEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, waterTexture);
 
-	const GLfloat spacing = 5;
+	waterAnimate(water, scene->waterTime);
 
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, waterTexture);
+	const Mat4 rotation = mat4Rotation(30, (Vec3) { 0, 1, 0 });
+	waterDraw(water, &rotation, scene->waterOffset, scene->waterHeight, &waterMaterial);
 
-	glPushMatrix();
-	glRotatef(30, 0, 1, 0);
-	glTranslatef(waterOffset, 0, 0);
-	glBegin(GL_QUADS);
-	for (GLfloat x = -100; x <= 100; x += spacing) {
-		for (GLfloat z = -100; z <= 100; z += spacing) {
+	renderDisable(GL_TEXTURE_2D);
+}
 
-			glVertex3d(x, waterHeight, z);
-			glNormal3d(0, 1, 0);
-			glTexCoord2f(0, 0);
+/****************************************************************************/
+void drawGround(void) {
+	renderEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, groundTexture);
 
+	// The terrain has its own basin for the pond, so it replaces both the ground and the pond mesh
+	if (terrain != NULL) {
+		terrainSelect(terrain, helicopterCameraPosition(&scene->helicopter), TERRAIN_TRIANGLE_BUDGET);
+		terrainDraw(terrain, &groundMaterial);
+		renderDisable(GL_TEXTURE_2D);
+		return;
+	}
 
-			glVertex3d(x + spacing, waterHeight, z);
-			glNormal3d(0, 1, 0);
-			glTexCoord2f(1, 0);
+	renderDrawBuffer(pondBuffer, NULL, &groundMaterial);
 
+	renderDrawBuffer(groundBuffer, NULL, &groundMaterial);
+	renderDisable(GL_TEXTURE_2D);
+}
 
-			glVertex3d(x + spacing, waterHeight, z + spacing);
-			glNormal3d(0, 1, 0);
-			glTexCoord2f(1, 1);
+void drawSky(void) {
+	skyDraw(sky, helicopterCameraPosition(&scene->helicopter));
+}
 
+void submitScene(PassScheduler* passes) {
+	const Vec3 camera = helicopterCameraPosition(&scene->helicopter);
+	passBegin(passes);
 
-			glVertex3d(x, waterHeight, z + spacing);
-			glNormal3d(0, 1, 0);
-			glTexCoord2f(0, 1);
+	// Opaque things are nearest first, so whatever is hidden behind them fails the depth test early
+	passSubmit(passes, PASS_OPAQUE, sceneDistance(camera, scene->helicopter.position), drawHelicopterItem, NULL, 0);
 
+	if (scene->swarm != NULL && scene->swarm->count > 0) {
+		// The drones are drawn together, as one instanced draw of each part, from the nearest drone's distance
+		GLfloat nearest = FLT_MAX;
+		const SwarmPose* pose = scene->swarm;
+		for (unsigned int i = 0; i < pose->count; ++i) {
+			nearest = fmin(nearest, sceneDistance(camera, (Vec3) { pose->positionX[i], pose->positionY[i], pose->positionZ[i] }));
 		}
+		passSubmit(passes, PASS_OPAQUE, nearest, drawSwarmItem, NULL, 0);
 	}
-	glEnd();
-	glPopMatrix();
 
-	glDisable(GL_TEXTURE_2D);
-}
+	// The trees are culled on the worker threads, leaving only the visible ones to submit here
+	profileBegin(PROFILE_CULL);
+	Frustum frustum = cullFrustumCurrent();
+	cullTrees(treeCull, &frustum, camera);
+	profileEnd(PROFILE_CULL);
+	for (unsigned int model = 0; model < TREE_MODEL_COUNT; ++model) {
+		for (unsigned int i = 0; i < treeCull->instanceCounts[model]; ++i) {
+			passSubmit(passes, PASS_OPAQUE, treeCull->instanceDistances[model][i], drawTreeItem, trees, treeCull->instances[model][i]);
+		}
+	}
 
-/****************************************************************************/
-void drawGround(void) {
-	glMaterialfv(GL_FRONT, GL_AMBIENT, (GLfloat[4]) { 0, 0, 0, 0 });
-	glMaterialfv(GL_FRONT, GL_DIFFUSE, (GLfloat[4]) { 1, 1, 1, 1 });
-	glMaterialfv(GL_FRONT, GL_SPECULAR, (GLfloat[4]) { 1, 1, 1, 1 });
-	glMaterialf(GL_FRONT, GL_SHININESS, 5);
+	if (terrain != NULL) {
+		// Each chunk is sorted on its own, so near hills hide the trees and chunks behind them
+		terrainSelect(terrain, camera, TERRAIN_TRIANGLE_BUDGET);
+		for (unsigned int i = 0; i < terrain->chunksPerSide * terrain->chunksPerSide; ++i) {
+			passSubmit(passes, PASS_OPAQUE, terrain->chunks[i].distance, drawTerrainChunkItem, terrain, i);
+		}
+	} else {
+		// The flat ground is under everything else, so it can't hide any of it and goes after the trees
+		passSubmit(passes, PASS_OPAQUE, FLT_MAX, drawGroundItem, NULL, 0);
+	}
 
-	const GLfloat spacing = 5;
+	// The sky sits at the far plane, so drawn after everything opaque it only fills in the pixels left
+	// uncovered. The water is blended, so it goes after the sky it can be seen against
+	passSubmit(passes, PASS_SKY, FLT_MAX, drawSkyItem, NULL, 0);
+	passSubmit(passes, PASS_TRANSLUCENT, sceneDistance(camera, (Vec3) { 0, scene->waterHeight, 0 }), drawWaterItem, NULL, 0);
+}
 
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, groundTexture);
+GLfloat sceneDistance(Vec3 camera, Vec3 position) {
+	const GLfloat dx = position.x - camera.x, dy = position.y - camera.y, dz = position.z - camera.z;
+	return sqrt(dx * dx + dy * dy + dz * dz);
+}
 
-	glPushMatrix();
-	renderMeshObject(pondModel);
-	glPopMatrix();
+void drawHelicopterItem(void* data, unsigned int index) {
+	profileBegin(PROFILE_HELICOPTER);
+	helicopterDisplay(&scene->helicopter, &helicopterModel);
+	profileEnd(PROFILE_HELICOPTER);
+}
 
-	glPushMatrix();
-	glBegin(GL_QUADS);
-	for (GLfloat x = -250; x <= 250; x += spacing) {
-		for (GLfloat z = -250; z <= 250; z += spacing) {
-			if (x < 40 && x > -40 && z < 40 && z > -40) {
-				continue;
-			}
+void drawSwarmItem(void* data, unsigned int index) {
+	profileBegin(PROFILE_HELICOPTER);
+	swarmDisplay(scene->swarm, &helicopterModel);
+	profileEnd(PROFILE_HELICOPTER);
+}
 
-			glVertex3d(x, 0, z);
-			glNormal3d(0, 1, 0);
-			glTexCoord2f(0, 0);
+void drawTreeItem(void* data, unsigned int index) {
+	profileBegin(PROFILE_TREES);
+	if (treeDisplayList01 != 0) {
+		treeDisplay(&((TreeObject*)data)[index], (GLuint[3]) { treeDisplayList01, treeDisplayList02, treeDisplayList03 });
+	} else {
+		treeDraw(&((TreeObject*)data)[index], (TreeModel*[3]) { &treeModel01, &treeModel02, &treeModel03 });
+	}
+	profileEnd(PROFILE_TREES);
+}
 
+void drawGroundItem(void* data, unsigned int index) {
+	profileBegin(PROFILE_GROUND);
+	drawGround();
+	profileEnd(PROFILE_GROUND);
+}
 
-			glVertex3d(x + spacing, 0, z);
-			glNormal3d(0, 1, 0);
-			glTexCoord2f(1, 0);
+void drawTerrainChunkItem(void* data, unsigned int index) {
+	profileBegin(PROFILE_GROUND);
+	renderEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, groundTexture);
+	terrainDrawChunk((Terrain*)data, index, &groundMaterial);
+	renderDisable(GL_TEXTURE_2D);
+	profileEnd(PROFILE_GROUND);
+}
 
+void drawSkyItem(void* data, unsigned int index) {
+	profileBegin(PROFILE_SKY);
+	drawSky();
+	profileEnd(PROFILE_SKY);
+}
 
-			glVertex3d(x + spacing, 0, z + spacing);
-			glNormal3d(0, 1, 0);
-			glTexCoord2f(1, 1);
+void drawWaterItem(void* data, unsigned int index) {
+	profileBegin(PROFILE_WATER);
+	drawWater();
+	profileEnd(PROFILE_WATER);
+}
 
+void drawOverdraw(void) {
+	unsigned int histogram[PASS_OVERDRAW_LEVELS + 1];
+	const GLfloat average = passReadOverdraw(histogram);
+	char text[64];
 
-			glVertex3d(x, 0, z + spacing);
-			glNormal3d(0, 1, 0);
-			glTexCoord2f(0, 1);
-		}
-	}
+	passDrawOverdraw();
 
-	glEnd();
-	glPopMatrix();
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+	glDisable(GL_LIGHTING);
 	glDisable(GL_TEXTURE_2D);
+	glColor3f(1, 1, 1);
+	snprintf(text, sizeof(text), "Overdraw: %.2f fragments per pixel", average);
+	drawText(text, (Vec2) { 20, windowHeight - 30 });
+	glPopAttrib();
 }
 
-void drawSky(void) {
-	glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, skyTexture);
+void treeModelReloaded(void* data, ReloadAsset* asset) {
+	TreeModel* models[TREE_MODEL_COUNT] = { &treeModel01, &treeModel02, &treeModel03 };
+	GLuint* displayLists[TREE_MODEL_COUNT] = { &treeDisplayList01, &treeDisplayList02, &treeDisplayList03 };
 
-	glMaterialfv(GL_BACK, GL_EMISSION, (GLfloat[4]) { 1, 1, 1, 1 });
-	glMaterialfv(GL_BACK, GL_DIFFUSE, (GLfloat[4]) { 1, 1, 1, 1 });
-	glMaterialfv(GL_BACK, GL_SPECULAR, (GLfloat[4]) { 1, 1, 1, 1 });
-	gluQuadricTexture(sphereQuadric, TRUE);
+	for (unsigned int i = 0; i < TREE_MODEL_COUNT; ++i) {
+		if (models[i] == data) {
+			// The display list holds its own copy of the vertices, so it's rebuilt from the new buffer
+			if (*displayLists[i] != 0) {
+				glDeleteLists(*displayLists[i], 1);
+				*displayLists[i] = treeGenerateDisplayList(models[i]);
+			}
 
-	glPushMatrix();
-	glRotatef(90, -1, 0, 0);
-	gluSphere(sphereQuadric, 250, 20, 20);
-	glPopMatrix();
+			Vec3 minimum, maximum;
+			treeBounds(models[i], &minimum, &maximum);
+			cullSetModelBounds(treeCull, i, minimum, maximum);
+		}
+	}
+}
 
-	gluQuadricTexture(sphereQuadric, FALSE);
-	glDisable(GL_TEXTURE_2D);
-	glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_FALSE);
+void skyReloaded(void* data, ReloadAsset* asset) {
+	// The skybox faces are resampled from the pixels that were just parsed, rather than reading the file again
+	skySetTexture(sky, skyTexture, asset->pixels, asset->width, asset->height);
 }
@@ -1,13 +1,37 @@
-#include <Windows.h>
+#include "platform.h"
 #include <freeglut.h>
 #include <math.h>
 #include <stdio.h>
+#include <float.h>
 
 #include "helicopter.h"
 #include "tree.h"
 #include "vecmath.h"
 #include "loader.h"
 #include "misc.h"
+#include "bench.h"
+#include "swarm.h"
+#include "cull.h"
+#include "angle.h"
+#include "glproc.h"
+#include "buffer.h"
+#include "mesh.h"
+#include "ground.h"
+#include "water.h"
+#include "terrain.h"
+#include "sky.h"
+#include "pass.h"
+#include "profile.h"
+#include "pacer.h"
+#include "snapshot.h"
+#include "atomic.h"
+#include "headless.h"
+#include "golden.h"
+#include "render.h"
+#include "text.h"
+#include "input.h"
+#include "alloc.h"
+#include "reload.h"
 
 /*
  * <main.c/main.h> Entrypoint of the program, handles window rendering, global state, 
@@ -18,8 +42,12 @@
  * Animation & Timing Setup
  ******************************************************************************/
 
- // Target frame rate (number of Frames Per Second).
-#define TARGET_FPS 60	
+ // Simulation rate (number of ticks per second), and the frame rate unless --fps sets another.
+#define TARGET_FPS 60
+// Most simulation ticks run back to back to catch up, when the simulation falls behind.
+#define MAX_TICKS_BEHIND 4
+// Number of the most recent inputs the input latency is reported over.
+#define LATENCY_SAMPLES 1024
 
 /******************************************************************************
  * GLUT Callback Prototypes
@@ -28,7 +56,7 @@
 void display(void);
 void reshape(int width, int height);
 void idle(void);
-void close(void);
+void cleanup(void);
 
 /******************************************************************************
  * Animation-Specific Function Prototypes (add your own here)
@@ -37,7 +65,36 @@ void close(void);
 void main(int argc, char** argv);
 void init(void);
 void think(void);
+// Runs the simulation on its own thread, ticking at TARGET_FPS until simulationRunning is cleared
+void simulate(void* data);
+// Copies the simulated scene into a snapshot and publishes it for display() to draw, along with
+// the time of the newest input the simulation had seen
+void publishSnapshot(unsigned long long inputTime);
+// Prints how busy the simulation and render threads have been, and the latency from inputs to the frames showing them
+void reportThreads(void);
+// Prints the average and 99th percentile of the latest latency samples, from inputs to a stage of handling them
+void reportLatencies(char* name, double* samples, unsigned int sampleCount, unsigned int capacity);
+// Writes an input event to a file as it's applied, as milliseconds since the main loop started, the key and
+// whether it was pressed
+void recordInputEvent(void* data, InputEvent* event);
 void initLights(bool fullBright);
 void drawWater(void);
 void drawGround(void);
-void drawSky(void);
\ No newline at end of file
+void drawSky(void);
+// Submits everything in the scene to be drawn this frame, after the camera has been set up
+void submitScene(PassScheduler* passes);
+// Returns the distance from the camera to a point, which draws are sorted by
+GLfloat sceneDistance(Vec3 camera, Vec3 position);
+// Draw functions for the pass scheduler, each drawing one thing in the scene
+void drawHelicopterItem(void* data, unsigned int index);
+void drawSwarmItem(void* data, unsigned int index);
+void drawTreeItem(void* data, unsigned int index);
+void drawGroundItem(void* data, unsigned int index);
+void drawTerrainChunkItem(void* data, unsigned int index);
+void drawSkyItem(void* data, unsigned int index);
+void drawWaterItem(void* data, unsigned int index);
+// Shows the overdraw heatmap and the average number of fragments per pixel over the frame
+void drawOverdraw(void);
+// Reload callbacks, rebuilding what the scene made from a tree model's meshes, or from the sky's texture
+void treeModelReloaded(void* data, ReloadAsset* asset);
+void skyReloaded(void* data, ReloadAsset* asset);
@@ -0,0 +1,671 @@
+#include "mesh.h"
+
+// Marks a vertex or hash slot that hasn't been assigned yet
+#define MESH_NONE 0xFFFFFFFFu
+
+typedef struct MESHCLUSTER {
+	unsigned int first, end;	// Range of triangles in the cluster
+	double potential;			// How much of the mesh the cluster could hide, higher drawing first
+} MeshCluster;
+
+// Hashes the indices of an OBJ face point, for sharing vertices between faces
+unsigned int meshHashPoint(MeshObjectFacePoint* point) {
+	return (unsigned int)point->vertexIndex * 73856093u ^ (unsigned int)point->texCoordIndex * 19349663u
+		^ (unsigned int)point->normalIndex * 83492791u;
+}
+
+Mesh* meshCreate(MeshObject* object) {
+	Mesh* mesh = allocCalloc(ALLOC_MESH, 1, sizeof(Mesh));
+	unsigned int pointCount = 0, triangleCount = 0;
+
+	for (int i = 0; i < object->faceCount; ++i) {
+		if (object->faces[i].pointCount >= 3) {
+			pointCount += object->faces[i].pointCount;
+			triangleCount += object->faces[i].pointCount - 2;
+		}
+	}
+
+	// Open addressing table of the face points already made into vertices, at most half full
+	unsigned int slotCount = 1;
+	while (slotCount < pointCount * 2) {
+		slotCount *= 2;
+	}
+	unsigned int* slots = allocMalloc(ALLOC_MESH, slotCount * sizeof(unsigned int));
+	MeshObjectFacePoint* slotPoints = allocMalloc(ALLOC_MESH, slotCount * sizeof(MeshObjectFacePoint));
+	memset(slots, 0xFF, slotCount * sizeof(unsigned int));
+
+	mesh->vertices = allocMalloc(ALLOC_MESH, pointCount * sizeof(Vertex));
+	mesh->indices = allocMalloc(ALLOC_MESH, triangleCount * 3 * sizeof(GLuint));
+	GLuint* faceIndices = allocMalloc(ALLOC_MESH, (pointCount > 0 ? pointCount : 1) * sizeof(GLuint));
+
+	for (int i = 0; i < object->faceCount; ++i) {
+		MeshObjectFace* face = &object->faces[i];
+		if (face->pointCount < 3) {
+			continue;
+		}
+
+		for (int j = 0; j < face->pointCount; ++j) {
+			MeshObjectFacePoint* point = &face->points[j];
+			unsigned int slot = meshHashPoint(point) & (slotCount - 1);
+
+			while (slots[slot] != MESH_NONE && (slotPoints[slot].vertexIndex != point->vertexIndex
+				|| slotPoints[slot].texCoordIndex != point->texCoordIndex || slotPoints[slot].normalIndex != point->normalIndex)) {
+				slot = (slot + 1) & (slotCount - 1);
+			}
+
+			if (slots[slot] == MESH_NONE) {
+				Vertex* vertex = &mesh->vertices[mesh->vertexCount];
+				const Vec3 position = object->vertices[point->vertexIndex];
+				const Vec3 normal = point->normalIndex >= 0 ? object->normals[point->normalIndex] : (Vec3) { 0, 1, 0 };
+				const Vec2 texCoord = point->texCoordIndex >= 0 ? object->texCoords[point->texCoordIndex] : (Vec2) { 0, 0 };
+
+				*vertex = (Vertex) { { position.x, position.y, position.z }, { normal.x, normal.y, normal.z }, { texCoord.x, texCoord.y } };
+				slots[slot] = mesh->vertexCount++;
+				slotPoints[slot] = *point;
+			}
+			faceIndices[j] = slots[slot];
+		}
+
+		// The faces are convex, so a fan covers each one the way GL_POLYGON would
+		for (int j = 1; j + 1 < face->pointCount; ++j) {
+			mesh->indices[mesh->indexCount++] = faceIndices[0];
+			mesh->indices[mesh->indexCount++] = faceIndices[j];
+			mesh->indices[mesh->indexCount++] = faceIndices[j + 1];
+		}
+	}
+
+	allocFree(faceIndices);
+	allocFree(slotPoints);
+	allocFree(slots);
+	return mesh;
+}
+
+// Pops vertices off the dead end stack until one with triangles left is found, or failing that, walks
+// the cursor on through the vertices. Returns MESH_NONE once every triangle has been drawn. Sets
+// *restarted if the vertex came from the cursor, as the cache holds nothing useful for it
+unsigned int meshSkipDeadEnd(unsigned int* liveCounts, unsigned int* deadEnds, unsigned int* deadEndCount,
+	unsigned int* cursor, unsigned int vertexCount, bool* restarted) {
+	while (*deadEndCount > 0) {
+		const unsigned int vertex = deadEnds[--*deadEndCount];
+		if (liveCounts[vertex] > 0) {
+			return vertex;
+		}
+	}
+
+	*restarted = TRUE;
+	for (; *cursor < vertexCount; ++*cursor) {
+		if (liveCounts[*cursor] > 0) {
+			return *cursor;
+		}
+	}
+	return MESH_NONE;
+}
+
+void meshOptimizeVertexCache(Mesh* mesh, unsigned int cacheSize) {
+	const unsigned int triangleCount = mesh->indexCount / 3, vertexCount = mesh->vertexCount;
+	unsigned int* liveCounts = allocCalloc(ALLOC_MESH, vertexCount + 1, sizeof(unsigned int));
+	unsigned int* adjacencyStarts = allocCalloc(ALLOC_MESH, vertexCount + 1, sizeof(unsigned int));
+	unsigned int* adjacency = allocMalloc(ALLOC_MESH, (mesh->indexCount + 1) * sizeof(unsigned int));
+	unsigned int* cacheTimes = allocCalloc(ALLOC_MESH, vertexCount + 1, sizeof(unsigned int));
+	unsigned int* deadEnds = allocMalloc(ALLOC_MESH, (mesh->indexCount + 1) * sizeof(unsigned int));
+	unsigned int* candidates = allocMalloc(ALLOC_MESH, (mesh->indexCount + 1) * sizeof(unsigned int));
+	bool* emitted = allocCalloc(ALLOC_MESH, triangleCount + 1, sizeof(bool));
+	GLuint* output = allocMalloc(ALLOC_MESH, (mesh->indexCount + 1) * sizeof(GLuint));
+	unsigned int deadEndCount = 0, outputCount = 0, cursor = 0;
+
+	allocFree(mesh->clusters);
+	mesh->clusters = allocMalloc(ALLOC_MESH, (triangleCount + 1) * sizeof(unsigned int));
+	mesh->clusterCount = 0;
+
+	// The triangles using each vertex, and how many of them are still to be drawn
+	for (unsigned int i = 0; i < mesh->indexCount; ++i) {
+		++liveCounts[mesh->indices[i]];
+	}
+	for (unsigned int i = 0; i < vertexCount; ++i) {
+		adjacencyStarts[i + 1] = adjacencyStarts[i] + liveCounts[i];
+		cacheTimes[i] = adjacencyStarts[i];
+	}
+	for (unsigned int i = 0; i < mesh->indexCount; ++i) {
+		adjacency[cacheTimes[mesh->indices[i]]++] = i / 3;
+	}
+	memset(cacheTimes, 0, vertexCount * sizeof(unsigned int));
+
+	// A vertex is in the cache if fewer than cacheSize vertices have gone in since it did
+	unsigned int time = cacheSize + 1;
+	unsigned int fan = vertexCount > 0 ? 0 : MESH_NONE;
+	bool restarted = TRUE;
+
+	while (fan != MESH_NONE) {
+		unsigned int candidateCount = 0;
+
+		if (restarted) {
+			mesh->clusters[mesh->clusterCount++] = outputCount / 3;
+			restarted = FALSE;
+		}
+
+		// Draw every remaining triangle around the fan vertex
+		for (unsigned int i = adjacencyStarts[fan]; i < adjacencyStarts[fan + 1]; ++i) {
+			const unsigned int triangle = adjacency[i];
+			if (emitted[triangle]) {
+				continue;
+			}
+
+			for (unsigned int corner = 0; corner < 3; ++corner) {
+				const unsigned int vertex = mesh->indices[triangle * 3 + corner];
+				deadEnds[deadEndCount++] = vertex;
+				candidates[candidateCount++] = vertex;
+				--liveCounts[vertex];
+				if (time - cacheTimes[vertex] > cacheSize) {
+					cacheTimes[vertex] = time++;
+				}
+				output[outputCount++] = vertex;
+			}
+			emitted[triangle] = TRUE;
+		}
+
+		// Fan around the vertex that's been in the cache longest and will still be in it once its
+		// remaining triangles are drawn, so it's used before it drops out
+		unsigned int best = 0;
+		fan = MESH_NONE;
+		for (unsigned int i = 0; i < candidateCount; ++i) {
+			const unsigned int vertex = candidates[i];
+			if (liveCounts[vertex] > 0 && time - cacheTimes[vertex] + 2 * liveCounts[vertex] <= cacheSize
+				&& time - cacheTimes[vertex] > best) {
+				best = time - cacheTimes[vertex];
+				fan = vertex;
+			}
+		}
+
+		if (fan == MESH_NONE) {
+			fan = meshSkipDeadEnd(liveCounts, deadEnds, &deadEndCount, &cursor, vertexCount, &restarted);
+		}
+	}
+
+	allocFree(mesh->indices);
+	mesh->indices = output;
+
+	allocFree(emitted);
+	allocFree(candidates);
+	allocFree(deadEnds);
+	allocFree(cacheTimes);
+	allocFree(adjacency);
+	allocFree(adjacencyStarts);
+	allocFree(liveCounts);
+}
+
+// Adds a triangle's area weighted normal, and its centroid weighted by its area, to running totals
+void meshAccumulateTriangle(Mesh* mesh, unsigned int triangle, double centroid[3], double normal[3], double* area) {
+	const GLfloat* a = mesh->vertices[mesh->indices[triangle * 3]].position;
+	const GLfloat* b = mesh->vertices[mesh->indices[triangle * 3 + 1]].position;
+	const GLfloat* c = mesh->vertices[mesh->indices[triangle * 3 + 2]].position;
+	const double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+	const double cross[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+	const double triangleArea = sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]) / 2;
+
+	for (unsigned int axis = 0; axis < 3; ++axis) {
+		centroid[axis] += (a[axis] + b[axis] + c[axis]) / 3.0 * triangleArea;
+		normal[axis] += cross[axis] / 2;
+	}
+	*area += triangleArea;
+}
+
+int meshCompareClusters(const void* a, const void* b) {
+	const MeshCluster* clusterA = a, * clusterB = b;
+	if (clusterA->potential != clusterB->potential) {
+		return clusterA->potential > clusterB->potential ? -1 : 1;
+	}
+	// Ties keep the vertex cache order, since qsort isn't stable
+	return clusterA->first < clusterB->first ? -1 : 1;
+}
+
+void meshOptimizeOverdraw(Mesh* mesh, unsigned int cacheSize, double threshold) {
+	const unsigned int triangleCount = mesh->indexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	const double limit = meshCacheStats(mesh, cacheSize).acmr * threshold;
+	MeshCluster* clusters = allocMalloc(ALLOC_MESH, triangleCount * sizeof(MeshCluster));
+	unsigned int* cacheTimes = allocCalloc(ALLOC_MESH, mesh->vertexCount, sizeof(unsigned int));
+	unsigned int clusterCount = 0, time = cacheSize + 1;
+
+	// Split the clusters wherever the ACMR of the part so far, starting from an empty cache, has come down
+	// to the limit, since from there on it can be drawn in any order without costing much more
+	for (unsigned int i = 0; i < (mesh->clusterCount > 0 ? mesh->clusterCount : 1); ++i) {
+		const unsigned int first = mesh->clusterCount > 0 ? mesh->clusters[i] : 0;
+		const unsigned int end = i + 1 < mesh->clusterCount ? mesh->clusters[i + 1] : triangleCount;
+		unsigned int start = first, misses = 0;
+
+		time += cacheSize;
+		for (unsigned int triangle = first; triangle < end; ++triangle) {
+			for (unsigned int corner = 0; corner < 3; ++corner) {
+				const unsigned int vertex = mesh->indices[triangle * 3 + corner];
+				if (time - cacheTimes[vertex] > cacheSize) {
+					cacheTimes[vertex] = time++;
+					++misses;
+				}
+			}
+
+			if (triangle + 1 == end || misses <= limit * (triangle + 1 - start)) {
+				clusters[clusterCount++] = (MeshCluster) { start, triangle + 1, 0 };
+				start = triangle + 1;
+				misses = 0;
+				time += cacheSize;
+			}
+		}
+	}
+
+	// Clusters facing away from the middle of the mesh are the likeliest to hide others
+	double meshCentroid[3] = { 0, 0, 0 }, meshNormal[3] = { 0, 0, 0 }, meshArea = 0;
+	for (unsigned int triangle = 0; triangle < triangleCount; ++triangle) {
+		meshAccumulateTriangle(mesh, triangle, meshCentroid, meshNormal, &meshArea);
+	}
+	for (unsigned int axis = 0; axis < 3; ++axis) {
+		meshCentroid[axis] /= meshArea > 0 ? meshArea : 1;
+	}
+
+	for (unsigned int i = 0; i < clusterCount; ++i) {
+		double centroid[3] = { 0, 0, 0 }, normal[3] = { 0, 0, 0 }, area = 0;
+		for (unsigned int triangle = clusters[i].first; triangle < clusters[i].end; ++triangle) {
+			meshAccumulateTriangle(mesh, triangle, centroid, normal, &area);
+		}
+
+		const double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (area > 0 && length > 0) {
+			for (unsigned int axis = 0; axis < 3; ++axis) {
+				clusters[i].potential += (centroid[axis] / area - meshCentroid[axis]) * normal[axis] / length;
+			}
+		}
+	}
+
+	qsort(clusters, clusterCount, sizeof(MeshCluster), meshCompareClusters);
+
+	GLuint* output = allocMalloc(ALLOC_MESH, mesh->indexCount * sizeof(GLuint));
+	unsigned int outputCount = 0;
+	mesh->clusters = allocRealloc(ALLOC_MESH, mesh->clusters, clusterCount * sizeof(unsigned int));
+	for (unsigned int i = 0; i < clusterCount; ++i) {
+		const unsigned int length = (clusters[i].end - clusters[i].first) * 3;
+		mesh->clusters[i] = outputCount / 3;
+		memcpy(output + outputCount, mesh->indices + clusters[i].first * 3, length * sizeof(GLuint));
+		outputCount += length;
+	}
+	mesh->clusterCount = clusterCount;
+
+	allocFree(mesh->indices);
+	mesh->indices = output;
+	allocFree(cacheTimes);
+	allocFree(clusters);
+}
+
+void meshOptimizeVertexFetch(Mesh* mesh) {
+	unsigned int* remap = allocMalloc(ALLOC_MESH, (mesh->vertexCount + 1) * sizeof(unsigned int));
+	Vertex* vertices = allocMalloc(ALLOC_MESH, (mesh->vertexCount + 1) * sizeof(Vertex));
+	unsigned int vertexCount = 0;
+
+	memset(remap, 0xFF, mesh->vertexCount * sizeof(unsigned int));
+	for (unsigned int i = 0; i < mesh->indexCount; ++i) {
+		const GLuint index = mesh->indices[i];
+		if (remap[index] == MESH_NONE) {
+			vertices[vertexCount] = mesh->vertices[index];
+			remap[index] = vertexCount++;
+		}
+		mesh->indices[i] = remap[index];
+	}
+
+	allocFree(mesh->vertices);
+	mesh->vertices = vertices;
+	mesh->vertexCount = vertexCount;
+	allocFree(remap);
+}
+
+void meshOptimize(Mesh* mesh) {
+	meshOptimizeVertexCache(mesh, MESH_CACHE_SIZE);
+	meshOptimizeOverdraw(mesh, MESH_CACHE_SIZE, MESH_OVERDRAW_THRESHOLD);
+	meshOptimizeVertexFetch(mesh);
+}
+
+MeshCacheStats meshCacheStats(Mesh* mesh, unsigned int cacheSize) {
+	MeshCacheStats stats = { 0, 0 };
+	unsigned int* cacheTimes = allocCalloc(ALLOC_MESH, mesh->vertexCount + 1, sizeof(unsigned int));
+	unsigned int time = cacheSize + 1, misses = 0, usedCount = 0;
+
+	for (unsigned int i = 0; i < mesh->indexCount; ++i) {
+		const GLuint vertex = mesh->indices[i];
+		if (cacheTimes[vertex] == 0) {
+			++usedCount;
+		}
+		if (time - cacheTimes[vertex] > cacheSize) {
+			cacheTimes[vertex] = time++;
+			++misses;
+		}
+	}
+
+	if (mesh->indexCount > 0) {
+		stats.acmr = misses / (mesh->indexCount / 3.0);
+		stats.atvr = (double)misses / usedCount;
+	}
+	allocFree(cacheTimes);
+	return stats;
+}
+
+double meshOverdraw(Mesh* mesh, unsigned int resolution) {
+	float* depths = allocMalloc(ALLOC_MESH, (size_t)resolution * resolution * sizeof(float));
+	GLfloat minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	double total = 0;
+	unsigned int viewCount = 0;
+
+	for (unsigned int i = 0; i < mesh->vertexCount; ++i) {
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			const GLfloat value = mesh->vertices[i].position[axis];
+			minimum[axis] = value < minimum[axis] ? value : minimum[axis];
+			maximum[axis] = value > maximum[axis] ? value : maximum[axis];
+		}
+	}
+
+	for (unsigned int view = 0; view < 6; ++view) {
+		// Looks down one axis, from the positive or negative side, with the other two across the buffer
+		const unsigned int axis = view / 2, across = (axis + 1) % 3, up = (axis + 2) % 3;
+		const float direction = view % 2 == 0 ? 1.0f : -1.0f;
+		const float acrossExtent = maximum[across] - minimum[across], upExtent = maximum[up] - minimum[up];
+		unsigned long long shaded = 0, covered = 0;
+
+		if (acrossExtent <= 0 || upExtent <= 0) {
+			continue;
+		}
+		const float acrossScale = resolution / acrossExtent, upScale = resolution / upExtent;
+
+		for (unsigned int i = 0; i < resolution * resolution; ++i) {
+			depths[i] = FLT_MAX;
+		}
+
+		for (unsigned int triangle = 0; triangle < mesh->indexCount / 3; ++triangle) {
+			float x[3], y[3], z[3];
+			for (unsigned int corner = 0; corner < 3; ++corner) {
+				const GLfloat* position = mesh->vertices[mesh->indices[triangle * 3 + corner]].position;
+				x[corner] = (position[across] - minimum[across]) * acrossScale;
+				y[corner] = (position[up] - minimum[up]) * upScale;
+				z[corner] = position[axis] * direction;
+			}
+
+			const float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+			if (fabsf(area) < 1e-6f) {
+				continue;
+			}
+
+			const int left = (int)fmaxf(floorf(fminf(x[0], fminf(x[1], x[2]))), 0);
+			const int right = (int)fminf(ceilf(fmaxf(x[0], fmaxf(x[1], x[2]))), resolution - 1.0f);
+			const int bottom = (int)fmaxf(floorf(fminf(y[0], fminf(y[1], y[2]))), 0);
+			const int top = (int)fminf(ceilf(fmaxf(y[0], fmaxf(y[1], y[2]))), resolution - 1.0f);
+
+			for (int row = bottom; row <= top; ++row) {
+				for (int column = left; column <= right; ++column) {
+					// Barycentric weights of the pixel centre, all positive inside either winding
+					const float px = column + 0.5f, py = row + 0.5f;
+					const float w0 = ((x[2] - x[1]) * (py - y[1]) - (y[2] - y[1]) * (px - x[1])) / area;
+					const float w1 = ((x[0] - x[2]) * (py - y[2]) - (y[0] - y[2]) * (px - x[2])) / area;
+					const float w2 = 1 - w0 - w1;
+					if (w0 < 0 || w1 < 0 || w2 < 0) {
+						continue;
+					}
+
+					const float depth = w0 * z[0] + w1 * z[1] + w2 * z[2];
+					float* stored = &depths[row * resolution + column];
+					if (depth < *stored) {
+						covered += *stored == FLT_MAX;
+						*stored = depth;
+						++shaded;
+					}
+				}
+			}
+		}
+
+		if (covered > 0) {
+			total += (double)shaded / covered;
+			++viewCount;
+		}
+	}
+
+	allocFree(depths);
+	return viewCount > 0 ? total / viewCount : 0;
+}
+
+// Rounds a value already scaled into the range of a short, clamping it to keep -32768 unused so the
+// range is symmetric
+GLshort meshQuantizeShort(double value) {
+	const double rounded = floor(value + 0.5);
+	return (GLshort)(rounded > 32767 ? 32767 : rounded < -32767 ? -32767 : rounded);
+}
+
+// Returns the half float nearest a value, rounding halfway cases up. Values too large for a half become
+// infinity, and ones too small for even a denormal become zero
+GLushort meshHalf(float value) {
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const GLushort sign = (GLushort)((bits >> 16) & 0x8000);
+	const int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+	unsigned int mantissa = bits & 0x7FFFFF;
+
+	if (exponent >= 31) {
+		return sign | 0x7C00;
+	}
+	if (exponent <= 0) {
+		if (exponent < -10) {
+			return sign;
+		}
+		// Denormal, with the implicit leading one shifted in
+		mantissa |= 0x800000;
+		const unsigned int shift = 14 - exponent;
+		return sign | (GLushort)((mantissa >> shift) + ((mantissa >> (shift - 1)) & 1));
+	}
+	// A carry out of the mantissa when rounding moves up to the next exponent, which is still right
+	return sign | (GLushort)(((unsigned int)exponent << 10 | mantissa >> 13) + ((mantissa >> 12) & 1));
+}
+
+// Returns the value of a half float that isn't infinity or NaN
+double meshHalfValue(GLushort half) {
+	const int exponent = (half >> 10) & 0x1F;
+	const double magnitude = exponent == 0 ? ldexp(half & 0x3FF, -24) : ldexp((half & 0x3FF) | 0x400, exponent - 25);
+	return half & 0x8000 ? -magnitude : magnitude;
+}
+
+// Unfolds a normal's octahedral coordinates the same way the GLSL backend does, into a unit vector
+void meshOctahedralDecode(const GLbyte encoded[2], double normal[3]) {
+	const double x = fmax(encoded[0] / 127.0, -1), y = fmax(encoded[1] / 127.0, -1);
+	normal[2] = 1 - fabs(x) - fabs(y);
+	normal[0] = normal[2] < 0 ? (1 - fabs(y)) * (x >= 0 ? 1 : -1) : x;
+	normal[1] = normal[2] < 0 ? (1 - fabs(x)) * (y >= 0 ? 1 : -1) : y;
+	const double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+	for (unsigned int axis = 0; axis < 3; ++axis) {
+		normal[axis] /= length;
+	}
+}
+
+// Folds a unit normal onto an octahedron and the octahedron out into a square, then rounds it to 8 bits
+// a side whichever of the four ways unfolds closest to the normal
+void meshOctahedralEncode(const double normal[3], GLbyte encoded[2]) {
+	const double sum = fabs(normal[0]) + fabs(normal[1]) + fabs(normal[2]);
+	double x = sum > 0 ? normal[0] / sum : 0, y = sum > 0 ? normal[1] / sum : 0;
+	if (sum > 0 && normal[2] < 0) {
+		const double foldedX = (1 - fabs(y)) * (x >= 0 ? 1 : -1);
+		y = (1 - fabs(x)) * (y >= 0 ? 1 : -1);
+		x = foldedX;
+	}
+
+	double best = -2;
+	for (unsigned int corner = 0; corner < 4; ++corner) {
+		const double roundedX = corner & 1 ? ceil(x * 127) : floor(x * 127);
+		const double roundedY = corner & 2 ? ceil(y * 127) : floor(y * 127);
+		const GLbyte candidate[2] = { (GLbyte)fmax(fmin(roundedX, 127), -127), (GLbyte)fmax(fmin(roundedY, 127), -127) };
+		double decoded[3];
+		meshOctahedralDecode(candidate, decoded);
+		const double dot = decoded[0] * normal[0] + decoded[1] * normal[1] + decoded[2] * normal[2];
+		if (dot > best) {
+			best = dot;
+			encoded[0] = candidate[0];
+			encoded[1] = candidate[1];
+		}
+	}
+}
+
+void* meshQuantize(Mesh* mesh, VertexFormat format, VertexDecode* decode, MeshQuantizeError* error) {
+	const size_t vertexSize = vertexFormatSize(format);
+	char* quantized = allocCalloc(ALLOC_MESH, mesh->vertexCount + 1, vertexSize);
+	GLfloat minimum[5] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+	GLfloat maximum[5] = { -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	GLfloat halfExtent = 0;
+
+	// Bounds of the positions, then the texture coordinates
+	for (unsigned int i = 0; i < mesh->vertexCount; ++i) {
+		const Vertex* vertex = &mesh->vertices[i];
+		for (unsigned int component = 0; component < 5; ++component) {
+			const GLfloat value = component < 3 ? vertex->position[component] : vertex->texCoord[component - 3];
+			minimum[component] = value < minimum[component] ? value : minimum[component];
+			maximum[component] = value > maximum[component] ? value : maximum[component];
+		}
+	}
+	if (mesh->vertexCount == 0) {
+		memset(minimum, 0, sizeof(minimum));
+		memset(maximum, 0, sizeof(maximum));
+	}
+
+	for (unsigned int axis = 0; axis < 3; ++axis) {
+		decode->positionOffset[axis] = (minimum[axis] + maximum[axis]) / 2;
+		halfExtent = fmaxf(halfExtent, (maximum[axis] - minimum[axis]) / 2);
+	}
+	decode->positionScale = halfExtent > 0 ? halfExtent / 32767 : 1;
+	for (unsigned int component = 0; component < 2; ++component) {
+		const GLfloat texCoordHalfExtent = (maximum[component + 3] - minimum[component + 3]) / 2;
+		decode->texCoordOffset[component] = format == VERTEX_COMPACT ? 0 : (minimum[component + 3] + maximum[component + 3]) / 2;
+		decode->texCoordScale[component] = format != VERTEX_COMPACT && texCoordHalfExtent > 0 ? texCoordHalfExtent / 32767 : 1;
+	}
+
+	if (error != NULL) {
+		*error = (MeshQuantizeError) { 0, 0, 0 };
+	}
+
+	for (unsigned int i = 0; i < mesh->vertexCount; ++i) {
+		const Vertex* vertex = &mesh->vertices[i];
+		// Packed and compact vertices both start with the position
+		GLshort* position = (GLshort*)(quantized + i * vertexSize);
+		const double length = sqrt(vertex->normal[0] * vertex->normal[0] + vertex->normal[1] * vertex->normal[1]
+			+ vertex->normal[2] * vertex->normal[2]);
+		double normal[3], decodedNormal[3], decodedTexCoord[2];
+		double positionError = 0;
+
+		for (unsigned int axis = 0; axis < 3; ++axis) {
+			position[axis] = meshQuantizeShort((vertex->position[axis] - decode->positionOffset[axis]) / decode->positionScale);
+			const double difference = position[axis] * (double)decode->positionScale + decode->positionOffset[axis]
+				- vertex->position[axis];
+			positionError += difference * difference;
+			normal[axis] = length > 0 ? vertex->normal[axis] / length : 0;
+		}
+
+		if (format == VERTEX_COMPACT) {
+			CompactVertex* out = (CompactVertex*)position;
+			meshOctahedralEncode(normal, out->normal);
+			meshOctahedralDecode(out->normal, decodedNormal);
+			for (unsigned int component = 0; component < 2; ++component) {
+				out->texCoord[component] = meshHalf(vertex->texCoord[component]);
+				decodedTexCoord[component] = meshHalfValue(out->texCoord[component]);
+			}
+		} else {
+			PackedVertex* out = (PackedVertex*)position;
+			for (unsigned int axis = 0; axis < 3; ++axis) {
+				out->normal[axis] = (GLbyte)floor(normal[axis] * 127 + 0.5);
+				decodedNormal[axis] = out->normal[axis] / 127.0;
+			}
+			for (unsigned int component = 0; component < 2; ++component) {
+				out->texCoord[component] = meshQuantizeShort((vertex->texCoord[component] - decode->texCoordOffset[component])
+					/ decode->texCoordScale[component]);
+				decodedTexCoord[component] = out->texCoord[component] * (double)decode->texCoordScale[component]
+					+ decode->texCoordOffset[component];
+			}
+		}
+
+		if (error == NULL) {
+			continue;
+		}
+		error->position = fmax(error->position, sqrt(positionError));
+		const double decodedLength = sqrt(decodedNormal[0] * decodedNormal[0] + decodedNormal[1] * decodedNormal[1]
+			+ decodedNormal[2] * decodedNormal[2]);
+		if (length > 0 && decodedLength > 0) {
+			const double cosine = fmin((normal[0] * decodedNormal[0] + normal[1] * decodedNormal[1] + normal[2] * decodedNormal[2])
+				/ decodedLength, 1);
+			error->normal = fmax(error->normal, acos(cosine) * 180 / 3.14159265358979323846);
+		}
+		for (unsigned int component = 0; component < 2; ++component) {
+			error->texCoord = fmax(error->texCoord, fabs(decodedTexCoord[component] - vertex->texCoord[component]));
+		}
+	}
+
+	return quantized;
+}
+
+VertexBuffer* meshCreateBuffer(Mesh* mesh, VertexFormat format) {
+	if (format != VERTEX_FLOAT) {
+		VertexDecode decode;
+		void* quantized = meshQuantize(mesh, format, &decode, NULL);
+		VertexBuffer* buffer = vertexBufferCreatePacked(GL_TRIANGLES, format, quantized, mesh->vertexCount, mesh->indices,
+			mesh->indexCount, &decode);
+		allocFree(quantized);
+		return buffer;
+	}
+	return vertexBufferCreate(GL_TRIANGLES, mesh->vertices, mesh->vertexCount, mesh->indices, mesh->indexCount);
+}
+
+// A mesh being loaded, handed from the job reading it to the job putting it in a vertex buffer
+typedef struct MESHLOAD {
+	char* fileName;
+	VertexFormat format;
+	VertexBuffer** buffer;
+	Mesh* mesh;
+} MeshLoad;
+
+Pool meshLoadPool;
+
+// Job function, reads and optimises a mesh
+void meshReadJob(void* data, unsigned int begin, unsigned int end) {
+	MeshLoad* load = data;
+	MeshObject* object = loadMeshObject(load->fileName);
+
+	if (object != NULL) {
+		load->mesh = meshCreate(object);
+		freeMeshObject(object);
+		meshOptimize(load->mesh);
+	}
+}
+
+// Main thread job function, puts a mesh read by meshReadJob into a vertex buffer
+void meshUploadJob(void* data, unsigned int begin, unsigned int end) {
+	MeshLoad* load = data;
+
+	*load->buffer = load->mesh != NULL ? meshCreateBuffer(load->mesh, load->format) : NULL;
+	meshFree(load->mesh);
+	poolRelease(&meshLoadPool, load);
+}
+
+void meshLoadAsync(char* fileName, VertexFormat format, VertexBuffer** buffer, Job* parent) {
+	// The records are only taken here and given back by the upload job, both on the main thread
+	if (meshLoadPool.itemSize == 0) {
+		poolInit(&meshLoadPool, ALLOC_MESH, sizeof(MeshLoad), 0);
+	}
+	MeshLoad* load = poolAlloc(&meshLoadPool);
+	*load = (MeshLoad) { fileName, format, buffer, NULL };
+
+	Job* read = jobCreate(meshReadJob, load, parent);
+	Job* upload = jobCreate(meshUploadJob, load, parent);
+	jobRequireMainThread(upload);
+	jobDepend(upload, read);
+	jobSubmit(upload);
+	jobSubmit(read);
+}
+
+void meshFree(Mesh* mesh) {
+	if (mesh == NULL) {
+		return;
+	}
+	allocFree(mesh->vertices);
+	allocFree(mesh->indices);
+	allocFree(mesh->clusters);
+	allocFree(mesh);
+}
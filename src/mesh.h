@@ -0,0 +1,91 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <freeglut.h>
+#include "misc.h"
+#include "loader.h"
+#include "buffer.h"
+#include "job.h"
+#include "alloc.h"
+
+/*
+ * <mesh.c/mesh.h> Turns the polygons of a loaded OBJ mesh into indexed triangles, and reorders them to
+ * draw faster. The order an exporter writes faces in makes poor use of the post-transform vertex
+ * cache, so the triangles are first reordered with Tipsify (Sander, Nehab and Barczak, "Fast Triangle
+ * Reordering for Vertex Locality and Reduced Overdraw", 2007). The clusters Tipsify leaves behind are
+ * then sorted so that the ones facing out of the mesh draw first and hide the ones behind them, and
+ * lastly the vertices are renumbered in the order the triangles first use them, so fetching them walks
+ * through memory
+ *
+ * ACMR is the average number of vertices transformed per triangle (0.5 at best for a large regular
+ * grid, 3 at worst), and ATVR the number transformed per unique vertex (1 at best). Both are measured
+ * by simulating a FIFO cache, and the overdraw from six directions with a small software rasteriser.
+ * --bench meshes reports them for every mesh the scene loads, before and after
+ *
+ * A mesh can also be packed into half the memory for drawing, with the error that costs measured
+ */
+
+// Number of entries in the FIFO vertex cache the triangles are ordered for and measured with
+#define MESH_CACHE_SIZE 16
+// How much worse than the whole mesh's ACMR a cluster's can be when the overdraw pass splits clusters
+// smaller, trading some vertex cache use for more freedom to sort them
+#define MESH_OVERDRAW_THRESHOLD 1.05
+// Width and height of the depth buffer the overdraw is measured with
+#define MESH_OVERDRAW_RESOLUTION 256
+
+typedef struct MESH {
+	Vertex* vertices;
+	unsigned int vertexCount;
+	GLuint* indices;			// Three per triangle
+	unsigned int indexCount;
+	unsigned int* clusters;		// First triangle of each cluster the vertex cache pass found, for the overdraw pass
+	unsigned int clusterCount;
+} Mesh;
+
+typedef struct MESHCACHESTATS {
+	double acmr;	// Average cache miss ratio, vertices transformed per triangle
+	double atvr;	// Average transform to vertex ratio, vertices transformed per unique vertex
+} MeshCacheStats;
+
+typedef struct MESHQUANTIZEERROR {
+	double position;	// Furthest any position moved, in the mesh's units
+	double normal;		// Furthest any normal turned, in degrees
+	double texCoord;	// Largest change in any texture coordinate component
+} MeshQuantizeError;
+
+// The records of meshes being loaded by meshLoadAsync, which only the main thread uses
+extern Pool meshLoadPool;
+
+// Creates indexed triangles from a mesh object's polygons, splitting each one into a fan and sharing
+// the vertices where the position, texture coordinate and normal are all the same. The triangles keep
+// the order of the faces in the file
+Mesh* meshCreate(MeshObject* object);
+// Reorders the triangles for a FIFO vertex cache of the given size with Tipsify, and records the clusters
+// it leaves behind, which start wherever it had to jump to a vertex no longer in the cache
+void meshOptimizeVertexCache(Mesh* mesh, unsigned int cacheSize);
+// Reorders the clusters from meshOptimizeVertexCache so the ones facing out of the mesh draw first. Clusters
+// are split further where the ACMR so far is within threshold times the whole mesh's
+void meshOptimizeOverdraw(Mesh* mesh, unsigned int cacheSize, double threshold);
+// Renumbers the vertices in the order the triangles first use them, dropping any that aren't used
+void meshOptimizeVertexFetch(Mesh* mesh);
+// Runs every optimisation, with the default cache size and threshold
+void meshOptimize(Mesh* mesh);
+// Returns the ACMR and ATVR of a mesh's triangle order with a FIFO vertex cache of the given size
+MeshCacheStats meshCacheStats(Mesh* mesh, unsigned int cacheSize);
+// Returns the average number of fragments that pass the depth test per covered pixel, drawing the mesh
+// along each axis in both directions, with its bounds filling a square depth buffer of the given size
+double meshOverdraw(Mesh* mesh, unsigned int resolution);
+// Packs a mesh's vertices into PackedVertex or CompactVertex, filling in how to decode them, and the
+// largest errors if error isn't NULL. Returns memory that must be allocFree()'d
+void* meshQuantize(Mesh* mesh, VertexFormat format, VertexDecode* decode, MeshQuantizeError* error);
+// Creates a vertex buffer holding a mesh's triangles, with its vertices in the given format
+VertexBuffer* meshCreateBuffer(Mesh* mesh, VertexFormat format);
+// Loads an OBJ mesh from the assets folder as jobs under the given parent. One job reads and optimises it on
+// any thread, then a main thread job stores a vertex buffer of its triangles in the given format in *buffer,
+// or NULL if it couldn't be loaded
+void meshLoadAsync(char* fileName, VertexFormat format, VertexBuffer** buffer, Job* parent);
+// Frees a mesh
+void meshFree(Mesh* mesh);
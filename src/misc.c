@@ -1,19 +1,15 @@
 #include "misc.h"
+#include "render.h"
+#include "text.h"
+#include "input.h"
 
-// Current state of all keys used to control our "player-controlled" object's motion.
-motionkeys_t motionKeyStates = {
-	KEYSTATE_UP, KEYSTATE_UP, KEYSTATE_UP, KEYSTATE_UP,
-	KEYSTATE_UP, KEYSTATE_UP, KEYSTATE_UP, KEYSTATE_UP };
-
-// How our "player-controlled" object should currently be moving, solely based on keyboard input.
-//
-// Note: this may not represent the actual motion of our object, which could be subject to
-// other controls (e.g. mouse input) or other simulated forces (e.g. gravity).
-motionstate4_t keyboardMotion = { MOTION_NONE, MOTION_NONE, MOTION_NONE, MOTION_NONE };
+// Whether drawText draws anything. The font atlas can't be built when GLUT didn't create the context
+bool textEnabled = TRUE;
 
 // window dimensions
 GLint windowWidth = DEFAULT_WINDOW_WIDTH;
 GLint windowHeight = DEFAULT_WINDOW_HEIGHT;
+Mat4 sceneProjection;
 
 GLfloat offsetRand(GLfloat offset) {
 	return (0.5f - (GLfloat)rand() / RAND_MAX) * offset;
@@ -24,31 +20,25 @@ void keyPressed(unsigned char key, int x, int y)
 	switch (tolower(key)) {
 
 		/*
-			Keyboard-Controlled Motion Handler - DON'T CHANGE THIS SECTION
-
-			Whenever one of our movement keys is pressed, we do two things:
-			(1) Update motionKeyStates to record that the key is held down. We use
-				this later in the keyReleased callback.
-			(2) Update the relevant axis in keyboardMotion to set the new direction
-				we should be moving in. The most recent key always "wins" (e.g. if
-				you're holding down KEY_MOVE_LEFT then also pressed KEY_MOVE_RIGHT,
-				our object will immediately start moving right).
+			Keyboard-Controlled Motion Handler
+
+			Whenever one of our movement keys is pressed, we push the press onto the input
+			queue, with the time it happened. The simulation thread works out which way to
+			move from the queue, applying each press at the right point in its tick. The most
+			recent key always "wins" (e.g. if you're holding down KEY_MOVE_LEFT then also
+			pressed KEY_MOVE_RIGHT, our object will immediately start moving right).
 		*/
 	case KEY_MOVE_FORWARD:
-		motionKeyStates.MoveForward = KEYSTATE_DOWN;
-		keyboardMotion.Surge = MOTION_FORWARD;
+		inputPush(INPUT_MOVE_FORWARD, TRUE);
 		break;
 	case KEY_MOVE_BACKWARD:
-		motionKeyStates.MoveBackward = KEYSTATE_DOWN;
-		keyboardMotion.Surge = MOTION_BACKWARD;
+		inputPush(INPUT_MOVE_BACKWARD, TRUE);
 		break;
 	case KEY_MOVE_LEFT:
-		motionKeyStates.MoveLeft = KEYSTATE_DOWN;
-		keyboardMotion.Sway = MOTION_LEFT;
+		inputPush(INPUT_MOVE_LEFT, TRUE);
 		break;
 	case KEY_MOVE_RIGHT:
-		motionKeyStates.MoveRight = KEYSTATE_DOWN;
-		keyboardMotion.Sway = MOTION_RIGHT;
+		inputPush(INPUT_MOVE_RIGHT, TRUE);
 		break;
 
 		/*
@@ -71,25 +61,21 @@ void specialKeyPressed(int key, int x, int y)
 	switch (key) {
 
 		/*
-			Keyboard-Controlled Motion Handler - DON'T CHANGE THIS SECTION
+			Keyboard-Controlled Motion Handler
 
 			This works as per the motion keys in keyPressed.
 		*/
 	case SP_KEY_MOVE_UP:
-		motionKeyStates.MoveUp = KEYSTATE_DOWN;
-		keyboardMotion.Heave = MOTION_UP;
+		inputPush(INPUT_MOVE_UP, TRUE);
 		break;
 	case SP_KEY_MOVE_DOWN:
-		motionKeyStates.MoveDown = KEYSTATE_DOWN;
-		keyboardMotion.Heave = MOTION_DOWN;
+		inputPush(INPUT_MOVE_DOWN, TRUE);
 		break;
 	case SP_KEY_TURN_LEFT:
-		motionKeyStates.TurnLeft = KEYSTATE_DOWN;
-		keyboardMotion.Yaw = MOTION_ANTICLOCKWISE;
+		inputPush(INPUT_TURN_LEFT, TRUE);
 		break;
 	case SP_KEY_TURN_RIGHT:
-		motionKeyStates.TurnRight = KEYSTATE_DOWN;
-		keyboardMotion.Yaw = MOTION_CLOCKWISE;
+		inputPush(INPUT_TURN_RIGHT, TRUE);
 		break;
 
 		/*
@@ -108,33 +94,24 @@ void keyReleased(unsigned char key, int x, int y)
 	switch (tolower(key)) {
 
 		/*
-			Keyboard-Controlled Motion Handler - DON'T CHANGE THIS SECTION
-
-			Whenever one of our movement keys is released, we do two things:
-			(1) Update motionKeyStates to record that the key is no longer held down;
-				we need to know when we get to step (2) below.
-			(2) Update the relevant axis in keyboardMotion to set the new direction
-				we should be moving in. This gets a little complicated to ensure
-				the controls work smoothly. When the user releases a key that moves
-				in one direction (e.g. KEY_MOVE_RIGHT), we check if its "opposite"
-				key (e.g. KEY_MOVE_LEFT) is pressed down. If it is, we begin moving
-				in that direction instead. Otherwise, we just stop moving.
+			Keyboard-Controlled Motion Handler
+
+			Whenever one of our movement keys is released, we push the release onto the
+			input queue. When the simulation applies it, it checks if the key's "opposite"
+			key (e.g. KEY_MOVE_LEFT for KEY_MOVE_RIGHT) is still held down. If it is, it
+			begins moving in that direction instead. Otherwise, it just stops moving.
 		*/
 	case KEY_MOVE_FORWARD:
-		motionKeyStates.MoveForward = KEYSTATE_UP;
-		keyboardMotion.Surge = (motionKeyStates.MoveBackward == KEYSTATE_DOWN) ? MOTION_BACKWARD : MOTION_NONE;
+		inputPush(INPUT_MOVE_FORWARD, FALSE);
 		break;
 	case KEY_MOVE_BACKWARD:
-		motionKeyStates.MoveBackward = KEYSTATE_UP;
-		keyboardMotion.Surge = (motionKeyStates.MoveForward == KEYSTATE_DOWN) ? MOTION_FORWARD : MOTION_NONE;
+		inputPush(INPUT_MOVE_BACKWARD, FALSE);
 		break;
 	case KEY_MOVE_LEFT:
-		motionKeyStates.MoveLeft = KEYSTATE_UP;
-		keyboardMotion.Sway = (motionKeyStates.MoveRight == KEYSTATE_DOWN) ? MOTION_RIGHT : MOTION_NONE;
+		inputPush(INPUT_MOVE_LEFT, FALSE);
 		break;
 	case KEY_MOVE_RIGHT:
-		motionKeyStates.MoveRight = KEYSTATE_UP;
-		keyboardMotion.Sway = (motionKeyStates.MoveLeft == KEYSTATE_DOWN) ? MOTION_LEFT : MOTION_NONE;
+		inputPush(INPUT_MOVE_RIGHT, FALSE);
 		break;
 
 		/*
@@ -154,25 +131,21 @@ void specialKeyReleased(int key, int x, int y)
 {
 	switch (key) {
 		/*
-			Keyboard-Controlled Motion Handler - DON'T CHANGE THIS SECTION
+			Keyboard-Controlled Motion Handler
 
 			This works as per the motion keys in keyReleased.
 		*/
 	case SP_KEY_MOVE_UP:
-		motionKeyStates.MoveUp = KEYSTATE_UP;
-		keyboardMotion.Heave = (motionKeyStates.MoveDown == KEYSTATE_DOWN) ? MOTION_DOWN : MOTION_NONE;
+		inputPush(INPUT_MOVE_UP, FALSE);
 		break;
 	case SP_KEY_MOVE_DOWN:
-		motionKeyStates.MoveDown = KEYSTATE_UP;
-		keyboardMotion.Heave = (motionKeyStates.MoveUp == KEYSTATE_DOWN) ? MOTION_UP : MOTION_NONE;
+		inputPush(INPUT_MOVE_DOWN, FALSE);
 		break;
 	case SP_KEY_TURN_LEFT:
-		motionKeyStates.TurnLeft = KEYSTATE_UP;
-		keyboardMotion.Yaw = (motionKeyStates.TurnRight == KEYSTATE_DOWN) ? MOTION_CLOCKWISE : MOTION_NONE;
+		inputPush(INPUT_TURN_LEFT, FALSE);
 		break;
 	case SP_KEY_TURN_RIGHT:
-		motionKeyStates.TurnRight = KEYSTATE_UP;
-		keyboardMotion.Yaw = (motionKeyStates.TurnLeft == KEYSTATE_DOWN) ? MOTION_ANTICLOCKWISE : MOTION_NONE;
+		inputPush(INPUT_TURN_RIGHT, FALSE);
 		break;
 
 		/*
@@ -185,10 +158,6 @@ void specialKeyReleased(int key, int x, int y)
 	}
 }
 
-motionstate4_t getKeyboardState(void) {
-	return keyboardMotion;
-}
-
 void reshape(int width, int height)
 {
 	windowHeight = height;
@@ -198,35 +167,29 @@ void reshape(int width, int height)
 
 	glMatrixMode(GL_PROJECTION);
 
-	glLoadIdentity();
-
-	gluPerspective(60, (float)windowWidth / (float)windowHeight, 2, 500);
+	// Worked out here rather than by gluPerspective, so the GLSL renderer can be handed the same matrix
+	sceneProjection = mat4Perspective(60, (float)windowWidth / (float)windowHeight, 2, 500);
+	glLoadMatrixf(sceneProjection.m);
 
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 }
 
-void setMaterial(RGB colour, RGB emission, GLfloat shininess) {
-	glMaterialfv(GL_FRONT, GL_AMBIENT, (GLfloat[4]) { 0, 0, 0, 0 });
-	glMaterialfv(GL_FRONT, GL_DIFFUSE, (GLfloat[4]) { colour.r / 255.f, colour.g / 255.f, colour.b / 255.f, 1 });
-	glMaterialfv(GL_FRONT, GL_SPECULAR, (GLfloat[4]) { 1, 1, 1, 1 });
-	glMaterialfv(GL_FRONT, GL_EMISSION, (GLfloat[4]) { emission.r, emission.g, emission.b, 1 });
-	glMaterialf(GL_FRONT, GL_SHININESS, shininess);
-}
-
 void drawText(char* text, Vec2 position) {
-	// https://stackoverflow.com/a/21923064
-	glMatrixMode(GL_PROJECTION);
-	glPushMatrix();
-	glLoadIdentity();
-	gluOrtho2D(0.0, DEFAULT_WINDOW_WIDTH, 0.0, DEFAULT_WINDOW_HEIGHT);
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-	glLoadIdentity();
-	glRasterPos2i(position.x, position.y);
-	glutBitmapString(GLUT_BITMAP_HELVETICA_18, text);
-	glMatrixMode(GL_PROJECTION);
-	glPopMatrix();
-	glMatrixMode(GL_MODELVIEW);
-	glPopMatrix();
-}
\ No newline at end of file
+	GLfloat colour[4];
+	GLboolean colourWrites[4];
+
+	if (!textEnabled) {
+		return;
+	}
+
+	// Text drawn while colour writes are off, as in the depth pre-pass, never showed up when it was drawn
+	// straight away, so it isn't queued either
+	glGetBooleanv(GL_COLOR_WRITEMASK, colourWrites);
+	if (!colourWrites[0]) {
+		return;
+	}
+
+	glGetFloatv(GL_CURRENT_COLOR, colour);
+	textQueue(text, position, colour);
+}
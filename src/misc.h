@@ -1,5 +1,8 @@
 #pragma once
+#include <ctype.h>
 #include <freeglut.h>
+#include "platform.h"
+#include "atomic.h"
 #include "vecmath.h"
 
 /*
@@ -90,11 +93,14 @@ void specialKeyPressed(int key, int x, int y);
 void keyReleased(unsigned char key, int x, int y);
 // Called each time a "special" key (e.g. an arrow key) is released.
 void specialKeyReleased(int key, int x, int y);
-// Returns the motion state of the keyboard input
-motionstate4_t getKeyboardState(void);
 // Called when the OpenGL window has been resized.
 void reshape(int width, int height);
-// Sets a basic RGB material colour with emission and shininess parameters
-void setMaterial(RGB colour, RGB emission, GLfloat shininess);
-// Draws text on the screen, takes an xy  position relative to the screen coordinates
+// Size of the window, as of the last reshape
+extern GLint windowWidth, windowHeight;
+// The scene's projection for the window's shape, as of the last reshape
+extern Mat4 sceneProjection;
+// Whether drawText draws anything, cleared when there's no GLUT window to build the font atlas with
+extern bool textEnabled;
+// Queues text to be drawn on the screen in the current colour when the frame's text is flushed, takes an
+// xy position in pixels from the bottom left of the window
 void drawText(char* text, Vec2 position);
\ No newline at end of file
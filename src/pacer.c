@@ -0,0 +1,58 @@
+#include "pacer.h"
+
+void pacerInit(FramePacer* pacer, double framesPerSecond) {
+	*pacer = (FramePacer) { 0 };
+	pacer->period = framesPerSecond > 0 ? (unsigned long long)(1e9 / framesPerSecond + 0.5) : 0;
+	pacer->deadline = platformNanoseconds();
+}
+
+unsigned long long pacerWait(FramePacer* pacer) {
+	unsigned long long now = platformNanoseconds();
+
+	if (pacer->period > 0) {
+		if (pacer->deadline > now + PACER_SPIN_TIME) {
+			platformSleepUntil(pacer->deadline - PACER_SPIN_TIME);
+		}
+		while ((now = platformNanoseconds()) < pacer->deadline) {
+		}
+
+		const unsigned long long late = now - pacer->deadline;
+		pacer->lateMean += (late - pacer->lateMean) / (pacer->frames + 1);
+		pacer->lateMax = late > pacer->lateMax ? late : pacer->lateMax;
+
+		// A frame that ran long is caught up on by the next ones starting straight away, unless it's so
+		// late that catching up would mean a burst of frames, in which case the schedule restarts
+		if (late > pacer->period * PACER_MAX_LATE_FRAMES) {
+			pacer->deadline = now;
+			++pacer->resyncs;
+		}
+		pacer->deadline += pacer->period;
+	}
+
+	if (pacer->frames > 0) {
+		// Welford's method, which keeps the variance accurate over any number of frames
+		const double interval = (double)(now - pacer->lastStart);
+		const double delta = interval - pacer->intervalMean;
+		pacer->intervalMean += delta / pacer->frames;
+		pacer->intervalM2 += delta * (interval - pacer->intervalMean);
+	}
+	pacer->lastStart = now;
+	++pacer->frames;
+
+	return now;
+}
+
+double pacerDeviation(FramePacer* pacer) {
+	return pacer->frames > 2 ? sqrt(pacer->intervalM2 / (pacer->frames - 2)) / 1e6 : 0;
+}
+
+void pacerReport(FramePacer* pacer, FILE* file) {
+	fprintf(file, "%llu frames, %.3f ms mean frame time, %.3f ms deviation", pacer->frames,
+		pacer->intervalMean / 1e6, pacerDeviation(pacer));
+
+	if (pacer->period > 0) {
+		fprintf(file, ", %.1f us mean lateness, %.1f us worst, %llu resyncs", pacer->lateMean / 1e3,
+			pacer->lateMax / 1e3, pacer->resyncs);
+	}
+	fprintf(file, "\n");
+}
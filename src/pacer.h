@@ -0,0 +1,42 @@
+#pragma once
+#include <stdio.h>
+#include <math.h>
+#include "misc.h"
+#include "platform.h"
+
+/*
+ * <pacer.c/pacer.h> Paces frames to a target rate. Frames are scheduled at fixed points on a
+ * monotonic clock rather than a fixed time after the last one finished, so lateness in one frame
+ * doesn't push every later frame back. The wait sleeps until shortly before the deadline, then spins
+ * for the rest, since a sleep can overshoot by up to the scheduler's granularity
+ */
+
+// Time before a deadline that the pacer stops sleeping and spins instead, in nanoseconds. A Windows
+// sleep is far coarser without the high resolution timer, so it stops well before
+#ifdef _WIN32
+#define PACER_SPIN_TIME 1000000ULL
+#else
+#define PACER_SPIN_TIME 300000ULL
+#endif
+// Number of whole frames a frame can run late by before the schedule gives up and restarts from now
+#define PACER_MAX_LATE_FRAMES 2
+
+typedef struct FRAMEPACER {
+	unsigned long long period;		// Time between frames in nanoseconds, or 0 to run uncapped
+	unsigned long long deadline;	// When the next frame is due to start
+	unsigned long long lastStart;	// When the last frame actually started
+	unsigned long long frames;		// Number of frames paced
+	unsigned long long resyncs;		// Number of times a frame ran so late the schedule restarted
+	double intervalMean, intervalM2;	// Running mean and sum of squared differences of frame intervals
+	double lateMean;				// Average time frames started after their deadline, in nanoseconds
+	unsigned long long lateMax;		// Latest a frame has started after its deadline
+} FramePacer;
+
+// Sets up a pacer for a target rate in frames per second, or uncapped if it's 0
+void pacerInit(FramePacer* pacer, double framesPerSecond);
+// Waits until the next frame is due, then returns the time it started
+unsigned long long pacerWait(FramePacer* pacer);
+// Returns the standard deviation of the time between frames, in milliseconds
+double pacerDeviation(FramePacer* pacer);
+// Writes the frame count, mean and deviation of the frame time, and how late frames were against the schedule
+void pacerReport(FramePacer* pacer, FILE* file);
@@ -0,0 +1,432 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "pack.h"
+#include "loader.h"
+
+PackArchive packArchive;
+
+// LZ4 matches are at least this long, the last match has to start this far before the end of the block,
+// and the last this many bytes are always literals
+#define PACK_MIN_MATCH 4
+#define PACK_MATCH_LIMIT 12
+#define PACK_LAST_LITERALS 5
+// Farthest back a match can be
+#define PACK_MAX_OFFSET 65535
+// Literal runs up to this long are copied in one go of this many bytes when the block and output have room
+#define PACK_FAST_COPY 16
+
+// Reads four bytes that needn't be aligned
+unsigned int packRead32(const unsigned char* data) {
+	unsigned int value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+unsigned long long packHash(const unsigned char* data, size_t size) {
+	unsigned long long hash = 14695981039346656037ULL;
+	size_t i = 0;
+
+	// FNV-1a a word at a time, then a byte at a time for what's left, with the high bits folded into
+	// the low ones at the end since a multiply only carries changes upwards
+	for (; i + sizeof(unsigned long long) <= size; i += sizeof(unsigned long long)) {
+		unsigned long long word;
+		memcpy(&word, data + i, sizeof(word));
+		hash = (hash ^ word) * 1099511628211ULL;
+	}
+	for (; i < size; ++i) {
+		hash = (hash ^ data[i]) * 1099511628211ULL;
+	}
+	return hash ^ (hash >> 32);
+}
+
+size_t packCompressBound(size_t size) {
+	return size + size / 255 + 16;
+}
+
+// Writes the length past what fits in a token's four bits, as bytes of 255 and then what's left
+unsigned char* packWriteLength(unsigned char* out, size_t length) {
+	for (; length >= 255; length -= 255) {
+		*out++ = 255;
+	}
+	*out++ = (unsigned char)length;
+	return out;
+}
+
+// Writes one sequence of literals, followed by a match unless matchLength is 0. Returns NULL if it doesn't fit
+unsigned char* packWriteSequence(unsigned char* out, unsigned char* end, const unsigned char* literals,
+	size_t literalLength, size_t offset, size_t matchLength) {
+	if ((size_t)(end - out) < 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1) {
+		return NULL;
+	}
+
+	unsigned char* token = out++;
+	*token = (unsigned char)((literalLength < 15 ? literalLength : 15) << 4);
+	if (literalLength >= 15) {
+		out = packWriteLength(out, literalLength - 15);
+	}
+	memcpy(out, literals, literalLength);
+	out += literalLength;
+
+	if (matchLength > 0) {
+		const size_t length = matchLength - PACK_MIN_MATCH;
+		*out++ = (unsigned char)(offset & 0xFF);
+		*out++ = (unsigned char)(offset >> 8);
+		*token |= (unsigned char)(length < 15 ? length : 15);
+		if (length >= 15) {
+			out = packWriteLength(out, length - 15);
+		}
+	}
+	return out;
+}
+
+size_t packCompress(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity) {
+	// Where each hash of four bytes was last seen, plus one so that 0 is empty
+	unsigned int* table = allocCalloc(ALLOC_LOADER, (size_t)1 << PACK_HASH_BITS, sizeof(unsigned int));
+	unsigned char* out = destination;
+	unsigned char* const end = destination + capacity;
+	size_t anchor = 0, position = 0;
+
+	// Greedy: the first match found at each position is taken, and the search carries on after it
+	while (size > PACK_MATCH_LIMIT && position < size - PACK_MATCH_LIMIT) {
+		const unsigned int sequence = packRead32(source + position);
+		const unsigned int hash = (sequence * 2654435761u) >> (32 - PACK_HASH_BITS);
+		const size_t candidate = table[hash];
+		table[hash] = (unsigned int)position + 1;
+
+		if (candidate == 0 || position - (candidate - 1) > PACK_MAX_OFFSET || packRead32(source + candidate - 1) != sequence) {
+			++position;
+			continue;
+		}
+
+		const size_t match = candidate - 1;
+		size_t length = PACK_MIN_MATCH;
+		while (position + length < size - PACK_LAST_LITERALS && source[match + length] == source[position + length]) {
+			++length;
+		}
+
+		out = packWriteSequence(out, end, source + anchor, position - anchor, position - match, length);
+		if (out == NULL) {
+			allocFree(table);
+			return 0;
+		}
+		position += length;
+		anchor = position;
+	}
+
+	allocFree(table);
+	out = packWriteSequence(out, end, source + anchor, size - anchor, 0, 0);
+	return out != NULL ? (size_t)(out - destination) : 0;
+}
+
+// Reads the length past a token's four bits. Returns FALSE if it runs off the end of the block
+bool packReadLength(const unsigned char* source, size_t size, size_t* in, size_t* length) {
+	unsigned char byte;
+	do {
+		if (*in >= size) {
+			return FALSE;
+		}
+		byte = source[(*in)++];
+		*length += byte;
+	} while (byte == 255);
+	return TRUE;
+}
+
+bool packDecompress(const unsigned char* source, size_t size, unsigned char* destination, size_t originalSize) {
+	size_t in = 0, out = 0;
+
+	while (in < size) {
+		const unsigned char token = source[in++];
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15 && !packReadLength(source, size, &in, &literalLength)) {
+			return FALSE;
+		}
+		if (literalLength > size - in || literalLength > originalSize - out) {
+			return FALSE;
+		}
+		// Short runs are copied a whole word pair at once where there's room, as most are
+		if (literalLength <= PACK_FAST_COPY && size - in >= PACK_FAST_COPY && originalSize - out >= PACK_FAST_COPY) {
+			memcpy(destination + out, source + in, PACK_FAST_COPY);
+		} else {
+			memcpy(destination + out, source + in, literalLength);
+		}
+		in += literalLength;
+		out += literalLength;
+
+		// The last sequence is only literals
+		if (in == size) {
+			break;
+		}
+
+		if (size - in < 2) {
+			return FALSE;
+		}
+		const size_t offset = source[in] | (source[in + 1] << 8);
+		in += 2;
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !packReadLength(source, size, &in, &matchLength)) {
+			return FALSE;
+		}
+		matchLength += PACK_MIN_MATCH;
+		if (offset == 0 || offset > out || matchLength > originalSize - out) {
+			return FALSE;
+		}
+
+		// A match can overlap what it's copying, repeating the last offset bytes. Eight bytes at a time only
+		// ever reads bytes already written when the offset is at least eight, and may write up to seven past
+		// the match, which the next sequence overwrites
+		const unsigned char* match = destination + out - offset;
+		unsigned char* copy = destination + out;
+		if (offset >= 8 && originalSize - out >= matchLength + 8) {
+			for (size_t i = 0; i < matchLength; i += 8) {
+				memcpy(copy + i, match + i, 8);
+			}
+		} else {
+			for (size_t i = 0; i < matchLength; ++i) {
+				copy[i] = match[i];
+			}
+		}
+		out += matchLength;
+	}
+
+	return out == originalSize;
+}
+
+bool packOpen(char* path) {
+	PackArchive* archive = &packArchive;
+	size_t size = 0;
+	unsigned char* data = platformMapFile(path, &size);
+
+	if (data == NULL) {
+		return FALSE;
+	}
+
+	const PackHeader* header = (const PackHeader*)data;
+	if (size < sizeof(PackHeader) || memcmp(header->magic, PACK_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != PACK_VERSION || header->entryCount > (size - sizeof(PackHeader)) / sizeof(PackEntry)) {
+		printf("'%s' isn't an asset archive this version can read\n", path);
+		platformUnmapFile(data, size);
+		return FALSE;
+	}
+
+	PackEntry* entries = (PackEntry*)(data + sizeof(PackHeader));
+	for (unsigned int i = 0; i < header->entryCount; ++i) {
+		const PackEntry* entry = &entries[i];
+		if (memchr(entry->name, '\0', PACK_MAX_NAME) == NULL || entry->offset > size || entry->size > size - entry->offset
+			|| entry->codec > PACK_LZ4 || (entry->codec == PACK_RAW && entry->size != entry->originalSize)) {
+			printf("'%s' has a broken index\n", path);
+			platformUnmapFile(data, size);
+			return FALSE;
+		}
+	}
+
+	packClose();
+	archive->data = data;
+	archive->size = size;
+	archive->entries = entries;
+	archive->entryCount = header->entryCount;
+	return TRUE;
+}
+
+void packClose(void) {
+	platformUnmapFile(packArchive.data, packArchive.size);
+	packArchive.data = NULL;
+	packArchive.size = 0;
+	packArchive.entries = NULL;
+	packArchive.entryCount = 0;
+}
+
+int packCompareEntries(const void* a, const void* b) {
+	return strcmp(((const PackEntry*)a)->name, ((const PackEntry*)b)->name);
+}
+
+PackEntry* packFind(char* name) {
+	PackEntry key;
+
+	if (packArchive.data == NULL || strlen(name) >= PACK_MAX_NAME) {
+		return NULL;
+	}
+	strcpy(key.name, name);
+	return bsearch(&key, packArchive.entries, packArchive.entryCount, sizeof(PackEntry), packCompareEntries);
+}
+
+// Reads an asset from its entry in the archive. Returns NULL if it's corrupt
+unsigned char* packReadEntry(PackEntry* entry) {
+	const unsigned char* stored = packArchive.data + entry->offset;
+	unsigned char* data = allocMalloc(ALLOC_LOADER, (size_t)entry->originalSize + 1);
+
+	if (entry->codec == PACK_LZ4) {
+		if (!packDecompress(stored, (size_t)entry->size, data, (size_t)entry->originalSize)) {
+			allocFree(data);
+			return NULL;
+		}
+	} else {
+		memcpy(data, stored, (size_t)entry->size);
+	}
+
+	if (packHash(data, (size_t)entry->originalSize) != entry->hash) {
+		allocFree(data);
+		return NULL;
+	}
+	data[entry->originalSize] = '\0';
+	return data;
+}
+
+// Reads an asset from the assets folder, filling in its size. Returns NULL if it can't be read
+unsigned char* packReadLoose(char* name, size_t* size) {
+	char* path = generatePath(name);
+	FILE* file = fopen(path, "rb");
+	allocFree(path);
+
+	if (file == NULL) {
+		return NULL;
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	unsigned char* data = length >= 0 ? allocMalloc(ALLOC_LOADER, (size_t)length + 1) : NULL;
+	if (data == NULL || fread(data, 1, (size_t)length, file) != (size_t)length) {
+		allocFree(data);
+		fclose(file);
+		return NULL;
+	}
+	fclose(file);
+
+	data[length] = '\0';
+	*size = (size_t)length;
+	return data;
+}
+
+unsigned char* packRead(char* name, size_t* size) {
+	PackArchive* archive = &packArchive;
+	const unsigned long long start = platformNanoseconds();
+	PackEntry* entry = packFind(name);
+	unsigned char* data = NULL;
+
+	if (entry != NULL) {
+		data = packReadEntry(entry);
+		if (data == NULL) {
+			printf("'%s' is corrupt in the archive, reading it from the assets folder instead\n", name);
+		} else {
+			*size = (size_t)entry->originalSize;
+			atomicAdd64(&archive->archiveReads, 1);
+			atomicAdd64(&archive->storedBytes, (long long)entry->size);
+		}
+	}
+	if (data == NULL) {
+		data = packReadLoose(name, size);
+		if (data == NULL) {
+			return NULL;
+		}
+		atomicAdd64(&archive->looseReads, 1);
+		atomicAdd64(&archive->storedBytes, (long long)*size);
+	}
+
+	atomicAdd64(&archive->decodedBytes, (long long)*size);
+	atomicAdd64(&archive->readTime, (long long)(platformNanoseconds() - start));
+	return data;
+}
+
+// The names of the files being packed
+typedef struct PACKNAMES {
+	PackEntry* entries;
+	unsigned int count;
+} PackNames;
+
+// Adds a file to the archive being written, if there's room and its name fits
+void packAddName(void* data, const char* name) {
+	PackNames* names = data;
+
+	if (strlen(name) >= PACK_MAX_NAME) {
+		printf("'%s' has too long a name to be packed\n", name);
+	} else if (names->count == PACK_MAX_ENTRIES) {
+		printf("'%s' wasn't packed, the archive is full\n", name);
+	} else {
+		memset(&names->entries[names->count], 0, sizeof(PackEntry));
+		strcpy(names->entries[names->count++].name, name);
+	}
+}
+
+bool packCreate(char* path, bool compress) {
+	PackEntry* entries = allocCalloc(ALLOC_LOADER, PACK_MAX_ENTRIES, sizeof(PackEntry));
+	PackNames names = { entries, 0 };
+	const unsigned char padding[PACK_ALIGNMENT] = { 0 };
+	unsigned long long storedTotal = 0, originalTotal = 0;
+
+	if (!platformListFiles(DIR, packAddName, &names)) {
+		printf("Couldn't list the files in '%s'\n", DIR);
+		allocFree(entries);
+		return FALSE;
+	}
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		printf("Couldn't write '%s'\n", path);
+		allocFree(entries);
+		return FALSE;
+	}
+
+	// The index is written once every entry's place is known, and sorted so it can be searched
+	qsort(entries, names.count, sizeof(PackEntry), packCompareEntries);
+	const PackHeader header = { PACK_MAGIC, PACK_VERSION, names.count };
+	unsigned long long offset = sizeof(PackHeader) + (unsigned long long)names.count * sizeof(PackEntry);
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(entries, sizeof(PackEntry), names.count, file);
+
+	for (unsigned int i = 0; i < names.count; ++i) {
+		PackEntry* entry = &entries[i];
+		size_t size = 0;
+		unsigned char* data = packReadLoose(entry->name, &size);
+		if (data == NULL) {
+			printf("Couldn't read '%s'\n", entry->name);
+			continue;
+		}
+
+		const size_t bound = packCompressBound(size);
+		unsigned char* compressed = compress ? allocMalloc(ALLOC_LOADER, bound) : NULL;
+		const size_t compressedSize = compress ? packCompress(data, size, compressed, bound) : 0;
+		const bool useCompressed = compressedSize > 0 && compressedSize < size;
+
+		const size_t alignment = (size_t)((PACK_ALIGNMENT - offset % PACK_ALIGNMENT) % PACK_ALIGNMENT);
+		fwrite(padding, 1, alignment, file);
+		offset += alignment;
+
+		entry->offset = offset;
+		entry->size = useCompressed ? compressedSize : size;
+		entry->originalSize = size;
+		entry->codec = useCompressed ? PACK_LZ4 : PACK_RAW;
+		entry->hash = packHash(data, size);
+		fwrite(useCompressed ? compressed : data, 1, (size_t)entry->size, file);
+		offset += entry->size;
+		storedTotal += entry->size;
+		originalTotal += size;
+
+		printf("%-20s %9zu bytes, %9llu stored %s\n", entry->name, size, entry->size, useCompressed ? "LZ4" : "raw");
+		allocFree(compressed);
+		allocFree(data);
+	}
+
+	fseek(file, sizeof(PackHeader), SEEK_SET);
+	fwrite(entries, sizeof(PackEntry), names.count, file);
+	const bool written = ferror(file) == 0;
+	fclose(file);
+	allocFree(entries);
+
+	if (!written) {
+		printf("Couldn't write '%s'\n", path);
+		return FALSE;
+	}
+	printf("Packed %u assets into '%s', %llu bytes down to %llu\n", names.count, path, originalTotal, storedTotal);
+	return TRUE;
+}
+
+void packReport(FILE* file) {
+	PackArchive* archive = &packArchive;
+	const long long archiveReads = atomicLoad64(&archive->archiveReads), looseReads = atomicLoad64(&archive->looseReads);
+
+	if (archiveReads + looseReads == 0) {
+		return;
+	}
+	fprintf(file, "Assets: %lld from the archive, %lld loose, %.2f MB read for %.2f MB, %.2f ms reading\n", archiveReads,
+		looseReads, atomicLoad64(&archive->storedBytes) / 1e6, atomicLoad64(&archive->decodedBytes) / 1e6,
+		atomicLoad64(&archive->readTime) / 1e6);
+}
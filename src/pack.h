@@ -0,0 +1,100 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "misc.h"
+#include "platform.h"
+#include "atomic.h"
+#include "alloc.h"
+
+/*
+ * <pack.c/pack.h> Reads assets out of a single archive instead of the loose files in the assets folder.
+ * An archive starts with a header and an index holding every entry's name, where its data is, how big it
+ * is stored and once decoded, how it's stored, and a hash of the decoded data. Entries are stored as they
+ * are or LZ4 compressed (the block format from https://github.com/lz4/lz4), whichever is smaller. The
+ * archive is mapped into memory when it's opened, and each entry is decoded straight from the mapping into
+ * the buffer it's read into, so reading one is a single copy or decode with no file calls at all
+ *
+ * Any asset that isn't in the archive, or every asset when there's no archive, is read from the assets
+ * folder instead, so the loose files can still be edited while developing. --pack writes an archive of
+ * everything in the assets folder. Reads are safe from any thread once the archive is open
+ */
+
+// Archive read at startup unless another is given with --archive
+#define PACK_DEFAULT_FILE "assets.pak"
+// First eight bytes of every archive, and the version of the format it's written in
+#define PACK_MAGIC "HELIPAK\x1A"
+#define PACK_VERSION 1
+// Longest name an entry can have, counting the terminating zero
+#define PACK_MAX_NAME 56
+// Most entries an archive is written with
+#define PACK_MAX_ENTRIES 256
+// Every entry's data starts at a multiple of this from the start of the archive
+#define PACK_ALIGNMENT 16
+// Number of bits of the hash of four bytes the LZ4 compressor looks earlier matches up with
+#define PACK_HASH_BITS 14
+
+typedef enum {
+	PACK_RAW = 0,	// Stored as it is
+	PACK_LZ4 = 1	// A single LZ4 block
+} PackCodec;
+
+// The start of an archive, all of whose numbers are little endian
+typedef struct PACKHEADER {
+	char magic[8];
+	unsigned int version;
+	unsigned int entryCount;
+} PackHeader;
+
+// One asset in an archive's index, which follows the header sorted by name
+typedef struct PACKENTRY {
+	char name[PACK_MAX_NAME];
+	unsigned long long offset;		// From the start of the archive
+	unsigned long long size;		// Bytes stored in the archive
+	unsigned long long originalSize;	// Bytes once decoded
+	unsigned long long hash;		// packHash of the decoded data
+	unsigned int codec;
+	unsigned int reserved;
+} PackEntry;
+
+typedef struct PACKARCHIVE {
+	unsigned char* data;			// The mapped archive, or NULL if none is open
+	size_t size;
+	PackEntry* entries;
+	unsigned int entryCount;
+
+	// What's been read, from any thread
+	volatile long long archiveReads;	// Assets read from the archive
+	volatile long long looseReads;		// Assets read from the assets folder
+	volatile long long storedBytes;		// Bytes read from the archive or the files
+	volatile long long decodedBytes;	// Bytes the assets came to
+	volatile long long readTime;		// Nanoseconds spent reading and decoding, added up over every thread
+} PackArchive;
+
+extern PackArchive packArchive;
+
+// Returns a 64 bit FNV-1a hash of some data, taken eight bytes at a time
+unsigned long long packHash(const unsigned char* data, size_t size);
+// Returns the most bytes packCompress can need for data of a size
+size_t packCompressBound(size_t size);
+// Compresses data into a single LZ4 block. Returns its size, or 0 if it doesn't fit in capacity bytes
+size_t packCompress(const unsigned char* source, size_t size, unsigned char* destination, size_t capacity);
+// Decodes an LZ4 block of a size into exactly originalSize bytes. Returns FALSE if the block is corrupt
+bool packDecompress(const unsigned char* source, size_t size, unsigned char* destination, size_t originalSize);
+
+// Maps an archive and checks its index. Returns FALSE if it can't be opened or isn't a valid archive, when
+// assets are read from the assets folder
+bool packOpen(char* path);
+// Unmaps the archive, if one is open
+void packClose(void);
+// Returns the entry for an asset in the open archive, or NULL if it isn't in there
+PackEntry* packFind(char* name);
+// Reads a whole asset from the archive, or the assets folder if it isn't in there, filling in its size.
+// The data is followed by a zero so text can be parsed in place. Returns memory counted against
+// ALLOC_LOADER that must be allocFree()'d, or NULL if the asset couldn't be read
+unsigned char* packRead(char* name, size_t* size);
+// Writes an archive of every file in the assets folder, LZ4 compressing the ones that get smaller if
+// compress is TRUE. Returns FALSE if it couldn't be written
+bool packCreate(char* path, bool compress);
+// Writes how many assets were read from where, and how long it took
+void packReport(FILE* file);
@@ -0,0 +1,148 @@
+#include "pass.h"
+
+void passBegin(PassScheduler* scheduler) {
+	scheduler->count = 0;
+}
+
+void passSubmit(PassScheduler* scheduler, PassType pass, GLfloat distance, PassDrawFunction draw, void* data, unsigned int index) {
+	if (scheduler->count == PASS_MAX_ITEMS) {
+		return;
+	}
+
+	scheduler->items[scheduler->count] = (PassItem) { draw, data, index, distance, pass, scheduler->count };
+	++scheduler->count;
+}
+
+// Orders items by pass, then nearest first for opaque items and furthest first for translucent ones.
+// Sky items, and any others at the same distance, keep the order they were submitted in
+int passCompareItems(const void* a, const void* b) {
+	const PassItem* itemA = a;
+	const PassItem* itemB = b;
+
+	if (itemA->pass != itemB->pass) {
+		return itemA->pass < itemB->pass ? -1 : 1;
+	}
+	if (itemA->pass == PASS_OPAQUE && itemA->distance != itemB->distance) {
+		return itemA->distance < itemB->distance ? -1 : 1;
+	}
+	if (itemA->pass == PASS_TRANSLUCENT && itemA->distance != itemB->distance) {
+		return itemA->distance > itemB->distance ? -1 : 1;
+	}
+
+	return itemA->order < itemB->order ? -1 : itemA->order > itemB->order ? 1 : 0;
+}
+
+// Draws every item in one pass, returning the index of the first item after it
+unsigned int passDrawRange(PassScheduler* scheduler, unsigned int start, PassType pass) {
+	unsigned int i = start;
+	for (; i < scheduler->count && scheduler->items[i].pass == pass; ++i) {
+		scheduler->items[i].draw(scheduler->items[i].data, scheduler->items[i].index);
+	}
+	return i;
+}
+
+void passExecute(PassScheduler* scheduler) {
+	// qsort isn't stable, but no two items compare equal since ties are broken by submission order
+	qsort(scheduler->items, scheduler->count, sizeof(PassItem), passCompareItems);
+
+	glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	glDisable(GL_BLEND);
+
+	if (scheduler->overdraw) {
+		// Count every fragment that passes the depth test, which is every fragment that gets written
+		glEnable(GL_STENCIL_TEST);
+		glStencilFunc(GL_ALWAYS, 0, 0xFF);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+	}
+
+	if (scheduler->depthPrepass) {
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		if (scheduler->overdraw) {
+			glDisable(GL_STENCIL_TEST);
+		}
+
+		passDrawRange(scheduler, 0, PASS_OPAQUE);
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		if (scheduler->overdraw) {
+			glEnable(GL_STENCIL_TEST);
+		}
+		glDepthFunc(GL_LEQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	unsigned int next = passDrawRange(scheduler, 0, PASS_OPAQUE);
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+	next = passDrawRange(scheduler, next, PASS_SKY);
+
+	glEnable(GL_BLEND);
+	glDepthMask(GL_FALSE);
+	passDrawRange(scheduler, next, PASS_TRANSLUCENT);
+
+	glPopAttrib();
+}
+
+void passDrawOverdraw(void) {
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT | GL_CURRENT_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_FOG);
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_STENCIL_TEST);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	gluOrtho2D(0, viewport[2], 0, viewport[3]);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	// Black where nothing was drawn, through blue and green to red at PASS_OVERDRAW_LEVELS and over
+	for (unsigned int level = 0; level <= PASS_OVERDRAW_LEVELS; ++level) {
+		const GLfloat heat = (GLfloat)level / PASS_OVERDRAW_LEVELS;
+		glStencilFunc(level == PASS_OVERDRAW_LEVELS ? GL_LEQUAL : GL_EQUAL, level, 0xFF);
+
+		if (level == 0) {
+			glColor3f(0, 0, 0);
+		} else {
+			glColor3f(fmin(fmax(heat * 2 - 1, 0), 1), 1 - fabs(heat * 2 - 1), fmin(fmax(1 - heat * 2, 0), 1));
+		}
+
+		glRecti(0, 0, viewport[2], viewport[3]);
+	}
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glPopAttrib();
+}
+
+GLfloat passReadOverdraw(unsigned int histogram[PASS_OVERDRAW_LEVELS + 1]) {
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	const unsigned int pixels = viewport[2] * viewport[3];
+	GLubyte* counts = frameAlloc(pixels);
+	unsigned long long total = 0;
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(viewport[0], viewport[1], viewport[2], viewport[3], GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, counts);
+
+	for (unsigned int level = 0; level <= PASS_OVERDRAW_LEVELS; ++level) {
+		histogram[level] = 0;
+	}
+	for (unsigned int i = 0; i < pixels; ++i) {
+		total += counts[i];
+		++histogram[counts[i] < PASS_OVERDRAW_LEVELS ? counts[i] : PASS_OVERDRAW_LEVELS];
+	}
+
+	return pixels > 0 ? (GLfloat)total / pixels : 0;
+}
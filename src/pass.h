@@ -0,0 +1,60 @@
+#pragma once
+#include <stdlib.h>
+#include <freeglut.h>
+#include "misc.h"
+#include "vecmath.h"
+#include "alloc.h"
+
+/*
+ * <pass.c/pass.h> Schedules the scene's draws into passes. Opaque things are drawn nearest first, so
+ * the depth test throws away as much hidden work as it can, then the sky fills in what's left, then
+ * anything blended is drawn furthest first over the top. Optionally the opaque things are drawn into
+ * the depth buffer on their own first, so every pixel is only shaded once
+ *
+ * In overdraw mode the stencil buffer counts the fragments written to each pixel, which is shown
+ * over the frame as a heatmap (this needs a stencil buffer in the window)
+ */
+
+// Most draws that can be submitted in a frame
+#define PASS_MAX_ITEMS 2048
+// Fragment count at which the overdraw heatmap is at its hottest colour
+#define PASS_OVERDRAW_LEVELS 8
+
+typedef enum {
+	PASS_OPAQUE = 0,	// Drawn nearest first, with blending off
+	PASS_SKY,			// Drawn after the opaque pass, in the order submitted
+	PASS_TRANSLUCENT,	// Drawn furthest first, with blending on and depth writes off
+	PASS_COUNT
+} PassType;
+
+// Draws one item, given the data and index it was submitted with
+typedef void (*PassDrawFunction)(void* data, unsigned int index);
+
+typedef struct PASSITEM {
+	PassDrawFunction draw;
+	void* data;
+	unsigned int index;
+	GLfloat distance;	// Distance from the camera that the item is sorted by
+	PassType pass;
+	unsigned int order;	// How many items were submitted before it this frame, which breaks ties in the sort
+} PassItem;
+
+typedef struct PASSSCHEDULER {
+	PassItem items[PASS_MAX_ITEMS];
+	unsigned int count;
+	bool depthPrepass;	// Whether the opaque items are drawn into the depth buffer on their own first
+	bool overdraw;		// Whether fragments are counted in the stencil buffer and shown as a heatmap
+} PassScheduler;
+
+// Clears the items submitted for the last frame
+void passBegin(PassScheduler* scheduler);
+// Submits an item to be drawn in a pass, at a distance from the camera
+void passSubmit(PassScheduler* scheduler, PassType pass, GLfloat distance, PassDrawFunction draw, void* data, unsigned int index);
+// Sorts and draws every submitted item. The colour, depth and (in overdraw mode) stencil buffers should
+// already be cleared, and the camera set up
+void passExecute(PassScheduler* scheduler);
+// Draws the overdraw heatmap over the frame from the stencil counts
+void passDrawOverdraw(void);
+// Reads the stencil counts back, returning the average number of fragments written per pixel
+// and filling in how many pixels had each count, up to PASS_OVERDRAW_LEVELS and over
+GLfloat passReadOverdraw(unsigned int histogram[PASS_OVERDRAW_LEVELS + 1]);
@@ -0,0 +1,272 @@
+#include "platform.h"
+
+unsigned long long platformNanoseconds(void) {
+#ifdef _WIN32
+	static LARGE_INTEGER frequency = { 0 };
+	LARGE_INTEGER counter;
+	if (frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	QueryPerformanceCounter(&counter);
+	// Split so the multiply can't overflow for any realistic uptime
+	return (counter.QuadPart / frequency.QuadPart) * 1000000000ULL
+		+ (counter.QuadPart % frequency.QuadPart) * 1000000000ULL / frequency.QuadPart;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec * 1000000000ULL + time.tv_nsec;
+#endif
+}
+
+#ifdef _WIN32
+// Waitable timer with sub-millisecond resolution, from Windows 10 1803. Not in older SDK headers
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+void platformSleepUntil(unsigned long long deadline) {
+#ifdef _WIN32
+	static HANDLE timer = NULL;
+	static BOOL timerCreated = FALSE;
+	const unsigned long long now = platformNanoseconds();
+
+	if (deadline <= now) {
+		return;
+	}
+	if (!timerCreated) {
+		timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		timerCreated = TRUE;
+	}
+
+	if (timer != NULL) {
+		// Negative due times are relative, in 100 nanosecond units
+		LARGE_INTEGER dueTime;
+		dueTime.QuadPart = -(LONGLONG)((deadline - now) / 100);
+		SetWaitableTimer(timer, &dueTime, 0, NULL, NULL, FALSE);
+		WaitForSingleObject(timer, INFINITE);
+	} else {
+		Sleep((DWORD)((deadline - now) / 1000000));
+	}
+#else
+	const struct timespec time = { deadline / 1000000000ULL, deadline % 1000000000ULL };
+	// Sleeping to an absolute time means a signal waking it early just sleeps again for what's left
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, NULL) == EINTR) {
+	}
+#endif
+}
+
+void* platformMapFile(const char* path, size_t* size) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER length;
+	if (file == INVALID_HANDLE_VALUE) {
+		return NULL;
+	}
+	if (!GetFileSizeEx(file, &length) || length.QuadPart == 0) {
+		CloseHandle(file);
+		return NULL;
+	}
+
+	// The view keeps the mapping and the file open after their handles are closed
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL) {
+		return NULL;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	*size = (size_t)length.QuadPart;
+	return data;
+#else
+	struct stat status;
+	const int file = open(path, O_RDONLY);
+	if (file < 0) {
+		return NULL;
+	}
+	if (fstat(file, &status) != 0 || status.st_size == 0) {
+		close(file);
+		return NULL;
+	}
+
+	void* data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+	*size = (size_t)status.st_size;
+	return data;
+#endif
+}
+
+void platformUnmapFile(void* data, size_t size) {
+	if (data == NULL) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+#else
+	munmap(data, size);
+#endif
+}
+
+int platformListFiles(const char* directory, PlatformFileCallback callback, void* data) {
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	char pattern[MAX_PATH];
+	sprintf_s(pattern, sizeof(pattern), "%s*", directory);
+
+	HANDLE search = FindFirstFileA(pattern, &found);
+	if (search == INVALID_HANDLE_VALUE) {
+		return FALSE;
+	}
+	do {
+		if (!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+			callback(data, found.cFileName);
+		}
+	} while (FindNextFileA(search, &found));
+	FindClose(search);
+	return TRUE;
+#else
+	DIR* folder = opendir(directory);
+	struct dirent* entry;
+	char path[4096];
+	if (folder == NULL) {
+		return FALSE;
+	}
+
+	while ((entry = readdir(folder)) != NULL) {
+		struct stat status;
+		snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+		if (stat(path, &status) == 0 && S_ISREG(status.st_mode)) {
+			callback(data, entry->d_name);
+		}
+	}
+	closedir(folder);
+	return TRUE;
+#endif
+}
+
+int platformEvictFile(const char* path) {
+#ifdef _WIN32
+	return FALSE;
+#else
+	const int file = open(path, O_RDONLY);
+	if (file < 0) {
+		return FALSE;
+	}
+	// Pages that haven't been written back yet can't be dropped, as for a file that's just been written
+	fdatasync(file);
+	const int evicted = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(file);
+	return evicted;
+#endif
+}
+
+int platformWatchFolder(PlatformWatcher* watcher, const char* directory) {
+	watcher->length = 0;
+	watcher->offset = 0;
+#ifdef _WIN32
+	watcher->reading = FALSE;
+	watcher->directory = CreateFileA(directory, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	if (watcher->directory == INVALID_HANDLE_VALUE) {
+		return FALSE;
+	}
+	ZeroMemory(&watcher->overlapped, sizeof(watcher->overlapped));
+	watcher->overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+	if (watcher->overlapped.hEvent == NULL) {
+		CloseHandle(watcher->directory);
+		return FALSE;
+	}
+	return TRUE;
+#else
+	watcher->descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watcher->descriptor < 0) {
+		return FALSE;
+	}
+	// Only files that whatever wrote them has closed, or that were renamed into place as editors that save
+	// to a temporary file do, are finished being written
+	if (inotify_add_watch(watcher->descriptor, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		close(watcher->descriptor);
+		return FALSE;
+	}
+	return TRUE;
+#endif
+}
+
+int platformNextChange(PlatformWatcher* watcher, char* name, size_t length, unsigned int timeout) {
+	for (;;) {
+#ifdef _WIN32
+		while (watcher->offset < watcher->length) {
+			const FILE_NOTIFY_INFORMATION* change = (const FILE_NOTIFY_INFORMATION*)((unsigned char*)watcher->buffer + watcher->offset);
+			watcher->offset = change->NextEntryOffset > 0 ? watcher->offset + change->NextEntryOffset : watcher->length;
+			if (change->Action == FILE_ACTION_REMOVED || change->Action == FILE_ACTION_RENAMED_OLD_NAME) {
+				continue;
+			}
+			const int written = WideCharToMultiByte(CP_UTF8, 0, change->FileName, (int)(change->FileNameLength / sizeof(WCHAR)),
+				name, (int)length - 1, NULL, NULL);
+			if (written > 0) {
+				name[written] = '\0';
+				return TRUE;
+			}
+		}
+
+		// Changes made while no read is queued are kept by the system until the next one
+		if (!watcher->reading) {
+			ResetEvent(watcher->overlapped.hEvent);
+			if (!ReadDirectoryChangesW(watcher->directory, watcher->buffer, sizeof(watcher->buffer), FALSE,
+				FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE, NULL, &watcher->overlapped, NULL)) {
+				return FALSE;
+			}
+			watcher->reading = TRUE;
+		}
+		if (WaitForSingleObject(watcher->overlapped.hEvent, timeout) != WAIT_OBJECT_0) {
+			return FALSE;
+		}
+
+		DWORD bytes = 0;
+		watcher->reading = FALSE;
+		if (!GetOverlappedResult(watcher->directory, &watcher->overlapped, &bytes, FALSE)) {
+			return FALSE;
+		}
+		watcher->length = bytes;
+		watcher->offset = 0;
+#else
+		while (watcher->offset < watcher->length) {
+			const struct inotify_event* change = (const struct inotify_event*)((unsigned char*)watcher->buffer + watcher->offset);
+			watcher->offset += sizeof(struct inotify_event) + change->len;
+			// Overflows have no name, and the queue has already dropped whatever they stand for
+			if (change->len > 0 && !(change->mask & IN_ISDIR)) {
+				snprintf(name, length, "%s", change->name);
+				return TRUE;
+			}
+		}
+
+		struct pollfd ready = { watcher->descriptor, POLLIN, 0 };
+		if (poll(&ready, 1, (int)timeout) <= 0) {
+			return FALSE;
+		}
+		const ssize_t bytes = read(watcher->descriptor, watcher->buffer, sizeof(watcher->buffer));
+		if (bytes <= 0) {
+			return FALSE;
+		}
+		watcher->length = (size_t)bytes;
+		watcher->offset = 0;
+#endif
+	}
+}
+
+void platformUnwatch(PlatformWatcher* watcher) {
+#ifdef _WIN32
+	CancelIo(watcher->directory);
+	if (watcher->reading) {
+		DWORD bytes;
+		GetOverlappedResult(watcher->directory, &watcher->overlapped, &bytes, TRUE);
+	}
+	CloseHandle(watcher->overlapped.hEvent);
+	CloseHandle(watcher->directory);
+#else
+	close(watcher->descriptor);
+#endif
+}
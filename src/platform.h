@@ -0,0 +1,82 @@
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
+
+/*
+ * <platform.c/platform.h> The few things that differ between Windows and everywhere else: a
+ * monotonic clock, sleeping until a point on it, mapping files into memory, listing folders and
+ * watching them for changes (inotify on Linux, ReadDirectoryChangesW on Windows), and the names MSVC gives the bounds checked C library functions the loader uses, so the program also
+ * builds with gcc or clang on Linux
+ */
+
+#ifndef _WIN32
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+#define sprintf_s(buffer, size, ...) snprintf(buffer, size, __VA_ARGS__)
+// Only %s and %c take a size in the _s version, and nothing reads either with it
+#define sscanf_s sscanf
+#define memcpy_s(destination, destinationSize, source, count) memcpy(destination, source, count)
+#define strtok_s strtok_r
+#define _countof(array) (sizeof(array) / sizeof((array)[0]))
+#endif
+
+// Returns the time in nanoseconds since some fixed point, which never goes backwards
+unsigned long long platformNanoseconds(void);
+// Sleeps until a time from platformNanoseconds. The sleep can run over by up to the scheduler's
+// granularity, which is around a millisecond on Windows and tens of microseconds on Linux
+void platformSleepUntil(unsigned long long deadline);
+
+// Size of the buffer a watcher reads a batch of changes into
+#define PLATFORM_WATCH_BUFFER_SIZE 4096
+
+// Called with the name of each file in a folder
+typedef void (*PlatformFileCallback)(void* data, const char* name);
+
+// Maps a whole file into memory read only, filling in its size. Returns NULL if it can't be opened or is empty
+void* platformMapFile(const char* path, size_t* size);
+// Unmaps a file mapped by platformMapFile
+void platformUnmapFile(void* data, size_t size);
+// Calls a function with the name of every file in a folder, skipping subfolders. Returns FALSE if it can't be read
+int platformListFiles(const char* directory, PlatformFileCallback callback, void* data);
+// Drops a file's pages from the operating system's cache, so the next read of it comes from the disk.
+// Returns FALSE where that isn't possible without special privileges, which is always on Windows
+int platformEvictFile(const char* path);
+
+// A folder being watched for files written into it
+typedef struct PLATFORMWATCHER {
+#ifdef _WIN32
+	HANDLE directory;
+	OVERLAPPED overlapped;
+	int reading;				// Whether a read of the next changes has been queued
+#else
+	int descriptor;				// The inotify instance
+#endif
+	// The last batch of changes read, and how far through it the next change is. Kept aligned for the records in it
+	unsigned long long buffer[PLATFORM_WATCH_BUFFER_SIZE / sizeof(unsigned long long)];
+	size_t length;
+	size_t offset;
+} PlatformWatcher;
+
+// Starts watching a folder for files that are written, or moved into it. Returns FALSE if it can't be watched
+int platformWatchFolder(PlatformWatcher* watcher, const char* directory);
+// Waits up to a number of milliseconds for a file in the watched folder to change, copying its name into a
+// buffer of a length. Returns FALSE if nothing changed in time. A file can be reported more than once for
+// one save, so callers should wait for the folder to go quiet before acting on it
+int platformNextChange(PlatformWatcher* watcher, char* name, size_t length, unsigned int timeout);
+// Stops watching a folder
+void platformUnwatch(PlatformWatcher* watcher);
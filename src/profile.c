@@ -0,0 +1,285 @@
+#include "profile.h"
+
+const char* profileScopeNames[PROFILE_SCOPE_COUNT] = {
+	"frame", "think", "helicopterThink", "collision", "display", "cull",
+	"helicopter", "trees", "ground", "sky", "water", "swap"
+};
+
+// Whether each scope is drawing, and so is timed on the GPU as well
+const bool profileGpuScopes[PROFILE_SCOPE_COUNT] = {
+	FALSE, FALSE, FALSE, FALSE, FALSE, FALSE,
+	TRUE, TRUE, TRUE, TRUE, TRUE, FALSE
+};
+
+// Whether each scope is timed on the thread with the OpenGL context, rather than the simulation thread
+const bool profileRenderScopes[PROFILE_SCOPE_COUNT] = {
+	TRUE, FALSE, FALSE, FALSE, TRUE, TRUE,
+	TRUE, TRUE, TRUE, TRUE, TRUE, TRUE
+};
+
+typedef struct PROFILER {
+	bool enabled, overlay, gpu;
+	FILE* csvFile, * jsonFile;
+	unsigned long long frameNumber;
+	unsigned long long lastFrameEnd;
+	unsigned long long starts[PROFILE_SCOPE_COUNT];	// Only touched by the thread timing each scope
+	volatile long long pending[PROFILE_SCOPE_COUNT];	// CPU time added up since the last frame ended
+	// Frames waiting on their timer queries, indexed by frame number modulo PROFILE_LATENCY
+	ProfileFrame frames[PROFILE_LATENCY];
+	GLuint queries[PROFILE_LATENCY][PROFILE_MAX_QUERIES];
+	ProfileScope queryScopes[PROFILE_LATENCY][PROFILE_MAX_QUERIES];
+	unsigned int queryCounts[PROFILE_LATENCY];
+	ProfileScope gpuScope; // Scope the open timer query is for, or PROFILE_NONE
+	// Reported frames, for the overlay
+	ProfileFrame history[PROFILE_HISTORY];
+	unsigned int historyCount, historyNext;
+} Profiler;
+
+Profiler profiler = { FALSE };
+
+void profileStart(bool overlay, FILE* csvFile, FILE* jsonFile) {
+	memset(&profiler, 0, sizeof(Profiler));
+	profiler.enabled = TRUE;
+	profiler.overlay = overlay;
+	profiler.csvFile = csvFile;
+	profiler.jsonFile = jsonFile;
+	profiler.gpu = glprocHasTimerQueries();
+	profiler.gpuScope = PROFILE_NONE;
+	profiler.lastFrameEnd = platformNanoseconds();
+
+	if (profiler.gpu) {
+		for (unsigned int i = 0; i < PROFILE_LATENCY; ++i) {
+			glprocGenQueries(PROFILE_MAX_QUERIES, profiler.queries[i]);
+		}
+	}
+
+	if (csvFile != NULL) {
+		fprintf(csvFile, "frame");
+		for (unsigned int scope = 0; scope < PROFILE_SCOPE_COUNT; ++scope) {
+			fprintf(csvFile, ",%s_cpu_ms", profileScopeNames[scope]);
+		}
+		for (unsigned int scope = 0; scope < PROFILE_SCOPE_COUNT; ++scope) {
+			if (profileGpuScopes[scope]) {
+				fprintf(csvFile, ",%s_gpu_ms", profileScopeNames[scope]);
+			}
+		}
+		fprintf(csvFile, "\n");
+	}
+}
+
+bool profileEnabled(void) {
+	return profiler.enabled;
+}
+
+// Ends the open timer query and starts one for a new scope, unless the scope's query is already open.
+// Consecutive draws in the same scope, like the trees, so share one query
+void profileSwitchQuery(ProfileScope scope) {
+	const unsigned int set = profiler.frameNumber % PROFILE_LATENCY;
+
+	if (!profiler.gpu || profiler.gpuScope == scope) {
+		return;
+	}
+	if (profiler.gpuScope != PROFILE_NONE) {
+		glprocEndQuery(GL_TIME_ELAPSED);
+		profiler.gpuScope = PROFILE_NONE;
+	}
+	if (scope != PROFILE_NONE && profiler.queryCounts[set] < PROFILE_MAX_QUERIES) {
+		const unsigned int index = profiler.queryCounts[set]++;
+		profiler.queryScopes[set][index] = scope;
+		glprocBeginQuery(GL_TIME_ELAPSED, profiler.queries[set][index]);
+		profiler.gpuScope = scope;
+	}
+}
+
+void profileBegin(ProfileScope scope) {
+	if (!profiler.enabled) {
+		return;
+	}
+
+	// Anything else starting on the render thread closes the open query, so the GPU time of a draw scope
+	// only covers its own draws
+	if (profileRenderScopes[scope]) {
+		profileSwitchQuery(profileGpuScopes[scope] ? scope : PROFILE_NONE);
+	}
+	profiler.starts[scope] = platformNanoseconds();
+}
+
+void profileEnd(ProfileScope scope) {
+	if (!profiler.enabled) {
+		return;
+	}
+
+	atomicAdd64(&profiler.pending[scope], platformNanoseconds() - profiler.starts[scope]);
+}
+
+// Writes one frame to the files and adds it to the history
+void profileReport(ProfileFrame* frame) {
+	if (profiler.csvFile != NULL) {
+		fprintf(profiler.csvFile, "%llu", frame->number);
+		for (unsigned int scope = 0; scope < PROFILE_SCOPE_COUNT; ++scope) {
+			fprintf(profiler.csvFile, ",%.4f", frame->cpu[scope] / 1e6);
+		}
+		for (unsigned int scope = 0; scope < PROFILE_SCOPE_COUNT; ++scope) {
+			if (!profileGpuScopes[scope]) {
+				continue;
+			}
+			if (profiler.gpu) {
+				fprintf(profiler.csvFile, ",%.4f", frame->gpu[scope] / 1e6);
+			} else {
+				fprintf(profiler.csvFile, ",");
+			}
+		}
+		fprintf(profiler.csvFile, "\n");
+	}
+
+	// One object per line, so a run that's cut short still leaves every line it wrote readable
+	if (profiler.jsonFile != NULL) {
+		fprintf(profiler.jsonFile, "{\"frame\":%llu,\"cpu_ms\":{", frame->number);
+		for (unsigned int scope = 0; scope < PROFILE_SCOPE_COUNT; ++scope) {
+			fprintf(profiler.jsonFile, "%s\"%s\":%.4f", scope > 0 ? "," : "", profileScopeNames[scope], frame->cpu[scope] / 1e6);
+		}
+		fprintf(profiler.jsonFile, "}");
+		if (profiler.gpu) {
+			bool first = TRUE;
+			fprintf(profiler.jsonFile, ",\"gpu_ms\":{");
+			for (unsigned int scope = 0; scope < PROFILE_SCOPE_COUNT; ++scope) {
+				if (profileGpuScopes[scope]) {
+					fprintf(profiler.jsonFile, "%s\"%s\":%.4f", first ? "" : ",", profileScopeNames[scope], frame->gpu[scope] / 1e6);
+					first = FALSE;
+				}
+			}
+			fprintf(profiler.jsonFile, "}");
+		}
+		fprintf(profiler.jsonFile, "}\n");
+	}
+
+	profiler.history[profiler.historyNext] = *frame;
+	profiler.historyNext = (profiler.historyNext + 1) % PROFILE_HISTORY;
+	if (profiler.historyCount < PROFILE_HISTORY) {
+		++profiler.historyCount;
+	}
+}
+
+// Reads back one set of timer queries into its frame, waiting for any that haven't finished, then reports it
+void profileCollect(unsigned int set) {
+	ProfileFrame* frame = &profiler.frames[set];
+
+	for (unsigned int i = 0; i < profiler.queryCounts[set]; ++i) {
+		unsigned long long elapsed = 0;
+		glprocGetQueryObjectui64v(profiler.queries[set][i], GL_QUERY_RESULT, &elapsed);
+		frame->gpu[profiler.queryScopes[set][i]] += elapsed;
+	}
+
+	profileReport(frame);
+	profiler.queryCounts[set] = 0;
+}
+
+void profileFrameEnd(void) {
+	if (!profiler.enabled) {
+		return;
+	}
+
+	profileSwitchQuery(PROFILE_NONE);
+
+	ProfileFrame* frame = &profiler.frames[profiler.frameNumber % PROFILE_LATENCY];
+	for (unsigned int scope = 0; scope < PROFILE_SCOPE_COUNT; ++scope) {
+		frame->cpu[scope] = atomicExchange64(&profiler.pending[scope], 0);
+	}
+
+	const unsigned long long now = platformNanoseconds();
+	frame->cpu[PROFILE_FRAME] = now - profiler.lastFrameEnd;
+	profiler.lastFrameEnd = now;
+	++profiler.frameNumber;
+
+	// The set the next frame will use belongs to the oldest frame still waiting, so that frame is done with
+	const unsigned int set = profiler.frameNumber % PROFILE_LATENCY;
+	if (profiler.frameNumber >= PROFILE_LATENCY) {
+		profileCollect(set);
+	}
+
+	memset(&profiler.frames[set], 0, sizeof(ProfileFrame));
+	profiler.frames[set].number = profiler.frameNumber;
+}
+
+int profileCompareTimes(const void* a, const void* b) {
+	const unsigned long long timeA = *(const unsigned long long*)a, timeB = *(const unsigned long long*)b;
+	return timeA < timeB ? -1 : timeA > timeB ? 1 : 0;
+}
+
+// Fills in the average and 99th percentile in milliseconds of a scope's CPU or GPU times over the history
+void profileStatistics(ProfileScope scope, bool gpu, double* average, double* percentile) {
+	unsigned long long times[PROFILE_HISTORY];
+	unsigned long long total = 0;
+
+	for (unsigned int i = 0; i < profiler.historyCount; ++i) {
+		times[i] = gpu ? profiler.history[i].gpu[scope] : profiler.history[i].cpu[scope];
+		total += times[i];
+	}
+	qsort(times, profiler.historyCount, sizeof(unsigned long long), profileCompareTimes);
+
+	// Nearest rank, so the 99th percentile of a full history is its second slowest frame
+	const unsigned int rank = (profiler.historyCount * 99 + 99) / 100;
+	*average = total / 1e6 / profiler.historyCount;
+	*percentile = times[rank - 1] / 1e6;
+}
+
+void profileDrawOverlay(void) {
+	char text[128];
+
+	if (!profiler.enabled || !profiler.overlay || profiler.historyCount == 0) {
+		return;
+	}
+
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_FOG);
+	glColor3f(1, 1, 1);
+
+	snprintf(text, sizeof(text), "Milliseconds over %u frames, average / 99th percentile", profiler.historyCount);
+	drawText(text, (Vec2) { windowWidth - 520, windowHeight - 30 });
+
+	for (unsigned int scope = 0; scope < PROFILE_SCOPE_COUNT; ++scope) {
+		double cpuAverage, cpuPercentile;
+		profileStatistics(scope, FALSE, &cpuAverage, &cpuPercentile);
+
+		int length = snprintf(text, sizeof(text), "%s: cpu %.2f / %.2f", profileScopeNames[scope], cpuAverage, cpuPercentile);
+		if (profiler.gpu && profileGpuScopes[scope]) {
+			double gpuAverage, gpuPercentile;
+			profileStatistics(scope, TRUE, &gpuAverage, &gpuPercentile);
+			snprintf(text + length, sizeof(text) - length, ", gpu %.2f / %.2f", gpuAverage, gpuPercentile);
+		}
+
+		drawText(text, (Vec2) { windowWidth - 520, windowHeight - 56 - 22 * scope });
+	}
+
+	glPopAttrib();
+}
+
+void profileStop(void) {
+	if (!profiler.enabled) {
+		return;
+	}
+
+	// Every frame before the current one is still waiting on its queries. The current one never ended
+	const unsigned long long first = profiler.frameNumber >= PROFILE_LATENCY - 1 ? profiler.frameNumber - (PROFILE_LATENCY - 1) : 0;
+	profileSwitchQuery(PROFILE_NONE);
+	for (unsigned long long number = first; number < profiler.frameNumber; ++number) {
+		profileCollect(number % PROFILE_LATENCY);
+	}
+
+	if (profiler.gpu) {
+		for (unsigned int i = 0; i < PROFILE_LATENCY; ++i) {
+			glprocDeleteQueries(PROFILE_MAX_QUERIES, profiler.queries[i]);
+		}
+	}
+	if (profiler.csvFile != NULL) {
+		fclose(profiler.csvFile);
+	}
+	if (profiler.jsonFile != NULL) {
+		fclose(profiler.jsonFile);
+	}
+
+	profiler.enabled = FALSE;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freeglut.h>
+#include "misc.h"
+#include "glproc.h"
+#include "atomic.h"
+
+/*
+ * <profile.c/profile.h> Per frame timing of the main loop. Scopes are timed on the CPU with a
+ * monotonic nanosecond clock, and the drawing scopes are also timed on the GPU with timer queries
+ * where the driver supports them. The last PROFILE_HISTORY frames are kept for averages and the 99th
+ * percentile, which can be drawn over the scene, and every frame can be written out as CSV or JSON
+ *
+ * GPU results only come back a few frames later, so each frame is reported once its queries are
+ * read, PROFILE_LATENCY - 1 frames after it was drawn. Each scope should only ever be timed by one thread:
+ * the simulation's scopes by the simulation thread, and the rest by the thread drawing
+ */
+
+// Number of frames the rolling averages and percentiles are taken over
+#define PROFILE_HISTORY 120
+// Number of frames of timer queries in flight before the oldest are read back
+#define PROFILE_LATENCY 4
+// Most timer queries started in a frame. Neighbouring draws in the same scope share a query
+#define PROFILE_MAX_QUERIES 256
+
+typedef enum {
+	PROFILE_FRAME = 0,			// Time from the end of one frame to the end of the next
+	PROFILE_THINK,				// The whole of think()
+	PROFILE_HELICOPTER_THINK,	// The player's helicopterThink()
+	PROFILE_COLLISION,			// The player's collision sweeps and slides
+	PROFILE_DISPLAY,			// The whole of display(), without the buffer swap
+	PROFILE_CULL,				// Culling the trees and building their draw lists
+	PROFILE_HELICOPTER,			// Drawing the helicopter and the swarm
+	PROFILE_TREES,				// Drawing the trees
+	PROFILE_GROUND,				// Drawing the ground, pond, or terrain
+	PROFILE_SKY,				// Drawing the sky
+	PROFILE_WATER,				// Drawing the water
+	PROFILE_SWAP,				// glutSwapBuffers()
+	PROFILE_SCOPE_COUNT,
+	PROFILE_NONE = PROFILE_SCOPE_COUNT
+} ProfileScope;
+
+// Times of every scope in one frame, in nanoseconds
+typedef struct PROFILEFRAME {
+	unsigned long long number;
+	unsigned long long cpu[PROFILE_SCOPE_COUNT];
+	unsigned long long gpu[PROFILE_SCOPE_COUNT];
+} ProfileFrame;
+
+// Turns the profiler on, which must be done after the window is created. The overlay is drawn by
+// profileDrawOverlay if it's set, and each frame is written to whichever of the files aren't NULL
+void profileStart(bool overlay, FILE* csvFile, FILE* jsonFile);
+// Returns whether the profiler has been started
+bool profileEnabled(void);
+// Starts timing a scope. Time in the same scope adds up until the frame ends
+void profileBegin(ProfileScope scope);
+// Stops timing a scope
+void profileEnd(ProfileScope scope);
+// Ends the frame, reading back the timer queries from PROFILE_LATENCY - 1 frames ago and reporting that frame
+void profileFrameEnd(void);
+// Draws the average and 99th percentile times of every scope over the last PROFILE_HISTORY frames
+void profileDrawOverlay(void);
+// Reports the frames still waiting on their timer queries, closes the files, and turns the profiler off
+void profileStop(void);
@@ -0,0 +1,282 @@
+#include "reload.h"
+
+Reloader reloader;
+
+// Registers an asset, returning NULL if there's no room for it
+ReloadAsset* reloadAdd(char* fileName, ReloadKind kind, ReloadCallback callback, void* data) {
+	if (reloader.assetCount == RELOAD_MAX_ASSETS) {
+		printf("More than %d assets are registered to reload, '%s' won't be\n", RELOAD_MAX_ASSETS, fileName);
+		return NULL;
+	}
+	ReloadAsset* asset = &reloader.assets[reloader.assetCount++];
+	memset(asset, 0, sizeof(ReloadAsset));
+	asset->fileName = fileName;
+	asset->kind = kind;
+	asset->callback = callback;
+	asset->callbackData = data;
+	return asset;
+}
+
+void reloadAddMesh(char* fileName, VertexBuffer** buffer, VertexFormat format, ReloadCallback callback, void* data) {
+	ReloadAsset* asset = reloadAdd(fileName, RELOAD_MESH, callback, data);
+	if (asset != NULL) {
+		asset->buffer = buffer;
+		asset->format = format;
+	}
+}
+
+void reloadAddTexture(char* fileName, GLuint* texture, ReloadCallback callback, void* data) {
+	ReloadAsset* asset = reloadAdd(fileName, RELOAD_TEXTURE, callback, data);
+	if (asset != NULL) {
+		asset->texture = texture;
+	}
+}
+
+// Returns the registered asset with a file name, or NULL if there isn't one
+ReloadAsset* reloadFind(const char* fileName) {
+	for (unsigned int i = 0; i < reloader.assetCount; ++i) {
+		if (!strcmp(reloader.assets[i].fileName, fileName)) {
+			return &reloader.assets[i];
+		}
+	}
+	return NULL;
+}
+
+// Returns whether every face of a mesh object only uses vertices, texture coordinates and normals it has.
+// The files the scene starts with are trusted, but one being edited can be caught half written
+bool reloadCheckMesh(MeshObject* object) {
+	for (int i = 0; i < object->faceCount; ++i) {
+		const MeshObjectFace* face = &object->faces[i];
+		for (int j = 0; j < face->pointCount; ++j) {
+			const MeshObjectFacePoint* point = &face->points[j];
+			if (point->vertexIndex < 0 || point->vertexIndex >= object->vertexCount
+				|| point->texCoordIndex >= object->texCoordCount || point->normalIndex >= object->normalCount) {
+				return FALSE;
+			}
+		}
+	}
+	return object->faceCount > 0;
+}
+
+// Job function, parses a changed asset and hands it to the GL thread
+void reloadParseJob(void* data, unsigned int begin, unsigned int end) {
+	ReloadAsset* asset = data;
+	const unsigned long long start = platformNanoseconds();
+	bool parsed = FALSE;
+
+	if (asset->kind == RELOAD_MESH) {
+		MeshObject* object = loadMeshObject(asset->fileName);
+		if (object != NULL && reloadCheckMesh(object)) {
+			asset->mesh = meshCreate(object);
+			meshOptimize(asset->mesh);
+			parsed = TRUE;
+		}
+		freeMeshObject(object);
+	} else {
+		asset->pixels = loadPPMPixels(asset->fileName, &asset->width, &asset->height);
+		parsed = asset->pixels != NULL;
+	}
+
+	asset->parseNanoseconds = platformNanoseconds() - start;
+	// Publishing the state also publishes what was parsed before it
+	atomicStore(&asset->state, parsed ? RELOAD_READY : RELOAD_FAILED);
+}
+
+// Parses every asset that's changed and isn't still waiting to be swapped in, and waits for them. Returns
+// whether any are left to parse once the ones waiting have been swapped in. The parses are worker jobs, so
+// the GL and simulation threads can't pick one up while they wait on their own jobs and stall a frame on it
+bool reloadParseChanged(Reloader* reload) {
+	Job* parsing = jobCreate(NULL, NULL, NULL);
+	bool waiting = FALSE;
+
+	jobRequireWorker(parsing);
+
+	for (unsigned int i = 0; i < reload->assetCount; ++i) {
+		ReloadAsset* asset = &reload->assets[i];
+		if (!asset->changed) {
+			continue;
+		}
+		if (atomicLoad(&asset->state) != RELOAD_IDLE) {
+			waiting = TRUE;
+			continue;
+		}
+
+		asset->changed = FALSE;
+		asset->changeTime = asset->seenTime;
+		asset->parseFrame = 0;
+		atomicStore(&asset->state, RELOAD_PARSING);
+
+		Job* job = jobCreate(reloadParseJob, asset, parsing);
+		jobRequireWorker(job);
+		jobSubmit(job);
+	}
+
+	jobSubmit(parsing);
+	jobWait(parsing);
+	return waiting;
+}
+
+// Returns whether a file is still in the assets folder
+bool reloadFileExists(char* fileName) {
+	char* path = generatePath(fileName);
+	FILE* file = fopen(path, "rb");
+	allocFree(path);
+	if (file != NULL) {
+		fclose(file);
+	}
+	return file != NULL;
+}
+
+// Thread function, waits for the registered assets to change and parses them once the folder's gone quiet
+void reloadWatch(void* data) {
+	Reloader* reload = &reloader;
+	char name[RELOAD_MAX_NAME];
+	char ignored[RELOAD_MAX_NAME] = "";
+	bool waiting = FALSE;
+
+	while (atomicLoad(&reload->running)) {
+		if (platformNextChange(&reload->watcher, name, sizeof(name), waiting || ignored[0] != '\0' ? RELOAD_SETTLE_TIME : RELOAD_POLL_TIME)) {
+			ReloadAsset* asset = reloadFind(name);
+			if (asset != NULL) {
+				if (!asset->changed) {
+					asset->seenTime = platformNanoseconds();
+					asset->changed = TRUE;
+				}
+				waiting = TRUE;
+			} else if (name[0] != '.' && name[strlen(name) - 1] != '~') {
+				// Editors' hidden and backup files aren't worth mentioning
+				strcpy(ignored, name);
+			}
+			continue;
+		}
+
+		// Editors that save to a temporary file and rename it have moved it away by the time it's quiet
+		if (ignored[0] != '\0' && reloadFileExists(ignored)) {
+			printf("'%s' changed, but it's only loaded at startup\n", ignored);
+		}
+		ignored[0] = '\0';
+		if (waiting) {
+			waiting = reloadParseChanged(reload);
+		}
+	}
+}
+
+bool reloadStart(const char* directory) {
+	Reloader* reload = &reloader;
+
+	if (!platformWatchFolder(&reload->watcher, directory)) {
+		printf("Couldn't watch '%s', the assets won't be reloaded when they change\n", directory);
+		return FALSE;
+	}
+	printf("Watching '%s' for changes to %u assets\n", directory, reload->assetCount);
+
+	reload->lastFrameTime = 0;
+	reload->averageFrame = 0;
+	atomicStore(&reload->running, TRUE);
+	reload->thread = threadStart(reloadWatch, NULL);
+	return TRUE;
+}
+
+// Puts a parsed asset in place of the one it replaces, and frees the old one. What was parsed is only
+// freed after the callback, which can build from it too
+void reloadSwap(ReloadAsset* asset) {
+	if (asset->kind == RELOAD_MESH) {
+		VertexBuffer* old = *asset->buffer;
+		*asset->buffer = meshCreateBuffer(asset->mesh, asset->format);
+		vertexBufferFree(old);
+	} else {
+		GLuint old = *asset->texture;
+		*asset->texture = createTexture(asset->pixels, asset->width, asset->height);
+		glDeleteTextures(1, &old);
+	}
+
+	if (asset->callback != NULL) {
+		asset->callback(asset->callbackData, asset);
+	}
+
+	meshFree(asset->mesh);
+	allocFree(asset->pixels);
+	asset->mesh = NULL;
+	asset->pixels = NULL;
+}
+
+void reloadApply(void) {
+	Reloader* reload = &reloader;
+	const unsigned long long now = platformNanoseconds();
+
+	// The time since the last call is the frame the last swaps were made on, which is only logged once it's over
+	if (reload->lastFrameTime != 0) {
+		const double frame = (now - reload->lastFrameTime) / 1e6;
+		bool swapped = FALSE;
+
+		for (unsigned int i = 0; i < reload->assetCount; ++i) {
+			ReloadAsset* asset = &reload->assets[i];
+			if (asset->logging) {
+				printf("Reloaded '%s' %.1f ms after it changed, parsed in %.2f ms with frames of up to %.2f ms meanwhile, and "
+					"swapped in %.2f ms on a %.2f ms frame, against %.2f ms on average\n", asset->fileName, asset->latency,
+					asset->parseTime, asset->parseFrame, asset->swapTime, frame, reload->averageFrame);
+				asset->logging = FALSE;
+				swapped = TRUE;
+			}
+		}
+
+		// The frame just timed ran alongside the parses of anything parsing or parsed now
+		for (unsigned int i = 0; i < reload->assetCount; ++i) {
+			ReloadAsset* asset = &reload->assets[i];
+			const int state = atomicLoad(&asset->state);
+			if ((state == RELOAD_PARSING || state == RELOAD_READY) && frame > asset->parseFrame) {
+				asset->parseFrame = frame;
+			}
+		}
+
+		// Frames with swaps in them would skew the average they're compared against
+		if (!swapped) {
+			reload->averageFrame += (frame - reload->averageFrame) * (reload->averageFrame > 0 ? RELOAD_FRAME_SMOOTHING : 1);
+		}
+	}
+	reload->lastFrameTime = now;
+
+	for (unsigned int i = 0; i < reload->assetCount; ++i) {
+		ReloadAsset* asset = &reload->assets[i];
+		const int state = atomicLoad(&asset->state);
+
+		if (state == RELOAD_FAILED) {
+			printf("'%s' couldn't be parsed, keeping the one already loaded\n", asset->fileName);
+			++reload->failures;
+			atomicStore(&asset->state, RELOAD_IDLE);
+		} else if (state == RELOAD_READY) {
+			const unsigned long long start = platformNanoseconds();
+			reloadSwap(asset);
+			const unsigned long long end = platformNanoseconds();
+
+			asset->latency = (end - asset->changeTime) / 1e6;
+			asset->parseTime = asset->parseNanoseconds / 1e6;
+			asset->swapTime = (end - start) / 1e6;
+			asset->logging = TRUE;
+			++reload->reloads;
+			// The watcher can parse it again from here, so nothing it writes can be read after this
+			atomicStore(&asset->state, RELOAD_IDLE);
+		}
+	}
+}
+
+void reloadStop(void) {
+	Reloader* reload = &reloader;
+
+	if (!atomicLoad(&reload->running)) {
+		return;
+	}
+	atomicStore(&reload->running, FALSE);
+	threadJoin(reload->thread);
+	platformUnwatch(&reload->watcher);
+
+	for (unsigned int i = 0; i < reload->assetCount; ++i) {
+		ReloadAsset* asset = &reload->assets[i];
+		meshFree(asset->mesh);
+		allocFree(asset->pixels);
+		asset->mesh = NULL;
+		asset->pixels = NULL;
+		asset->state = RELOAD_IDLE;
+	}
+	printf("%u assets reloaded, %u couldn't be parsed\n", reload->reloads, reload->failures);
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freeglut.h>
+#include "misc.h"
+#include "platform.h"
+#include "atomic.h"
+#include "thread.h"
+#include "job.h"
+#include "loader.h"
+#include "buffer.h"
+#include "mesh.h"
+#include "alloc.h"
+
+/*
+ * <reload.c/reload.h> Hot reloading of the meshes and textures the scene draws, with --hot-reload. A thread
+ * watches the assets folder, and once it's gone quiet after a file the scene registered was written, only
+ * that asset is parsed again, as a worker job on the scheduler so the GL and simulation threads never run
+ * or wait on it. At the next frame boundary the GL thread creates the new vertex buffer or texture, swaps
+ * it in where the scene keeps it and frees the old one, which nothing can be drawing from between frames,
+ * then calls back whoever registered it to rebuild anything made from it, like a tree's display list, from
+ * what was parsed rather than reading the file again. A file that doesn't parse keeps the asset it had
+ *
+ * Each reload is logged with the time from the watcher seeing the change to the asset being swapped in, how
+ * long parsing and swapping took, the longest frame drawn while it was parsing, and how long the frame it
+ * was swapped in on took against the frames before
+ *
+ * Only the loose files are watched, so every asset is read from the assets folder while it's on
+ */
+
+// Most assets that can be registered
+#define RELOAD_MAX_ASSETS 16
+// Longest file name that's watched for, counting the terminating zero
+#define RELOAD_MAX_NAME 256
+// Milliseconds the folder has to be quiet before the changed files are parsed, since one save can be
+// several writes, or a write then a rename
+#define RELOAD_SETTLE_TIME 50
+// Milliseconds the watcher waits for a change before checking whether it's been stopped
+#define RELOAD_POLL_TIME 100
+// Weight of each frame in the running average of frame times that swaps are compared against
+#define RELOAD_FRAME_SMOOTHING 0.05
+
+typedef enum {
+	RELOAD_MESH,
+	RELOAD_TEXTURE
+} ReloadKind;
+
+// Where a registered asset is, which also says which thread may touch what it's parsed into
+typedef enum {
+	RELOAD_IDLE = 0,	// Nothing waiting
+	RELOAD_PARSING,		// Being parsed on a worker thread
+	RELOAD_READY,		// Parsed, waiting for the GL thread to swap it in
+	RELOAD_FAILED		// Didn't parse, waiting for the GL thread to say so
+} ReloadState;
+
+struct RELOADASSET;
+
+// Called on the GL thread after an asset's been swapped in, with the data it was registered with and the
+// asset, whose parsed mesh or pixels are still there to build anything else from until it returns
+typedef void (*ReloadCallback)(void* data, struct RELOADASSET* asset);
+
+typedef struct RELOADASSET {
+	char* fileName;
+	ReloadKind kind;
+	VertexBuffer** buffer;			// Where a mesh's vertex buffer is kept
+	VertexFormat format;
+	GLuint* texture;				// Where a texture's name is kept
+	ReloadCallback callback;
+	void* callbackData;
+
+	volatile int state;				// ReloadState, handed between the watcher and the GL thread
+	bool changed;					// Written since it was last parsed, only touched by the watcher
+	unsigned long long seenTime;	// When the watcher saw the first write since it was last parsed
+	unsigned long long changeTime;	// The seenTime of the change being parsed or swapped in
+	unsigned long long parseNanoseconds;
+	Mesh* mesh;						// What it was parsed into
+	GLubyte* pixels;
+	int width, height;
+
+	// Kept by the GL thread until the frame it was swapped in on has been timed, all in milliseconds
+	bool logging;
+	double latency;					// From the change being seen to the swap finishing
+	double parseTime;
+	double parseFrame;				// Longest frame drawn while it was being parsed, reset by the watcher before it's parsed
+	double swapTime;				// Spent swapping it in on the GL thread
+} ReloadAsset;
+
+typedef struct RELOADER {
+	ReloadAsset assets[RELOAD_MAX_ASSETS];
+	unsigned int assetCount;
+	PlatformWatcher watcher;
+	Thread thread;
+	volatile int running;
+
+	// Kept by the GL thread
+	unsigned long long lastFrameTime;	// When reloadApply was last called
+	double averageFrame;				// Running average of the time between calls, in milliseconds
+	unsigned int reloads;
+	unsigned int failures;
+} Reloader;
+
+extern Reloader reloader;
+
+// Registers a mesh to reload into a vertex buffer in the given format, stored in *buffer. The callback, if
+// there is one, is called with data once it's been swapped in. Has to be called before reloadStart
+void reloadAddMesh(char* fileName, VertexBuffer** buffer, VertexFormat format, ReloadCallback callback, void* data);
+// Registers a texture to reload, its name stored in *texture. Has to be called before reloadStart
+void reloadAddTexture(char* fileName, GLuint* texture, ReloadCallback callback, void* data);
+// Starts watching a folder for changes to the registered assets. Returns FALSE if it can't be watched
+bool reloadStart(const char* directory);
+// Swaps in every asset that's been parsed since the last call, freeing the ones they replace, and logs
+// the ones swapped in on the frame before. Only the GL thread can call this, between frames
+void reloadApply(void);
+// Stops watching, and frees anything parsed that was never swapped in. Has to be called before jobShutdown
+void reloadStop(void);
@@ -0,0 +1,418 @@
+#include "render.h"
+
+// Starts every shader, after the version and the number of lights have been defined. Lights a point the
+// way OpenGL 1.1 does with local lights, a non-local viewer and GL_NORMALIZE on, so the picture matches
+// the fixed function backend
+const char* renderCommonSource =
+	"#define MAX_LIGHTS " RENDER_STRING(RENDER_MAX_LIGHTS) "\n"
+	"layout(std140) uniform Frame {\n"
+	"	mat4 projection;\n"
+	"	vec4 lightPositions[MAX_LIGHTS];\n"
+	"	vec4 lightAmbient[MAX_LIGHTS];\n"
+	"	vec4 lightDiffuse[MAX_LIGHTS];\n"
+	"	vec4 lightSpecular[MAX_LIGHTS];\n"
+	"	vec4 lightAttenuation[MAX_LIGHTS];\n"
+	"	vec4 sceneAmbient;\n"
+	"	vec4 fogColour;\n"
+	"	vec4 fogDensity;\n"
+	"};\n"
+	"vec3 lightPoint(vec3 position, vec3 normal, vec4 ambient, vec4 diffuse, vec4 specular, vec4 emission, float shininess) {\n"
+	"	vec3 lit = emission.rgb + ambient.rgb * sceneAmbient.rgb;\n"
+	"	for (int i = 0; i < LIGHT_COUNT; ++i) {\n"
+	"		vec3 toLight = lightPositions[i].xyz - position * lightPositions[i].w;\n"
+	"		float distance = length(toLight);\n"
+	"		toLight /= distance;\n"
+	"		float attenuation = lightPositions[i].w == 0.0 ? 1.0 : 1.0 / (lightAttenuation[i].x\n"
+	"			+ lightAttenuation[i].y * distance + lightAttenuation[i].z * distance * distance);\n"
+	"		float lambert = dot(normal, toLight);\n"
+	"		float highlight = lambert > 0.0\n"
+	"			? pow(max(dot(normal, normalize(toLight + vec3(0.0, 0.0, 1.0))), 0.0), shininess) : 0.0;\n"
+	"		lit += attenuation * (ambient.rgb * lightAmbient[i].rgb\n"
+	"			+ max(lambert, 0.0) * diffuse.rgb * lightDiffuse[i].rgb\n"
+	"			+ highlight * specular.rgb * lightSpecular[i].rgb);\n"
+	"	}\n"
+	"	return lit;\n"
+	"}\n"
+;
+
+// Declares the per draw block, which the flags come in too
+const char* renderMeshDeclarations =
+	"layout(std140) uniform Draw {\n"
+	"	mat4 modelView;\n"
+	"	mat3 normalMatrix;\n"
+	"	mat4 model;\n"
+	"	vec4 positionDecode;\n"
+	"	vec4 texCoordDecode;\n"
+	"	vec4 ambient;\n"
+	"	vec4 diffuse;\n"
+	"	vec4 specular;\n"
+	"	vec4 emission;\n"
+	"	float shininess;\n"
+	"	int flags;\n"
+	"};\n";
+
+// Lights a vertex buffer from its generic attributes and the per draw block, decoding packed and compact
+// vertices first. Floats come with a decode that leaves them as they are, and a compact vertex's normal
+// comes in as its octahedral coordinates, with the z left 0 for the shader to unfold. An instanced draw
+// places the vertex with the draw's model matrix and then its instance's, before the view in modelView
+const char* renderMeshVertexSource =
+	"layout(location = " RENDER_STRING(VERTEX_POSITION_ATTRIBUTE) ") in vec3 vertexPosition;\n"
+	"layout(location = " RENDER_STRING(VERTEX_NORMAL_ATTRIBUTE) ") in vec3 vertexNormal;\n"
+	"layout(location = " RENDER_STRING(VERTEX_TEXCOORD_ATTRIBUTE) ") in vec2 vertexTexCoord;\n"
+	"layout(location = " RENDER_STRING(VERTEX_INSTANCE_ATTRIBUTE) ") in mat4 instanceModel;\n"
+	"out vec4 colour;\n"
+	"out vec2 texCoord;\n"
+	"out float fogDepth;\n"
+	"void main() {\n"
+	"	vec4 position = vec4(vertexPosition * positionDecode.w + positionDecode.xyz, 1.0);\n"
+	"	vec3 normal = vertexNormal;\n"
+	"	if ((flags & " RENDER_STRING(RENDER_OCTAHEDRAL) ") != 0) {\n"
+	"		normal.z = 1.0 - abs(normal.x) - abs(normal.y);\n"
+	"		normal.xy = normal.z < 0.0 ? (1.0 - abs(normal.yx)) * mix(vec2(-1.0), vec2(1.0), step(0.0, normal.xy)) : normal.xy;\n"
+	"	}\n"
+	"	if ((flags & " RENDER_STRING(RENDER_INSTANCED) ") != 0) {\n"
+	"		position = instanceModel * (model * position);\n"
+	"		normal = mat3(instanceModel) * (mat3(model) * normal);\n"
+	"	}\n"
+	"	vec4 eyePosition = modelView * position;\n"
+	"	gl_Position = projection * eyePosition;\n"
+	"	texCoord = vertexTexCoord * texCoordDecode.zw + texCoordDecode.xy;\n"
+	"	fogDepth = abs(eyePosition.z);\n"
+	"	vec3 lit = lightPoint(eyePosition.xyz, normalize(normalMatrix * normal), ambient, diffuse, specular, emission, shininess);\n"
+	"	colour = clamp((flags & " RENDER_STRING(RENDER_LIT) ") != 0 ? vec4(lit, diffuse.a) : diffuse, 0.0, 1.0);\n"
+	"}\n";
+
+// Modulates by the texture and blends in exponential fog, as GL_MODULATE and GL_EXP do
+const char* renderFragmentSource =
+	"uniform sampler2D texture0;\n"
+	"in vec4 colour;\n"
+	"in vec2 texCoord;\n"
+	"in float fogDepth;\n"
+	"out vec4 fragmentColour;\n"
+	"void main() {\n"
+	"	vec4 result = colour;\n"
+	"	if ((flags & " RENDER_STRING(RENDER_TEXTURED) ") != 0) {\n"
+	"		result *= texture(texture0, texCoord);\n"
+	"	}\n"
+	"	if ((flags & " RENDER_STRING(RENDER_FOGGED) ") != 0) {\n"
+	"		float fog = clamp(exp(-fogDensity.x * fogDepth), 0.0, 1.0);\n"
+	"		result.rgb = mix(fogColour.rgb, result.rgb, fog);\n"
+	"	}\n"
+	"	fragmentColour = result;\n"
+	"}\n";
+
+Renderer renderer = { RENDER_FIXED };
+
+// Compiles one stage of the program for a number of lights, printing the log and returning 0 if it fails
+GLuint renderCompileShader(GLenum type, const char* source, unsigned int lightCount) {
+	GLuint shader = glprocCreateShader(type);
+	GLint compiled = GL_FALSE;
+	char header[64], log[1024];
+
+	// The number of lights is built into the program, so the loop over them has a constant length that
+	// the compiler can unroll
+	sprintf_s(header, sizeof(header), "#version 330 core\n#define LIGHT_COUNT %u\n", lightCount);
+	const char* sources[] = { header, renderCommonSource, renderMeshDeclarations, source };
+	glprocShaderSource(shader, 4, sources, NULL);
+	glprocCompileShader(shader);
+	glprocGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+
+	if (!compiled) {
+		glprocGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		printf("Couldn't compile the %s shader:\n%s\n", type == GL_VERTEX_SHADER ? "vertex" : "fragment", log);
+		glprocDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+// Builds the program, binding its texture and uniform blocks. Prints the log and returns 0 if it fails
+GLuint renderBuildProgram(void) {
+	const GLuint vertexShader = renderCompileShader(GL_VERTEX_SHADER, renderMeshVertexSource, renderer.lightCount);
+	const GLuint fragmentShader = renderCompileShader(GL_FRAGMENT_SHADER, renderFragmentSource, renderer.lightCount);
+	GLuint program = 0;
+	GLint linked = GL_FALSE;
+
+	if (vertexShader != 0 && fragmentShader != 0) {
+		program = glprocCreateProgram();
+		glprocAttachShader(program, vertexShader);
+		glprocAttachShader(program, fragmentShader);
+		glprocLinkProgram(program);
+		glprocGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+		if (!linked) {
+			char log[1024];
+			glprocGetProgramInfoLog(program, sizeof(log), NULL, log);
+			printf("Couldn't link the shader program:\n%s\n", log);
+			glprocDeleteProgram(program);
+			program = 0;
+		}
+	}
+
+	// The program keeps the shaders it was linked from, so they can go either way
+	if (vertexShader != 0) {
+		glprocDeleteShader(vertexShader);
+	}
+	if (fragmentShader != 0) {
+		glprocDeleteShader(fragmentShader);
+	}
+	if (program == 0) {
+		return 0;
+	}
+
+	glprocUseProgram(program);
+	glprocUniform1i(glprocGetUniformLocation(program, "texture0"), 0);
+	glprocUniformBlockBinding(program, glprocGetUniformBlockIndex(program, "Frame"), RENDER_FRAME_BINDING);
+	glprocUniformBlockBinding(program, glprocGetUniformBlockIndex(program, "Draw"), RENDER_DRAW_BINDING);
+	glprocUseProgram(0);
+	return program;
+}
+
+bool renderInit(RenderBackend backend) {
+	renderer = (Renderer) { RENDER_FIXED };
+
+	if (backend == RENDER_FIXED) {
+		return TRUE;
+	}
+
+	if (!glprocHasShaders()) {
+		printf("OpenGL 3.3 shaders, uniform buffers and instancing aren't supported, the fixed function renderer will be used\n");
+		return FALSE;
+	}
+
+	// Only the lights initLights turned on are shaded, packed into the first slots of the frame block
+	for (unsigned int i = 0; i < RENDER_MAX_LIGHTS; ++i) {
+		if (glIsEnabled(GL_LIGHT0 + i)) {
+			renderer.lights[renderer.lightCount++] = GL_LIGHT0 + i;
+		}
+	}
+
+	renderer.program = renderBuildProgram();
+	if (renderer.program == 0) {
+		printf("The fixed function renderer will be used instead\n");
+		renderFree();
+		return FALSE;
+	}
+
+	glprocGenBuffers(1, &renderer.frameBuffer);
+	glprocBindBuffer(GL_UNIFORM_BUFFER, renderer.frameBuffer);
+	glprocBufferData(GL_UNIFORM_BUFFER, sizeof(RenderFrame), NULL, GL_DYNAMIC_DRAW);
+
+	// Each draw's slot has to start on the alignment the driver asks for, which is at least 16 bytes
+	GLint alignment = 16;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	renderer.drawStride = (GLsizei)((sizeof(RenderDraw) + alignment - 1) / alignment * alignment);
+	glprocGenBuffers(1, &renderer.drawBuffer);
+	glprocBindBuffer(GL_UNIFORM_BUFFER, renderer.drawBuffer);
+	glprocBufferData(GL_UNIFORM_BUFFER, renderer.drawStride * RENDER_DRAW_SLOTS, NULL, GL_STREAM_DRAW);
+	glprocBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glprocGenBuffers(1, &renderer.instanceBuffer);
+
+	renderer.backend = backend;
+	return TRUE;
+}
+
+RenderBackend renderBackend(void) {
+	return renderer.backend;
+}
+
+void renderBeginScene(const Mat4* projection, const Mat4* view, GLfloat fogDensity) {
+	glFogf(GL_FOG_DENSITY, fogDensity);
+
+	if (renderer.backend != RENDER_GLSL) {
+		return;
+	}
+	renderer.view = *view;
+
+	// The lights are read back from OpenGL, which has already moved their positions into eye space
+	RenderFrame* frame = &renderer.frame;
+	memcpy(frame->projection, projection->m, sizeof(frame->projection));
+	for (unsigned int i = 0; i < renderer.lightCount; ++i) {
+		const GLenum light = renderer.lights[i];
+		glGetLightfv(light, GL_POSITION, frame->lightPositions[i]);
+		glGetLightfv(light, GL_AMBIENT, frame->lightAmbient[i]);
+		glGetLightfv(light, GL_DIFFUSE, frame->lightDiffuse[i]);
+		glGetLightfv(light, GL_SPECULAR, frame->lightSpecular[i]);
+		glGetLightfv(light, GL_CONSTANT_ATTENUATION, &frame->lightAttenuation[i][0]);
+		glGetLightfv(light, GL_LINEAR_ATTENUATION, &frame->lightAttenuation[i][1]);
+		glGetLightfv(light, GL_QUADRATIC_ATTENUATION, &frame->lightAttenuation[i][2]);
+	}
+	glGetFloatv(GL_LIGHT_MODEL_AMBIENT, frame->sceneAmbient);
+	glGetFloatv(GL_FOG_COLOR, frame->fogColour);
+	frame->fogDensity[0] = fogDensity;
+
+	glprocBindBuffer(GL_UNIFORM_BUFFER, renderer.frameBuffer);
+	glprocBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(RenderFrame), frame);
+	glprocBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glprocBindBufferBase(GL_UNIFORM_BUFFER, RENDER_FRAME_BINDING, renderer.frameBuffer);
+
+	renderer.active = TRUE;
+	glprocUseProgram(renderer.program);
+	renderSyncFlags();
+}
+
+void renderEndScene(void) {
+	if (renderer.active) {
+		glprocUseProgram(0);
+		renderer.active = FALSE;
+	}
+}
+
+// Copies a draw's data into the next slot of the draw buffer, and binds the slot for the mesh program
+void renderUploadDraw(const RenderDraw* draw) {
+	glprocBindBuffer(GL_UNIFORM_BUFFER, renderer.drawBuffer);
+	if (renderer.drawSlot == RENDER_DRAW_SLOTS) {
+		// Orphaning the full buffer gives it new storage, rather than waiting on the draws reading the old
+		glprocBufferData(GL_UNIFORM_BUFFER, renderer.drawStride * RENDER_DRAW_SLOTS, NULL, GL_STREAM_DRAW);
+		renderer.drawSlot = 0;
+	}
+
+	const GLintptrProc offset = (GLintptrProc)renderer.drawSlot++ * renderer.drawStride;
+	glprocBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(RenderDraw), draw);
+	glprocBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glprocBindBufferRange(GL_UNIFORM_BUFFER, RENDER_DRAW_BINDING, renderer.drawBuffer, offset, sizeof(RenderDraw));
+}
+
+// Fills in a draw's slot and draws a vertex buffer through the program, with any of the RENDER_ bits for
+// the draw itself added to the flags. An instanced draw places its vertices with the model matrix, or
+// leaves them where they are if that's NULL, and then with each instance's
+void renderDrawAttributes(VertexBuffer* buffer, Mat4 modelView, const Mat4* model, const RenderMaterial* material, int flags) {
+	// The meshes are only ever moved, turned and scaled evenly, so the normal matrix is the modelview
+	// matrix's rotation, and the shader normalises what it gives
+	RenderDraw draw = { 0 };
+	memcpy(draw.modelView, modelView.m, sizeof(draw.modelView));
+	for (unsigned int column = 0; column < 3; ++column) {
+		memcpy(draw.normalMatrix[column], &modelView.m[column * 4], 3 * sizeof(GLfloat));
+	}
+	memcpy(draw.model, model != NULL ? model->m : mat4Identity().m, sizeof(draw.model));
+
+	if (buffer->format != VERTEX_FLOAT) {
+		const VertexDecode* decode = &buffer->decode;
+		memcpy(draw.positionDecode, decode->positionOffset, sizeof(decode->positionOffset));
+		draw.positionDecode[3] = decode->positionScale;
+		memcpy(draw.texCoordDecode, decode->texCoordOffset, sizeof(decode->texCoordOffset));
+		memcpy(&draw.texCoordDecode[2], decode->texCoordScale, sizeof(decode->texCoordScale));
+	} else {
+		draw.positionDecode[3] = 1;
+		draw.texCoordDecode[2] = draw.texCoordDecode[3] = 1;
+	}
+	draw.material = *material;
+	draw.flags = renderer.flags | flags | (buffer->format == VERTEX_COMPACT ? RENDER_OCTAHEDRAL : 0);
+
+	renderUploadDraw(&draw);
+	if ((flags & RENDER_INSTANCED) != 0) {
+		vertexBufferDrawInstanced(buffer, renderer.instanceBuffer, renderer.instanceCount);
+	} else {
+		vertexBufferDrawAttributes(buffer);
+	}
+}
+
+void renderDrawBuffer(VertexBuffer* buffer, const Mat4* model, const RenderMaterial* material) {
+	if (!renderer.active) {
+		if (model != NULL) {
+			glPushMatrix();
+			glMultMatrixf(model->m);
+		}
+		glMaterialfv(GL_FRONT, GL_AMBIENT, material->ambient);
+		glMaterialfv(GL_FRONT, GL_DIFFUSE, material->diffuse);
+		glMaterialfv(GL_FRONT, GL_SPECULAR, material->specular);
+		glMaterialfv(GL_FRONT, GL_EMISSION, material->emission);
+		glMaterialf(GL_FRONT, GL_SHININESS, material->shininess);
+		glColor4fv(material->diffuse);
+
+		vertexBufferDraw(buffer);
+
+		if (model != NULL) {
+			glPopMatrix();
+		}
+		return;
+	}
+
+	renderDrawAttributes(buffer, model != NULL ? mat4Multiply(renderer.view, *model) : renderer.view, NULL, material, 0);
+}
+
+void renderSetInstances(const Mat4* instances, unsigned int count) {
+	renderer.instances = instances;
+	renderer.instanceCount = count;
+
+	if (renderer.active) {
+		glprocBindBuffer(GL_ARRAY_BUFFER, renderer.instanceBuffer);
+		glprocBufferData(GL_ARRAY_BUFFER, count * sizeof(Mat4), instances, GL_STREAM_DRAW);
+		glprocBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+void renderDrawInstanced(VertexBuffer* buffer, const Mat4* model, const RenderMaterial* material) {
+	if (renderer.instanceCount == 0) {
+		return;
+	}
+
+	if (!renderer.active) {
+		for (unsigned int i = 0; i < renderer.instanceCount; ++i) {
+			glPushMatrix();
+			glMultMatrixf(renderer.instances[i].m);
+			renderDrawBuffer(buffer, model, material);
+			glPopMatrix();
+		}
+		return;
+	}
+
+	// The instances carry their own model matrices, so the draw's modelview matrix is only the view
+	renderDrawAttributes(buffer, renderer.view, model, material, RENDER_INSTANCED);
+}
+
+// Returns the flag the program uses for a capability, or 0 if they don't emulate it
+int renderCapabilityFlag(GLenum capability) {
+	switch (capability) {
+	case GL_TEXTURE_2D: return RENDER_TEXTURED;
+	case GL_LIGHTING: return RENDER_LIT;
+	case GL_FOG: return RENDER_FOGGED;
+	default: return 0;
+	}
+}
+
+void renderEnable(GLenum capability) {
+	glEnable(capability);
+	if (renderer.active) {
+		renderer.flags |= renderCapabilityFlag(capability);
+	}
+}
+
+void renderDisable(GLenum capability) {
+	glDisable(capability);
+	if (renderer.active) {
+		renderer.flags &= ~renderCapabilityFlag(capability);
+	}
+}
+
+void renderSyncFlags(void) {
+	if (renderer.active) {
+		renderer.flags = (glIsEnabled(GL_TEXTURE_2D) ? RENDER_TEXTURED : 0) | (glIsEnabled(GL_LIGHTING) ? RENDER_LIT : 0)
+			| (glIsEnabled(GL_FOG) ? RENDER_FOGGED : 0);
+	}
+}
+
+bool renderSuspend(void) {
+	if (!renderer.active) {
+		return FALSE;
+	}
+	glprocUseProgram(0);
+	return TRUE;
+}
+
+void renderResume(void) {
+	glprocUseProgram(renderer.program);
+}
+
+void renderFree(void) {
+	if (renderer.program != 0) {
+		glprocDeleteProgram(renderer.program);
+	}
+	if (renderer.frameBuffer != 0) {
+		glprocDeleteBuffers(1, &renderer.frameBuffer);
+		glprocDeleteBuffers(1, &renderer.drawBuffer);
+		glprocDeleteBuffers(1, &renderer.instanceBuffer);
+	}
+	renderer = (Renderer) { RENDER_FIXED };
+}
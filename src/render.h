@@ -0,0 +1,144 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freeglut.h>
+#include "misc.h"
+#include "glproc.h"
+#include "vecmath.h"
+#include "buffer.h"
+
+/*
+ * <render.c/render.h> Picks how the scene is shaded. The fixed function backend leaves it all to
+ * OpenGL 1.1's lighting, texturing and fog. The GLSL backend draws the same geometry through a GLSL
+ * 3.30 program instead, reading the camera, lights and fog from a uniform buffer filled once a frame
+ *
+ * Meshes in vertex buffers are drawn with renderDrawBuffer, which takes their model matrix and material
+ * from the caller. With the GLSL backend they go through a core profile program fed by generic vertex
+ * attributes, with each draw's modelview matrix and material in its own slot of a second uniform
+ * buffer, so nothing it reads comes from the fixed function state. A mesh that's drawn in many places,
+ * like the helicopters, is drawn with renderDrawInstanced once for all of them, with the places set
+ * beforehand by renderSetInstances. The GLSL backend makes that a single instanced draw, and the fixed
+ * function backend draws it once for each
+ *
+ * The lighting is worked out per vertex the way the fixed function pipeline does it, so both backends
+ * draw the same picture and can be compared with --golden. The shaders need to know which of texturing,
+ * lighting and fog are on, so the scene turns them on and off with renderEnable and renderDisable rather
+ * than glEnable and glDisable
+ */
+
+// Most lights the GLSL backend shades with, which covers the two from initLights and --fullbright's
+#define RENDER_MAX_LIGHTS 3
+// Uniform buffer bindings the per frame data and the current draw's data are bound to
+#define RENDER_FRAME_BINDING 0
+#define RENDER_DRAW_BINDING 1
+// Slots in the per draw uniform buffer. Once they've all been used the buffer is orphaned and filled
+// again from the first, so a frame can have any number of draws
+#define RENDER_DRAW_SLOTS 1024
+// Bits of the flags uniform, for the capabilities the GLSL program has to emulate
+#define RENDER_TEXTURED 1
+#define RENDER_LIT 2
+#define RENDER_FOGGED 4
+// Bit of a draw's flags for a compact vertex buffer, whose normals have to be unfolded from an octahedron
+#define RENDER_OCTAHEDRAL 8
+// Bit of a draw's flags for an instanced draw, whose vertices are placed by the instance matrices too
+#define RENDER_INSTANCED 16
+
+// Turns a constant into a string literal, for passing constants into the shader sources
+#define RENDER_STRING(value) RENDER_STRING_LITERAL(value)
+#define RENDER_STRING_LITERAL(value) #value
+
+typedef enum {
+	RENDER_FIXED = 0,	// OpenGL 1.1's fixed function pipeline
+	RENDER_GLSL			// A GLSL 3.30 program with per frame and per draw uniform buffers
+} RenderBackend;
+
+// The per frame uniform block, laid out by std140 rules. Every member is a mat4, a vec4 or an array of
+// vec4s, so the C struct and the block line up without any padding
+typedef struct RENDERFRAME {
+	GLfloat projection[16];								// The camera's projection
+	GLfloat lightPositions[RENDER_MAX_LIGHTS][4];		// In eye space, as glLightfv stored them
+	GLfloat lightAmbient[RENDER_MAX_LIGHTS][4];
+	GLfloat lightDiffuse[RENDER_MAX_LIGHTS][4];
+	GLfloat lightSpecular[RENDER_MAX_LIGHTS][4];
+	GLfloat lightAttenuation[RENDER_MAX_LIGHTS][4];	// Constant, linear and quadratic
+	GLfloat sceneAmbient[4];							// The light model's ambient light
+	GLfloat fogColour[4];
+	GLfloat fogDensity[4];								// Only the first is used
+} RenderFrame;
+
+// How a surface reflects light, in the same terms as glMaterial
+typedef struct RENDERMATERIAL {
+	GLfloat ambient[4];
+	GLfloat diffuse[4];		// Also the colour of a mesh drawn with lighting off
+	GLfloat specular[4];
+	GLfloat emission[4];
+	GLfloat shininess;
+} RenderMaterial;
+
+// The per draw uniform block, laid out by std140 rules. The normal matrix is a mat3, whose columns
+// each take up a vec4, and the material's shininess and the flags are packed into the last vec4
+typedef struct RENDERDRAW {
+	GLfloat modelView[16];
+	GLfloat normalMatrix[3][4];
+	GLfloat model[16];			// Places an instanced draw's vertices before its instance matrices do
+	GLfloat positionDecode[4];	// Offset, then scale, for turning packed positions back into the mesh's
+	GLfloat texCoordDecode[4];	// Offset, then scale, for packed texture coordinates
+	RenderMaterial material;
+	GLint flags;
+	GLfloat padding[2];
+} RenderDraw;
+
+typedef struct RENDERER {
+	RenderBackend backend;
+	GLuint program;			// Draws vertex buffers from generic attributes and the per draw block
+	GLuint frameBuffer;		// Uniform buffer holding a RenderFrame
+	GLuint drawBuffer;		// Uniform buffer holding RENDER_DRAW_SLOTS RenderDraws
+	GLsizei drawStride;		// Bytes between slots, which have to start on the driver's offset alignment
+	unsigned int drawSlot;	// The next slot to fill
+	GLuint instanceBuffer;	// Vertex buffer object holding the instance matrices for instanced draws
+	const Mat4* instances;	// The instance matrices, which the fixed function backend draws from
+	unsigned int instanceCount;
+	GLenum lights[RENDER_MAX_LIGHTS];	// The lights that were on when the program was built
+	unsigned int lightCount;
+	RenderFrame frame;
+	Mat4 view;				// The camera's view matrix, which the meshes' model matrices go onto
+	int flags;				// Capabilities the program is emulating, as RENDER_ bits
+	bool active;			// Whether the program is drawing the scene
+} Renderer;
+
+// Sets up a backend, after initLights has set up the lights. Falls back to the fixed function backend
+// and returns FALSE if the GLSL backend isn't supported or its program doesn't build
+bool renderInit(RenderBackend backend);
+// Returns the backend in use
+RenderBackend renderBackend(void);
+// Starts drawing the scene from a camera, uploading its projection, the frame's fog density, and the
+// lights as they are in OpenGL. The view matrix is kept for renderDrawBuffer, which needs it loaded as the
+// modelview matrix too for the fixed function backend
+void renderBeginScene(const Mat4* projection, const Mat4* view, GLfloat fogDensity);
+// Finishes drawing the scene, so anything drawn after it (like the overlays) uses the fixed function pipeline
+void renderEndScene(void);
+// Turns on a capability, passing GL_TEXTURE_2D, GL_LIGHTING and GL_FOG on to the GLSL program too
+void renderEnable(GLenum capability);
+// Turns off a capability, passing GL_TEXTURE_2D, GL_LIGHTING and GL_FOG on to the GLSL program too
+void renderDisable(GLenum capability);
+// Draws a vertex buffer placed by a model matrix, or where it is if that's NULL, with a material. With
+// the fixed function backend the model matrix goes onto the modelview matrix and the material is set
+// with glMaterial, and its diffuse colour with glColor for when lighting is off
+void renderDrawBuffer(VertexBuffer* buffer, const Mat4* model, const RenderMaterial* material);
+// Sets the model matrices renderDrawInstanced draws at, which have to stay where they are until the
+// instanced draws are done
+void renderSetInstances(const Mat4* instances, unsigned int count);
+// Draws a vertex buffer once at each of the matrices from renderSetInstances, placed by a model matrix
+// before the instance's, or where it is in the instance if that's NULL, with a material
+void renderDrawInstanced(VertexBuffer* buffer, const Mat4* model, const RenderMaterial* material);
+// Reads which of texturing, lighting and fog are on back from OpenGL, after something other than
+// renderEnable and renderDisable has changed them, like glPopAttrib
+void renderSyncFlags(void);
+// Stops the program in the middle of the scene, for drawing that only works with the fixed function
+// pipeline, like bitmap text. Returns whether it was running, and so need renderResume afterwards
+bool renderSuspend(void);
+// Binds the program again after renderSuspend
+void renderResume(void);
+// Frees the GLSL backend's program and buffers
+void renderFree(void);
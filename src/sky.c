@@ -0,0 +1,186 @@
+#include "sky.h"
+
+// The sky is unlit, so only the diffuse colour it's drawn in matters
+const RenderMaterial skyMaterial = { { 0, 0, 0, 1 }, { 1, 1, 1, 1 }, { 0, 0, 0, 1 }, { 0, 0, 0, 1 }, 0 };
+
+// Centre, right and up directions of each skybox face, which both the face textures and the box use
+const Vec3 skyFaceAxes[6][3] = {
+	{ { 1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+	{ { -1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 } },
+	{ { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+	{ { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, -1 } },
+	{ { 0, 0, 1 }, { -1, 0, 0 }, { 0, 1, 0 } },
+	{ { 0, 0, -1 }, { 1, 0, 0 }, { 0, 1, 0 } }
+};
+
+Vec3 skyDomeDirection(GLfloat s, GLfloat t) {
+	// The same parameterisation as gluSphere, turned so that its poles are up and down
+	const GLfloat theta = 2 * VEC_PI * (1 - s), phi = VEC_PI * (1 - t);
+	return (Vec3) { sinf(phi) * sinf(theta), cosf(phi), -sinf(phi) * cosf(theta) };
+}
+
+Vec2 skyDomeTexCoord(Vec3 direction) {
+	const GLfloat length = sqrtf(vec3Dot(direction, direction));
+	GLfloat theta = atan2f(direction.x, -direction.z);
+	if (theta < 0) { theta += 2 * VEC_PI; }
+
+	return (Vec2) { 1 - theta / (2 * VEC_PI), 1 - acosf(fminf(fmaxf(direction.y / length, -1), 1)) / VEC_PI };
+}
+
+// Samples an RGB image with bilinear filtering, wrapping around horizontally and clamping vertically
+void skySample(const GLubyte* pixels, int width, int height, Vec2 texCoord, GLubyte* colour) {
+	const GLfloat x = texCoord.x * width - 0.5f, y = fminf(fmaxf(texCoord.y * height - 0.5f, 0), height - 1.0f);
+	const int x0 = (int)floorf(x), y0 = (int)y;
+	const int y1 = y0 + 1 < height ? y0 + 1 : y0;
+	const GLfloat fx = x - x0, fy = y - y0;
+	const int columns[2] = { ((x0 % width) + width) % width, (((x0 + 1) % width) + width) % width };
+
+	for (int channel = 0; channel < 3; ++channel) {
+		const GLfloat bottom = pixels[(y0 * width + columns[0]) * 3 + channel] * (1 - fx) + pixels[(y0 * width + columns[1]) * 3 + channel] * fx;
+		const GLfloat top = pixels[(y1 * width + columns[0]) * 3 + channel] * (1 - fx) + pixels[(y1 * width + columns[1]) * 3 + channel] * fx;
+		colour[channel] = (GLubyte)(bottom + (top - bottom) * fy + 0.5f);
+	}
+}
+
+// Builds the skybox faces by looking up what the dome's pixels show in the direction of every texel. Faces
+// that were already built keep their textures and buffers, and only have the texels replaced
+void skyCreateFaces(Sky* sky, const GLubyte* pixels, int width, int height) {
+	GLubyte* face = malloc(SKY_FACE_SIZE * SKY_FACE_SIZE * 3);
+
+	if (sky->faceTextures[0] == 0) {
+		glGenTextures(6, sky->faceTextures);
+	}
+
+	for (unsigned int f = 0; f < 6; ++f) {
+		const Vec3 centre = skyFaceAxes[f][0], right = skyFaceAxes[f][1], up = skyFaceAxes[f][2];
+
+		for (unsigned int row = 0; row < SKY_FACE_SIZE; ++row) {
+			for (unsigned int column = 0; column < SKY_FACE_SIZE; ++column) {
+				const GLfloat u = (column + 0.5f) / SKY_FACE_SIZE * 2 - 1, v = (row + 0.5f) / SKY_FACE_SIZE * 2 - 1;
+				const Vec3 direction = vec3Add(centre, vec3Add(vec3Scale(right, u), vec3Scale(up, v)));
+				skySample(pixels, width, height, skyDomeTexCoord(direction), &face[(row * SKY_FACE_SIZE + column) * 3]);
+			}
+		}
+
+		glBindTexture(GL_TEXTURE_2D, sky->faceTextures[f]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SKY_FACE_SIZE, SKY_FACE_SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, face);
+
+		if (sky->faces[f] != NULL) {
+			continue;
+		}
+		Vertex vertices[4];
+		GLuint indices[4] = { 0, 1, 2, 3 };
+		for (unsigned int corner = 0; corner < 4; ++corner) {
+			const GLfloat u = (corner & 1) ? 1.0f : -1.0f, v = (corner & 2) ? 1.0f : -1.0f;
+			const Vec3 position = vec3Scale(vec3Add(centre, vec3Add(vec3Scale(right, u), vec3Scale(up, v))), SKY_BOX_SIZE);
+			vertices[corner] = (Vertex) { { position.x, position.y, position.z }, { -centre.x, -centre.y, -centre.z }, { (u + 1) / 2, (v + 1) / 2 } };
+		}
+		sky->faces[f] = vertexBufferCreate(GL_TRIANGLE_STRIP, vertices, 4, indices, 4);
+	}
+
+	free(face);
+}
+
+Sky* skyCreate(GLuint domeTexture, char* textureFileName, bool skybox) {
+	Sky* sky = calloc(1, sizeof(Sky));
+	Vertex* vertices = malloc((SKY_STACKS + 1) * (SKY_SLICES + 1) * sizeof(Vertex));
+	GLuint* indices = malloc(SKY_STACKS * SKY_SLICES * 6 * sizeof(GLuint));
+	unsigned int indexCount = 0;
+
+	sky->skybox = skybox;
+	sky->domeTexture = domeTexture;
+
+	// Normals face inwards, though nothing lights the sky
+	for (unsigned int stack = 0; stack <= SKY_STACKS; ++stack) {
+		for (unsigned int slice = 0; slice <= SKY_SLICES; ++slice) {
+			const GLfloat s = 1 - (GLfloat)slice / SKY_SLICES, t = 1 - (GLfloat)stack / SKY_STACKS;
+			const Vec3 direction = skyDomeDirection(s, t);
+			vertices[stack * (SKY_SLICES + 1) + slice] = (Vertex) {
+				{ direction.x * SKY_RADIUS, direction.y * SKY_RADIUS, direction.z * SKY_RADIUS },
+				{ -direction.x, -direction.y, -direction.z },
+				{ s, t }
+			};
+		}
+	}
+
+	for (unsigned int stack = 0; stack < SKY_STACKS; ++stack) {
+		for (unsigned int slice = 0; slice < SKY_SLICES; ++slice) {
+			const GLuint corner = stack * (SKY_SLICES + 1) + slice;
+			const GLuint quad[6] = { corner, corner + SKY_SLICES + 1, corner + 1, corner + 1, corner + SKY_SLICES + 1, corner + SKY_SLICES + 2 };
+			memcpy(&indices[indexCount], quad, sizeof(quad));
+			indexCount += 6;
+		}
+	}
+
+	sky->dome = vertexBufferCreate(GL_TRIANGLES, vertices, (SKY_STACKS + 1) * (SKY_SLICES + 1), indices, indexCount);
+	free(vertices);
+	free(indices);
+
+	if (skybox) {
+		int width, height;
+		GLubyte* pixels = loadPPMPixels(textureFileName, &width, &height);
+		// Only a file that's been changed since the dome's texture was loaded from it can fail here
+		if (pixels == NULL) {
+			sky->skybox = FALSE;
+		} else {
+			skyCreateFaces(sky, pixels, width, height);
+			allocFree(pixels);
+		}
+	}
+
+	return sky;
+}
+
+void skySetTexture(Sky* sky, GLuint domeTexture, const GLubyte* pixels, int width, int height) {
+	sky->domeTexture = domeTexture;
+	if (sky->skybox) {
+		skyCreateFaces(sky, pixels, width, height);
+	}
+}
+
+void skyDraw(Sky* sky, Vec3 camera) {
+	// The sky is pushed to the far plane, so it also works drawn after everything else, only filling
+	// in the pixels nothing else has covered
+	glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT | GL_VIEWPORT_BIT | GL_CURRENT_BIT);
+	renderDisable(GL_LIGHTING);
+	renderDisable(GL_FOG);
+	glDisable(GL_BLEND);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_LEQUAL);
+	glDepthRange(1, 1);
+	renderEnable(GL_TEXTURE_2D);
+
+	if (sky->skybox) {
+		// The box moves with the camera, so only the camera's rotation is left
+		const Mat4 model = mat4Translation(camera);
+		for (unsigned int f = 0; f < 6; ++f) {
+			glBindTexture(GL_TEXTURE_2D, sky->faceTextures[f]);
+			renderDrawBuffer(sky->faces[f], &model, &skyMaterial);
+		}
+	} else {
+		glBindTexture(GL_TEXTURE_2D, sky->domeTexture);
+		renderDrawBuffer(sky->dome, NULL, &skyMaterial);
+	}
+
+	glPopAttrib();
+	renderSyncFlags();
+}
+
+void skyFree(Sky* sky) {
+	if (sky == NULL) {
+		return;
+	}
+
+	vertexBufferFree(sky->dome);
+	if (sky->skybox) {
+		glDeleteTextures(6, sky->faceTextures);
+		for (unsigned int f = 0; f < 6; ++f) {
+			vertexBufferFree(sky->faces[f]);
+		}
+	}
+	free(sky);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <math.h>
+#include <freeglut.h>
+#include "buffer.h"
+#include "loader.h"
+#include "vecinline.h"
+#include "render.h"
+
+/*
+ * <sky.c/sky.h> The sky, drawn as an unlit, unfogged backdrop at the far plane that doesn't write
+ * to the depth buffer. It's either the textured dome the scene has always had, built once into a
+ * vertex buffer, or a box around the camera with its six faces resampled from the dome's texture
+ */
+
+// Radius and tessellation of the sky dome, the same as the gluSphere it replaces
+#define SKY_RADIUS 250
+#define SKY_SLICES 20
+#define SKY_STACKS 20
+// Texture size of each skybox face, and half the width of the box drawn around the camera
+#define SKY_FACE_SIZE 256
+#define SKY_BOX_SIZE 100
+
+typedef struct SKY {
+	bool skybox;			// Whether the box is drawn rather than the dome
+	GLuint domeTexture;
+	VertexBuffer* dome;
+	GLuint faceTextures[6];
+	VertexBuffer* faces[6];
+} Sky;
+
+// Builds the sky dome with the given texture, and when skybox is set, the skybox faces resampled from
+// the ppm file the texture was loaded from
+Sky* skyCreate(GLuint domeTexture, char* textureFileName, bool skybox);
+// Returns the direction from the centre of the sky dome that a texture coordinate on it is seen in
+Vec3 skyDomeDirection(GLfloat s, GLfloat t);
+// Returns the texture coordinate on the sky dome seen in a direction from its centre
+Vec2 skyDomeTexCoord(Vec3 direction);
+// Draws the sky around a camera at the given position. It can come first, straight after the camera is
+// set up, or after all the opaque geometry
+void skyDraw(Sky* sky, Vec3 camera);
+// Puts a new texture on the dome, and resamples the skybox faces, if there are any, from its pixels
+void skySetTexture(Sky* sky, GLuint domeTexture, const GLubyte* pixels, int width, int height);
+// Frees the sky's buffers and skybox textures
+void skyFree(Sky* sky);
@@ -0,0 +1,37 @@
+#include "snapshot.h"
+
+void snapshotBufferInit(SnapshotBuffer* buffer, unsigned int swarmCount) {
+	for (unsigned int i = 0; i < 3; ++i) {
+		buffer->slots[i] = (SceneSnapshot) { 0 };
+		buffer->slots[i].swarm = swarmCount > 0 ? swarmPoseCreate(swarmCount) : NULL;
+	}
+	buffer->writeSlot = 0;
+	buffer->shared = 1;
+	buffer->readSlot = 2;
+}
+
+SceneSnapshot* snapshotBufferWriting(SnapshotBuffer* buffer) {
+	return &buffer->slots[buffer->writeSlot];
+}
+
+void snapshotBufferPublish(SnapshotBuffer* buffer) {
+	// The exchange publishes every write to the slot along with it, and hands back the older shared
+	// slot to write the next snapshot into, whether or not the reader ever picked it up
+	const int previous = atomicExchange(&buffer->shared, buffer->writeSlot | SNAPSHOT_FRESH);
+	buffer->writeSlot = previous & ~SNAPSHOT_FRESH;
+}
+
+SceneSnapshot* snapshotBufferLatest(SnapshotBuffer* buffer) {
+	if (atomicLoad(&buffer->shared) & SNAPSHOT_FRESH) {
+		const int previous = atomicExchange(&buffer->shared, buffer->readSlot);
+		buffer->readSlot = previous & ~SNAPSHOT_FRESH;
+	}
+	return &buffer->slots[buffer->readSlot];
+}
+
+void snapshotBufferFree(SnapshotBuffer* buffer) {
+	for (unsigned int i = 0; i < 3; ++i) {
+		swarmPoseFree(buffer->slots[i].swarm);
+		buffer->slots[i].swarm = NULL;
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "helicopter.h"
+#include "swarm.h"
+#include "atomic.h"
+
+/*
+ * <snapshot.c/snapshot.h> Hands the simulated scene from the simulation thread to the render thread.
+ * At the end of each tick the simulation writes everything drawing needs into a snapshot and
+ * publishes it, and each frame draws from the newest published snapshot. The snapshots live in a
+ * triple buffer: one slot is being written, one is being drawn, and the third holds the newest
+ * published one. Publishing and picking up a snapshot each swap a slot with one atomic exchange,
+ * so neither thread ever waits on the other
+ */
+
+// Set in the shared slot index when the slot holds a snapshot the reader hasn't picked up yet
+#define SNAPSHOT_FRESH 4
+
+typedef struct SCENESNAPSHOT {
+	unsigned long long tick;		// Number of the simulation tick the snapshot was taken after
+	unsigned long long inputTime;	// Platform clock time of the newest input the tick had seen
+	Helicopter helicopter;
+	SwarmPose* swarm;				// The swarm's drones, or NULL if there's no swarm
+	GLfloat waterHeight, waterOffset, waterTime;
+} SceneSnapshot;
+
+typedef struct SNAPSHOTBUFFER {
+	SceneSnapshot slots[3];
+	int writeSlot;			// Slot the simulation thread is writing, only touched by that thread
+	int readSlot;			// Slot the render thread is drawing, only touched by that thread
+	volatile int shared;	// Slot that's neither, with SNAPSHOT_FRESH set if it hasn't been read
+} SnapshotBuffer;
+
+// Sets up a buffer with every slot empty, giving each room for a swarm of a number of drones
+void snapshotBufferInit(SnapshotBuffer* buffer, unsigned int swarmCount);
+// Returns the snapshot the simulation thread should write into next
+SceneSnapshot* snapshotBufferWriting(SnapshotBuffer* buffer);
+// Publishes the snapshot that was being written, making it the newest
+void snapshotBufferPublish(SnapshotBuffer* buffer);
+// Returns the newest published snapshot, which stays the render thread's until it calls this again
+SceneSnapshot* snapshotBufferLatest(SnapshotBuffer* buffer);
+// Frees the swarm poses in every slot
+void snapshotBufferFree(SnapshotBuffer* buffer);
@@ -0,0 +1,251 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "swarm.h"
+#include "angle.h"
+
+// What the jobs stepping the swarm share, each taking its own range of drones
+typedef struct SWARMSTEP {
+	Swarm* swarm;
+	unsigned int ticks;
+	GLfloat deltaTime;
+} SwarmStep;
+
+// Scrambles an integer, used for giving each drone its own repeatable script
+unsigned int swarmHash(unsigned int value) {
+	value ^= value >> 16;
+	value *= 0x7feb352d;
+	value ^= value >> 15;
+	value *= 0x846ca68b;
+	value ^= value >> 16;
+	return value;
+}
+
+Swarm* swarmCreate(unsigned int count, TreeObject* trees) {
+	Swarm* swarm = allocMalloc(ALLOC_SWARM, sizeof(Swarm));
+	swarm->count = count;
+	swarm->positionX = allocMalloc(ALLOC_SWARM, sizeof(GLfloat) * count);
+	swarm->positionY = allocMalloc(ALLOC_SWARM, sizeof(GLfloat) * count);
+	swarm->positionZ = allocMalloc(ALLOC_SWARM, sizeof(GLfloat) * count);
+	swarm->velocityX = allocCalloc(ALLOC_SWARM, count, sizeof(GLfloat));
+	swarm->velocityY = allocCalloc(ALLOC_SWARM, count, sizeof(GLfloat));
+	swarm->velocityZ = allocCalloc(ALLOC_SWARM, count, sizeof(GLfloat));
+	swarm->angle = allocMalloc(ALLOC_SWARM, sizeof(GLfloat) * count);
+	swarm->angularVelocity = allocCalloc(ALLOC_SWARM, count, sizeof(GLfloat));
+	swarm->atEdge = allocCalloc(ALLOC_SWARM, count, sizeof(bool));
+	swarm->targetX = allocMalloc(ALLOC_SWARM, sizeof(GLfloat) * count);
+	swarm->targetY = allocMalloc(ALLOC_SWARM, sizeof(GLfloat) * count);
+	swarm->targetZ = allocMalloc(ALLOC_SWARM, sizeof(GLfloat) * count);
+	swarm->sines = allocMalloc(ALLOC_SWARM, sizeof(GLfloat) * count);
+	swarm->cosines = allocMalloc(ALLOC_SWARM, sizeof(GLfloat) * count);
+	swarm->replay = NULL;
+	swarm->replayLength = 0;
+	swarm->tick = 0;
+	swarm->rotorAngle = 0;
+	swarm->trees = trees;
+	treeGridBuild(&swarm->grid, trees);
+
+	Helicopter placement = { 0 };
+	for (unsigned int i = 0; i < count; ++i) {
+		Vec3 position;
+		do {
+			position = (Vec3) {
+				offsetRand(HELI_MAP_RADIUS * 1.8),
+				SWARM_SCRIPT_MIN_HEIGHT + ((GLfloat)rand() / RAND_MAX) * (SWARM_SCRIPT_MAX_HEIGHT - SWARM_SCRIPT_MIN_HEIGHT),
+				offsetRand(HELI_MAP_RADIUS * 1.8)
+			};
+			position.y += helicopterFloor(position.x, position.z) - HELI_MIN_HEIGHT;
+		} while (helicopterCollision(&placement, position, trees));
+
+		swarm->positionX[i] = position.x;
+		swarm->positionY[i] = position.y;
+		swarm->positionZ[i] = position.z;
+		swarm->angle[i] = ((GLfloat)rand() / RAND_MAX) * 360;
+	}
+
+	return swarm;
+}
+
+bool swarmLoadReplay(Swarm* swarm, char* fileName) {
+	FILE* file = fopen(fileName, "r");
+
+	if (file == NULL) {
+		return FALSE;
+	}
+
+	unsigned int capacity = 1024;
+	Quat4 control;
+	Quat4* replay = allocMalloc(ALLOC_SWARM, sizeof(Quat4) * capacity);
+	unsigned int length = 0;
+
+	while (fscanf(file, "%f %f %f %f", &control.x, &control.y, &control.z, &control.w) == 4) {
+		if (length == capacity) {
+			capacity *= 2;
+			replay = allocRealloc(ALLOC_SWARM, replay, sizeof(Quat4) * capacity);
+		}
+		replay[length++] = control;
+	}
+	fclose(file);
+
+	if (length == 0) {
+		allocFree(replay);
+		return FALSE;
+	}
+
+	allocFree(swarm->replay);
+	swarm->replay = replay;
+	swarm->replayLength = length;
+	return TRUE;
+}
+
+Quat4 swarmControl(Swarm* swarm, unsigned int drone, unsigned int tick) {
+	if (swarm->replay != NULL) {
+		return swarm->replay[(tick + drone * SWARM_REPLAY_STRIDE) % swarm->replayLength];
+	}
+
+	// Mostly fly forward while turning a random way, changing every interval (offset per drone so
+	// they don't all change at once), and keep between the script heights
+	const unsigned int hash = swarmHash(drone * 7919 + (tick + drone) / SWARM_SCRIPT_INTERVAL);
+	Quat4 control = {
+		(hash & 3) ? MOTION_FORWARD : MOTION_NONE,
+		MOTION_NONE,
+		MOTION_NONE,
+		(GLfloat)((int)((hash >> 2) % 3) - 1)
+	};
+
+	const GLfloat height = swarm->positionY[drone] - (helicopterFloor(swarm->positionX[drone], swarm->positionZ[drone]) - HELI_MIN_HEIGHT);
+	if (height < SWARM_SCRIPT_MIN_HEIGHT) { control.y = MOTION_UP; }
+	if (height > SWARM_SCRIPT_MAX_HEIGHT) { control.y = MOTION_DOWN; }
+
+	return control;
+}
+
+// Steps a range of drones forward by one tick, the same way helicopterThink moves the player. The
+// steering is done over the whole range at once with the batch vector functions, then each drone
+// is moved and collided on its own
+void swarmStepRange(Swarm* swarm, unsigned int begin, unsigned int end, unsigned int tick, GLfloat deltaTime) {
+	const unsigned int count = end - begin;
+
+	for (unsigned int i = begin; i < end; ++i) {
+		const Quat4 control = swarmControl(swarm, i, tick);
+
+		swarm->angularVelocity[i] = lerp(swarm->angularVelocity[i], control.w * YAW_SPEED * deltaTime, 0.15);
+		swarm->angle[i] = angleWrap(swarm->angle[i] + swarm->angularVelocity[i]);
+
+		swarm->targetX[i] = control.x * MOVE_SPEED * deltaTime;
+		swarm->targetY[i] = control.y * MOVE_SPEED * deltaTime;
+		swarm->targetZ[i] = control.z * MOVE_SPEED * deltaTime;
+		swarm->sines[i] = -swarm->angle[i];
+	}
+
+	// The sines array holds the angles to rotate by until it's replaced with their sines
+	angleSinCosBatch(&swarm->sines[begin], &swarm->sines[begin], &swarm->cosines[begin], count);
+	rotateXZBatch(&swarm->targetX[begin], &swarm->targetZ[begin], &swarm->sines[begin], &swarm->cosines[begin], count);
+
+	lerpBatch(&swarm->velocityX[begin], &swarm->targetX[begin], 0.15, count);
+	lerpBatch(&swarm->velocityY[begin], &swarm->targetY[begin], 0.15, count);
+	lerpBatch(&swarm->velocityZ[begin], &swarm->targetZ[begin], 0.15, count);
+
+	for (unsigned int i = begin; i < end; ++i) {
+		Vec3 position = { swarm->positionX[i], swarm->positionY[i], swarm->positionZ[i] };
+		Vec3 velocity = { swarm->velocityX[i], swarm->velocityY[i], swarm->velocityZ[i] };
+
+		swarm->atEdge[i] = helicopterSlide(&position, &velocity, swarm->trees, &swarm->grid);
+
+		swarm->positionX[i] = position.x;
+		swarm->positionY[i] = position.y;
+		swarm->positionZ[i] = position.z;
+		swarm->velocityX[i] = velocity.x;
+		swarm->velocityY[i] = velocity.y;
+		swarm->velocityZ[i] = velocity.z;
+	}
+}
+
+// Job function, steps a range of the swarm. Drones never affect each other, so each range can run
+// every tick without waiting on the other ranges
+void swarmStepJob(void* data, unsigned int begin, unsigned int end) {
+	SwarmStep* step = data;
+
+	for (unsigned int tick = 0; tick < step->ticks; ++tick) {
+		swarmStepRange(step->swarm, begin, end, step->swarm->tick + tick, step->deltaTime);
+	}
+}
+
+void swarmAdvance(Swarm* swarm, unsigned int ticks, GLfloat deltaTime) {
+	SwarmStep step = { swarm, ticks, deltaTime };
+	jobParallelFor(swarmStepJob, &step, swarm->count, SWARM_JOB_GRAIN);
+
+	swarm->tick += ticks;
+	swarm->rotorAngle = angleWrap(swarm->rotorAngle + ROTOR_SPEED * deltaTime * ticks);
+}
+
+SwarmPose* swarmPoseCreate(unsigned int count) {
+	SwarmPose* pose = allocMalloc(ALLOC_SWARM, sizeof(SwarmPose));
+	pose->count = count;
+	pose->positionX = allocCalloc(ALLOC_SWARM, count, sizeof(GLfloat));
+	pose->positionY = allocCalloc(ALLOC_SWARM, count, sizeof(GLfloat));
+	pose->positionZ = allocCalloc(ALLOC_SWARM, count, sizeof(GLfloat));
+	pose->velocityX = allocCalloc(ALLOC_SWARM, count, sizeof(GLfloat));
+	pose->velocityY = allocCalloc(ALLOC_SWARM, count, sizeof(GLfloat));
+	pose->velocityZ = allocCalloc(ALLOC_SWARM, count, sizeof(GLfloat));
+	pose->angle = allocCalloc(ALLOC_SWARM, count, sizeof(GLfloat));
+	pose->rotorAngle = 0;
+	return pose;
+}
+
+void swarmPoseCopy(Swarm* swarm, SwarmPose* pose) {
+	const size_t size = sizeof(GLfloat) * swarm->count;
+	memcpy(pose->positionX, swarm->positionX, size);
+	memcpy(pose->positionY, swarm->positionY, size);
+	memcpy(pose->positionZ, swarm->positionZ, size);
+	memcpy(pose->velocityX, swarm->velocityX, size);
+	memcpy(pose->velocityY, swarm->velocityY, size);
+	memcpy(pose->velocityZ, swarm->velocityZ, size);
+	memcpy(pose->angle, swarm->angle, size);
+	pose->rotorAngle = swarm->rotorAngle;
+}
+
+void swarmDisplay(SwarmPose* pose, HelicopterModel* model) {
+	// Every drone is drawn in one go, so their matrices only have to last until the end of the frame
+	Mat4* instances = frameAlloc(pose->count * sizeof(Mat4));
+	for (unsigned int i = 0; i < pose->count; ++i) {
+		instances[i] = helicopterInstance(
+			(Vec3) { pose->positionX[i], pose->positionY[i], pose->positionZ[i] },
+			(Vec3) { pose->velocityX[i], pose->velocityY[i], pose->velocityZ[i] },
+			pose->angle[i]
+		);
+	}
+	helicopterDrawInstances(model, instances, pose->count, pose->rotorAngle);
+}
+
+void swarmFree(Swarm* swarm) {
+	if (swarm != NULL) {
+		allocFree(swarm->positionX);
+		allocFree(swarm->positionY);
+		allocFree(swarm->positionZ);
+		allocFree(swarm->velocityX);
+		allocFree(swarm->velocityY);
+		allocFree(swarm->velocityZ);
+		allocFree(swarm->angle);
+		allocFree(swarm->angularVelocity);
+		allocFree(swarm->atEdge);
+		allocFree(swarm->targetX);
+		allocFree(swarm->targetY);
+		allocFree(swarm->targetZ);
+		allocFree(swarm->sines);
+		allocFree(swarm->cosines);
+		allocFree(swarm->replay);
+		allocFree(swarm);
+	}
+}
+
+void swarmPoseFree(SwarmPose* pose) {
+	if (pose != NULL) {
+		allocFree(pose->positionX);
+		allocFree(pose->positionY);
+		allocFree(pose->positionZ);
+		allocFree(pose->velocityX);
+		allocFree(pose->velocityY);
+		allocFree(pose->velocityZ);
+		allocFree(pose->angle);
+		allocFree(pose);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "helicopter.h"
+#include "job.h"
+#include "alloc.h"
+
+/*
+ * <swarm.c/swarm.h> Simulates and draws a swarm of drones flying alongside the player. The
+ * drones' state is stored as one array per field, and the swarm is split into ranges that
+ * are stepped in parallel as jobs against a shared, read only tree grid
+ */
+
+// Most drones one job steps
+#define SWARM_JOB_GRAIN 64
+// Number of ticks a scripted drone holds each control input for
+#define SWARM_SCRIPT_INTERVAL 90
+// Heights above the ground that scripted drones try to stay between
+#define SWARM_SCRIPT_MIN_HEIGHT 5
+#define SWARM_SCRIPT_MAX_HEIGHT 25
+// Spacing (in ticks) between where each drone starts playing back a replay
+#define SWARM_REPLAY_STRIDE 97
+
+typedef struct SWARM {
+	unsigned int count; // Number of drones in the swarm
+	GLfloat* positionX, * positionY, * positionZ; // The drones' current positions
+	GLfloat* velocityX, * velocityY, * velocityZ; // The drones' current velocities
+	GLfloat* angle; // The drones' angles in the XZ plane in degrees
+	GLfloat* angularVelocity; // The drones' current turn speeds
+	bool* atEdge; // If each drone is pushing against the edge of the scene
+	GLfloat* targetX, * targetY, * targetZ; // Scratch space for the velocities the drones are steering towards
+	GLfloat* sines, * cosines; // Scratch space for rotating the target velocities
+	Quat4* replay; // Recorded control inputs the drones play back, or NULL to script their inputs
+	unsigned int replayLength; // Number of ticks in the replay
+	unsigned int tick; // Number of ticks the swarm has been simulated for
+	GLfloat rotorAngle; // Angle of every drone's rotors, which all spin together
+	TreeObject* trees; // The trees the drones collide with
+	TreeGrid grid; // The trees bucketed for collision queries
+} Swarm;
+
+// What drawing the swarm needs of it, copied out so it can be drawn while the swarm is being simulated
+typedef struct SWARMPOSE {
+	unsigned int count;
+	GLfloat* positionX, * positionY, * positionZ;
+	GLfloat* velocityX, * velocityY, * velocityZ;
+	GLfloat* angle;
+	GLfloat rotorAngle;
+} SwarmPose;
+
+// Creates a swarm of drones at random clear positions around the scene
+Swarm* swarmCreate(unsigned int count, TreeObject* trees);
+// Loads control inputs recorded with --record for the drones to play back. Returns FALSE if the file can't be read
+bool swarmLoadReplay(Swarm* swarm, char* fileName);
+// Returns the control input of a drone on a given tick, from the replay or the drone's script
+Quat4 swarmControl(Swarm* swarm, unsigned int drone, unsigned int tick);
+// Simulates the swarm for a number of ticks, split into jobs over the job scheduler's threads
+void swarmAdvance(Swarm* swarm, unsigned int ticks, GLfloat deltaTime);
+// Creates a pose with room for a number of drones
+SwarmPose* swarmPoseCreate(unsigned int count);
+// Copies the drones' current positions, velocities and angles into a pose of the same size
+void swarmPoseCopy(Swarm* swarm, SwarmPose* pose);
+// Draws every drone in a pose of the swarm from a helicopter model, each part of them in one instanced draw
+void swarmDisplay(SwarmPose* pose, HelicopterModel* model);
+// Frees a swarm and all of its drones
+void swarmFree(Swarm* swarm);
+// Frees a pose of the swarm
+void swarmPoseFree(SwarmPose* pose);
@@ -0,0 +1,412 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "terrain.h"
+
+Terrain* terrainLoad(char* fileName) {
+	size_t length = 0;
+	unsigned char* data = packRead(fileName, &length);
+
+	if (data == NULL || length == 0) {
+		allocFree(data);
+		return NULL;
+	}
+
+	GLfloat* heights = NULL;
+	unsigned int size = 0;
+
+	if (length > 2 && data[0] == 'P' && (data[1] == '2' || data[1] == '3' || data[1] == '5' || data[1] == '6')) {
+		// PNM, taking the smaller of the width and height so the heightmap is square
+		const bool binary = data[1] == '5' || data[1] == '6';
+		const unsigned int channels = data[1] == '3' || data[1] == '6' ? 3 : 1;
+		size_t offset = 2;
+		const int width = readPNMNumber(data, length, &offset);
+		const int height = readPNMNumber(data, length, &offset);
+		const int maxValue = readPNMNumber(data, length, &offset);
+		const unsigned int bytes = maxValue > 255 ? 2 : 1;
+		++offset; // Single whitespace character before the binary data
+
+		if (width < 2 || height < 2 || maxValue <= 0 || (binary && offset + (size_t)width * height * channels * bytes > length)) {
+			allocFree(data);
+			return NULL;
+		}
+
+		size = width < height ? width : height;
+		heights = malloc(size * size * sizeof(GLfloat));
+
+		for (unsigned int row = 0; row < size; ++row) {
+			for (unsigned int column = 0; column < (unsigned int)width; ++column) {
+				int value = 0;
+
+				for (unsigned int channel = 0; channel < channels; ++channel) {
+					int sample;
+					if (binary) {
+						sample = bytes == 2 ? (data[offset] << 8) | data[offset + 1] : data[offset];
+						offset += bytes;
+					} else {
+						sample = readPNMNumber(data, length, &offset);
+					}
+					// Only the red channel of a colour image is used
+					if (channel == 0) { value = sample; }
+				}
+
+				if (column < size) {
+					heights[row * size + column] = (GLfloat)value / maxValue;
+				}
+			}
+		}
+	} else {
+		// Raw, as a square of 8 bit values or else little endian 16 bit ones
+		const unsigned int side8 = (unsigned int)(sqrt((double)length) + 0.5);
+		const unsigned int side16 = (unsigned int)(sqrt((double)length / 2) + 0.5);
+
+		if (side8 * side8 == length) {
+			size = side8;
+			heights = malloc(size * size * sizeof(GLfloat));
+			for (unsigned int i = 0; i < size * size; ++i) {
+				heights[i] = data[i] / 255.0f;
+			}
+		} else if (side16 * side16 * 2 == length) {
+			size = side16;
+			heights = malloc(size * size * sizeof(GLfloat));
+			for (unsigned int i = 0; i < size * size; ++i) {
+				heights[i] = (data[2 * i] | (data[2 * i + 1] << 8)) / 65535.0f;
+			}
+		}
+	}
+
+	allocFree(data);
+
+	if (heights == NULL || size < 2) {
+		free(heights);
+		return NULL;
+	}
+
+	Terrain* terrain = terrainCreate(heights, size, TRUE);
+	free(heights);
+	return terrain;
+}
+
+// Returns a height from the heightmap, clamping the row and column to its edges
+GLfloat terrainHeightAt(Terrain* terrain, int column, int row) {
+	const int last = (int)terrain->size - 1;
+	column = column < 0 ? 0 : column > last ? last : column;
+	row = row < 0 ? 0 : row > last ? last : row;
+	return terrain->heights[row * terrain->size + column];
+}
+
+// Returns the normal at a point on the heightmap grid, from the heights either side of it
+Vec3 terrainNormalAt(Terrain* terrain, int column, int row) {
+	const GLfloat slopeX = (terrainHeightAt(terrain, column + 1, row) - terrainHeightAt(terrain, column - 1, row)) / (2 * terrain->spacing);
+	const GLfloat slopeZ = (terrainHeightAt(terrain, column, row + 1) - terrainHeightAt(terrain, column, row - 1)) / (2 * terrain->spacing);
+	const GLfloat length = sqrt(slopeX * slopeX + 1 + slopeZ * slopeZ);
+	return (Vec3) { -slopeX / length, 1 / length, -slopeZ / length };
+}
+
+// Returns the vertex for a point on the heightmap grid, lowered by a depth for skirts
+Vertex terrainVertex(Terrain* terrain, int column, int row, GLfloat depth) {
+	const GLfloat x = terrain->origin + column * terrain->spacing;
+	const GLfloat z = terrain->origin + row * terrain->spacing;
+	const Vec3 normal = terrainNormalAt(terrain, column, row);
+
+	return (Vertex) {
+		{ x, terrainHeightAt(terrain, column, row) - depth, z },
+		{ normal.x, normal.y, normal.z },
+		{ x / TERRAIN_TEXTURE_SIZE, z / TERRAIN_TEXTURE_SIZE }
+	};
+}
+
+// Finds the grid position of the i'th vertex along one edge of a chunk with the given number of tiles per side
+void terrainEdgePoint(unsigned int edge, unsigned int i, unsigned int tiles, unsigned int* column, unsigned int* row) {
+	switch (edge) {
+	case 0: *column = i; *row = 0; break;
+	case 1: *column = tiles; *row = i; break;
+	case 2: *column = tiles - i; *row = tiles; break;
+	default: *column = 0; *row = tiles - i; break;
+	}
+}
+
+// Builds one chunk at one level of detail, as triangles with a skirt around its edges
+VertexBuffer* terrainBuildChunkLevel(Terrain* terrain, TerrainChunk* chunk, unsigned int chunkX, unsigned int chunkZ, unsigned int level) {
+	const unsigned int step = 1 << level;
+	const unsigned int tiles = TERRAIN_CHUNK_TILES / step;
+	const unsigned int side = tiles + 1;
+	const int firstColumn = chunkX * TERRAIN_CHUNK_TILES, firstRow = chunkZ * TERRAIN_CHUNK_TILES;
+	// The skirt only has to reach as far down as the chunk's lowest point to cover any crack
+	const GLfloat skirtDepth = chunk->max.y - chunk->min.y + 1;
+
+	Vertex* vertices = malloc((side * side + 4 * side) * sizeof(Vertex));
+	GLuint* indices = malloc((tiles * tiles * 6 + 4 * tiles * 6) * sizeof(GLuint));
+	unsigned int vertexCount = 0, indexCount = 0;
+
+	for (unsigned int row = 0; row < side; ++row) {
+		for (unsigned int column = 0; column < side; ++column) {
+			vertices[vertexCount++] = terrainVertex(terrain, firstColumn + column * step, firstRow + row * step, 0);
+		}
+	}
+
+	// Two triangles per tile, wound anticlockwise seen from above
+	for (unsigned int row = 0; row < tiles; ++row) {
+		for (unsigned int column = 0; column < tiles; ++column) {
+			const GLuint corner = row * side + column;
+			const GLuint tile[6] = { corner, corner + side, corner + 1, corner + 1, corner + side, corner + side + 1 };
+			memcpy(&indices[indexCount], tile, sizeof(tile));
+			indexCount += 6;
+		}
+	}
+
+	// The skirt along each edge, joining each of the edge's vertices to a lowered copy of itself
+	for (unsigned int edge = 0; edge < 4; ++edge) {
+		for (unsigned int i = 0; i < side; ++i) {
+			unsigned int column, row;
+			terrainEdgePoint(edge, i, tiles, &column, &row);
+			vertices[vertexCount++] = terrainVertex(terrain, firstColumn + column * step, firstRow + row * step, skirtDepth);
+
+			if (i > 0) {
+				unsigned int previousColumn, previousRow;
+				terrainEdgePoint(edge, i - 1, tiles, &previousColumn, &previousRow);
+
+				const GLuint top = row * side + column, previousTop = previousRow * side + previousColumn;
+				const GLuint quad[6] = { previousTop, vertexCount - 2, top, top, vertexCount - 2, vertexCount - 1 };
+				memcpy(&indices[indexCount], quad, sizeof(quad));
+				indexCount += 6;
+			}
+		}
+	}
+
+	VertexBuffer* buffer = vertexBufferCreate(GL_TRIANGLES, vertices, vertexCount, indices, indexCount);
+	free(vertices);
+	free(indices);
+	return buffer;
+}
+
+Terrain* terrainCreate(GLfloat* heights, unsigned int size, bool buildMeshes) {
+	Terrain* terrain = calloc(1, sizeof(Terrain));
+	const unsigned int chunks = (size - 1 + TERRAIN_CHUNK_TILES - 1) / TERRAIN_CHUNK_TILES;
+
+	terrain->chunksPerSide = chunks > 0 ? chunks : 1;
+	terrain->size = terrain->chunksPerSide * TERRAIN_CHUNK_TILES + 1;
+	terrain->spacing = (GLfloat)TERRAIN_SIZE / (terrain->size - 1);
+	terrain->origin = -TERRAIN_SIZE / 2.0f;
+	terrain->heights = malloc(terrain->size * terrain->size * sizeof(GLfloat));
+	terrain->maxHeight = TERRAIN_HEIGHT_OFFSET;
+
+	// Resample the heightmap onto a grid that divides into chunks evenly
+	const GLfloat scale = (GLfloat)(size - 1) / (terrain->size - 1);
+	for (unsigned int row = 0; row < terrain->size; ++row) {
+		for (unsigned int column = 0; column < terrain->size; ++column) {
+			const GLfloat x = column * scale, z = row * scale;
+			const unsigned int x0 = (unsigned int)x < size - 1 ? (unsigned int)x : size - 2;
+			const unsigned int z0 = (unsigned int)z < size - 1 ? (unsigned int)z : size - 2;
+			const GLfloat fx = x - x0, fz = z - z0;
+			const GLfloat near = heights[z0 * size + x0] + (heights[z0 * size + x0 + 1] - heights[z0 * size + x0]) * fx;
+			const GLfloat far = heights[(z0 + 1) * size + x0] + (heights[(z0 + 1) * size + x0 + 1] - heights[(z0 + 1) * size + x0]) * fx;
+			const GLfloat height = TERRAIN_HEIGHT_OFFSET + (near + (far - near) * fz) * TERRAIN_HEIGHT_SCALE;
+
+			terrain->heights[row * terrain->size + column] = height;
+			terrain->maxHeight = fmax(terrain->maxHeight, height);
+		}
+	}
+
+	terrain->chunks = calloc(terrain->chunksPerSide * terrain->chunksPerSide, sizeof(TerrainChunk));
+	terrain->order = malloc(terrain->chunksPerSide * terrain->chunksPerSide * sizeof(TerrainChunk*));
+
+	for (unsigned int chunkZ = 0; chunkZ < terrain->chunksPerSide; ++chunkZ) {
+		for (unsigned int chunkX = 0; chunkX < terrain->chunksPerSide; ++chunkX) {
+			TerrainChunk* chunk = &terrain->chunks[chunkZ * terrain->chunksPerSide + chunkX];
+			GLfloat low = FLT_MAX, high = -FLT_MAX;
+
+			for (unsigned int row = 0; row <= TERRAIN_CHUNK_TILES; ++row) {
+				for (unsigned int column = 0; column <= TERRAIN_CHUNK_TILES; ++column) {
+					const GLfloat height = terrainHeightAt(terrain, chunkX * TERRAIN_CHUNK_TILES + column, chunkZ * TERRAIN_CHUNK_TILES + row);
+					low = fmin(low, height);
+					high = fmax(high, height);
+				}
+			}
+
+			chunk->min = (Vec3) { terrain->origin + chunkX * TERRAIN_CHUNK_TILES * terrain->spacing, low, terrain->origin + chunkZ * TERRAIN_CHUNK_TILES * terrain->spacing };
+			chunk->max = (Vec3) { chunk->min.x + TERRAIN_CHUNK_TILES * terrain->spacing, high, chunk->min.z + TERRAIN_CHUNK_TILES * terrain->spacing };
+
+			for (unsigned int level = 0; level < TERRAIN_LOD_LEVELS; ++level) {
+				const unsigned int tiles = TERRAIN_CHUNK_TILES >> level;
+				chunk->triangles[level] = 2 * tiles * tiles + 8 * tiles;
+				if (buildMeshes) {
+					chunk->levels[level] = terrainBuildChunkLevel(terrain, chunk, chunkX, chunkZ, level);
+				}
+			}
+		}
+	}
+
+	return terrain;
+}
+
+GLfloat* terrainGenerateHeights(unsigned int size, unsigned int seed) {
+	// Value noise on a lattice of random values, added up over several octaves
+	const unsigned int lattice = 64;
+	GLfloat* values = malloc(lattice * lattice * sizeof(GLfloat));
+	GLfloat* heights = malloc(size * size * sizeof(GLfloat));
+	unsigned int state = seed * 2654435761u + 1;
+	GLfloat low = FLT_MAX, high = -FLT_MAX;
+
+	for (unsigned int i = 0; i < lattice * lattice; ++i) {
+		state = state * 1664525u + 1013904223u;
+		values[i] = (state >> 8) / 16777216.0f;
+	}
+
+	for (unsigned int row = 0; row < size; ++row) {
+		for (unsigned int column = 0; column < size; ++column) {
+			GLfloat height = 0, amplitude = 1, frequency = 3;
+
+			for (unsigned int octave = 0; octave < 5; ++octave) {
+				const GLfloat x = (GLfloat)column / (size - 1) * frequency, z = (GLfloat)row / (size - 1) * frequency;
+				const unsigned int x0 = (unsigned int)x, z0 = (unsigned int)z;
+				// Smoothstep between lattice points, so the hills don't have creases along the lattice lines
+				const GLfloat fx = (x - x0) * (x - x0) * (3 - 2 * (x - x0)), fz = (z - z0) * (z - z0) * (3 - 2 * (z - z0));
+				const GLfloat v00 = values[(z0 % lattice) * lattice + x0 % lattice], v10 = values[(z0 % lattice) * lattice + (x0 + 1) % lattice];
+				const GLfloat v01 = values[((z0 + 1) % lattice) * lattice + x0 % lattice], v11 = values[((z0 + 1) % lattice) * lattice + (x0 + 1) % lattice];
+				height += amplitude * (v00 + (v10 - v00) * fx + (v01 - v00 + (v11 - v10 - v01 + v00) * fx) * fz);
+
+				amplitude *= 0.5f;
+				frequency *= 2;
+			}
+
+			heights[row * size + column] = height;
+			low = fmin(low, height);
+			high = fmax(high, height);
+		}
+	}
+
+	// Normalise, then sink a basin in the middle where the pond is, with the hills rising up around it
+	for (unsigned int row = 0; row < size; ++row) {
+		for (unsigned int column = 0; column < size; ++column) {
+			const GLfloat x = ((GLfloat)column / (size - 1) - 0.5f) * TERRAIN_SIZE, z = ((GLfloat)row / (size - 1) - 0.5f) * TERRAIN_SIZE;
+			const GLfloat distance = sqrt(x * x + z * z);
+			const GLfloat t = fmin(fmax((distance - 30) / 60, 0), 1);
+			const GLfloat rise = t * t * (3 - 2 * t);
+			const GLfloat height = (heights[row * size + column] - low) / (high - low);
+
+			heights[row * size + column] = rise * (0.1f + 0.9f * height * height);
+		}
+	}
+
+	free(values);
+	return heights;
+}
+
+bool terrainSaveHeights(char* fileName, GLfloat* heights, unsigned int size) {
+	FILE* file = fopen(fileName, "wb");
+
+	if (file == NULL) {
+		return FALSE;
+	}
+
+	fprintf(file, "P5\n%u %u\n255\n", size, size);
+	for (unsigned int i = 0; i < size * size; ++i) {
+		fputc((int)(fmin(fmax(heights[i], 0), 1) * 255 + 0.5f), file);
+	}
+
+	fclose(file);
+	return TRUE;
+}
+
+GLfloat terrainHeight(Terrain* terrain, GLfloat x, GLfloat z) {
+	const GLfloat last = (GLfloat)(terrain->size - 1);
+	const GLfloat gridX = fmin(fmax((x - terrain->origin) / terrain->spacing, 0), last);
+	const GLfloat gridZ = fmin(fmax((z - terrain->origin) / terrain->spacing, 0), last);
+	const unsigned int column = gridX < last ? (unsigned int)gridX : terrain->size - 2;
+	const unsigned int row = gridZ < last ? (unsigned int)gridZ : terrain->size - 2;
+	const GLfloat fx = gridX - column, fz = gridZ - row;
+	const GLfloat* near = &terrain->heights[row * terrain->size + column];
+	const GLfloat* far = near + terrain->size;
+
+	const GLfloat nearHeight = near[0] + (near[1] - near[0]) * fx;
+	const GLfloat farHeight = far[0] + (far[1] - far[0]) * fx;
+	return nearHeight + (farHeight - nearHeight) * fz;
+}
+
+Vec3 terrainNormal(Terrain* terrain, GLfloat x, GLfloat z) {
+	const GLfloat step = terrain->spacing / 2;
+	const GLfloat slopeX = (terrainHeight(terrain, x + step, z) - terrainHeight(terrain, x - step, z)) / (2 * step);
+	const GLfloat slopeZ = (terrainHeight(terrain, x, z + step) - terrainHeight(terrain, x, z - step)) / (2 * step);
+	const GLfloat length = sqrt(slopeX * slopeX + 1 + slopeZ * slopeZ);
+	return (Vec3) { -slopeX / length, 1 / length, -slopeZ / length };
+}
+
+// Orders chunks from furthest to nearest
+int terrainCompareChunks(const void* a, const void* b) {
+	const GLfloat distanceA = (*(TerrainChunk**)a)->distance, distanceB = (*(TerrainChunk**)b)->distance;
+	return distanceA < distanceB ? 1 : distanceA > distanceB ? -1 : 0;
+}
+
+void terrainSelect(Terrain* terrain, Vec3 camera, unsigned int triangleBudget) {
+	const unsigned int chunkCount = terrain->chunksPerSide * terrain->chunksPerSide;
+	unsigned int triangles = 0;
+
+	for (unsigned int i = 0; i < chunkCount; ++i) {
+		TerrainChunk* chunk = &terrain->chunks[i];
+		// Distance to the closest point of the chunk's bounding box
+		const GLfloat dx = fmax(fmax(chunk->min.x - camera.x, camera.x - chunk->max.x), 0);
+		const GLfloat dy = fmax(fmax(chunk->min.y - camera.y, camera.y - chunk->max.y), 0);
+		const GLfloat dz = fmax(fmax(chunk->min.z - camera.z, camera.z - chunk->max.z), 0);
+		chunk->distance = sqrt(dx * dx + dy * dy + dz * dz);
+
+		GLfloat levelDistance = TERRAIN_LOD_DISTANCE;
+		chunk->level = 0;
+		while (chunk->level < TERRAIN_LOD_LEVELS - 1 && chunk->distance > levelDistance) {
+			++chunk->level;
+			levelDistance *= 2;
+		}
+
+		triangles += chunk->triangles[chunk->level];
+		terrain->order[i] = chunk;
+	}
+
+	// Over budget, so coarsen the furthest chunks a level at a time until it fits
+	if (triangles > triangleBudget) {
+		bool coarsened = TRUE;
+		qsort(terrain->order, chunkCount, sizeof(TerrainChunk*), terrainCompareChunks);
+
+		while (triangles > triangleBudget && coarsened) {
+			coarsened = FALSE;
+			for (unsigned int i = 0; i < chunkCount && triangles > triangleBudget; ++i) {
+				TerrainChunk* chunk = terrain->order[i];
+				if (chunk->level < TERRAIN_LOD_LEVELS - 1) {
+					triangles -= chunk->triangles[chunk->level];
+					++chunk->level;
+					triangles += chunk->triangles[chunk->level];
+					coarsened = TRUE;
+				}
+			}
+		}
+	}
+
+	terrain->drawnTriangles = triangles;
+}
+
+void terrainDrawChunk(Terrain* terrain, unsigned int index, const RenderMaterial* material) {
+	const TerrainChunk* chunk = &terrain->chunks[index];
+	if (chunk->levels[chunk->level] != NULL) {
+		renderDrawBuffer(chunk->levels[chunk->level], NULL, material);
+	}
+}
+
+void terrainDraw(Terrain* terrain, const RenderMaterial* material) {
+	for (unsigned int i = 0; i < terrain->chunksPerSide * terrain->chunksPerSide; ++i) {
+		terrainDrawChunk(terrain, i, material);
+	}
+}
+
+void terrainFree(Terrain* terrain) {
+	if (terrain == NULL) {
+		return;
+	}
+
+	for (unsigned int i = 0; i < terrain->chunksPerSide * terrain->chunksPerSide; ++i) {
+		for (unsigned int level = 0; level < TERRAIN_LOD_LEVELS; ++level) {
+			vertexBufferFree(terrain->chunks[i].levels[level]);
+		}
+	}
+
+	free(terrain->heights);
+	free(terrain->chunks);
+	free(terrain->order);
+	free(terrain);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <freeglut.h>
+#include "buffer.h"
+#include "render.h"
+#include "loader.h"
+#include "vecmath.h"
+
+/*
+ * <terrain.c/terrain.h> Heightmap terrain. The heightmap is split into square chunks, and each chunk
+ * is built at a few levels of detail, every level using half the vertices of the one before along each
+ * axis. Each frame, chunks further from the camera are drawn at coarser levels, and the furthest are
+ * coarsened again until the whole terrain fits into a triangle budget. Skirts hanging down from the
+ * edges of every chunk hide the cracks between neighbours drawn at different levels
+ *
+ * Heights can be looked up at any point in constant time, which is what collision uses
+ */
+
+// Size of the terrain in world units along each axis, centred on the origin
+#define TERRAIN_SIZE 510
+// Height in world units of the brightest value in a heightmap
+#define TERRAIN_HEIGHT_SCALE 30
+// Height the darkest value in a heightmap sits at, a little under the water so the pond can be carved out
+#define TERRAIN_HEIGHT_OFFSET -3
+// Number of tiles along each side of a chunk at the finest level, which heightmaps are resampled to fit
+#define TERRAIN_CHUNK_TILES 32
+// Number of levels of detail each chunk is built at
+#define TERRAIN_LOD_LEVELS 4
+// Distance from the camera within which chunks are drawn at the finest level. Each level after
+// that covers twice the distance of the one before
+#define TERRAIN_LOD_DISTANCE 60
+// Largest number of triangles drawn in a frame, if the distances alone would draw more
+#define TERRAIN_TRIANGLE_BUDGET 40000
+// Size of the ground texture on the terrain, the same as a ground tile
+#define TERRAIN_TEXTURE_SIZE 5
+
+typedef struct TERRAINCHUNK {
+	Vec3 min, max;									// Bounding box of the chunk
+	VertexBuffer* levels[TERRAIN_LOD_LEVELS];		// The chunk at each level of detail, finest first
+	unsigned int triangles[TERRAIN_LOD_LEVELS];		// Number of triangles at each level, skirts included
+	unsigned int level;								// Level picked for the frame by terrainSelect
+	GLfloat distance;								// Distance from the camera when it was last selected
+} TerrainChunk;
+
+typedef struct TERRAIN {
+	unsigned int size;		// Number of heights along each side of the heightmap
+	GLfloat spacing;		// Distance between neighbouring heights
+	GLfloat origin;			// World position of the first height along each axis
+	GLfloat maxHeight;		// Height of the highest point on the terrain
+	GLfloat* heights;		// The heightmap in world units, row by row along z
+	unsigned int chunksPerSide;
+	TerrainChunk* chunks;
+	TerrainChunk** order;	// Every chunk, sorted furthest first when the budget needs the furthest coarsened
+	unsigned int drawnTriangles; // Triangles the last selection will draw
+} Terrain;
+
+// Loads a heightmap from the assets folder into a terrain. Binary and ASCII PGM and PPM files (the red
+// channel is used) are read as greyscale, anything else is read as a raw square of 8 or 16 bit values.
+// Returns NULL if the file can't be read
+Terrain* terrainLoad(char* fileName);
+// Creates a terrain from a square array of heights between 0 and 1, resampling it so it divides into
+// chunks evenly. The chunk meshes are only built if buildMeshes is set, which needs an OpenGL context
+Terrain* terrainCreate(GLfloat* heights, unsigned int size, bool buildMeshes);
+// Generates a square array of rolling hills between 0 and 1 with a basin in the middle for the pond.
+// Returns memory that must be free()'d
+GLfloat* terrainGenerateHeights(unsigned int size, unsigned int seed);
+// Writes a heightmap array as a binary PGM file, so generated hills can be saved as an asset
+bool terrainSaveHeights(char* fileName, GLfloat* heights, unsigned int size);
+// Returns the height of the terrain at a point on the XZ plane, interpolated between the
+// surrounding heights. Points past the edge take the height at the edge
+GLfloat terrainHeight(Terrain* terrain, GLfloat x, GLfloat z);
+// Returns the surface normal of the terrain at a point on the XZ plane
+Vec3 terrainNormal(Terrain* terrain, GLfloat x, GLfloat z);
+// Picks the level of detail each chunk is drawn at for a camera position, keeping within a triangle budget
+void terrainSelect(Terrain* terrain, Vec3 camera, unsigned int triangleBudget);
+// Draws one chunk with a material, by its index in the chunk array, at the level picked by the last terrainSelect
+void terrainDrawChunk(Terrain* terrain, unsigned int index, const RenderMaterial* material);
+// Draws every chunk with a material, at the level picked by the last terrainSelect
+void terrainDraw(Terrain* terrain, const RenderMaterial* material);
+// Frees a terrain and all of its chunk meshes
+void terrainFree(Terrain* terrain);
@@ -0,0 +1,194 @@
+#include "text.h"
+
+TextRenderer textRenderer;
+
+// Returns the smallest power of two at least as big as a size, since OpenGL 1.1 textures have to be
+unsigned int textPowerOfTwo(unsigned int size) {
+	unsigned int power = 1;
+	while (power < size) {
+		power *= 2;
+	}
+	return power;
+}
+
+bool textInit(void) {
+	TextRenderer* text = &textRenderer;
+	GLint viewport[4];
+	unsigned int widest = 0;
+
+	text->texture = 0;
+	text->glyphCount = 0;
+	for (unsigned int i = 0; i < TEXT_CHARACTER_COUNT; ++i) {
+		text->advances[i] = (unsigned char)glutBitmapWidth(TEXT_FONT, TEXT_FIRST_CHARACTER + i);
+		widest = text->advances[i] > widest ? text->advances[i] : widest;
+	}
+	text->lineHeight = glutBitmapHeight(TEXT_FONT);
+	text->cellWidth = widest + TEXT_GLYPH_PADDING * 2;
+	text->cellHeight = text->lineHeight + TEXT_GLYPH_PADDING * 2;
+	text->atlasWidth = textPowerOfTwo(TEXT_ATLAS_COLUMNS * text->cellWidth);
+	text->atlasHeight = textPowerOfTwo((TEXT_CHARACTER_COUNT + TEXT_ATLAS_COLUMNS - 1) / TEXT_ATLAS_COLUMNS * text->cellHeight);
+
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((unsigned int)viewport[2] < text->atlasWidth || (unsigned int)viewport[3] < text->atlasHeight) {
+		printf("The window is too small to build the font atlas in, so no text will be drawn\n");
+		return FALSE;
+	}
+
+	// Each character is drawn white on black in its own cell, with the baseline TEXT_DESCENT above the bottom
+	// of its line, exactly as glutBitmapString would draw it
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_PIXEL_MODE_BIT);
+	glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_FOG);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	gluOrtho2D(0, viewport[2], 0, viewport[3]);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glClearColor(0, 0, 0, 0);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glColor3f(1, 1, 1);
+	for (unsigned int i = 0; i < TEXT_CHARACTER_COUNT; ++i) {
+		const unsigned int column = i % TEXT_ATLAS_COLUMNS, row = i / TEXT_ATLAS_COLUMNS;
+		glRasterPos2i(column * text->cellWidth + TEXT_GLYPH_PADDING, row * text->cellHeight + TEXT_GLYPH_PADDING + TEXT_DESCENT);
+		glutBitmapCharacter(TEXT_FONT, TEXT_FIRST_CHARACTER + i);
+	}
+
+	GLubyte* pixels = malloc(text->atlasWidth * text->atlasHeight);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glReadPixels(viewport[0], viewport[1], text->atlasWidth, text->atlasHeight, GL_RED, GL_UNSIGNED_BYTE, pixels);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glGenTextures(1, &text->texture);
+	glBindTexture(GL_TEXTURE_2D, text->texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA8, text->atlasWidth, text->atlasHeight, 0, GL_ALPHA, GL_UNSIGNED_BYTE, pixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	free(pixels);
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glPopClientAttrib();
+	glPopAttrib();
+	return TRUE;
+}
+
+void textQueue(char* text, Vec2 position, GLfloat colour[4]) {
+	TextRenderer* renderer = &textRenderer;
+	const GLubyte bytes[4] = { (GLubyte)(colour[0] * 255), (GLubyte)(colour[1] * 255), (GLubyte)(colour[2] * 255),
+		(GLubyte)(colour[3] * 255) };
+	// The raster position glutBitmapString started from was rounded down to a whole pixel, so the quads are too,
+	// keeping every texel on exactly one pixel
+	const int left = (int)position.x;
+	int x = left, y = (int)position.y;
+
+	if (renderer->texture == 0) {
+		return;
+	}
+
+	for (; *text != '\0'; ++text) {
+		const unsigned char character = *text;
+		if (character == '\n') {
+			x = left;
+			y -= renderer->lineHeight;
+			continue;
+		}
+		if (character < TEXT_FIRST_CHARACTER || character > TEXT_LAST_CHARACTER || renderer->glyphCount == TEXT_MAX_GLYPHS) {
+			continue;
+		}
+
+		const unsigned int index = character - TEXT_FIRST_CHARACTER;
+		const GLfloat u0 = (GLfloat)(index % TEXT_ATLAS_COLUMNS * renderer->cellWidth) / renderer->atlasWidth;
+		const GLfloat v0 = (GLfloat)(index / TEXT_ATLAS_COLUMNS * renderer->cellHeight) / renderer->atlasHeight;
+		const GLfloat u1 = u0 + (GLfloat)renderer->cellWidth / renderer->atlasWidth;
+		const GLfloat v1 = v0 + (GLfloat)renderer->cellHeight / renderer->atlasHeight;
+		const GLfloat x0 = (GLfloat)(x - TEXT_GLYPH_PADDING), y0 = (GLfloat)(y - TEXT_GLYPH_PADDING - TEXT_DESCENT);
+		const GLfloat x1 = x0 + renderer->cellWidth, y1 = y0 + renderer->cellHeight;
+
+		TextVertex* quad = &renderer->vertices[renderer->glyphCount++ * 4];
+		quad[0] = (TextVertex) { { x0, y0 }, { u0, v0 } };
+		quad[1] = (TextVertex) { { x1, y0 }, { u1, v0 } };
+		quad[2] = (TextVertex) { { x1, y1 }, { u1, v1 } };
+		quad[3] = (TextVertex) { { x0, y1 }, { u0, v1 } };
+		for (unsigned int corner = 0; corner < 4; ++corner) {
+			memcpy(quad[corner].colour, bytes, sizeof(bytes));
+		}
+
+		x += renderer->advances[index];
+	}
+}
+
+void textFlush(void) {
+	TextRenderer* text = &textRenderer;
+	GLint viewport[4];
+
+	if (text->glyphCount == 0) {
+		return;
+	}
+
+	// The quads are drawn through the fixed function pipeline, even in the middle of a shaded scene
+	const bool shaded = renderSuspend();
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	// The colour array leaves the current colour undefined, so it's saved too
+	glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT);
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_FOG);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_STENCIL_TEST);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, text->texture);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	gluOrtho2D(0, viewport[2], 0, viewport[3]);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), text->vertices[0].position);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), text->vertices[0].texCoord);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TextVertex), text->vertices[0].colour);
+	glDrawArrays(GL_QUADS, 0, text->glyphCount * 4);
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glPopClientAttrib();
+	glPopAttrib();
+
+	if (shaded) {
+		renderResume();
+	}
+	text->glyphCount = 0;
+}
+
+void textFree(void) {
+	if (textRenderer.texture != 0) {
+		glDeleteTextures(1, &textRenderer.texture);
+		textRenderer.texture = 0;
+	}
+}
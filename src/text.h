@@ -0,0 +1,58 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freeglut.h>
+#include "misc.h"
+#include "render.h"
+
+/*
+ * <text.c/text.h> Screen text drawn from a texture atlas of GLUT's Helvetica font. GLUT draws bitmap
+ * fonts one glBitmap call per character, which is slow on most drivers, so the font is drawn into the
+ * framebuffer once, read back into an alpha texture, and every string drawn in a frame is queued up as
+ * textured quads and drawn at once, in a single pass over the whole viewport, when the frame is flushed
+ */
+
+// The font the atlas is built from
+#define TEXT_FONT GLUT_BITMAP_HELVETICA_18
+// First and last characters in the atlas. Anything else is skipped over
+#define TEXT_FIRST_CHARACTER 32
+#define TEXT_LAST_CHARACTER 126
+#define TEXT_CHARACTER_COUNT (TEXT_LAST_CHARACTER - TEXT_FIRST_CHARACTER + 1)
+// Number of characters in each row of the atlas
+#define TEXT_ATLAS_COLUMNS 16
+// Space left around each character's cell, for the parts of it drawn outside its width and height
+#define TEXT_GLYPH_PADDING 3
+// Distance from the bottom of the font's line to the baseline, for the parts below it
+#define TEXT_DESCENT 6
+// Most characters that can be queued in one frame. Any more are dropped
+#define TEXT_MAX_GLYPHS 4096
+
+typedef struct TEXTVERTEX {
+	GLfloat position[2];
+	GLfloat texCoord[2];
+	GLubyte colour[4];
+} TextVertex;
+
+typedef struct TEXTRENDERER {
+	GLuint texture;				// The atlas, or 0 if it hasn't been built
+	unsigned int atlasWidth, atlasHeight;
+	unsigned int cellWidth, cellHeight;
+	unsigned int lineHeight;
+	unsigned char advances[TEXT_CHARACTER_COUNT];	// How far the pen moves after each character
+	TextVertex vertices[TEXT_MAX_GLYPHS * 4];		// Four per character queued this frame
+	unsigned int glyphCount;
+} TextRenderer;
+
+extern TextRenderer textRenderer;
+
+// Builds the font atlas, drawing into the current framebuffer and clearing it after. Needs a GLUT window at
+// least as big as the atlas. Returns FALSE if it couldn't be built, when text isn't drawn
+bool textInit(void);
+// Queues a string to be drawn with its baseline starting at a position in pixels from the bottom left of the
+// viewport, in a colour. A newline starts a new line below the first character
+void textQueue(char* text, Vec2 position, GLfloat colour[4]);
+// Draws everything queued since the last flush over the viewport and empties the queue
+void textFlush(void);
+// Frees the atlas
+void textFree(void);
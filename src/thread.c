@@ -0,0 +1,134 @@
+#include "thread.h"
+#ifndef _WIN32
+#include <unistd.h>
+#include <sched.h>
+#endif
+
+// What a new thread needs to run, handed to the platform's thread entry point
+typedef struct THREADSTART {
+	ThreadFunction function;
+	void* data;
+} ThreadStart;
+
+#ifdef _WIN32
+DWORD WINAPI threadEntry(LPVOID parameter) {
+#else
+void* threadEntry(void* parameter) {
+#endif
+	ThreadStart start = *(ThreadStart*)parameter;
+	free(parameter);
+	start.function(start.data);
+	return 0;
+}
+
+Thread threadStart(ThreadFunction function, void* data) {
+	Thread thread;
+	ThreadStart* start = malloc(sizeof(ThreadStart));
+	start->function = function;
+	start->data = data;
+
+#ifdef _WIN32
+	thread.handle = CreateThread(NULL, 0, threadEntry, start, 0, NULL);
+#else
+	pthread_create(&thread.handle, NULL, threadEntry, start);
+#endif
+	return thread;
+}
+
+void threadJoin(Thread thread) {
+#ifdef _WIN32
+	WaitForSingleObject(thread.handle, INFINITE);
+	CloseHandle(thread.handle);
+#else
+	pthread_join(thread.handle, NULL);
+#endif
+}
+
+unsigned int threadCoreCount(void) {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#else
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (unsigned int)count : 1;
+#endif
+}
+
+void threadYield(void) {
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+void threadMutexInit(Mutex* mutex) {
+#ifdef _WIN32
+	InitializeCriticalSection(&mutex->section);
+#else
+	pthread_mutex_init(&mutex->mutex, NULL);
+#endif
+}
+
+void threadMutexLock(Mutex* mutex) {
+#ifdef _WIN32
+	EnterCriticalSection(&mutex->section);
+#else
+	pthread_mutex_lock(&mutex->mutex);
+#endif
+}
+
+void threadMutexUnlock(Mutex* mutex) {
+#ifdef _WIN32
+	LeaveCriticalSection(&mutex->section);
+#else
+	pthread_mutex_unlock(&mutex->mutex);
+#endif
+}
+
+void threadMutexFree(Mutex* mutex) {
+#ifdef _WIN32
+	DeleteCriticalSection(&mutex->section);
+#else
+	pthread_mutex_destroy(&mutex->mutex);
+#endif
+}
+
+void threadConditionInit(Condition* condition) {
+#ifdef _WIN32
+	InitializeConditionVariable(&condition->variable);
+#else
+	pthread_cond_init(&condition->variable, NULL);
+#endif
+}
+
+void threadConditionWait(Condition* condition, Mutex* mutex) {
+#ifdef _WIN32
+	SleepConditionVariableCS(&condition->variable, &mutex->section, INFINITE);
+#else
+	pthread_cond_wait(&condition->variable, &mutex->mutex);
+#endif
+}
+
+void threadConditionWakeOne(Condition* condition) {
+#ifdef _WIN32
+	WakeConditionVariable(&condition->variable);
+#else
+	pthread_cond_signal(&condition->variable);
+#endif
+}
+
+void threadConditionWakeAll(Condition* condition) {
+#ifdef _WIN32
+	WakeAllConditionVariable(&condition->variable);
+#else
+	pthread_cond_broadcast(&condition->variable);
+#endif
+}
+
+void threadConditionFree(Condition* condition) {
+#ifndef _WIN32
+	pthread_cond_destroy(&condition->variable);
+#endif
+}
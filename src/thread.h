@@ -0,0 +1,68 @@
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+#include <stdlib.h>
+
+/*
+ * <thread.c/thread.h> A thin wrapper over the platform's threads, locks and condition variables
+ * (Win32 on Windows, pthreads everywhere else), so the rest of the program doesn't need to care
+ * which it's using
+ */
+
+// The function a thread runs, given the data pointer passed when it was started
+typedef void (*ThreadFunction)(void* data);
+
+typedef struct THREAD {
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+} Thread;
+
+typedef struct MUTEX {
+#ifdef _WIN32
+	CRITICAL_SECTION section;
+#else
+	pthread_mutex_t mutex;
+#endif
+} Mutex;
+
+typedef struct CONDITION {
+#ifdef _WIN32
+	CONDITION_VARIABLE variable;
+#else
+	pthread_cond_t variable;
+#endif
+} Condition;
+
+// Starts a new thread running the given function
+Thread threadStart(ThreadFunction function, void* data);
+// Waits for a thread to finish running
+void threadJoin(Thread thread);
+// Returns the number of processor cores available to the program
+unsigned int threadCoreCount(void);
+// Gives up the rest of the calling thread's time slice to any other thread that's ready to run
+void threadYield(void);
+// Sets up a mutex, unlocked
+void threadMutexInit(Mutex* mutex);
+// Locks a mutex, waiting for any other thread holding it to unlock it first
+void threadMutexLock(Mutex* mutex);
+// Unlocks a mutex locked by the calling thread
+void threadMutexUnlock(Mutex* mutex);
+// Frees a mutex, which must be unlocked
+void threadMutexFree(Mutex* mutex);
+// Sets up a condition variable
+void threadConditionInit(Condition* condition);
+// Unlocks the mutex and sleeps until the condition is woken, locking the mutex again before returning.
+// It can also wake for no reason, so whatever was waited for has to be checked again
+void threadConditionWait(Condition* condition, Mutex* mutex);
+// Wakes one of the threads waiting on a condition, if there are any
+void threadConditionWakeOne(Condition* condition);
+// Wakes every thread waiting on a condition
+void threadConditionWakeAll(Condition* condition);
+// Frees a condition variable nothing is waiting on
+void threadConditionFree(Condition* condition);
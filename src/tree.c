@@ -1,50 +1,86 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include "tree.h"
 
-void treeLoad(TreeModel* model, char* trunkFilePath, char* leavesFilePath) {
+const TreeCollisionProfile treeCollisionProfiles[TREE_MODEL_COUNT] = {
+	{ 6.5, 11, 5 },
+	{ 6, 11, 13 },
+	{ 4.5, 9.5, 10 }
+};
+
+const RenderMaterial treeTrunkMaterial = { { 0, 0, 0, 0 }, { 74.f / 255.f, 37.f / 255.f, 14.f / 255.f, 1 }, { 0, 0, 0, 1 }, { 0, 0, 0, 1 }, 20 };
+const RenderMaterial treeLeavesMaterial = { { 0, 0, 0, 0 }, { 22.f / 255.f, 61.f / 255.f, 7.f / 255.f, 1 }, { 0, 0, 0, 1 }, { 0, 0, 0, 1 }, 20 };
+
+void treeLoad(TreeModel* model, char* trunkFilePath, char* leavesFilePath, VertexFormat format, Job* parent) {
 	model->trunkFilePath = trunkFilePath;
 	model->leavesFilePath = leavesFilePath;
-	model->trunkObj = loadMeshObject(trunkFilePath);
-	model->leavesObj = loadMeshObject(leavesFilePath);
+	meshLoadAsync(trunkFilePath, format, &model->trunkBuffer, parent);
+	meshLoadAsync(leavesFilePath, format, &model->leavesBuffer, parent);
+}
+
+void treeDrawModelSegments(TreeModel* model, const Mat4* placement) {
+	renderDrawBuffer(model->trunkBuffer, placement, &treeTrunkMaterial);
+	renderDrawBuffer(model->leavesBuffer, placement, &treeLeavesMaterial);
 }
 
-void treeDrawModelSegments(TreeModel* model) {
+void treeBounds(TreeModel* model, Vec3* minimum, Vec3* maximum) {
+	VertexBuffer* buffers[] = { model->trunkBuffer, model->leavesBuffer };
+	bool empty = TRUE;
 
-	glMaterialfv(GL_FRONT, GL_AMBIENT, (GLfloat[4]) { 0, 0, 0, 0 });
-	glMaterialfv(GL_FRONT, GL_DIFFUSE, (GLfloat[4]) { 74.f / 255.f, 37.f / 255.f, 14.f / 255.f, 1 });
-	glMaterialfv(GL_FRONT, GL_SPECULAR, (GLfloat[4]) { 0, 0, 0, 1 });
-	glMaterialf(GL_FRONT, GL_SHININESS, 20);
-	renderMeshObject(model->trunkObj);
+	*minimum = *maximum = (Vec3) { 0, 0, 0 };
+	for (unsigned int i = 0; i < 2; ++i) {
+		// A mesh that couldn't be loaded draws nothing, so it takes up no room
+		if (buffers[i] == NULL || buffers[i]->vertexCount == 0) {
+			continue;
+		}
+		const GLfloat* low = buffers[i]->minimum;
+		const GLfloat* high = buffers[i]->maximum;
+		if (empty) {
+			*minimum = (Vec3) { low[0], low[1], low[2] };
+			*maximum = (Vec3) { high[0], high[1], high[2] };
+			empty = FALSE;
+			continue;
+		}
+		*minimum = (Vec3) { fmin(minimum->x, low[0]), fmin(minimum->y, low[1]), fmin(minimum->z, low[2]) };
+		*maximum = (Vec3) { fmax(maximum->x, high[0]), fmax(maximum->y, high[1]), fmax(maximum->z, high[2]) };
+	}
+}
 
-	glMaterialfv(GL_FRONT, GL_AMBIENT, (GLfloat[4]) { 0, 0, 0, 0 });
-	glMaterialfv(GL_FRONT, GL_DIFFUSE, (GLfloat[4]) { 22.f / 255.f, 61.f / 255.f, 7.f / 255.f, 1 });
-	glMaterialfv(GL_FRONT, GL_SPECULAR, (GLfloat[4]) { 0, 0, 0, 1 });
-	glMaterialf(GL_FRONT, GL_SHININESS, 20);
-	renderMeshObject(model->leavesObj);
+size_t treeModelSize(TreeModel* model) {
+	return vertexBufferSize(model->trunkBuffer) + vertexBufferSize(model->leavesBuffer);
 }
 
 void treeClose(TreeModel* tree) {
-	freeMeshObject(tree->trunkObj);
-	freeMeshObject(tree->leavesObj);
+	vertexBufferFree(tree->trunkBuffer);
+	vertexBufferFree(tree->leavesBuffer);
 }
 
 void generateTrees(TreeObject* trees) {
 	GLfloat treeValues[TREES_LENGTH][3];
-	loadTrees(&treeValues);
+	loadTrees(treeValues);
 
 	for (unsigned int i = 0; i < TREES_LENGTH; ++i) {
 		trees[i].position = (Vec2){ treeValues[i][0], treeValues[i][1] };
 		trees[i].modelIndex = (GLuint)treeValues[i][2];
+		trees[i].height = 0;
 	}
 
 }
 
+void treeDisplay(TreeObject* tree, GLuint* displayLists) {
+	glPushMatrix();
+	glTranslatef(tree->position.x, tree->height, tree->position.y);
+	glCallList(displayLists[tree->modelIndex]);
+	glPopMatrix();
+}
+
+void treeDraw(TreeObject* tree, TreeModel** models) {
+	const Mat4 placement = mat4Translation((Vec3) { tree->position.x, tree->height, tree->position.y });
+	treeDrawModelSegments(models[tree->modelIndex], &placement);
+}
+
 void treesDisplay(TreeObject* trees, GLuint* displayLists) {
 	for (unsigned int i = 0; i < TREES_LENGTH; ++i) {
-		glPushMatrix();
-		glTranslatef(trees[i].position.x, 0, trees[i].position.y);
-		glCallList(displayLists[trees[i].modelIndex]);
-		glPopMatrix();
+		treeDisplay(&trees[i], displayLists);
 	}
 }
 
@@ -52,8 +88,37 @@ void treesDisplay(TreeObject* trees, GLuint* displayLists) {
 GLuint treeGenerateDisplayList(TreeModel* model) {
 	GLuint index = glGenLists(1);
 	glNewList(index, GL_COMPILE);
-	treeDrawModelSegments(model);
+	treeDrawModelSegments(model, NULL);
 	glEndList();
 
 	return index;
+}
+
+GLfloat treeCollisionRadius(GLuint modelIndex, GLfloat height) {
+	const TreeCollisionProfile* profile = &treeCollisionProfiles[modelIndex];
+	return height > profile->canopyHeight ? profile->canopyRadius : profile->trunkRadius;
+}
+
+int treeGridCell(GLfloat coordinate) {
+	const int cell = (int)floor((coordinate + TREE_GRID_EXTENT) / TREE_GRID_CELL_SIZE);
+	return cell < 0 ? 0 : cell >= TREE_GRID_CELLS ? TREE_GRID_CELLS - 1 : cell;
+}
+
+void treeGridBuild(TreeGrid* grid, TreeObject* trees) {
+	unsigned int cellCounts[TREE_GRID_CELLS * TREE_GRID_CELLS] = { 0 };
+
+	for (unsigned int i = 0; i < TREES_LENGTH; ++i) {
+		++cellCounts[treeGridCell(trees[i].position.y) * TREE_GRID_CELLS + treeGridCell(trees[i].position.x)];
+	}
+
+	grid->cellStarts[0] = 0;
+	for (unsigned int i = 0; i < TREE_GRID_CELLS * TREE_GRID_CELLS; ++i) {
+		grid->cellStarts[i + 1] = grid->cellStarts[i] + cellCounts[i];
+		cellCounts[i] = grid->cellStarts[i];
+	}
+
+	for (unsigned int i = 0; i < TREES_LENGTH; ++i) {
+		const int cell = treeGridCell(trees[i].position.y) * TREE_GRID_CELLS + treeGridCell(trees[i].position.x);
+		grid->treeIndices[cellCounts[cell]++] = (unsigned short)i;
+	}
 }
\ No newline at end of file
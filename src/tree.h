@@ -1,33 +1,86 @@
 #pragma once
 #include "loader.h"
+#include "mesh.h"
 #include "misc.h"
 #include "vecmath.h"
+#include "render.h"
 
 /*
  * <tree.c/tree.h> Defines the functions and datatypes required to generate and render
  * a tree in the scene
  */
 
+// Number of tree models, which a tree's modelIndex picks between
+#define TREE_MODEL_COUNT 3
+
 typedef struct TREE {
 	char* trunkFilePath;
 	char* leavesFilePath;
-	MeshObject* trunkObj;
-	MeshObject* leavesObj;
+	VertexBuffer* trunkBuffer;	// Optimised triangles of the trunk and leaves meshes
+	VertexBuffer* leavesBuffer;
 } TreeModel;
 
 typedef struct TreeObject {
 	Vec2 position;
 	GLuint modelIndex;
+	GLfloat height; // Height of the ground the tree stands on, which its collision profile starts from
 } TreeObject;
 
+// Height above which nothing can collide with a tree
+#define TREE_COLLISION_HEIGHT 29
+
+// The collision shape of a tree model, made of two stacked vertical cylinders. The trunk radius
+// applies up to canopyHeight and the canopy radius above it. Both radii already include the size
+// of the helicopter, so the helicopter can be tested against them as a single point
+typedef struct TreeCollisionProfile {
+	GLfloat trunkRadius;
+	GLfloat canopyRadius;
+	GLfloat canopyHeight;
+} TreeCollisionProfile;
+
+// Collision profiles for each tree model, indexed by a tree's modelIndex
+extern const TreeCollisionProfile treeCollisionProfiles[TREE_MODEL_COUNT];
+// Largest collision radius of any tree model
+#define TREE_MAX_COLLISION_RADIUS 11
+
+// Tree Grid Dimensions
+
+#define TREE_GRID_CELLS 16
+#define TREE_GRID_EXTENT 256
+#define TREE_GRID_CELL_SIZE (TREE_GRID_EXTENT * 2.0f / TREE_GRID_CELLS)
+
+// A uniform grid over the XZ plane that buckets trees by the cell their centre is in. It's
+// read only once built, so any number of threads can query it at the same time
+typedef struct TREEGRID {
+	unsigned int cellStarts[TREE_GRID_CELLS * TREE_GRID_CELLS + 1]; // Offset of each cell's trees in treeIndices
+	unsigned short treeIndices[TREES_LENGTH]; // Indexes into the tree array, sorted by cell
+} TreeGrid;
+
+// Starts loading the trunk and leaves meshes of a tree model as jobs under the given parent, with their
+// vertices in the given format
+void treeLoad(TreeModel* model, char* trunkFilePath, char* leavesFilePath, VertexFormat format, Job* parent);
 // Generates the data for the scene's trees
 void generateTrees(TreeObject* trees);
-// Draws a tree model from it's segment models
-void treeDrawModelSegments(TreeModel* model);
+// Draws a tree model from it's segment models, placed by a model matrix, or where it is if that's NULL
+void treeDrawModelSegments(TreeModel* model, const Mat4* placement);
+// Finds the box around a tree model's trunk and leaves, relative to the tree's position
+void treeBounds(TreeModel* model, Vec3* minimum, Vec3* maximum);
+// Returns the number of bytes a tree model's trunk and leaves vertex buffers take up
+size_t treeModelSize(TreeModel* model);
 // Frees all the models from a tree model
 void treeClose(TreeModel* tree); 
+// Draws one tree with the display list for its model
+void treeDisplay(TreeObject* tree, GLuint* displayLists);
+// Draws one tree straight from its model's vertex buffers, for when there are no display lists
+void treeDraw(TreeObject* tree, TreeModel** models);
 // Draws all of the trees from a given array of trees
 void treesDisplay(TreeObject* trees, GLuint* displayLists);
 // For a given array of tree models, generates the display lists that draw each model.
 // Returns an array of all of the list indexes
 GLuint treeGenerateDisplayList(TreeModel* model);
+// Buckets the given trees into a tree grid
+void treeGridBuild(TreeGrid* grid, TreeObject* trees);
+// Returns the grid cell (on one axis) that a coordinate falls in, clamped to the grid
+int treeGridCell(GLfloat coordinate);
+// Returns the collision radius of a tree model at the given height
+GLfloat treeCollisionRadius(GLuint modelIndex, GLfloat height);
@@ -0,0 +1,224 @@
+#pragma once
+#include <math.h>
+#include "vecmath.h"
+
+/*
+ * <vecinline.h> Four wide operations, backed by SSE where the compiler targets it, and batch
+ * versions of the functions in vecmath.h that run over arrays of components four at a time.
+ * The batch sine and cosine come from polynomials rather than sinf and cosf, which puts them
+ * within ANGLE_POLYNOMIAL's error of sinCos
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VEC_SSE
+#include <emmintrin.h>
+#endif
+
+// Four floats operated on together, in an SSE register where available
+#ifdef VEC_SSE
+typedef __m128 Vec4f;
+#else
+typedef struct VECTOR4F {
+	GLfloat v[4];
+} Vec4f;
+#endif
+
+/******************************************************************************
+ * Four Wide Operations
+ ******************************************************************************/
+
+VEC_INLINE Vec4f vec4fSet(GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+#ifdef VEC_SSE
+	return _mm_setr_ps(x, y, z, w);
+#else
+	return (Vec4f) { { x, y, z, w } };
+#endif
+}
+
+VEC_INLINE Vec4f vec4fSplat(GLfloat value) {
+#ifdef VEC_SSE
+	return _mm_set1_ps(value);
+#else
+	return (Vec4f) { { value, value, value, value } };
+#endif
+}
+
+// Loads four floats from an array, which doesn't need to be aligned
+VEC_INLINE Vec4f vec4fLoad(const GLfloat* values) {
+#ifdef VEC_SSE
+	return _mm_loadu_ps(values);
+#else
+	return (Vec4f) { { values[0], values[1], values[2], values[3] } };
+#endif
+}
+
+VEC_INLINE void vec4fStore(GLfloat* values, Vec4f vector) {
+#ifdef VEC_SSE
+	_mm_storeu_ps(values, vector);
+#else
+	values[0] = vector.v[0]; values[1] = vector.v[1]; values[2] = vector.v[2]; values[3] = vector.v[3];
+#endif
+}
+
+VEC_INLINE Vec4f vec4fAdd(Vec4f a, Vec4f b) {
+#ifdef VEC_SSE
+	return _mm_add_ps(a, b);
+#else
+	return (Vec4f) { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+#endif
+}
+
+VEC_INLINE Vec4f vec4fSub(Vec4f a, Vec4f b) {
+#ifdef VEC_SSE
+	return _mm_sub_ps(a, b);
+#else
+	return (Vec4f) { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } };
+#endif
+}
+
+VEC_INLINE Vec4f vec4fMul(Vec4f a, Vec4f b) {
+#ifdef VEC_SSE
+	return _mm_mul_ps(a, b);
+#else
+	return (Vec4f) { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } };
+#endif
+}
+
+// Rounds each element down to a whole number. Only valid for values that fit in an int
+VEC_INLINE Vec4f vec4fFloor(Vec4f a) {
+#ifdef VEC_SSE
+	const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+	return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a), _mm_set1_ps(1)));
+#else
+	return (Vec4f) { { floorf(a.v[0]), floorf(a.v[1]), floorf(a.v[2]), floorf(a.v[3]) } };
+#endif
+}
+
+// Picks each element from a where the matching elements of the conditions are non zero, otherwise from b
+VEC_INLINE Vec4f vec4fSelect(Vec4f conditions, Vec4f a, Vec4f b) {
+#ifdef VEC_SSE
+	const __m128 mask = _mm_cmpneq_ps(conditions, _mm_setzero_ps());
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+#else
+	return (Vec4f) { {
+		conditions.v[0] != 0 ? a.v[0] : b.v[0], conditions.v[1] != 0 ? a.v[1] : b.v[1],
+		conditions.v[2] != 0 ? a.v[2] : b.v[2], conditions.v[3] != 0 ? a.v[3] : b.v[3]
+	} };
+#endif
+}
+
+VEC_INLINE Vec4f vec4fSqrt(Vec4f a) {
+#ifdef VEC_SSE
+	return _mm_sqrt_ps(a);
+#else
+	return (Vec4f) { { sqrtf(a.v[0]), sqrtf(a.v[1]), sqrtf(a.v[2]), sqrtf(a.v[3]) } };
+#endif
+}
+
+// Calculates the sines and cosines of four angles in degrees with minimax polynomials over [-pi/4, pi/4]
+// (the single precision Cephes coefficients, as anglePolynomialSine and anglePolynomialCosine use). The
+// angles are reduced to the nearest quarter turn, then the polynomials are evaluated on what's left over
+VEC_INLINE void vec4fSinCos(Vec4f degrees, Vec4f* sines, Vec4f* cosines) {
+	const Vec4f half = vec4fSplat(0.5f), one = vec4fSplat(1), quarter = vec4fSplat(0.25f), four = vec4fSplat(4);
+	const Vec4f quarters = vec4fMul(degrees, vec4fSplat(1 / 90.0f));
+	const Vec4f quadrant = vec4fFloor(vec4fAdd(quarters, half));
+	const Vec4f x = vec4fMul(vec4fSub(quarters, quadrant), vec4fSplat(VEC_PI / 2));
+	const Vec4f x2 = vec4fMul(x, x);
+
+	Vec4f s = vec4fAdd(vec4fMul(x2, vec4fSplat(-1.9515295891e-4f)), vec4fSplat(8.3321608736e-3f));
+	s = vec4fSub(vec4fMul(s, x2), vec4fSplat(1.6666654611e-1f));
+	s = vec4fAdd(vec4fMul(vec4fMul(s, x2), x), x);
+
+	Vec4f c = vec4fSub(vec4fMul(x2, vec4fSplat(2.443315711809948e-5f)), vec4fSplat(1.388731625493765e-3f));
+	c = vec4fAdd(vec4fMul(c, x2), vec4fSplat(4.166664568298827e-2f));
+	c = vec4fAdd(vec4fSub(vec4fMul(vec4fMul(c, x2), x2), vec4fMul(half, x2)), one);
+
+	// Quadrants 1 and 3 swap sine and cosine, sine is negated in 2 and 3, and cosine in 1 and 2
+	const Vec4f wrapped = vec4fSub(quadrant, vec4fMul(four, vec4fFloor(vec4fMul(quadrant, quarter))));
+	const Vec4f halves = vec4fFloor(vec4fMul(wrapped, half));
+	const Vec4f odd = vec4fSub(wrapped, vec4fAdd(halves, halves));
+	const Vec4f cosineHalves = vec4fFloor(vec4fMul(vec4fAdd(wrapped, one), half));
+	const Vec4f cosineNegated = vec4fSub(cosineHalves, vec4fAdd(vec4fFloor(vec4fMul(cosineHalves, half)), vec4fFloor(vec4fMul(cosineHalves, half))));
+
+	const Vec4f sineSign = vec4fSub(one, vec4fAdd(halves, halves));
+	const Vec4f cosineSign = vec4fSub(one, vec4fAdd(cosineNegated, cosineNegated));
+	*sines = vec4fMul(vec4fSelect(odd, c, s), sineSign);
+	*cosines = vec4fMul(vec4fSelect(odd, s, c), cosineSign);
+}
+
+/******************************************************************************
+ * Batch Operations
+ *
+ * These work over arrays holding one component each (as the swarm stores its
+ * drones), four elements at a time, with any leftover elements done one by one
+ ******************************************************************************/
+
+// Calculates the sines and cosines of an array of angles in degrees, four at a time with vec4fSinCos.
+// The last few angles are padded out to four, so every result matches the scalar angleSinCosPolynomial
+VEC_INLINE void sinCosBatch(const GLfloat* degrees, GLfloat* sines, GLfloat* cosines, unsigned int count) {
+	unsigned int i = 0;
+	Vec4f sine, cosine;
+
+	for (; i + 4 <= count; i += 4) {
+		vec4fSinCos(vec4fLoad(&degrees[i]), &sine, &cosine);
+		vec4fStore(&sines[i], sine);
+		vec4fStore(&cosines[i], cosine);
+	}
+	if (i < count) {
+		GLfloat padded[4] = { 0, 0, 0, 0 }, paddedSines[4], paddedCosines[4];
+		for (unsigned int j = 0; j < 4 && i + j < count; ++j) {
+			padded[j] = degrees[i + j];
+		}
+		vec4fSinCos(vec4fLoad(padded), &sine, &cosine);
+		vec4fStore(paddedSines, sine);
+		vec4fStore(paddedCosines, cosine);
+		for (unsigned int j = 0; j < 4 && i + j < count; ++j) {
+			sines[i + j] = paddedSines[j];
+			cosines[i + j] = paddedCosines[j];
+		}
+	}
+}
+
+// Rotates arrays of XZ components in place, each by the angle with the matching sine and cosine
+VEC_INLINE void rotateXZBatch(GLfloat* x, GLfloat* z, const GLfloat* sines, const GLfloat* cosines, unsigned int count) {
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const Vec4f vx = vec4fLoad(&x[i]), vz = vec4fLoad(&z[i]);
+		const Vec4f sine = vec4fLoad(&sines[i]), cosine = vec4fLoad(&cosines[i]);
+		vec4fStore(&x[i], vec4fSub(vec4fMul(vx, cosine), vec4fMul(vz, sine)));
+		vec4fStore(&z[i], vec4fAdd(vec4fMul(vx, sine), vec4fMul(vz, cosine)));
+	}
+	for (; i < count; ++i) {
+		const GLfloat rotatedX = x[i] * cosines[i] - z[i] * sines[i];
+		z[i] = x[i] * sines[i] + z[i] * cosines[i];
+		x[i] = rotatedX;
+	}
+}
+
+// Interpolates an array of values in place towards an array of targets
+VEC_INLINE void lerpBatch(GLfloat* values, const GLfloat* targets, GLfloat t, unsigned int count) {
+	t = t > 1 ? 1 : t < 0 ? 0 : t;
+
+	unsigned int i = 0;
+	const Vec4f vt = vec4fSplat(t);
+	for (; i + 4 <= count; i += 4) {
+		const Vec4f a = vec4fLoad(&values[i]);
+		vec4fStore(&values[i], vec4fAdd(a, vec4fMul(vec4fSub(vec4fLoad(&targets[i]), a), vt)));
+	}
+	for (; i < count; ++i) {
+		values[i] = values[i] + (targets[i] - values[i]) * t;
+	}
+}
+
+// Calculates the distance on the XZ plane from a point to each point in arrays of XZ components
+VEC_INLINE void distanceXZBatch(const GLfloat* x, const GLfloat* z, GLfloat pointX, GLfloat pointZ, GLfloat* distances, unsigned int count) {
+	unsigned int i = 0;
+	const Vec4f px = vec4fSplat(pointX), pz = vec4fSplat(pointZ);
+	for (; i + 4 <= count; i += 4) {
+		const Vec4f dx = vec4fSub(vec4fLoad(&x[i]), px), dz = vec4fSub(vec4fLoad(&z[i]), pz);
+		vec4fStore(&distances[i], vec4fSqrt(vec4fAdd(vec4fMul(dx, dx), vec4fMul(dz, dz))));
+	}
+	for (; i < count; ++i) {
+		distances[i] = sqrtf((x[i] - pointX) * (x[i] - pointX) + (z[i] - pointZ) * (z[i] - pointZ));
+	}
+}
@@ -1,35 +1,87 @@
-#include "vecmath.h";
+#include "vecmath.h"
 
-GLfloat toRad(GLfloat degree) { return degree * (3.141592653 / 180.0); }
+Mat4 mat4Identity(void) {
+	return (Mat4) { { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } };
+}
+
+Mat4 mat4Multiply(Mat4 a, Mat4 b) {
+	Mat4 result;
+	for (unsigned int column = 0; column < 4; ++column) {
+		for (unsigned int row = 0; row < 4; ++row) {
+			result.m[column * 4 + row] = a.m[row] * b.m[column * 4] + a.m[4 + row] * b.m[column * 4 + 1]
+				+ a.m[8 + row] * b.m[column * 4 + 2] + a.m[12 + row] * b.m[column * 4 + 3];
+		}
+	}
+	return result;
+}
+
+Mat4 mat4Translation(Vec3 offset) {
+	Mat4 result = mat4Identity();
+	result.m[12] = offset.x;
+	result.m[13] = offset.y;
+	result.m[14] = offset.z;
+	return result;
+}
 
-GLfloat angleClamp(GLfloat angle) {
-	if (angle < 0) { return 360 - angle; }
-	if (angle > 360) { return -360 + angle; }
-	return angle;
+Mat4 mat4Rotation(GLfloat angle, Vec3 axis) {
+	const GLfloat length = sqrtf(vec3Dot(axis, axis));
+	if (length <= 1.0e-4f) {
+		return mat4Identity();
+	}
+	const GLfloat x = axis.x / length, y = axis.y / length, z = axis.z / length;
+	const GLfloat sine = sinf(toRad(angle)), cosine = cosf(toRad(angle)), rest = 1 - cosine;
+
+	return (Mat4) { {
+		x * x * rest + cosine, y * x * rest + z * sine, x * z * rest - y * sine, 0,
+		x * y * rest - z * sine, y * y * rest + cosine, y * z * rest + x * sine, 0,
+		x * z * rest + y * sine, y * z * rest - x * sine, z * z * rest + cosine, 0,
+		0, 0, 0, 1
+	} };
 }
 
-Vec3 rotateVectorXZ(Vec3 vector, GLfloat angle) {
-	const double theta = toRad(angle);
-	return (Vec3) { 
-		vector.x * cos(theta) - vector.z * sin(theta), 
-		vector.y, 
-		vector.x * sin(theta) + vector.z * cos(theta) 
-	}; 
+Vec3 mat4TransformPoint(Mat4 matrix, Vec3 point) {
+	const Vec3 turned = mat4TransformDirection(matrix, point);
+	return (Vec3) { turned.x + matrix.m[12], turned.y + matrix.m[13], turned.z + matrix.m[14] };
 }
 
-GLfloat lerp(GLfloat a, GLfloat b, GLfloat t) {
-	if (t > 1) return b;
-	if (t < 0) return a;
-	return (1 - t) * a + (b * t);
+Vec3 mat4TransformDirection(Mat4 matrix, Vec3 direction) {
+	return (Vec3) {
+		matrix.m[0] * direction.x + matrix.m[4] * direction.y + matrix.m[8] * direction.z,
+		matrix.m[1] * direction.x + matrix.m[5] * direction.y + matrix.m[9] * direction.z,
+		matrix.m[2] * direction.x + matrix.m[6] * direction.y + matrix.m[10] * direction.z
+	};
 }
 
-Vec3 vec3Lerp(Vec3 a, Vec3 b, GLfloat t) {
-	if (t > 1) return b;
-	if (t < 0) return a;
+Mat4 mat4Perspective(GLfloat fieldOfView, GLfloat aspect, GLfloat near, GLfloat far) {
+	// Worked out in doubles the way gluPerspective does, since the depth terms lose precision in floats,
+	// and anything close to coplanar fights over the depth buffer differently for it
+	const double halfAngle = fieldOfView / 2.0 * 3.14159265358979323846 / 180, depth = (double)far - near;
+	const double focal = cos(halfAngle) / sin(halfAngle);
+
+	return (Mat4) { {
+		(GLfloat)(focal / aspect), 0, 0, 0,
+		0, (GLfloat)focal, 0, 0,
+		0, 0, (GLfloat)(-((double)far + near) / depth), -1,
+		0, 0, (GLfloat)(-2 * (double)near * far / depth), 0
+	} };
+}
 
-	return (Vec3) { lerp(a.x, b.x, t), lerp(a.y, b.y, t), lerp(a.z, b.z, t) };
+// Scales a vector to a length of one, dividing like gluLookAt does so the two give the same matrix
+Vec3 mat4Normalize(Vec3 vector) {
+	const double length = sqrt(vector.x * vector.x + vector.y * vector.y + vector.z * vector.z);
+	return (Vec3) { (GLfloat)(vector.x / length), (GLfloat)(vector.y / length), (GLfloat)(vector.z / length) };
 }
 
-GLfloat vec3XZMagnitude(Vec3 vector) {
-	return sqrt(pow(fabs(vector.x), 2) + pow(fabs(vector.z), 2));
-}
\ No newline at end of file
+Mat4 mat4LookAt(Vec3 eye, Vec3 centre, Vec3 up) {
+	const Vec3 forward = mat4Normalize((Vec3) { centre.x - eye.x, centre.y - eye.y, centre.z - eye.z });
+	const Vec3 side = mat4Normalize((Vec3) { forward.y * up.z - forward.z * up.y, forward.z * up.x - forward.x * up.z,
+		forward.x * up.y - forward.y * up.x });
+	const Vec3 top = { side.y * forward.z - side.z * forward.y, side.z * forward.x - side.x * forward.z, side.x * forward.y - side.y * forward.x };
+
+	return (Mat4) { {
+		side.x, top.x, -forward.x, 0,
+		side.y, top.y, -forward.y, 0,
+		side.z, top.z, -forward.z, 0,
+		-vec3Dot(side, eye), -vec3Dot(top, eye), vec3Dot(forward, eye), 1
+	} };
+}
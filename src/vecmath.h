@@ -4,9 +4,20 @@
 
 /*
  * <vecmath.c/vecmath.h> Defines general mathematical functions and vector types,
- * as well as functions for handling vectors
+ * as well as functions for handling vectors. The small scalar and vector functions
+ * are defined here so they can be inlined, and versions over arrays of components
+ * are in vecinline.h
  */
 
+#ifdef _MSC_VER
+#define VEC_INLINE static __inline
+#else
+#define VEC_INLINE static inline
+#endif
+
+#define VEC_PI 3.14159265358979f
+#define VEC_DEGREES_TO_RADIANS (VEC_PI / 180.0f)
+
 // Object type for 3D Vector (x, y, z)
 typedef struct VECTOR3 {
 	GLfloat x, y, z;
@@ -28,15 +39,87 @@ typedef struct COLOURRGB {
 	GLfloat r, g, b;
 } RGB;
 
+// Object type for a 4x4 matrix, stored in columns the way OpenGL takes them
+typedef struct MATRIX4 {
+	GLfloat m[16];
+} Mat4;
+
 // Converts given degrees to radians
-GLfloat toRad(GLfloat degree);
-// Clamps a given angle between 0 and 360 degrees
-GLfloat angleClamp(GLfloat angle);
+VEC_INLINE GLfloat toRad(GLfloat degree) {
+	return degree * VEC_DEGREES_TO_RADIANS;
+}
+
+// Calculates the sine and cosine of an angle in degrees together
+VEC_INLINE void sinCos(GLfloat degree, GLfloat* sine, GLfloat* cosine) {
+	const GLfloat theta = toRad(degree);
+	*sine = sinf(theta);
+	*cosine = cosf(theta);
+}
+
 // Linear interpolation between 2 floats
-GLfloat lerp(GLfloat a, GLfloat b, GLfloat t);
+VEC_INLINE GLfloat lerp(GLfloat a, GLfloat b, GLfloat t) {
+	if (t > 1) return b;
+	if (t < 0) return a;
+	return (1 - t) * a + (b * t);
+}
+
 // Linear interpolation between 2 vectors
-Vec3 vec3Lerp(Vec3 a, Vec3 b, GLfloat t);
+VEC_INLINE Vec3 vec3Lerp(Vec3 a, Vec3 b, GLfloat t) {
+	if (t > 1) return b;
+	if (t < 0) return a;
+	return (Vec3) { (1 - t) * a.x + b.x * t, (1 - t) * a.y + b.y * t, (1 - t) * a.z + b.z * t };
+}
+
+// Rotates a given vector around the XZ plane by an angle given as its sine and cosine
+VEC_INLINE Vec3 rotateVectorXZSinCos(Vec3 vector, GLfloat sine, GLfloat cosine) {
+	return (Vec3) {
+		vector.x * cosine - vector.z * sine,
+		vector.y,
+		vector.x * sine + vector.z * cosine
+	};
+}
+
 // Rotates a given vector around the XZ plane by the given angle in degrees
-Vec3 rotateVectorXZ(Vec3 vector, GLfloat angle);
+VEC_INLINE Vec3 rotateVectorXZ(Vec3 vector, GLfloat angle) {
+	GLfloat sine, cosine;
+	sinCos(angle, &sine, &cosine);
+	return rotateVectorXZSinCos(vector, sine, cosine);
+}
+
 // Returns the magintude on the XZ plane of a given vector
-GLfloat vec3XZMagnitude(Vec3 vector);
+VEC_INLINE GLfloat vec3XZMagnitude(Vec3 vector) {
+	return sqrtf(vector.x * vector.x + vector.z * vector.z);
+}
+
+// Adds two vectors together
+VEC_INLINE Vec3 vec3Add(Vec3 a, Vec3 b) {
+	return (Vec3) { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+
+// Multiplies a vector by a scalar
+VEC_INLINE Vec3 vec3Scale(Vec3 vector, GLfloat scale) {
+	return (Vec3) { vector.x * scale, vector.y * scale, vector.z * scale };
+}
+
+// Returns the dot product of two vectors
+VEC_INLINE GLfloat vec3Dot(Vec3 a, Vec3 b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Returns the identity matrix
+Mat4 mat4Identity(void);
+// Multiplies two matrices, so the result applies b and then a, as glMultMatrix does
+Mat4 mat4Multiply(Mat4 a, Mat4 b);
+// Returns a matrix that moves by the given offset, as glTranslate does
+Mat4 mat4Translation(Vec3 offset);
+// Returns a matrix that rotates by an angle in degrees around an axis, as glRotate does, which leaves
+// everything where it is if the axis has no length
+Mat4 mat4Rotation(GLfloat angle, Vec3 axis);
+// Moves a point by a matrix
+Vec3 mat4TransformPoint(Mat4 matrix, Vec3 point);
+// Turns a direction by a matrix, leaving out its translation
+Vec3 mat4TransformDirection(Mat4 matrix, Vec3 direction);
+// Returns a perspective projection with a vertical field of view in degrees, as gluPerspective does
+Mat4 mat4Perspective(GLfloat fieldOfView, GLfloat aspect, GLfloat near, GLfloat far);
+// Returns a view matrix from an eye looking at a centre, as gluLookAt does
+Mat4 mat4LookAt(Vec3 eye, Vec3 centre, Vec3 up);
@@ -0,0 +1,132 @@
+#include "water.h"
+
+Water* waterCreate(bool waves) {
+	const unsigned int vertexCount = WATER_SIDE * WATER_SIDE;
+	Water* water = calloc(1, sizeof(Water));
+	// One strip per row of tiles, two indices per column, plus two to join each row onto the last
+	GLuint* indices = malloc(WATER_TILES * (2 * WATER_SIDE + 2) * sizeof(GLuint));
+	unsigned int indexCount = 0;
+
+	water->waves = waves;
+	water->vertices = malloc(vertexCount * sizeof(Vertex));
+	water->gridX = malloc(vertexCount * sizeof(GLfloat));
+	water->gridZ = malloc(vertexCount * sizeof(GLfloat));
+
+	// Texture coordinates carry on across tiles so the repeating texture lines up with each tile
+	for (unsigned int row = 0; row < WATER_SIDE; ++row) {
+		for (unsigned int column = 0; column < WATER_SIDE; ++column) {
+			const unsigned int i = row * WATER_SIDE + column;
+			water->gridX[i] = (GLfloat)(-WATER_EXTENT + (int)column * WATER_SPACING);
+			water->gridZ[i] = (GLfloat)(-WATER_EXTENT + (int)row * WATER_SPACING);
+			water->vertices[i] = (Vertex) {
+				{ water->gridX[i], 0, water->gridZ[i] }, { 0, 1, 0 }, { water->gridX[i] / WATER_SPACING, water->gridZ[i] / WATER_SPACING }
+			};
+		}
+	}
+
+	for (unsigned int row = 0; row < WATER_TILES; ++row) {
+		if (indexCount > 0) {
+			indices[indexCount] = indices[indexCount - 1];
+			indices[indexCount + 1] = (row + 1) * WATER_SIDE;
+			indexCount += 2;
+		}
+
+		for (unsigned int column = 0; column < WATER_SIDE; ++column) {
+			indices[indexCount++] = (row + 1) * WATER_SIDE + column;
+			indices[indexCount++] = row * WATER_SIDE + column;
+		}
+	}
+
+	water->buffer = vertexBufferCreate(GL_TRIANGLE_STRIP, water->vertices, vertexCount, indices, indexCount);
+	free(indices);
+
+	if (waves) {
+		water->phases = malloc(3 * vertexCount * sizeof(GLfloat));
+		water->sines = malloc(2 * vertexCount * sizeof(GLfloat));
+		water->cosines = malloc(2 * vertexCount * sizeof(GLfloat));
+	}
+
+	return water;
+}
+
+void waterAnimate(Water* water, GLfloat time) {
+	const GLfloat heights[] = WATER_WAVE_HEIGHTS, lengths[] = WATER_WAVE_LENGTHS;
+	const GLfloat directions[] = WATER_WAVE_DIRECTIONS, frequencies[] = WATER_WAVE_FREQUENCIES;
+	const unsigned int count = WATER_SIDE * WATER_SIDE;
+
+	if (!water->waves) {
+		return;
+	}
+
+	// The phase of each wave at each vertex, in degrees, so the batch sine and cosine can take it
+	for (unsigned int wave = 0; wave < 2; ++wave) {
+		GLfloat sine, cosine;
+		sinCos(directions[wave], &sine, &cosine);
+
+		const Vec4f stepX = vec4fSplat(cosine * 360 / lengths[wave]);
+		const Vec4f stepZ = vec4fSplat(sine * 360 / lengths[wave]);
+		const Vec4f start = vec4fSplat(angleWrap(time * frequencies[wave] * 360));
+		GLfloat* phases = &water->phases[wave * count];
+
+		for (unsigned int i = 0; i < count; i += 4) {
+			const Vec4f phase = vec4fAdd(vec4fAdd(vec4fMul(vec4fLoad(&water->gridX[i]), stepX), vec4fMul(vec4fLoad(&water->gridZ[i]), stepZ)), start);
+			vec4fStore(&phases[i], phase);
+		}
+	}
+
+	sinCosBatch(water->phases, water->sines, water->cosines, 2 * count);
+
+	// Height is the sum of the sines, and the normal comes from the slope, which is the sum of the cosines
+	// scaled by each wave's height and how quickly its phase changes along x and z. The phases are
+	// done with by now, so the results go back into their space before being copied into the vertices
+	GLfloat sines[2], cosines[2];
+	sinCos(directions[0], &sines[0], &cosines[0]);
+	sinCos(directions[1], &sines[1], &cosines[1]);
+
+	const Vec4f height0 = vec4fSplat(heights[0]), height1 = vec4fSplat(heights[1]);
+	const Vec4f slope0 = vec4fSplat(heights[0] * 2 * VEC_PI / lengths[0]), slope1 = vec4fSplat(heights[1] * 2 * VEC_PI / lengths[1]);
+	const Vec4f cosine0 = vec4fSplat(cosines[0]), sine0 = vec4fSplat(sines[0]);
+	const Vec4f cosine1 = vec4fSplat(cosines[1]), sine1 = vec4fSplat(sines[1]);
+	const Vec4f zero = vec4fSplat(0);
+	GLfloat* resultHeights = water->phases;
+	GLfloat* resultNormalsX = &water->phases[count];
+	GLfloat* resultNormalsZ = &water->phases[2 * count];
+
+	for (unsigned int i = 0; i < count; i += 4) {
+		const Vec4f gradient0 = vec4fMul(slope0, vec4fLoad(&water->cosines[i]));
+		const Vec4f gradient1 = vec4fMul(slope1, vec4fLoad(&water->cosines[count + i]));
+
+		vec4fStore(&resultHeights[i], vec4fAdd(vec4fMul(height0, vec4fLoad(&water->sines[i])), vec4fMul(height1, vec4fLoad(&water->sines[count + i]))));
+		vec4fStore(&resultNormalsX[i], vec4fSub(zero, vec4fAdd(vec4fMul(gradient0, cosine0), vec4fMul(gradient1, cosine1))));
+		vec4fStore(&resultNormalsZ[i], vec4fSub(zero, vec4fAdd(vec4fMul(gradient0, sine0), vec4fMul(gradient1, sine1))));
+	}
+
+	for (unsigned int i = 0; i < count; ++i) {
+		water->vertices[i].position[1] = resultHeights[i];
+		water->vertices[i].normal[0] = resultNormalsX[i];
+		water->vertices[i].normal[2] = resultNormalsZ[i];
+	}
+
+	vertexBufferUpdate(water->buffer, water->vertices);
+}
+
+void waterDraw(Water* water, const Mat4* model, GLfloat offset, GLfloat height, const RenderMaterial* material) {
+	const Mat4 moved = mat4Translation((Vec3) { offset, height, 0 });
+	const Mat4 placed = model != NULL ? mat4Multiply(*model, moved) : moved;
+	renderDrawBuffer(water->buffer, &placed, material);
+}
+
+void waterFree(Water* water) {
+	if (water == NULL) {
+		return;
+	}
+
+	vertexBufferFree(water->buffer);
+	free(water->vertices);
+	free(water->gridX);
+	free(water->gridZ);
+	free(water->phases);
+	free(water->sines);
+	free(water->cosines);
+	free(water);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <freeglut.h>
+#include "buffer.h"
+#include "render.h"
+#include "angle.h"
+#include "vecinline.h"
+
+/*
+ * <water.c/water.h> The water surface, a grid that's built once and moved as a whole each frame.
+ * With waves turned on, the grid's heights and normals are recalculated on the CPU each frame,
+ * four vertices at a time, and copied into its vertex buffer
+ */
+
+// Size of each water tile, which the water texture is repeated across once
+#define WATER_SPACING 5
+// Corner of the first and last tile along each axis
+#define WATER_EXTENT 100
+// Number of tiles along each axis
+#define WATER_TILES (2 * WATER_EXTENT / WATER_SPACING + 1)
+// Number of vertices along each axis, which keeps the vertex count a multiple of four for the wave kernel
+#define WATER_SIDE (WATER_TILES + 1)
+
+// The two waves added together when waves are turned on: height, distance between crests,
+// direction of travel (in degrees around the y axis), and crests passing a point per second
+#define WATER_WAVE_HEIGHTS { 0.12f, 0.06f }
+#define WATER_WAVE_LENGTHS { 37.0f, 13.0f }
+#define WATER_WAVE_DIRECTIONS { 20.0f, 75.0f }
+#define WATER_WAVE_FREQUENCIES { 0.15f, 0.4f }
+
+typedef struct WATER {
+	VertexBuffer* buffer;
+	Vertex* vertices;	// The grid's vertices, which the waves are written into before they're uploaded
+	bool waves;			// Whether waterAnimate moves the vertices
+	GLfloat* gridX;		// The x and z of every vertex, kept apart so the wave kernel can load four at a time
+	GLfloat* gridZ;
+	GLfloat* phases;	// Scratch space for the wave kernel, an angle per vertex per wave (and then the results)
+	GLfloat* sines;
+	GLfloat* cosines;
+} Water;
+
+// Builds the water grid into a vertex buffer of triangle strips, with the scratch space for waves if asked for
+Water* waterCreate(bool waves);
+// Recalculates the waves at a given time in seconds and uploads them. Does nothing if waves are turned off
+void waterAnimate(Water* water, GLfloat time);
+// Draws the water surface with a material, moved along x by an offset and raised to a given height, then
+// placed by a model matrix, or where it is if that's NULL
+void waterDraw(Water* water, const Mat4* model, GLfloat offset, GLfloat height, const RenderMaterial* material);
+// Frees the water and its vertex buffer
+void waterFree(Water* water);